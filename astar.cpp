@@ -0,0 +1,282 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "astar.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include "maze.h"
+
+using MazeLib::Direction;
+
+AStar::AStar(CostModel costModel, Heuristic heuristic)
+    : mCostModel(costModel), mHeuristic(heuristic), mQueue(MAX_CELLS) {
+  memset(mSearch, 0, sizeof(mSearch));
+}
+
+void AStar::setCostModel(AStar::CostModel costModel) {
+  mCostModel = costModel;
+}
+
+AStar::CostModel AStar::costModel() const {
+  return mCostModel;
+}
+
+void AStar::setHeuristic(AStar::Heuristic heuristic) {
+  mHeuristic = heuristic;
+}
+
+AStar::Heuristic AStar::heuristic() const {
+  return mHeuristic;
+}
+
+const uint16_t *AStar::route() const {
+  return mRoute;
+}
+
+int AStar::routeLength() const {
+  return mRouteLength;
+}
+
+uint8_t AStar::routeDirection(int index) const {
+  if (index < 0 || index + 1 >= mRouteLength) {
+    return INVALID_DIRECTION;
+  }
+  return mRouteDirections[index];
+}
+
+int AStar::expandedCount() const {
+  return mExpanded;
+}
+
+uint32_t AStar::estimate(const Maze &maze, uint16_t cell, uint16_t target) const {
+  uint32_t distance = mHeuristic == CHEBYSHEV_HEURISTIC ? maze.chebyshevDistance(cell, target)
+                                                         : maze.manhattanDistance(cell, target);
+  if (mCostModel == RUNLENGTH_COST) {
+    distance *= mLeastStepCost;
+  }
+  return distance;
+}
+
+void AStar::touch(uint16_t cell) {
+  if (mSearch[cell] != mSearchNumber) {
+    mSearch[cell] = mSearchNumber;
+    mCost[cell] = MAX_COST;
+    mClosed[cell] = false;
+  }
+}
+
+/*
+ * With unit costs each cell is labelled once with the cost of the cheapest
+ * way found to it so far, as in the manhattan flood.
+ */
+uint16_t AStar::findRoute(const Maze &maze, uint16_t start, uint16_t target, uint8_t open_close_mask) {
+  mSearchNumber++;
+  if (mSearchNumber == 0) {
+    // the numbers have wrapped so old marks could look current
+    memset(mSearch, 0, sizeof(mSearch));
+    std::fill(mStateSearch.begin(), mStateSearch.end(), 0);
+    mSearchNumber = 1;
+  }
+  mRouteLength = 0;
+  mExpanded = 0;
+  if (mCostModel == RUNLENGTH_COST) {
+    mLeastStepCost = maze.runLengthLeastStepCost();
+    return findRunLengthRoute(maze, start, target, open_close_mask);
+  }
+  mQueue.clear();
+  touch(start);
+  mCost[start] = 0;
+  mQueue.update(start, Node(estimate(maze, start, target), start, INVALID_DIRECTION));
+  while (mQueue.size() > 0) {
+    Node node = mQueue.fetchSmallest();
+    const uint16_t here = node.cell;
+    mClosed[here] = true;
+    if (here == target) {
+      buildRoute(start, target);
+      return mCost[target];
+    }
+    mExpanded++;
+    const uint8_t walls = maze.getXWalls(here);
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (exitWall == node.entryWall || (walls & (open_close_mask << exitWall))) {
+        continue;
+      }
+      const uint16_t next = maze.neighbour(here, exitWall);
+      touch(next);
+      if (mClosed[next]) {
+        continue;
+      }
+      const uint32_t newCost = mCost[here] + 1;
+      if (newCost >= mCost[next]) {
+        continue;
+      }
+      mCost[next] = (uint16_t)newCost;
+      mParent[next] = here;
+      mParentDirection[next] = exitWall;
+      mQueue.update(next, Node(newCost + estimate(maze, next, target), next, Maze::opposite(exitWall)));
+    }
+  }
+  return MAX_COST;
+}
+
+void AStar::buildRoute(uint16_t start, uint16_t target) {
+  int length = 1;
+  for (uint16_t cell = target; cell != start; cell = mParent[cell]) {
+    length++;
+  }
+  mRouteLength = length;
+  uint16_t cell = target;
+  for (int i = length - 1; i >= 0; i--) {
+    mRoute[i] = cell;
+    if (i > 0) {
+      mRouteDirections[i - 1] = mParentDirection[cell];
+      cell = mParent[cell];
+    }
+  }
+}
+
+/*
+ * The runs out of the start are orthogonal, so the first piece costs the
+ * same as the first step out of the target in the runlength flood. A turn
+ * can only start a new run, since going on in the same heading is covered
+ * by the run that ended at the state. The estimate never falls by more than
+ * the least step cost per piece, so the first state taken from the queue
+ * in the target cell has the cheapest cost there is.
+ */
+uint16_t AStar::findRunLengthRoute(const Maze &maze, uint16_t start, uint16_t target, uint8_t open_close_mask) {
+  if (mStateSearch.empty()) {
+    const int stateCount = MAX_CELLS * DiagonalFlood::STATES_PER_CELL;
+    mStateCost.resize(stateCount);
+    mStateFrom.resize(stateCount);
+    mStateRun.resize(stateCount);
+    mStateSearch.assign(stateCount, 0);
+  }
+  mStateQueue.clear();
+  if (start == target) {
+    mRoute[0] = start;
+    mRouteLength = 1;
+    return 0;
+  }
+  for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+    run(maze, start, exitWall, Direction(2 * exitWall), 0, NO_STATE, target, open_close_mask);
+  }
+  while (!mStateQueue.empty()) {
+    std::pop_heap(mStateQueue.begin(), mStateQueue.end(), std::greater<uint64_t>());
+    const uint64_t entry = mStateQueue.back();
+    mStateQueue.pop_back();
+    const int here = (int)(entry & 0xFFFFFFFF);
+    const uint16_t cell = (uint16_t)(here / DiagonalFlood::STATES_PER_CELL);
+    const uint32_t hereCost = mStateCost[here];
+    if ((entry >> 32) != hereCost + estimate(maze, cell, target)) {
+      continue;  // a cheaper way to this state was found after this entry was queued
+    }
+    if (cell == target) {
+      if (!buildRunLengthRoute(maze, here)) {
+        return MAX_COST;
+      }
+      return (uint16_t)std::min<uint32_t>(hereCost, MAX_COST - 1);
+    }
+    mExpanded++;
+    const uint8_t walls = maze.getXWalls(cell);
+    const uint8_t entryWall = (uint8_t)((here / 3) % 4);
+    const Direction inHeading = DiagonalFlood::heading(here);
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (exitWall == entryWall || (walls & (open_close_mask << exitWall))) {
+        continue;
+      }
+      const Direction outHeading(DiagonalFlood::pieceHeading(entryWall, exitWall));
+      if (outHeading != inHeading) {
+        const uint32_t turnCost =
+            (uint32_t)DiagonalFlood::turnSize(inHeading, outHeading) * RunLengthCost::TURN_PENALTY;
+        run(maze, cell, exitWall, outHeading, hereCost + turnCost, here, target, open_close_mask);
+      }
+    }
+  }
+  return MAX_COST;
+}
+
+/// runs stop at 255 pieces, which is far more than any maze needs unless its exits wrap round the edges
+void AStar::run(const Maze &maze, uint16_t cell, uint8_t exitWall, Direction heading, uint32_t cost, int from,
+                uint16_t target, uint8_t open_close_mask) {
+  const RunLengthCostTables &tables = maze.runLengthCosts();
+  for (int runLength = 1; runLength <= UINT8_MAX; runLength++) {
+    if (maze.getXWalls(cell) & (open_close_mask << exitWall)) {
+      return;
+    }
+    const int index = std::min(runLength, RunLengthCostTables::LENGTHS - 1);
+    cost += heading.isOrthogonal() ? tables.ortho[index] : tables.diag[index];
+    cell = maze.neighbour(cell, exitWall);
+    relax(DiagonalFlood::state(cell, Maze::opposite(exitWall), heading), cost, from, runLength,
+          estimate(maze, cell, target));
+    exitWall = DiagonalFlood::nextExitWall(heading, exitWall);
+  }
+}
+
+void AStar::relax(int state, uint32_t cost, int from, int runLength, uint32_t estimate) {
+  if (mStateSearch[state] != mSearchNumber) {
+    mStateSearch[state] = mSearchNumber;
+    mStateCost[state] = UINT32_MAX;
+  }
+  if (cost >= mStateCost[state]) {
+    return;
+  }
+  mStateCost[state] = cost;
+  mStateFrom[state] = (uint16_t)from;
+  mStateRun[state] = (uint8_t)runLength;
+  mStateQueue.push_back((uint64_t)(cost + estimate) << 32 | (uint32_t)state);
+  std::push_heap(mStateQueue.begin(), mStateQueue.end(), std::greater<uint64_t>());
+}
+
+/*
+ * Each run is walked back from the state it ended in. The pieces of a
+ * diagonal leave by its two walls in turn, so going back through them
+ * alternates in the same way.
+ */
+bool AStar::buildRunLengthRoute(const Maze &maze, int last) {
+  int pieces = 0;
+  for (int state = last; state != NO_STATE; state = mStateFrom[state]) {
+    pieces += mStateRun[state];
+  }
+  if (pieces >= MAX_ROUTE) {
+    return false;
+  }
+  int i = pieces;
+  for (int state = last; state != NO_STATE; state = mStateFrom[state]) {
+    uint16_t cell = (uint16_t)(state / DiagonalFlood::STATES_PER_CELL);
+    uint8_t move = Maze::opposite((uint8_t)((state / 3) % 4));
+    const Direction heading = DiagonalFlood::heading(state);
+    mRoute[i] = cell;
+    for (int piece = 0; piece < mStateRun[state]; piece++) {
+      cell = maze.neighbour(cell, Maze::opposite(move));
+      i--;
+      mRoute[i] = cell;
+      mRouteDirections[i] = move;
+      move = DiagonalFlood::nextExitWall(heading, move);
+    }
+  }
+  mRouteLength = pieces + 1;
+  return true;
+}
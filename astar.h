@@ -0,0 +1,152 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <cstdint>
+#include <vector>
+#include "diagonalflood.h"
+#include "floodinfo.h"
+#include "indexedheap.h"
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * Point to point route queries.
+ *
+ * A flood finds the cost from every cell to the target, but running to the
+ * target only needs the route from the current cell. AStar searches from
+ * the start towards the target and stops when it gets there, guided by the
+ * manhattan or chebyshev distance. The work done depends on the length of
+ * the route rather than on the size of the maze.
+ *
+ * With UNIT_COST every step costs one, and the route is a shortest route as
+ * the manhattan flood finds. With RUNLENGTH_COST the steps are costed with
+ * the runlength costs of the maze, just as in the runlength flood, and each
+ * distance is scaled by the cheapest possible step so that the estimate
+ * never exceeds the true cost.
+ *
+ * The runlength flood keeps one run for each cell, so the cost it finds
+ * depends on the order the cells are reached in. The runlength search
+ * instead uses the states of DiagonalFlood, a cell with the wall it was
+ * entered by and the heading it was crossed with, and each step out of a
+ * state is a whole run in a new heading. The cost is then exact. The first
+ * run out of the start is orthogonal, as the first run out of the source of
+ * a flood is, so the cost is the same as DiagonalFlood::routeCost(target)
+ * after a diagonal flood from the start, and never more than the cost of
+ * the target after a runlength flood from the start.
+ * Its state takes about 110k bytes for a 32x32 maze, allocated by the first
+ * runlength query.
+ *
+ * The distances ignore the wrap at the edges of the maze. Mazes with their
+ * boundary walls in place never need it.
+ *
+ * The per-cell data is marked with a search number rather than cleared so
+ * a query does not need to touch every cell of the maze.
+ */
+class AStar {
+ public:
+  enum CostModel { UNIT_COST, RUNLENGTH_COST };
+  enum Heuristic { MANHATTAN_HEURISTIC, CHEBYSHEV_HEURISTIC };
+
+  static const int MAX_CELLS = 1024;
+  /// room for a route that passes through some cells more than once
+  static const int MAX_ROUTE = 2 * MAX_CELLS;
+
+  explicit AStar(CostModel costModel = UNIT_COST, Heuristic heuristic = MANHATTAN_HEURISTIC);
+
+  void setCostModel(CostModel costModel);
+  CostModel costModel() const;
+  void setHeuristic(Heuristic heuristic);
+  Heuristic heuristic() const;
+
+  /// Find the cheapest route from start to target using the walls allowed by the mask.
+  /// Returns its cost, or MAX_COST if there is no route or it does not fit in MAX_ROUTE cells.
+  /// The maze is not changed.
+  uint16_t findRoute(const Maze &maze, uint16_t start, uint16_t target, uint8_t open_close_mask);
+
+  /// the cells of the route from the most recent query, start and target included
+  const uint16_t *route() const;
+  /// the number of cells in the route. Zero if there was no route.
+  int routeLength() const;
+  /// the direction from the cell at the given position in the route to the next one
+  uint8_t routeDirection(int index) const;
+  /// the number of cells, or for RUNLENGTH_COST states, taken from the queue and expanded by the most recent query
+  int expandedCount() const;
+
+ private:
+  struct Node {
+    uint32_t priority = 0;
+    uint16_t cell = 0;
+    uint8_t entryWall = 0;
+
+    Node() = default;
+    Node(uint32_t _priority, uint16_t _cell, uint8_t inWall) : priority(_priority), cell(_cell), entryWall(inWall) {}
+
+    bool operator<(const Node &rhs) const { return priority < rhs.priority; }
+  };
+
+  static const int NO_STATE = UINT16_MAX;
+
+  CostModel mCostModel;
+  Heuristic mHeuristic;
+  uint16_t mCost[MAX_CELLS];
+  uint16_t mParent[MAX_CELLS];
+  uint8_t mParentDirection[MAX_CELLS];
+  uint16_t mSearch[MAX_CELLS];
+  bool mClosed[MAX_CELLS];
+  uint16_t mSearchNumber = 0;
+  uint16_t mRoute[MAX_ROUTE];
+  uint8_t mRouteDirections[MAX_ROUTE];
+  int mRouteLength = 0;
+  int mExpanded = 0;
+  /// the cheapest step in the runlength costs of the maze being searched
+  uint16_t mLeastStepCost = 1;
+  IndexedHeap<Node> mQueue;
+  /// the runlength search, indexed by DiagonalFlood::state(): the best cost, the state the run that
+  /// reached each state set out from and the number of pieces in that run
+  std::vector<uint32_t> mStateCost;
+  std::vector<uint16_t> mStateFrom;
+  std::vector<uint8_t> mStateRun;
+  std::vector<uint16_t> mStateSearch;
+  /// a binary heap of (priority << 32 | state). Stale entries are skipped when they come out.
+  std::vector<uint64_t> mStateQueue;
+
+  uint32_t estimate(const Maze &maze, uint16_t cell, uint16_t target) const;
+  /// set up the per-cell data for a cell the first time it is seen in this query
+  void touch(uint16_t cell);
+  void buildRoute(uint16_t start, uint16_t target);
+  uint16_t findRunLengthRoute(const Maze &maze, uint16_t start, uint16_t target, uint8_t open_close_mask);
+  /// follow one run out of the cell through exitWall, relaxing the state at the end of each piece
+  void run(const Maze &maze, uint16_t cell, uint8_t exitWall, MazeLib::Direction heading, uint32_t cost, int from,
+           uint16_t target, uint8_t open_close_mask);
+  void relax(int state, uint32_t cost, int from, int runLength, uint32_t estimate);
+  /// false, leaving no route, if the route would not fit in MAX_ROUTE cells
+  bool buildRunLengthRoute(const Maze &maze, int last);
+};
+
+#endif  // ASTAR_H
@@ -0,0 +1,319 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "bidirectionalsearch.h"
+#include <cstring>
+#include "floodinfo.h"
+#include "maze.h"
+
+static const uint8_t exitDirs[] = {DIR_N, DIR_E, DIR_S, DIR_W};
+static const uint32_t NO_ROUTE = 0xFFFFFFFF;
+
+BidirectionalSearch::BidirectionalSearch(CostModel costModel) : mCostModel(costModel) {
+  memset(mForward.search, 0, sizeof(mForward.search));
+  memset(mBackward.search, 0, sizeof(mBackward.search));
+}
+
+void BidirectionalSearch::setCostModel(BidirectionalSearch::CostModel costModel) {
+  mCostModel = costModel;
+}
+
+BidirectionalSearch::CostModel BidirectionalSearch::costModel() const {
+  return mCostModel;
+}
+
+void BidirectionalSearch::setCornerWeight(uint16_t cornerWeight) {
+  mCornerWeight = cornerWeight;
+}
+
+uint16_t BidirectionalSearch::cornerWeight() const {
+  return mCornerWeight;
+}
+
+void BidirectionalSearch::setBidirectional(bool bidirectional) {
+  mBidirectional = bidirectional;
+}
+
+bool BidirectionalSearch::isBidirectional() const {
+  return mBidirectional;
+}
+
+const uint16_t *BidirectionalSearch::route() const {
+  return mRoute;
+}
+
+int BidirectionalSearch::routeLength() const {
+  return mRouteLength;
+}
+
+uint8_t BidirectionalSearch::routeDirection(int index) const {
+  if (index < 0 || index + 1 >= mRouteLength) {
+    return INVALID_DIRECTION;
+  }
+  return mRouteDirections[index];
+}
+
+const uint8_t *BidirectionalSearch::routeDirections() const {
+  return mRouteDirections;
+}
+
+int BidirectionalSearch::expandedCount() const {
+  return mExpanded;
+}
+
+uint16_t BidirectionalSearch::stateFor(uint16_t cell, uint8_t move) const {
+  if (mCostModel == UNIT_COST || move == INVALID_DIRECTION) {
+    return static_cast<uint16_t>(cell * 4);
+  }
+  return static_cast<uint16_t>(cell * 4 + move);
+}
+
+void BidirectionalSearch::touch(Side &side, uint16_t state) {
+  if (side.search[state] != mSearchNumber) {
+    side.search[state] = mSearchNumber;
+    side.cost[state] = MAX_COST;
+    side.closed[state] = false;
+  }
+}
+
+void BidirectionalSearch::seed(Side &side, uint16_t cell, uint8_t move, uint8_t runLength, uint8_t entryDir) {
+  uint16_t state = stateFor(cell, move);
+  touch(side, state);
+  side.cost[state] = 0;
+  side.parent[state] = NO_PARENT;
+  side.move[state] = move;
+  side.runLength[state] = runLength;
+  side.entryDir[state] = entryDir;
+}
+
+uint16_t BidirectionalSearch::stepCost(const Maze &maze, const Side &side, uint16_t state, uint8_t exitWall,
+                                       uint8_t &runLength, uint8_t &exitDir) const {
+  const uint8_t move = side.move[state];
+  runLength = 0;
+  exitDir = exitDirs[exitWall];
+  switch (mCostModel) {
+    case WEIGHTED_COST:
+      return (move == INVALID_DIRECTION || move == exitWall) ? AHEAD_COST : mCornerWeight;
+    case RUNLENGTH_COST:
+      if (side.parent[state] == NO_PARENT) {
+        runLength = 1;
+        return maze.runLengthStartCost();
+      } else {
+        FloodInfo info(0, static_cast<uint16_t>(state / 4), side.runLength[state], side.entryDir[state],
+                       Maze::opposite(move));
+        return maze.runLengthStepCost(info, exitWall, runLength, exitDir);
+      }
+    default:
+      return 1;
+  }
+}
+
+/*
+ * A route through the meeting cell is the forward half, the move that
+ * joins the halves and the backward half. The backward half has already
+ * been charged for that move as if it were the first move out of the
+ * target, so only the difference a turn makes is added here. The runlength
+ * halves are simply added together.
+ */
+void BidirectionalSearch::join(uint16_t forwardState, uint16_t backwardState) {
+  const uint8_t forwardMove = mForward.move[forwardState];
+  const uint8_t backwardMove = mBackward.move[backwardState];
+  const bool atStart = mForward.parent[forwardState] == NO_PARENT;
+  if (!atStart && backwardMove != INVALID_DIRECTION && backwardMove == forwardMove) {
+    // the route would turn back on itself
+    return;
+  }
+  uint32_t cost = uint32_t(mForward.cost[forwardState]) + mBackward.cost[backwardState];
+  if (mCostModel == WEIGHTED_COST && backwardMove != INVALID_DIRECTION && forwardMove != INVALID_DIRECTION &&
+      forwardMove != Maze::opposite(backwardMove)) {
+    cost += mCornerWeight - AHEAD_COST;
+  }
+  if (cost < mBestCost) {
+    mBestCost = cost;
+    mBestForward = forwardState;
+    mBestBackward = backwardState;
+  }
+}
+
+void BidirectionalSearch::expand(const Maze &maze, Side &side, Side &other, uint8_t open_close_mask) {
+  const bool forward = &side == &mForward;
+  const uint16_t state = side.queue.fetchSmallest().state;
+  const uint16_t here = state / 4;
+  side.closed[state] = true;
+  mExpanded++;
+  const uint8_t walls = maze.getXWalls(here);
+  const bool atSeed = side.parent[state] == NO_PARENT;
+  for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+    if (walls & (open_close_mask << exitWall)) {
+      continue;
+    }
+    if (!atSeed && exitWall == Maze::opposite(side.move[state])) {
+      continue;
+    }
+    const uint16_t next = maze.neighbour(here, exitWall);
+    const uint16_t nextState = stateFor(next, exitWall);
+    touch(side, nextState);
+    if (side.closed[nextState]) {
+      continue;
+    }
+    uint8_t runLength;
+    uint8_t exitDir;
+    const uint32_t newCost = side.cost[state] + stepCost(maze, side, state, exitWall, runLength, exitDir);
+    if (newCost >= side.cost[nextState]) {
+      continue;
+    }
+    side.cost[nextState] = static_cast<uint16_t>(newCost);
+    side.parent[nextState] = state;
+    side.move[nextState] = exitWall;
+    side.runLength[nextState] = runLength;
+    side.entryDir[nextState] = exitDir;
+    side.queue.update(nextState, Node(newCost, nextState));
+    const int slots = mCostModel == UNIT_COST ? 1 : 4;
+    for (int slot = 0; slot < slots; slot++) {
+      const uint16_t otherState = static_cast<uint16_t>(next * 4 + slot);
+      if (other.search[otherState] != mSearchNumber || other.cost[otherState] == MAX_COST) {
+        continue;
+      }
+      if (forward) {
+        join(nextState, otherState);
+      } else {
+        join(otherState, nextState);
+      }
+    }
+  }
+}
+
+/*
+ * The side with the smaller queue expands its cheapest state next, which
+ * keeps the two frontiers about the same size. A cheaper route than the
+ * best one found would have to cost at least as much as the two cheapest
+ * queued states together, so the search stops once they cost as much as
+ * the best route. With unit costs every cell one step past either frontier
+ * has already been labelled and the search can stop one step sooner.
+ * Searching from the start only, the backward side holds just the target
+ * and the search stops as a Dijkstra search would.
+ */
+uint16_t BidirectionalSearch::findRoute(const Maze &maze, uint16_t start, uint8_t startHeading, uint16_t target,
+                                        uint8_t open_close_mask) {
+  mSearchNumber++;
+  if (mSearchNumber == 0) {
+    // the numbers have wrapped so old marks could look current
+    memset(mForward.search, 0, sizeof(mForward.search));
+    memset(mBackward.search, 0, sizeof(mBackward.search));
+    mSearchNumber = 1;
+  }
+  mForward.queue.clear();
+  mBackward.queue.clear();
+  mRouteLength = 0;
+  mExpanded = 0;
+  mBestCost = NO_ROUTE;
+  if (startHeading > WEST) {
+    startHeading = INVALID_DIRECTION;
+  }
+  const uint8_t startDir = startHeading == INVALID_DIRECTION ? static_cast<uint8_t>(DIR_N) : exitDirs[startHeading];
+  seed(mForward, start, startHeading, 0, startDir);
+  seed(mBackward, target, INVALID_DIRECTION, 0, DIR_N);
+  mForward.queue.update(stateFor(start, startHeading), Node(0, stateFor(start, startHeading)));
+  if (mBidirectional) {
+    mBackward.queue.update(stateFor(target, INVALID_DIRECTION), Node(0, stateFor(target, INVALID_DIRECTION)));
+  }
+  if (start == target) {
+    join(stateFor(start, startHeading), stateFor(target, INVALID_DIRECTION));
+  }
+  while (mForward.queue.size() > 0 || mBackward.queue.size() > 0) {
+    const bool forwardEmpty = mForward.queue.size() == 0;
+    const bool backwardEmpty = mBackward.queue.size() == 0;
+    if (mBidirectional && (forwardEmpty || backwardEmpty) && mBestCost == NO_ROUTE) {
+      // one end has been cut off from the other
+      break;
+    }
+    const uint32_t forwardTop = forwardEmpty ? 0 : mForward.cost[mForward.queue.topKey()];
+    const uint32_t backwardTop = backwardEmpty ? 0 : mBackward.cost[mBackward.queue.topKey()];
+    if (forwardTop + backwardTop + (mCostModel == UNIT_COST ? 1 : 0) >= mBestCost) {
+      break;
+    }
+    if (forwardEmpty || (!backwardEmpty && mBackward.queue.size() < mForward.queue.size())) {
+      expand(maze, mBackward, mForward, open_close_mask);
+    } else {
+      expand(maze, mForward, mBackward, open_close_mask);
+    }
+  }
+  if (mBestCost == NO_ROUTE) {
+    return MAX_COST;
+  }
+  buildRoute();
+  return routeCost(maze, startHeading);
+}
+
+void BidirectionalSearch::buildRoute() {
+  int length = 1;
+  for (uint16_t state = mBestForward; mForward.parent[state] != NO_PARENT; state = mForward.parent[state]) {
+    length++;
+  }
+  uint16_t state = mBestForward;
+  for (int i = length - 1; i >= 0; i--) {
+    mRoute[i] = state / 4;
+    if (i > 0) {
+      mRouteDirections[i - 1] = mForward.move[state];
+      state = mForward.parent[state];
+    }
+  }
+  for (state = mBestBackward; mBackward.parent[state] != NO_PARENT; state = mBackward.parent[state]) {
+    mRouteDirections[length - 1] = Maze::opposite(mBackward.move[state]);
+    mRoute[length] = mBackward.parent[state] / 4;
+    length++;
+  }
+  mRouteLength = length;
+}
+
+uint16_t BidirectionalSearch::routeCost(const Maze &maze, uint8_t startHeading) const {
+  uint32_t cost = 0;
+  uint8_t move = startHeading;
+  uint8_t runLength = 0;
+  uint8_t entryDir = DIR_N;
+  for (int i = 0; i + 1 < mRouteLength; i++) {
+    const uint8_t exitWall = mRouteDirections[i];
+    switch (mCostModel) {
+      case WEIGHTED_COST:
+        cost += (move == INVALID_DIRECTION || move == exitWall) ? AHEAD_COST : mCornerWeight;
+        break;
+      case RUNLENGTH_COST:
+        if (i == 0) {
+          cost += maze.runLengthStartCost();
+          runLength = 1;
+          entryDir = exitDirs[exitWall];
+        } else {
+          FloodInfo info(0, mRoute[i], runLength, entryDir, Maze::opposite(move));
+          cost += maze.runLengthStepCost(info, exitWall, runLength, entryDir);
+        }
+        break;
+      default:
+        cost += 1;
+        break;
+    }
+    move = exitWall;
+  }
+  return cost < MAX_COST ? static_cast<uint16_t>(cost) : MAX_COST;
+}
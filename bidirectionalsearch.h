@@ -0,0 +1,165 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef BIDIRECTIONALSEARCH_H
+#define BIDIRECTIONALSEARCH_H
+
+#include <cstdint>
+#include "indexedheap.h"
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * Point to point route queries that search from both ends at once.
+ *
+ * A Dijkstra search runs forwards from the start and another runs backwards
+ * from the target. Each side expands whichever frontier is cheaper and the
+ * search stops when the two frontiers together cost more than the best
+ * route found where they meet. Neither side needs to reach much past the
+ * middle of the route, so far fewer cells are expanded than by a search
+ * from one end.
+ *
+ * Each search state is a cell together with the heading of the move into
+ * it, so the turn costs of the weighted and runlength models are charged
+ * correctly on both sides. The costs of a route and of the same route
+ * driven in reverse are equal, which lets the backward side use the same
+ * step costs as the forward side. The heading of the mouse at the start is
+ * part of the query so that the weighted model charges the first move as a
+ * turn when it needs one.
+ *
+ * UNIT_COST charges one per step and needs only one state per cell.
+ * WEIGHTED_COST charges AHEAD_COST for a step straight on and the corner
+ * weight for a step after a turn, as in the weighted flood. Both give
+ * exactly the cheapest route.
+ *
+ * RUNLENGTH_COST charges the steps with the runlength costs of the maze.
+ * Like the runlength flood it keeps a single run length for each state, and
+ * the two halves of a route are joined without carrying the run across the
+ * meeting point, so the route is a good one rather than the cheapest
+ * possible.
+ * The cost returned is that of the whole route, costed from the start.
+ *
+ * With setBidirectional(false) only the forward side runs. That is a plain
+ * Dijkstra search from the start, useful for comparison.
+ *
+ * Per-state data is marked with a search number rather than cleared so a
+ * query does not need to touch every cell of the maze.
+ */
+class BidirectionalSearch {
+ public:
+  enum CostModel { UNIT_COST, WEIGHTED_COST, RUNLENGTH_COST };
+
+  static const int MAX_CELLS = 1024;
+  static const int MAX_STATES = 4 * MAX_CELLS;
+  /// the weighted cost of a step straight on. Turns cost the corner weight.
+  static const uint16_t AHEAD_COST = 2;
+
+  explicit BidirectionalSearch(CostModel costModel = UNIT_COST);
+
+  void setCostModel(CostModel costModel);
+  CostModel costModel() const;
+  /// the weighted cost of a step after a turn. It should be no less than AHEAD_COST.
+  void setCornerWeight(uint16_t cornerWeight);
+  uint16_t cornerWeight() const;
+  /// search from both ends (the default) or from the start only
+  void setBidirectional(bool bidirectional);
+  bool isBidirectional() const;
+
+  /// Find the cheapest route from start to target using the walls allowed by the mask. The
+  /// mouse starts out facing startHeading, which may be INVALID_DIRECTION if it does not matter.
+  /// Returns the cost of the route, or MAX_COST if there is none. The maze is not changed.
+  uint16_t findRoute(const Maze &maze, uint16_t start, uint8_t startHeading, uint16_t target, uint8_t open_close_mask);
+
+  /// the cells of the route from the most recent query, start and target included
+  const uint16_t *route() const;
+  /// the number of cells in the route. Zero if there was no route.
+  int routeLength() const;
+  /// the direction from the cell at the given position in the route to the next one
+  uint8_t routeDirection(int index) const;
+  /// the directions of all the moves in the route. There is one fewer than the cells.
+  const uint8_t *routeDirections() const;
+  /// the number of states taken from the queues and expanded by the most recent query
+  int expandedCount() const;
+
+ private:
+  struct Node {
+    uint32_t priority = 0;
+    uint16_t state = 0;
+
+    Node() = default;
+    Node(uint32_t _priority, uint16_t _state) : priority(_priority), state(_state) {}
+
+    bool operator<(const Node &rhs) const { return priority < rhs.priority; }
+  };
+
+  /// The labels and queue for one direction of the search. The move into each state is the
+  /// move as that side makes it, so moves on the backward side point towards the start.
+  struct Side {
+    uint16_t cost[MAX_STATES];
+    uint16_t parent[MAX_STATES];
+    uint8_t move[MAX_STATES];
+    uint8_t runLength[MAX_STATES];
+    uint8_t entryDir[MAX_STATES];
+    uint16_t search[MAX_STATES];
+    bool closed[MAX_STATES];
+    IndexedHeap<Node> queue;
+
+    Side() : queue(MAX_STATES) {}
+  };
+
+  static const uint16_t NO_PARENT = 0xFFFF;
+
+  CostModel mCostModel;
+  uint16_t mCornerWeight = 3;
+  bool mBidirectional = true;
+  uint16_t mSearchNumber = 0;
+  Side mForward;
+  Side mBackward;
+  uint32_t mBestCost = 0;
+  uint16_t mBestForward = 0;
+  uint16_t mBestBackward = 0;
+  uint16_t mRoute[2 * MAX_CELLS];
+  uint8_t mRouteDirections[2 * MAX_CELLS];
+  int mRouteLength = 0;
+  int mExpanded = 0;
+
+  /// the state for arriving in a cell with a given move. Unit costs ignore the move.
+  uint16_t stateFor(uint16_t cell, uint8_t move) const;
+  /// set up the data for a state the first time it is seen in this query
+  void touch(Side &side, uint16_t state);
+  void seed(Side &side, uint16_t cell, uint8_t move, uint8_t runLength, uint8_t entryDir);
+  /// the cost of a step in direction exitWall from the given state, and the run that follows it
+  uint16_t stepCost(const Maze &maze, const Side &side, uint16_t state, uint8_t exitWall, uint8_t &runLength,
+                    uint8_t &exitDir) const;
+  /// expand the cheapest state on one side, joining to the other side wherever they meet
+  void expand(const Maze &maze, Side &side, Side &other, uint8_t open_close_mask);
+  /// record the route through the given states if it is the best so far
+  void join(uint16_t forwardState, uint16_t backwardState);
+  void buildRoute();
+  uint16_t routeCost(const Maze &maze, uint8_t startHeading) const;
+};
+
+#endif  // BIDIRECTIONALSEARCH_H
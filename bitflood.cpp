@@ -0,0 +1,446 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "bitflood.h"
+#include <cstring>
+#include "mazeconstants.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITFLOOD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef WallPlanes::column_t column_t;
+
+/*
+ * Columns are stored from index 1 with a copy of the last column at index 0
+ * and a copy of the first column just after the last. The columns to the
+ * west and east of any column are then always at the previous and next
+ * index, wrap included. The spare words at the end let the vector kernels
+ * load whole blocks past the last column.
+ */
+const int STRIDE = WallPlanes::MAX_WIDTH + 16;
+
+struct FloodState {
+  column_t north[STRIDE];
+  column_t east[STRIDE];
+  column_t south[STRIDE];
+  column_t west[STRIDE];
+  /// rows in use for the real columns, zero for the copies and the spare words
+  column_t inMaze[STRIDE];
+  column_t visited[STRIDE];
+  column_t bufferA[STRIDE];
+  column_t bufferB[STRIDE];
+  column_t *frontier;
+  column_t *next;
+  int width;
+  int top;
+  /// for a pair flood, where the costs for the upper half of each column word go
+  uint16_t *upperCost;
+  /// true if some exit leads off an edge of the maze and wraps round to the other side
+  bool wraps;
+};
+
+void wrapColumns(column_t *columns, int width) {
+  columns[0] = columns[width];
+  columns[width + 1] = columns[1];
+}
+
+void prepare(FloodState &state, const WallPlanes &planes, uint8_t open_close_mask) {
+  memset(&state, 0, sizeof(state));
+  state.width = planes.width();
+  state.top = state.width - 1;
+  state.frontier = state.bufferA;
+  state.next = state.bufferB;
+  const column_t topRow = column_t(1) << state.top;
+  column_t edgeExits = 0;
+  for (uint16_t col = 0; col < state.width; col++) {
+    state.north[col + 1] = planes.exits(col, NORTH, open_close_mask);
+    state.east[col + 1] = planes.exits(col, EAST, open_close_mask);
+    state.south[col + 1] = planes.exits(col, SOUTH, open_close_mask);
+    state.west[col + 1] = planes.exits(col, WEST, open_close_mask);
+    state.inMaze[col + 1] = planes.rowMask();
+    edgeExits |= (state.north[col + 1] & topRow) | (state.south[col + 1] & 1);
+  }
+  edgeExits |= state.east[state.width] | state.west[1];
+  state.wraps = edgeExits != 0;
+  wrapColumns(state.north, state.width);
+  wrapColumns(state.east, state.width);
+  wrapColumns(state.south, state.width);
+  wrapColumns(state.west, state.width);
+}
+
+inline int lowestBit(uint32_t bits) {
+#if defined(__GNUC__)
+  return __builtin_ctz(bits);
+#else
+  int bit = 0;
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+/// Give every cell in the listed columns of cells the new distance. Returns the number of cells.
+inline uint16_t storeBits(column_t bits, uint16_t distance, uint16_t *columnCost) {
+  uint16_t count = 0;
+  while (bits) {
+    columnCost[lowestBit(bits)] = distance;
+    bits &= bits - 1;
+    count++;
+  }
+  return count;
+}
+
+inline uint16_t storeLevel(const FloodState &state, const column_t *cells, uint32_t columns, uint16_t distance,
+                           uint16_t *cost) {
+  uint16_t count = 0;
+  while (columns) {
+    const int col = lowestBit(columns);
+    columns &= columns - 1;
+    column_t bits = cells[col];
+    if (state.upperCost) {
+      count += storeBits(bits >> BitFlood::PAIR_MAX_WIDTH, distance, state.upperCost + col * state.width);
+      bits &= (column_t(1) << BitFlood::PAIR_MAX_WIDTH) - 1;
+    }
+    count += storeBits(bits, distance, cost + col * state.width);
+  }
+  return count;
+}
+
+/*
+ * A cell joins the next frontier if it has not been visited and a frontier
+ * cell next to it has an exit towards it:
+ *  - from the south, the same column shifted up one row
+ *  - from the north, the same column shifted down one row
+ *  - from the west and east, the neighbouring columns
+ *  - from the top of the column to the west or the bottom of the column to
+ *    the east, since north and south wrap into the next column
+ * Returns a word with bit n set if column n has cells in the new frontier.
+ */
+uint32_t stepPortable(FloodState &state) {
+  const column_t *frontier = state.frontier;
+  uint32_t columns = 0;
+  for (int i = 1; i <= state.width; i++) {
+    column_t reached = (frontier[i] & state.north[i]) << 1;
+    reached |= (frontier[i] & state.south[i]) >> 1;
+    reached |= frontier[i - 1] & state.east[i - 1];
+    reached |= frontier[i + 1] & state.west[i + 1];
+    reached |= ((frontier[i - 1] & state.north[i - 1]) >> state.top) & 1;
+    reached |= ((frontier[i + 1] & state.south[i + 1]) & 1) << state.top;
+    reached &= state.inMaze[i] & ~state.visited[i];
+    state.next[i] = reached;
+    state.visited[i] |= reached;
+    if (reached) {
+      columns |= uint32_t(1) << (i - 1);
+    }
+  }
+  return columns;
+}
+
+uint16_t floodPortable(FloodState &state, uint16_t *cost) {
+  uint16_t reachedCount = 1;
+  uint16_t distance = 0;
+  uint32_t columns;
+  while ((columns = stepPortable(state)) != 0) {
+    distance++;
+    reachedCount += storeLevel(state, state.next + 1, columns, distance, cost);
+    column_t *swap = state.frontier;
+    state.frontier = state.next;
+    state.next = swap;
+    wrapColumns(state.frontier, state.width);
+  }
+  return reachedCount;
+}
+
+#ifdef BITFLOOD_X86
+
+/*
+ * The vector kernels hold the whole maze in registers, BLOCKS vectors of four
+ * or eight columns each, for the length of the flood. Moving a frontier east
+ * or west is a shift of one lane with the lane that falls off the end of one
+ * vector carried into the next. They do not deal with exits that wrap round
+ * the edges of the maze. A maze with its boundary walls never has any; for
+ * one that does the portable kernel is used.
+ */
+template <int BLOCKS>
+__attribute__((target("sse2"))) uint16_t floodSse2(const FloodState &state, uint16_t *cost) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i north[BLOCKS], east[BLOCKS], south[BLOCKS], west[BLOCKS], frontier[BLOCKS], visited[BLOCKS];
+  for (int k = 0; k < BLOCKS; k++) {
+    north[k] = _mm_loadu_si128((const __m128i *)(state.north + 1 + 4 * k));
+    east[k] = _mm_loadu_si128((const __m128i *)(state.east + 1 + 4 * k));
+    south[k] = _mm_loadu_si128((const __m128i *)(state.south + 1 + 4 * k));
+    west[k] = _mm_loadu_si128((const __m128i *)(state.west + 1 + 4 * k));
+    frontier[k] = _mm_loadu_si128((const __m128i *)(state.frontier + 1 + 4 * k));
+    visited[k] = frontier[k];
+  }
+  alignas(16) column_t cells[4 * BLOCKS];
+  uint16_t reachedCount = 1;
+  uint16_t distance = 0;
+  for (;;) {
+    __m128i goingEast[BLOCKS], goingWest[BLOCKS];
+    for (int k = 0; k < BLOCKS; k++) {
+      goingEast[k] = _mm_and_si128(frontier[k], east[k]);
+      goingWest[k] = _mm_and_si128(frontier[k], west[k]);
+    }
+    uint32_t columns = 0;
+    for (int k = 0; k < BLOCKS; k++) {
+      __m128i reached = _mm_slli_epi32(_mm_and_si128(frontier[k], north[k]), 1);
+      reached = _mm_or_si128(reached, _mm_srli_epi32(_mm_and_si128(frontier[k], south[k]), 1));
+      reached = _mm_or_si128(reached, _mm_slli_si128(goingEast[k], 4));
+      reached = _mm_or_si128(reached, _mm_srli_si128(goingWest[k], 4));
+      if (k > 0) {
+        reached = _mm_or_si128(reached, _mm_srli_si128(goingEast[k - 1], 12));
+      }
+      if (k + 1 < BLOCKS) {
+        reached = _mm_or_si128(reached, _mm_slli_si128(goingWest[k + 1], 12));
+      }
+      reached = _mm_andnot_si128(visited[k], reached);
+      visited[k] = _mm_or_si128(visited[k], reached);
+      frontier[k] = reached;
+      _mm_store_si128((__m128i *)(cells + 4 * k), reached);
+      uint32_t empty = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(reached, zero)));
+      columns |= (~empty & 0x0Fu) << (4 * k);
+    }
+    if (columns == 0) {
+      break;
+    }
+    distance++;
+    reachedCount += storeLevel(state, cells, columns, distance, cost);
+  }
+  return reachedCount;
+}
+
+template <int BLOCKS>
+__attribute__((target("avx2"))) uint16_t floodAvx2(const FloodState &state, uint16_t *cost) {
+  const __m256i zero = _mm256_setzero_si256();
+  // lane n takes lane n-1, or lane n+1, with the end lane wrapping round to be replaced by a blend
+  const __m256i laneToEast = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+  const __m256i laneToWest = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  __m256i north[BLOCKS], east[BLOCKS], south[BLOCKS], west[BLOCKS], frontier[BLOCKS], visited[BLOCKS];
+  for (int k = 0; k < BLOCKS; k++) {
+    north[k] = _mm256_loadu_si256((const __m256i *)(state.north + 1 + 8 * k));
+    east[k] = _mm256_loadu_si256((const __m256i *)(state.east + 1 + 8 * k));
+    south[k] = _mm256_loadu_si256((const __m256i *)(state.south + 1 + 8 * k));
+    west[k] = _mm256_loadu_si256((const __m256i *)(state.west + 1 + 8 * k));
+    frontier[k] = _mm256_loadu_si256((const __m256i *)(state.frontier + 1 + 8 * k));
+    visited[k] = frontier[k];
+  }
+  alignas(32) column_t cells[8 * BLOCKS];
+  uint16_t reachedCount = 1;
+  uint16_t distance = 0;
+  for (;;) {
+    __m256i goingEast[BLOCKS], goingWest[BLOCKS];
+    for (int k = 0; k < BLOCKS; k++) {
+      goingEast[k] = _mm256_permutevar8x32_epi32(_mm256_and_si256(frontier[k], east[k]), laneToEast);
+      goingWest[k] = _mm256_permutevar8x32_epi32(_mm256_and_si256(frontier[k], west[k]), laneToWest);
+    }
+    uint32_t columns = 0;
+    for (int k = 0; k < BLOCKS; k++) {
+      __m256i reached = _mm256_slli_epi32(_mm256_and_si256(frontier[k], north[k]), 1);
+      reached = _mm256_or_si256(reached, _mm256_srli_epi32(_mm256_and_si256(frontier[k], south[k]), 1));
+      reached = _mm256_or_si256(reached, _mm256_blend_epi32(goingEast[k], k > 0 ? goingEast[k - 1] : zero, 0x01));
+      reached =
+          _mm256_or_si256(reached, _mm256_blend_epi32(goingWest[k], k + 1 < BLOCKS ? goingWest[k + 1] : zero, 0x80));
+      reached = _mm256_andnot_si256(visited[k], reached);
+      visited[k] = _mm256_or_si256(visited[k], reached);
+      frontier[k] = reached;
+      _mm256_store_si256((__m256i *)(cells + 8 * k), reached);
+      uint32_t empty = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(reached, zero)));
+      columns |= (~empty & 0xFFu) << (8 * k);
+    }
+    if (columns == 0) {
+      break;
+    }
+    distance++;
+    reachedCount += storeLevel(state, cells, columns, distance, cost);
+  }
+  return reachedCount;
+}
+
+uint16_t floodVector(BitFlood::Kernel kernel, FloodState &state, uint16_t *cost) {
+  if (kernel == BitFlood::AVX2_KERNEL) {
+    switch ((state.width + 7) / 8) {
+      case 1:
+        return floodAvx2<1>(state, cost);
+      case 2:
+        return floodAvx2<2>(state, cost);
+      case 3:
+        return floodAvx2<3>(state, cost);
+      default:
+        return floodAvx2<4>(state, cost);
+    }
+  }
+  switch ((state.width + 3) / 4) {
+    case 1:
+      return floodSse2<1>(state, cost);
+    case 2:
+      return floodSse2<2>(state, cost);
+    case 3:
+      return floodSse2<3>(state, cost);
+    case 4:
+      return floodSse2<4>(state, cost);
+    case 5:
+      return floodSse2<5>(state, cost);
+    case 6:
+      return floodSse2<6>(state, cost);
+    case 7:
+      return floodSse2<7>(state, cost);
+    default:
+      return floodSse2<8>(state, cost);
+  }
+}
+
+#endif  // BITFLOOD_X86
+
+uint16_t runKernel(BitFlood::Kernel kernel, FloodState &state, uint16_t *cost) {
+#ifdef BITFLOOD_X86
+  if (kernel != BitFlood::PORTABLE_KERNEL && !state.wraps && BitFlood::isSupported(kernel)) {
+    return floodVector(kernel, state, cost);
+  }
+#endif
+  return floodPortable(state, cost);
+}
+
+BitFlood::Kernel findBestKernel() {
+  if (BitFlood::isSupported(BitFlood::AVX2_KERNEL)) {
+    return BitFlood::AVX2_KERNEL;
+  }
+  if (BitFlood::isSupported(BitFlood::SSE2_KERNEL)) {
+    return BitFlood::SSE2_KERNEL;
+  }
+  return BitFlood::PORTABLE_KERNEL;
+}
+
+}  // namespace
+
+bool BitFlood::isSupported(BitFlood::Kernel kernel) {
+  switch (kernel) {
+    case PORTABLE_KERNEL:
+      return true;
+#ifdef BITFLOOD_X86
+    case SSE2_KERNEL:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case AVX2_KERNEL:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+BitFlood::Kernel BitFlood::bestKernel() {
+  static const Kernel best = findBestKernel();
+  return best;
+}
+
+const char *BitFlood::kernelName(BitFlood::Kernel kernel) {
+  switch (kernel) {
+    case PORTABLE_KERNEL:
+      return "portable";
+    case SSE2_KERNEL:
+      return "sse2";
+    case AVX2_KERNEL:
+      return "avx2";
+    default:
+      return "unknown";
+  }
+}
+
+uint16_t BitFlood::flood(const WallPlanes &planes, uint16_t target, uint8_t open_close_mask, uint16_t *cost) {
+  return flood(planes, target, open_close_mask, cost, bestKernel());
+}
+
+uint16_t BitFlood::flood(const WallPlanes &planes, uint16_t target, uint8_t open_close_mask, uint16_t *cost,
+                         BitFlood::Kernel kernel) {
+  const uint16_t width = planes.width();
+  const uint16_t cellCount = width * width;
+  FloodState state;
+  prepare(state, planes, open_close_mask);
+  for (uint16_t cell = 0; cell < cellCount; cell++) {
+    cost[cell] = MAX_COST;
+  }
+  cost[target] = 0;
+  const column_t targetBit = column_t(1) << (target % width);
+  state.frontier[target / width + 1] = targetBit;
+  state.visited[target / width + 1] = targetBit;
+  wrapColumns(state.frontier, width);
+  return runKernel(kernel, state, cost);
+}
+
+uint16_t BitFlood::floodPair(const WallPlanes &planes, uint16_t target, uint16_t *closedCost, uint16_t *openCost) {
+  return floodPair(planes, target, closedCost, openCost, bestKernel());
+}
+
+/*
+ * The closed maze flood goes in the upper half of each column word and the
+ * open maze flood in the lower half, so one pass of a kernel does both.
+ * Nothing can shift from one half into the other because, with no exits
+ * that wrap, the top row has no exit north and the bottom row no exit
+ * south. Each half of a new frontier is stored in its own cost array.
+ */
+uint16_t BitFlood::floodPair(const WallPlanes &planes, uint16_t target, uint16_t *closedCost, uint16_t *openCost,
+                             BitFlood::Kernel kernel) {
+  const uint16_t width = planes.width();
+  FloodState state;
+  prepare(state, planes, OPEN_MASK);
+  if (width > PAIR_MAX_WIDTH || state.wraps) {
+    uint16_t count = flood(planes, target, CLOSED_MASK, closedCost, kernel);
+    return count + flood(planes, target, OPEN_MASK, openCost, kernel);
+  }
+  // the closed maze exits are a subset of the open ones so they cannot wrap either
+  for (uint16_t col = 0; col < width; col++) {
+    state.north[col + 1] |= planes.exits(col, NORTH, CLOSED_MASK) << PAIR_MAX_WIDTH;
+    state.east[col + 1] |= planes.exits(col, EAST, CLOSED_MASK) << PAIR_MAX_WIDTH;
+    state.south[col + 1] |= planes.exits(col, SOUTH, CLOSED_MASK) << PAIR_MAX_WIDTH;
+    state.west[col + 1] |= planes.exits(col, WEST, CLOSED_MASK) << PAIR_MAX_WIDTH;
+    state.inMaze[col + 1] |= planes.rowMask() << PAIR_MAX_WIDTH;
+  }
+  wrapColumns(state.north, width);
+  wrapColumns(state.east, width);
+  wrapColumns(state.south, width);
+  wrapColumns(state.west, width);
+  const uint16_t cellCount = width * width;
+  for (uint16_t cell = 0; cell < cellCount; cell++) {
+    openCost[cell] = MAX_COST;
+    closedCost[cell] = MAX_COST;
+  }
+  openCost[target] = 0;
+  closedCost[target] = 0;
+  const column_t targetBit = column_t(1) << (target % width);
+  const column_t targetBits = targetBit | (targetBit << PAIR_MAX_WIDTH);
+  state.frontier[target / width + 1] = targetBits;
+  state.visited[target / width + 1] = targetBits;
+  wrapColumns(state.frontier, width);
+  state.upperCost = closedCost;
+  return runKernel(kernel, state, openCost) + 1;
+}
@@ -0,0 +1,79 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef BITFLOOD_H
+#define BITFLOOD_H
+
+#include <cstdint>
+#include "wallplanes.h"
+
+/*
+ * Bit-parallel breadth first flood.
+ *
+ * A manhattan flood is a breadth first search with unit costs. Instead of
+ * taking cells from a queue one at a time, BitFlood keeps the frontier as
+ * one word per column and finds the next frontier by shifting it through
+ * the exits in the WallPlanes. Each step deals with a whole column, or with
+ * four or eight columns at once in the SSE2 and AVX2 kernels, and the
+ * number of steps is the cost of the most distant cell.
+ *
+ * The costs are the breadth first distances from the target, which is
+ * exactly what Maze::manhattanFlood() has always stored, including
+ * MAX_COST for cells that cannot be reached. Neighbours wrap in the same
+ * way as Maze::neighbour().
+ *
+ * The vector kernels are only built for x86 with GCC or Clang. The best
+ * kernel the processor supports is found once, at run time, with CPUID.
+ * Other targets use the portable kernel.
+ */
+class BitFlood {
+ public:
+  enum Kernel { PORTABLE_KERNEL, SSE2_KERNEL, AVX2_KERNEL };
+
+  /// the fastest kernel that this processor supports
+  static Kernel bestKernel();
+  /// true if the kernel was built and the processor can run it
+  static bool isSupported(Kernel kernel);
+  static const char *kernelName(Kernel kernel);
+
+  /// Store in cost the distance of every cell from the target using the best kernel.
+  /// The cost array needs one entry per cell. Returns the number of cells reached.
+  static uint16_t flood(const WallPlanes &planes, uint16_t target, uint8_t open_close_mask, uint16_t *cost);
+  /// As above but with the given kernel. An unsupported kernel falls back to the portable one.
+  static uint16_t flood(const WallPlanes &planes, uint16_t target, uint8_t open_close_mask, uint16_t *cost,
+                        Kernel kernel);
+
+  /// the widest maze that floodPair() can do in one pass. Wider mazes get two floods.
+  static const uint16_t PAIR_MAX_WIDTH = 16;
+
+  /// Flood with CLOSED_MASK and OPEN_MASK together, in a single pass of the best kernel
+  /// when the maze is no more than PAIR_MAX_WIDTH wide and no exit wraps round an edge.
+  /// The costs are identical to two calls to flood(). Returns the cells reached by both.
+  static uint16_t floodPair(const WallPlanes &planes, uint16_t target, uint16_t *closedCost, uint16_t *openCost);
+  static uint16_t floodPair(const WallPlanes &planes, uint16_t target, uint16_t *closedCost, uint16_t *openCost,
+                            Kernel kernel);
+};
+
+#endif  // BITFLOOD_H
@@ -0,0 +1,234 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef BUCKETQUEUE_H
+#define BUCKETQUEUE_H
+
+#include <cassert>
+#include <cstdint>
+
+/*
+ * A bucket queue (Dial's algorithm) for floods whose edge costs are small
+ * bounded integers, such as the runlength flood.
+ *
+ * Items are filed in a circular array of buckets indexed by cost so that
+ * add() and fetchSmallest() are O(1) rather than the O(n) search in
+ * PriorityQueue. It relies on two properties of the floods that use it:
+ *  - no item is added with a cost lower than the last one fetched
+ *  - all queued costs lie within BUCKET_COUNT of each other
+ * Both are checked with assertions.
+ *
+ * The queue hands out items in exactly the same order as
+ * PriorityQueue::fetchSmallest() so that a flood gives the same results
+ * whichever queue it uses. PriorityQueue is a circular buffer where the
+ * smallest item is swapped with the head item before being removed. Here,
+ * every item remembers the buffer slot it would occupy and each bucket is
+ * kept in slot order. When the smallest item is not at the head, the head
+ * item takes over its slot and moves to the matching place in its own bucket.
+ *
+ * item_t must have an integer member called cost.
+ */
+template <class item_t, int BUCKET_COUNT = 256>
+class BucketQueue {
+ public:
+  explicit BucketQueue(int maxSize = 1024) : MAX_ITEMS(maxSize) {
+    static_assert((BUCKET_COUNT & (BUCKET_COUNT - 1)) == 0, "BUCKET_COUNT must be a power of 2");
+    mNodes = new Node[MAX_ITEMS];
+    mSlotOwner = new int[MAX_ITEMS];
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+      mBucketGeneration[i] = 0;
+    }
+    clear();
+  }
+
+  BucketQueue(const BucketQueue<item_t, BUCKET_COUNT> &rhs) = delete;
+  BucketQueue<item_t, BUCKET_COUNT> &operator=(const BucketQueue<item_t, BUCKET_COUNT> &rhs) = delete;
+
+  ~BucketQueue() {
+    delete[] mNodes;
+    delete[] mSlotOwner;
+  }
+
+  int size() const { return mItemCount; }
+
+  /*
+   * Clearing does not walk the buckets or the nodes. Buckets from an
+   * earlier generation are emptied the first time they are used, and
+   * nodes are handed out in order until some have been freed for reuse.
+   */
+  void clear() {
+    ++mGeneration;
+    if (mGeneration == 0) {
+      // the numbers have wrapped so old buckets could look current
+      for (int i = 0; i < BUCKET_COUNT; i++) {
+        mBucketGeneration[i] = 0;
+      }
+      mGeneration = 1;
+    }
+    mFree = NONE;
+    mUnused = 0;
+    mHeadSlot = 0;
+    mItemCount = 0;
+    mCurrentCost = 0;
+    mHighestCost = 0;
+    mLastFetchedCost = 0;
+  }
+
+  /*
+   * Adds an item to the tail of the queue
+   */
+  void add(item_t item) {
+    assert(mItemCount < MAX_ITEMS);
+    assert(item.cost >= mLastFetchedCost);
+    if (mItemCount == 0 || item.cost < mCurrentCost) {
+      mCurrentCost = item.cost;
+    }
+    if (mItemCount == 0 || item.cost > mHighestCost) {
+      mHighestCost = item.cost;
+    }
+    assert(mHighestCost - mCurrentCost < BUCKET_COUNT);
+    int node = mFree;
+    if (node == NONE) {
+      node = mUnused++;
+    } else {
+      mFree = mNodes[node].next;
+    }
+    mNodes[node].item = item;
+    mNodes[node].slot = mHeadSlot + mItemCount;
+    mNodes[node].next = NONE;
+    mSlotOwner[slotIndex(mNodes[node].slot)] = node;
+    int bucket = bucketIndex(item.cost);
+    freshen(bucket);
+    if (mLast[bucket] == NONE) {
+      mFirst[bucket] = node;
+    } else {
+      mNodes[mLast[bucket]].next = node;
+    }
+    mLast[bucket] = node;
+    ++mItemCount;
+  }
+
+  /*
+   * Return the smallest item in the queue. If two items are equally
+   * small, return the one that PriorityQueue would have returned.
+   */
+  item_t fetchSmallest() {
+    assert(mItemCount > 0);
+    int bucket = bucketIndex(mCurrentCost);
+    freshen(bucket);
+    while (mFirst[bucket] == NONE) {
+      ++mCurrentCost;
+      bucket = bucketIndex(mCurrentCost);
+      freshen(bucket);
+    }
+    mLastFetchedCost = mCurrentCost;
+    int node = popFirst(bucket);
+    uint32_t slot = mNodes[node].slot;
+    if (slot != mHeadSlot) {
+      // the item at the head of the buffer is swapped into the vacant slot
+      int headNode = mSlotOwner[slotIndex(mHeadSlot)];
+      int headBucket = bucketIndex(mNodes[headNode].item.cost);
+      popFirst(headBucket);
+      mNodes[headNode].slot = slot;
+      mSlotOwner[slotIndex(slot)] = headNode;
+      insertInSlotOrder(headBucket, headNode);
+    }
+    ++mHeadSlot;
+    --mItemCount;
+    item_t result = mNodes[node].item;
+    mNodes[node].next = mFree;
+    mFree = node;
+    return result;
+  }
+
+ protected:
+  static const int NONE = -1;
+
+  struct Node {
+    item_t item;
+    uint32_t slot;
+    int next;
+  };
+
+  Node *mNodes;
+  int *mSlotOwner;
+  const int MAX_ITEMS;
+  int mFirst[BUCKET_COUNT];
+  int mLast[BUCKET_COUNT];
+  uint32_t mBucketGeneration[BUCKET_COUNT];
+  uint32_t mGeneration = 0;
+  int mFree = NONE;
+  /// nodes from here on have never been used since the last clear()
+  int mUnused = 0;
+  uint32_t mHeadSlot = 0;
+  int mItemCount = 0;
+  int mCurrentCost = 0;
+  int mHighestCost = 0;
+  int mLastFetchedCost = 0;
+
+  static int bucketIndex(int cost) { return cost & (BUCKET_COUNT - 1); }
+
+  /// empty a bucket left over from before the last clear()
+  void freshen(int bucket) {
+    if (mBucketGeneration[bucket] != mGeneration) {
+      mBucketGeneration[bucket] = mGeneration;
+      mFirst[bucket] = NONE;
+      mLast[bucket] = NONE;
+    }
+  }
+
+  int slotIndex(uint32_t slot) const { return static_cast<int>(slot % MAX_ITEMS); }
+
+  int popFirst(int bucket) {
+    int node = mFirst[bucket];
+    mFirst[bucket] = mNodes[node].next;
+    if (mFirst[bucket] == NONE) {
+      mLast[bucket] = NONE;
+    }
+    return node;
+  }
+
+  /// buckets are short so a linear search for the insertion point is fine
+  void insertInSlotOrder(int bucket, int node) {
+    uint32_t slot = mNodes[node].slot;
+    int previous = NONE;
+    int current = mFirst[bucket];
+    while (current != NONE && mNodes[current].slot < slot) {
+      previous = current;
+      current = mNodes[current].next;
+    }
+    mNodes[node].next = current;
+    if (previous == NONE) {
+      mFirst[bucket] = node;
+    } else {
+      mNodes[previous].next = node;
+    }
+    if (current == NONE) {
+      mLast[bucket] = node;
+    }
+  }
+};
+
+#endif  // BUCKETQUEUE_H
@@ -26,6 +26,8 @@
 
 #include "compiler.h"
 #include <cassert>
+#include <cstddef>
+#include <vector>
 #include "commandnames.h"
 
 typedef enum {
@@ -511,3 +513,117 @@ void makeInPlaceCommands(const char *src, const uint16_t maxLength, uint8_t *com
     }
   };
 }
+
+/*
+ * The route has one heading for each cell the mouse crosses, orthogonal
+ * where it goes straight over the cell and diagonal where it turns in it,
+ * with the half cells out of the start and into the target at the ends.
+ * Each run of one heading is a straight or a diagonal and each change of
+ * heading between runs is part of a turn. A diagonal run of one cell
+ * between two changes of heading is the middle of an SS90, SS180, SD135 or
+ * DS135 turn and is not run on its own.
+ *
+ * A straight that follows a turn is one longer than its count of cells,
+ * as in makeDiagonalCommands(), and the half cell into the target is not
+ * counted. A turn straight into the stop is an explore turn. A route that
+ * ends before its last turn is finished gives CMD_ERROR.
+ */
+void makeRouteCommands(const MazeLib::Directions &route, const uint16_t maxLength, uint8_t *commands) {
+  struct Run {
+    MazeLib::Direction heading;
+    int length;
+  };
+  std::vector<Run> runs;
+  for (MazeLib::Direction heading : route) {
+    if (!runs.empty() && runs.back().heading == heading) {
+      runs.back().length++;
+    } else {
+      runs.push_back({heading, 1});
+    }
+  }
+  assert(maxLength > 2);
+  if (runs.empty()) {
+    commands[0] = CMD_STOP;
+    return;
+  }
+  if (!runs.front().heading.isOrthogonal() || !runs.back().heading.isOrthogonal()) {
+    commands[0] = CMD_ERROR_NOF;
+    commands[1] = CMD_STOP;
+    return;
+  }
+  const std::size_t last = runs.size() - 1;
+  auto straightLength = [&](std::size_t i) { return runs[i].length + 1 - (i == last ? 1 : 0); };
+  auto side = [&](std::size_t i) { return (runs[i + 1].heading - runs[i].heading) < 4 ? TURN_RIGHT : TURN_LEFT; };
+  int p = 0;
+  bool failed = false;
+  auto add = [&](int command) {
+    if (p >= maxLength - 1) {
+      failed = true;
+      return;
+    }
+    commands[p++] = (uint8_t)command;
+  };
+  auto addRun = [&](int base, int length) {
+    if (length > 31) {  // MAGIC: maximum for half-size maze
+      failed = true;
+    }
+    add(base + length);
+  };
+  std::size_t i = 0;
+  int length = straightLength(0) - 1;
+  bool diagonal = false;
+  while (!failed) {
+    if (!diagonal) {
+      addRun(FWD0, length);
+      if (i == last) {
+        break;
+      }
+      if (i + 2 > last) {  // a route cannot end in a turn
+        failed = true;
+        break;
+      }
+      const Run &turn = runs[i + 1];
+      if (turn.length == 1 && runs[i + 2].heading.isOrthogonal()) {
+        bool explore = i + 2 == last && runs[last].length == 1;
+        add((explore ? SS90ER : SS90FR) + side(i));
+        i += 2;
+        length = straightLength(i);
+      } else if (turn.length == 1 && i + 3 <= last && runs[i + 2].length == 1 && runs[i + 3].heading.isOrthogonal()) {
+        add(SS180R + side(i));
+        i += 3;
+        length = straightLength(i);
+      } else if (turn.length == 1) {
+        add(SD135R + side(i));
+        i += 2;
+        diagonal = true;
+      } else {
+        add(SD45R + side(i));
+        i += 1;
+        diagonal = true;
+      }
+    } else {
+      addRun(DIA0, runs[i].length);
+      const Run &next = runs[i + 1];
+      if (next.heading.isOrthogonal()) {
+        add(DS45R + side(i));
+        i += 1;
+        length = straightLength(i);
+        diagonal = false;
+      } else if (next.length == 1 && runs[i + 2].heading.isOrthogonal()) {
+        add(DS135R + side(i));
+        i += 2;
+        length = straightLength(i);
+        diagonal = false;
+      } else {
+        add(DD90R + side(i));
+        i += 1;
+      }
+    }
+  }
+  if (failed) {
+    commands[0] = CMD_ERROR;
+    commands[1] = CMD_STOP;
+    return;
+  }
+  commands[p] = CMD_STOP;
+}
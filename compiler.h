@@ -28,6 +28,7 @@
 #define MICROMOUSE_MAZE_COMPILER_H
 
 #include <cstdint>
+#include "direction.h"
 
 /// Convert the path to a set of commands using only 90 degree in place turns
 void makeInPlaceCommands(const char *src, const uint16_t maxLength, uint8_t *commands);
@@ -35,5 +36,8 @@ void makeInPlaceCommands(const char *src, const uint16_t maxLength, uint8_t *com
 void makeDiagonalCommands(const char *src, const uint16_t maxLength, uint8_t *commands);
 /// Convert the path to a set of commands using the full range of turns and moves
 void makeSmoothCommands(const char *src, const uint16_t maxLength, uint8_t *commands);
+/// Convert a route given as headings between wall midpoints, as DiagonalFlood::route() gives it, to a set of
+/// commands with diagonals. The lengths are counted as makeDiagonalCommands() counts them.
+void makeRouteCommands(const MazeLib::Directions &route, const uint16_t maxLength, uint8_t *commands);
 
 #endif  // MICROMOUSE_MAZE_COMPILER_H
@@ -0,0 +1,745 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "contractionindex.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "diagonalflood.h"
+#include "direction.h"
+#include "maze.h"
+
+using MazeLib::Direction;
+
+namespace {
+
+/// the file starts with "LMCH"
+const uint8_t FILE_MAGIC[4] = {'L', 'M', 'C', 'H'};
+/// a witness search gives up after settling this many nodes and the shortcut is kept
+const int WITNESS_LIMIT = 500;
+/// contraction stops once taking out the next node would need more shortcuts than this
+const int CORE_SHORTCUTS = 16;
+
+/*
+ * The graph while it is being contracted. Every edge ever added is kept,
+ * in the out list of its tail and the in list of its head, and a node is
+ * only marked as contracted, so that the query graph can be read off at
+ * the end from the ranks.
+ */
+class Contractor {
+ public:
+  struct Edge {
+    int node;
+    uint32_t cost;
+  };
+
+  explicit Contractor(int nodeCount)
+      : mOut(nodeCount),
+        mIn(nodeCount),
+        mRank(nodeCount, -1),
+        mDeleted(nodeCount, 0),
+        mCost(nodeCount, UINT32_MAX),
+        mSearch(nodeCount, 0),
+        mTarget(nodeCount, 0) {}
+
+  /// add a node with no edges and return its number
+  int addNode() {
+    mOut.emplace_back();
+    mIn.emplace_back();
+    mRank.push_back(-1);
+    mDeleted.push_back(0);
+    mCost.push_back(UINT32_MAX);
+    mSearch.push_back(0);
+    mTarget.push_back(0);
+    return (int)mOut.size() - 1;
+  }
+
+  int nodeCount() const { return (int)mOut.size(); }
+
+  /// add an edge, or lower the cost of the one already there. Returns true if the edge is new.
+  bool addEdge(int from, int to, uint32_t cost) {
+    if (from == to) {
+      return false;
+    }
+    for (Edge &edge : mOut[from]) {
+      if (edge.node == to) {
+        if (cost < edge.cost) {
+          edge.cost = cost;
+          for (Edge &back : mIn[to]) {
+            if (back.node == from) {
+              back.cost = cost;
+            }
+          }
+        }
+        return false;
+      }
+    }
+    mOut[from].push_back({to, cost});
+    mIn[to].push_back({from, cost});
+    return true;
+  }
+
+  /*
+   * Rank every node, least important first, adding shortcuts as each one
+   * is taken out. Returns the shortcuts. In open parts of a maze the
+   * graph gets denser as it shrinks until each node would need a great
+   * many shortcuts, so the nodes left then stay in the graph as a core
+   * that shares the top rank.
+   */
+  int contract() {
+    using Entry = std::pair<int, int>;
+    std::vector<Entry> heap;
+    for (int node = 0; node < (int)mOut.size(); node++) {
+      heap.push_back({priority(node), node});
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    int shortcuts = 0;
+    int rank = 0;
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+      int node = heap.back().second;
+      heap.pop_back();
+      // the priority may have risen as neighbours went. Put it back if another node now comes first.
+      int now = priority(node);
+      if (!heap.empty() && now > heap.front().first) {
+        heap.push_back({now, node});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        continue;
+      }
+      if ((int)mShortcuts.size() > CORE_SHORTCUTS) {
+        mRank[node] = rank;
+        for (const Entry &entry : heap) {
+          mRank[entry.second] = rank;
+        }
+        break;
+      }
+      // priority() has just left the shortcuts for this node in mShortcuts
+      for (const Shortcut &shortcut : mShortcuts) {
+        shortcuts += addEdge(shortcut.from, shortcut.to, shortcut.cost);
+      }
+      mRank[node] = rank++;
+      for (const Edge &edge : mOut[node]) {
+        mDeleted[edge.node]++;
+      }
+      for (const Edge &edge : mIn[node]) {
+        mDeleted[edge.node]++;
+      }
+    }
+    return shortcuts;
+  }
+
+  const std::vector<Edge> &out(int node) const { return mOut[node]; }
+  int rank(int node) const { return mRank[node]; }
+
+ private:
+  struct Shortcut {
+    int from;
+    int to;
+    uint32_t cost;
+  };
+
+  std::vector<std::vector<Edge>> mOut;
+  std::vector<std::vector<Edge>> mIn;
+  std::vector<int> mRank;
+  /// the neighbours of each node already contracted, which spreads the contraction over the maze
+  std::vector<int> mDeleted;
+  std::vector<Shortcut> mShortcuts;
+  std::vector<uint32_t> mCost;
+  std::vector<uint32_t> mSearch;
+  uint32_t mSearchNumber = 0;
+  /// the neighbours the witness searches for the node being taken out are looking for
+  std::vector<uint32_t> mTarget;
+  uint32_t mTargetNumber = 0;
+  std::vector<uint64_t> mQueue;
+
+  bool isLive(int node) const { return mRank[node] < 0; }
+
+  /// the shortcuts needed, less the edges that go, plus the neighbours already contracted
+  int priority(int node) {
+    findShortcuts(node);
+    int removed = 0;
+    for (const Edge &edge : mOut[node]) {
+      removed += isLive(edge.node);
+    }
+    for (const Edge &edge : mIn[node]) {
+      removed += isLive(edge.node);
+    }
+    return (int)mShortcuts.size() - removed + mDeleted[node];
+  }
+
+  /// the shortcuts taking the node out would need, left in mShortcuts
+  void findShortcuts(int node) {
+    mShortcuts.clear();
+    mTargetNumber++;
+    int targets = 0;
+    for (const Edge &out : mOut[node]) {
+      if (isLive(out.node)) {
+        mTarget[out.node] = mTargetNumber;
+        targets++;
+      }
+    }
+    for (const Edge &in : mIn[node]) {
+      if (!isLive(in.node)) {
+        continue;
+      }
+      bool anyOut = false;
+      uint32_t limit = 0;
+      for (const Edge &out : mOut[node]) {
+        if (isLive(out.node) && out.node != in.node) {
+          anyOut = true;
+          limit = std::max(limit, in.cost + out.cost);
+        }
+      }
+      if (!anyOut) {
+        continue;
+      }
+      witnessSearch(in.node, node, limit, targets);
+      for (const Edge &out : mOut[node]) {
+        if (!isLive(out.node) || out.node == in.node) {
+          continue;
+        }
+        uint32_t viaNode = in.cost + out.cost;
+        if (mSearch[out.node] != mSearchNumber || mCost[out.node] > viaNode) {
+          mShortcuts.push_back({in.node, out.node, viaNode});
+        }
+      }
+    }
+  }
+
+  /// Dijkstra from the start over the live nodes other than the one being taken out, up to the limit or
+  /// until the targets have all been settled
+  void witnessSearch(int start, int skip, uint32_t limit, int targets) {
+    mSearchNumber++;
+    mQueue.clear();
+    mSearch[start] = mSearchNumber;
+    mCost[start] = 0;
+    mQueue.push_back((uint64_t)start);
+    int settled = 0;
+    while (!mQueue.empty() && settled < WITNESS_LIMIT) {
+      std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+      uint64_t entry = mQueue.back();
+      mQueue.pop_back();
+      int here = (int)(entry & 0xFFFFFFFF);
+      uint32_t cost = (uint32_t)(entry >> 32);
+      if (cost != mCost[here]) {
+        continue;  // a cheaper way to this node was found after this entry was queued
+      }
+      if (cost > limit) {
+        break;
+      }
+      settled++;
+      if (mTarget[here] == mTargetNumber && --targets == 0) {
+        break;
+      }
+      for (const Edge &edge : mOut[here]) {
+        if (edge.node == skip || !isLive(edge.node)) {
+          continue;
+        }
+        uint32_t next = cost + edge.cost;
+        if (mSearch[edge.node] != mSearchNumber || next < mCost[edge.node]) {
+          mSearch[edge.node] = mSearchNumber;
+          mCost[edge.node] = next;
+          mQueue.push_back((uint64_t)next << 32 | (uint32_t)edge.node);
+          std::push_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+        }
+      }
+    }
+  }
+};
+
+/// FNV-1a, enough to tell one maze or set of tables from another
+uint32_t hashBytes(uint32_t hash, const uint8_t *bytes, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+const uint32_t HASH_SEED = 2166136261u;
+
+/// the run length from which every further piece costs the same, once the mouse is at its top speed
+int cruiseLength(const uint16_t *costs) {
+  int length = RunLengthCostTables::LENGTHS - 1;
+  while (length > 1 && costs[length - 1] == costs[RunLengthCostTables::LENGTHS - 1]) {
+    length--;
+  }
+  return length;
+}
+
+void put16(std::vector<uint8_t> &data, uint16_t value) {
+  data.push_back((uint8_t)(value & 0xFF));
+  data.push_back((uint8_t)(value >> 8));
+}
+
+void put32(std::vector<uint8_t> &data, uint32_t value) {
+  put16(data, (uint16_t)(value & 0xFFFF));
+  put16(data, (uint16_t)(value >> 16));
+}
+
+/// reads the little-endian values written by put16() and put32(), failing rather than running off the end
+class Reader {
+ public:
+  Reader(const uint8_t *data, size_t size) : mData(data), mSize(size) {}
+
+  bool get8(uint8_t &value) {
+    if (mPosition + 1 > mSize) {
+      return false;
+    }
+    value = mData[mPosition++];
+    return true;
+  }
+
+  bool get16(uint16_t &value) {
+    uint8_t low;
+    uint8_t high;
+    if (!get8(low) || !get8(high)) {
+      return false;
+    }
+    value = (uint16_t)(low | high << 8);
+    return true;
+  }
+
+  bool get32(uint32_t &value) {
+    uint16_t low;
+    uint16_t high;
+    if (!get16(low) || !get16(high)) {
+      return false;
+    }
+    value = low | (uint32_t)high << 16;
+    return true;
+  }
+
+  bool atEnd() const { return mPosition == mSize; }
+
+ private:
+  const uint8_t *mData;
+  size_t mSize;
+  size_t mPosition = 0;
+};
+
+}  // namespace
+
+int ContractionIndex::cellCount() const {
+  return mWidth * mWidth;
+}
+
+/// the node a query starts its forward search from, the target cell as the source of a diagonal flood
+int ContractionIndex::sourceNode(uint16_t cell) const {
+  return cell;
+}
+
+/// the node that every state of a cell leads to at no cost, where a query starts its backward search
+int ContractionIndex::sinkNode(uint16_t cell) const {
+  return cellCount() + cell;
+}
+
+uint32_t ContractionIndex::wallHash(const Maze &maze, uint8_t open_close_mask) {
+  uint8_t header[3] = {(uint8_t)maze.width(), (uint8_t)(maze.width() >> 8), open_close_mask};
+  uint32_t hash = hashBytes(HASH_SEED, header, sizeof(header));
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    uint8_t walls = maze.walls(cell, open_close_mask);
+    hash = hashBytes(hash, &walls, 1);
+  }
+  return hash;
+}
+
+uint32_t ContractionIndex::costHash(const Maze &maze) {
+  const RunLengthCostTables &tables = maze.runLengthCosts();
+  uint32_t hash = hashBytes(HASH_SEED, reinterpret_cast<const uint8_t *>(tables.ortho), sizeof(tables.ortho));
+  hash = hashBytes(hash, reinterpret_cast<const uint8_t *>(tables.diag), sizeof(tables.diag));
+  uint8_t turn = RunLengthCost::TURN_PENALTY;
+  return hashBytes(hash, &turn, 1);
+}
+
+/*
+ * The graph is the one DiagonalFlood searches, with a run broken into its
+ * pieces. A node is a state together with the length of the run that came
+ * to it, or a state where the run stops and the mouse may turn. The cost
+ * of a piece depends only on its place in the run, so each run node has
+ * an edge on to the next piece and one to stop at its state, and a state
+ * has an edge to start each turning run. Turning costs TURN_PENALTY per 45
+ * degrees and a run straight out of a source does not turn.
+ *
+ * Once the mouse reaches its top speed every piece costs the same, so the
+ * run lengths beyond that share one node. An edge from each state to the
+ * end of every piece in its run would be simpler, but an open maze would
+ * have edges in proportion to its width for every state and contracting
+ * them takes far longer than the sparse graph.
+ */
+void ContractionIndex::build(const Maze &maze, uint8_t open_close_mask) {
+  const uint16_t numCells = maze.numCells();
+  mWidth = maze.width();
+  mMask = open_close_mask;
+  mWallHash = wallHash(maze, open_close_mask);
+  mCostHash = costHash(maze);
+  const RunLengthCostTables &tables = maze.runLengthCosts();
+  uint8_t exits[MAX_CELLS];
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    exits[cell] = (uint8_t)(~maze.walls(cell, open_close_mask) & 0x0F);
+  }
+  const int cruiseOrtho = cruiseLength(tables.ortho);
+  const int cruiseDiag = cruiseLength(tables.diag);
+
+  // the sources and sinks come first. Every other node is numbered as it is first reached.
+  const int runLengths = RunLengthCostTables::LENGTHS;
+  std::vector<int> ids((size_t)numCells * DiagonalFlood::STATES_PER_CELL * runLengths, -1);
+  std::vector<int> pending;
+  Contractor graph(2 * numCells);
+  auto node = [&](int state, int runLength) {
+    int &id = ids[(size_t)state * runLengths + runLength];
+    if (id < 0) {
+      id = graph.addNode();
+      pending.push_back(state * runLengths + runLength);
+    }
+    return id;
+  };
+  auto startRun = [&](int from, uint16_t cell, uint8_t exitWall, Direction heading, uint32_t cost) {
+    if (exits[cell] & (1 << exitWall)) {
+      const uint16_t *costs = heading.isOrthogonal() ? tables.ortho : tables.diag;
+      const int next = DiagonalFlood::state(maze.neighbour(cell, exitWall), (uint8_t)((exitWall + 2) % 4), heading);
+      graph.addEdge(from, node(next, 1), cost + costs[1]);
+    }
+  };
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      startRun(sourceNode(cell), cell, exitWall, Direction(2 * exitWall), 0);
+    }
+  }
+  while (!pending.empty()) {
+    const int key = pending.back();
+    pending.pop_back();
+    const int state = key / runLengths;
+    const int runLength = key % runLengths;
+    const int here = ids[key];
+    const uint16_t cell = (uint16_t)(state / DiagonalFlood::STATES_PER_CELL);
+    const uint8_t entryWall = (uint8_t)((state / 3) % 4);
+    const Direction heading = DiagonalFlood::heading(state);
+    if (runLength == 0) {
+      graph.addEdge(here, sinkNode(cell), 0);
+      for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+        if (exitWall == entryWall) {
+          continue;
+        }
+        Direction outHeading(DiagonalFlood::pieceHeading(entryWall, exitWall));
+        if (outHeading != heading) {
+          startRun(here, cell, exitWall, outHeading,
+                   (uint32_t)DiagonalFlood::turnSize(heading, outHeading) * RunLengthCost::TURN_PENALTY);
+        }
+      }
+      continue;
+    }
+    graph.addEdge(here, node(state, 0), 0);
+    const uint8_t aheadWall = DiagonalFlood::nextExitWall(heading, (uint8_t)((entryWall + 2) % 4));
+    if (exits[cell] & (1 << aheadWall)) {
+      const uint16_t *costs = heading.isOrthogonal() ? tables.ortho : tables.diag;
+      const int nextLength = std::min(runLength + 1, heading.isOrthogonal() ? cruiseOrtho : cruiseDiag);
+      const int next = DiagonalFlood::state(maze.neighbour(cell, aheadWall), (uint8_t)((aheadWall + 2) % 4), heading);
+      graph.addEdge(here, node(next, nextLength), costs[nextLength]);
+    }
+  }
+  mShortcuts = graph.contract();
+
+  // each edge goes up from its tail or down into its head, whichever is ranked lower, and both ways in the core
+  const int nodes = graph.nodeCount();
+  mNodeCount = nodes;
+  mUpFirst.assign(nodes + 1, 0);
+  mDownFirst.assign(nodes + 1, 0);
+  for (int node = 0; node < nodes; node++) {
+    for (const Contractor::Edge &edge : graph.out(node)) {
+      if (graph.rank(edge.node) >= graph.rank(node)) {
+        mUpFirst[node + 1]++;
+      }
+      if (graph.rank(edge.node) <= graph.rank(node)) {
+        mDownFirst[edge.node + 1]++;
+      }
+    }
+  }
+  for (int node = 0; node < nodes; node++) {
+    mUpFirst[node + 1] += mUpFirst[node];
+    mDownFirst[node + 1] += mDownFirst[node];
+  }
+  mUp.resize(mUpFirst[nodes]);
+  mDown.resize(mDownFirst[nodes]);
+  std::vector<uint32_t> upNext(mUpFirst.begin(), mUpFirst.end() - 1);
+  std::vector<uint32_t> downNext(mDownFirst.begin(), mDownFirst.end() - 1);
+  for (int node = 0; node < nodes; node++) {
+    for (const Contractor::Edge &edge : graph.out(node)) {
+      if (graph.rank(edge.node) >= graph.rank(node)) {
+        mUp[upNext[node]++] = {(uint32_t)edge.node, edge.cost};
+      }
+      if (graph.rank(edge.node) <= graph.rank(node)) {
+        mDown[downNext[edge.node]++] = {(uint32_t)node, edge.cost};
+      }
+    }
+  }
+  prepareSearches();
+}
+
+void ContractionIndex::prepareSearches() {
+  const int nodes = nodeCount();
+  mForwardCost.assign(nodes, UINT32_MAX);
+  mBackwardCost.assign(nodes, UINT32_MAX);
+  mForwardSearch.assign(nodes, 0);
+  mBackwardSearch.assign(nodes, 0);
+  mSearchNumber = 0;
+}
+
+bool ContractionIndex::isBuilt() const {
+  return mWidth != 0;
+}
+
+bool ContractionIndex::matches(const Maze &maze, uint8_t open_close_mask) const {
+  return isBuilt() && maze.width() == mWidth && open_close_mask == mMask &&
+         wallHash(maze, open_close_mask) == mWallHash && costHash(maze) == mCostHash;
+}
+
+/*
+ * Both searches only go up in rank, or across the core: forwards from the
+ * target as the source of the flood and backwards from the start. The cheapest node
+ * reached by both gives the cost. Each step settles the cheaper of the two
+ * queues and the query stops when neither holds anything cheaper than the
+ * best meeting found so far.
+ */
+uint32_t ContractionIndex::query(uint16_t start, uint16_t target) {
+  mSearchSpace = 0;
+  if (!isBuilt() || start >= cellCount() || target >= cellCount()) {
+    return MAX_COST;
+  }
+  if (start == target) {
+    return 0;
+  }
+  mSearchNumber++;
+  if (mSearchNumber == 0) {
+    std::fill(mForwardSearch.begin(), mForwardSearch.end(), 0);
+    std::fill(mBackwardSearch.begin(), mBackwardSearch.end(), 0);
+    mSearchNumber = 1;
+  }
+  const int from = sourceNode(target);
+  const int to = sinkNode(start);
+  mForwardQueue.clear();
+  mBackwardQueue.clear();
+  mForwardSearch[from] = mSearchNumber;
+  mForwardCost[from] = 0;
+  mForwardQueue.push_back((uint64_t)from);
+  mBackwardSearch[to] = mSearchNumber;
+  mBackwardCost[to] = 0;
+  mBackwardQueue.push_back((uint64_t)to);
+  uint64_t best = UINT32_MAX;
+  while (!mForwardQueue.empty() || !mBackwardQueue.empty()) {
+    uint64_t forwardLeast = mForwardQueue.empty() ? UINT64_MAX : mForwardQueue.front() >> 32;
+    uint64_t backwardLeast = mBackwardQueue.empty() ? UINT64_MAX : mBackwardQueue.front() >> 32;
+    if (std::min(forwardLeast, backwardLeast) >= best) {
+      break;
+    }
+    const bool forward = forwardLeast <= backwardLeast;
+    std::vector<uint64_t> &queue = forward ? mForwardQueue : mBackwardQueue;
+    std::vector<uint32_t> &cost = forward ? mForwardCost : mBackwardCost;
+    std::vector<uint16_t> &search = forward ? mForwardSearch : mBackwardSearch;
+    const std::vector<uint32_t> &otherCost = forward ? mBackwardCost : mForwardCost;
+    const std::vector<uint16_t> &otherSearch = forward ? mBackwardSearch : mForwardSearch;
+    const std::vector<uint32_t> &first = forward ? mUpFirst : mDownFirst;
+    const std::vector<Arc> &arcs = forward ? mUp : mDown;
+
+    std::pop_heap(queue.begin(), queue.end(), std::greater<uint64_t>());
+    uint64_t entry = queue.back();
+    queue.pop_back();
+    int here = (int)(entry & 0xFFFFFFFF);
+    uint32_t hereCost = (uint32_t)(entry >> 32);
+    if (hereCost != cost[here]) {
+      continue;  // a cheaper way to this node was found after this entry was queued
+    }
+    mSearchSpace++;
+    if (otherSearch[here] == mSearchNumber) {
+      best = std::min<uint64_t>(best, (uint64_t)hereCost + otherCost[here]);
+    }
+    for (uint32_t i = first[here]; i < first[here + 1]; i++) {
+      const Arc &arc = arcs[i];
+      uint32_t next = hereCost + arc.cost;
+      if (search[arc.node] != mSearchNumber || next < cost[arc.node]) {
+        search[arc.node] = mSearchNumber;
+        cost[arc.node] = next;
+        queue.push_back((uint64_t)next << 32 | arc.node);
+        std::push_heap(queue.begin(), queue.end(), std::greater<uint64_t>());
+      }
+    }
+  }
+  return best >= UINT32_MAX ? MAX_COST : (uint32_t)best;
+}
+
+uint16_t ContractionIndex::width() const {
+  return mWidth;
+}
+
+int ContractionIndex::nodeCount() const {
+  return mNodeCount;
+}
+
+int ContractionIndex::edgeCount() const {
+  return (int)(mUp.size() + mDown.size());
+}
+
+int ContractionIndex::shortcutCount() const {
+  return mShortcuts;
+}
+
+int ContractionIndex::searchSpace() const {
+  return mSearchSpace;
+}
+
+/*
+ * All values are little-endian:
+ *   "LMCH", version (16 bits), width (16), mask (8), wall hash (32), cost hash (32),
+ *   nodes (32), shortcuts (32), up edges (32), down edges (32),
+ *   the number of up edges of each node (16), each up edge as node (32) and cost (32),
+ *   the number of down edges of each node (16), each down edge as node (32) and cost (32)
+ */
+void ContractionIndex::save(std::vector<uint8_t> &data) const {
+  data.clear();
+  for (uint8_t byte : FILE_MAGIC) {
+    data.push_back(byte);
+  }
+  put16(data, FILE_VERSION);
+  put16(data, mWidth);
+  data.push_back(mMask);
+  put32(data, mWallHash);
+  put32(data, mCostHash);
+  put32(data, (uint32_t)mNodeCount);
+  put32(data, (uint32_t)mShortcuts);
+  put32(data, (uint32_t)mUp.size());
+  put32(data, (uint32_t)mDown.size());
+  const int nodes = nodeCount();
+  for (const auto *list : {&mUpFirst, &mDownFirst}) {
+    const std::vector<Arc> &arcs = list == &mUpFirst ? mUp : mDown;
+    for (int node = 0; node < nodes; node++) {
+      put16(data, (uint16_t)((*list)[node + 1] - (*list)[node]));
+    }
+    for (const Arc &arc : arcs) {
+      put32(data, arc.node);
+      put32(data, arc.cost);
+    }
+  }
+}
+
+bool ContractionIndex::load(const uint8_t *data, size_t size) {
+  mWidth = 0;
+  mUp.clear();
+  mDown.clear();
+  Reader reader(data, size);
+  for (uint8_t expected : FILE_MAGIC) {
+    uint8_t byte;
+    if (!reader.get8(byte) || byte != expected) {
+      return false;
+    }
+  }
+  uint16_t version;
+  uint16_t width;
+  uint8_t mask;
+  uint32_t wallHash;
+  uint32_t costHash;
+  uint32_t nodeCount;
+  uint32_t shortcuts;
+  uint32_t upCount;
+  uint32_t downCount;
+  if (!reader.get16(version) || version != FILE_VERSION || !reader.get16(width) || width == 0 ||
+      width * width > MAX_CELLS || !reader.get8(mask) || !reader.get32(wallHash) || !reader.get32(costHash) ||
+      !reader.get32(nodeCount) || !reader.get32(shortcuts) || !reader.get32(upCount) || !reader.get32(downCount)) {
+    return false;
+  }
+  // every cell has a source and a sink, and no node can be added twice for the same state and run length
+  const int cells = width * width;
+  if (nodeCount < 2u * cells || nodeCount > 2u * cells + (uint32_t)cells * DiagonalFlood::STATES_PER_CELL *
+                                                            RunLengthCostTables::LENGTHS) {
+    return false;
+  }
+  const int nodes = (int)nodeCount;
+  std::vector<uint32_t> firsts[2];
+  std::vector<Arc> arcs[2];
+  const uint32_t counts[2] = {upCount, downCount};
+  for (int list = 0; list < 2; list++) {
+    // the counts must be there in full before the space for them is taken
+    if (size < (size_t)nodes * 2 + (size_t)counts[list] * 8) {
+      return false;
+    }
+    firsts[list].assign(nodes + 1, 0);
+    for (int node = 0; node < nodes; node++) {
+      uint16_t degree;
+      if (!reader.get16(degree)) {
+        return false;
+      }
+      firsts[list][node + 1] = firsts[list][node] + degree;
+    }
+    if (firsts[list][nodes] != counts[list]) {
+      return false;
+    }
+    arcs[list].resize(counts[list]);
+    for (Arc &arc : arcs[list]) {
+      if (!reader.get32(arc.node) || arc.node >= nodeCount || !reader.get32(arc.cost)) {
+        return false;
+      }
+    }
+  }
+  if (!reader.atEnd()) {
+    return false;
+  }
+  mWidth = width;
+  mNodeCount = nodes;
+  mMask = mask;
+  mWallHash = wallHash;
+  mCostHash = costHash;
+  mShortcuts = (int)shortcuts;
+  mUpFirst.swap(firsts[0]);
+  mUp.swap(arcs[0]);
+  mDownFirst.swap(firsts[1]);
+  mDown.swap(arcs[1]);
+  prepareSearches();
+  return true;
+}
+
+int ContractionIndex::writeFile(const char *fileName) const {
+  std::vector<uint8_t> data;
+  save(data);
+  FILE *fp = fopen(fileName, "wb");
+  if (fp == nullptr) {
+    return INDEX_WRITE_ERROR;
+  }
+  size_t written = fwrite(data.data(), 1, data.size(), fp);
+  fclose(fp);
+  return written == data.size() ? INDEX_SUCCESS : INDEX_WRITE_ERROR;
+}
+
+int ContractionIndex::readFile(const char *fileName) {
+  FILE *fp = fopen(fileName, "rb");
+  if (fp == nullptr) {
+    return INDEX_READ_ERROR;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[4096];
+  size_t bytesRead;
+  while ((bytesRead = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+    data.insert(data.end(), buffer, buffer + bytesRead);
+  }
+  fclose(fp);
+  return load(data.data(), data.size()) ? INDEX_SUCCESS : INDEX_READ_ERROR;
+}
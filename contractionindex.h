@@ -0,0 +1,144 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef CONTRACTIONINDEX_H
+#define CONTRACTIONINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * A contraction hierarchy for cell to cell route costs in a solved maze.
+ *
+ * Once testForSolution() says the maze is solved its walls will not change,
+ * yet a tool may still want thousands of route costs from it: other goals,
+ * restarts after a crash, return runs. A flood answers one target at a time
+ * and costs the same however few cells are wanted. The index does the work
+ * once and then answers each query with two small searches.
+ *
+ * The costs are exactly those of DiagonalFlood, the exact form of the
+ * runlength costs: query(start, target) is the routeCost(start) that a
+ * diagonal flood from the target would give. The graph is the one that
+ * flood searches, with a node for each wall a mouse can cross, the
+ * heading it crosses with and how far it has run, and a node for each
+ * cell as a target and as a start.
+ *
+ * build() ranks the nodes, least important first, and takes them out of
+ * the graph one at a time. When a node goes, any route through it that
+ * a short witness search cannot match is kept as a shortcut edge between
+ * its neighbours. A query searches upwards in rank from both ends and the
+ * cheapest meeting point gives the cost. The nodes that would need too
+ * many shortcuts stay in the graph as a core that both searches cross
+ * freely. Contest mazes build in a few hundred milliseconds at most and
+ * have a small core, but a maze with large open areas has a large core,
+ * builds in seconds and answers no faster than a flood. The costs depend
+ * on the runlength tables of the maze when the index is built.
+ *
+ * The query graph can be saved as bytes or to a file to keep next to the
+ * .maz file. It holds a hash of the walls and of the cost tables, so
+ * matches() can tell whether a stored index still fits a maze.
+ */
+class ContractionIndex {
+ public:
+  enum FileResult {
+    INDEX_SUCCESS = 0,
+    INDEX_READ_ERROR,
+    INDEX_WRITE_ERROR,
+  };
+
+  static const int MAX_CELLS = 1024;
+  static const uint16_t FILE_VERSION = 1;
+
+  /// build the index from the walls of the maze under the mask, with the runlength costs of the maze
+  void build(const Maze &maze, uint8_t open_close_mask = CLOSED_MASK);
+  bool isBuilt() const;
+  /// true if the index was built from these walls under this mask and with the runlength costs of the maze
+  bool matches(const Maze &maze, uint8_t open_close_mask = CLOSED_MASK) const;
+
+  /// The cost of the best route from start to target, as DiagonalFlood::routeCost() gives after a flood
+  /// from the target. Zero if they are the same cell and MAX_COST if there is no route.
+  uint32_t query(uint16_t start, uint16_t target);
+
+  uint16_t width() const;
+  int nodeCount() const;
+  /// the edges kept for the queries, shortcuts included
+  int edgeCount() const;
+  /// the shortcut edges added by build()
+  int shortcutCount() const;
+  /// the nodes settled by both searches of the most recent query
+  int searchSpace() const;
+
+  /// the query graph in a form that can be stored
+  void save(std::vector<uint8_t> &data) const;
+  /// Replace the index with one saved by save(). Returns false, leaving no index, if the data is not a
+  /// complete index of this version.
+  bool load(const uint8_t *data, size_t size);
+  int writeFile(const char *fileName) const;
+  int readFile(const char *fileName);
+
+ private:
+  /// an edge out of a node, or into it for the downward lists
+  struct Arc {
+    uint32_t node;
+    uint32_t cost;
+  };
+
+  uint16_t mWidth = 0;
+  int mNodeCount = 0;
+  uint8_t mMask = CLOSED_MASK;
+  uint32_t mWallHash = 0;
+  uint32_t mCostHash = 0;
+  int mShortcuts = 0;
+  /// for each node the edges to higher ranked nodes, from mUp[mUpFirst[node]]
+  std::vector<uint32_t> mUpFirst;
+  std::vector<Arc> mUp;
+  /// for each node the edges into it from higher ranked nodes
+  std::vector<uint32_t> mDownFirst;
+  std::vector<Arc> mDown;
+
+  /// the query searches. The per-node data is marked with a search number rather than cleared.
+  std::vector<uint32_t> mForwardCost;
+  std::vector<uint32_t> mBackwardCost;
+  std::vector<uint16_t> mForwardSearch;
+  std::vector<uint16_t> mBackwardSearch;
+  uint16_t mSearchNumber = 0;
+  std::vector<uint64_t> mForwardQueue;
+  std::vector<uint64_t> mBackwardQueue;
+  int mSearchSpace = 0;
+
+  int cellCount() const;
+  int sourceNode(uint16_t cell) const;
+  int sinkNode(uint16_t cell) const;
+  static uint32_t wallHash(const Maze &maze, uint8_t open_close_mask);
+  static uint32_t costHash(const Maze &maze);
+  /// size the query data for the graph once it has been built or loaded
+  void prepareSearches();
+};
+
+#endif  // CONTRACTIONINDEX_H
@@ -0,0 +1,458 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "corridorgraph.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include "floodengine.h"
+#include "maze.h"
+#include "mazegeometry.h"
+
+/// the start of a route is recorded with this in place of the state it came from
+static const uint32_t START_STATE = 0xFFFF;
+/// the start of a route that begins at a node has no edge
+static const uint32_t NO_START_EDGE = 0x7FFF;
+static const int HEADINGS = 5;
+
+static uint32_t packFrom(uint32_t state, uint32_t edge, bool forward) {
+  return state << 16 | edge << 1 | (forward ? 1 : 0);
+}
+
+CorridorGraph::CorridorGraph() {
+  for (int cell = 0; cell < MAX_CELLS; cell++) {
+    mExits[cell] = 0;
+    mNode[cell] = NO_NODE;
+    mEdgeOf[cell] = NO_EDGE;
+  }
+}
+
+const CorridorGraph::Counters &CorridorGraph::counters() const {
+  return mCounters;
+}
+
+void CorridorGraph::resetCounters() {
+  mCounters = Counters();
+}
+
+bool CorridorGraph::isValid() const {
+  return mValid && mChangeCount == 0;
+}
+
+void CorridorGraph::invalidate() {
+  mValid = false;
+  mChangeCount = 0;
+}
+
+void CorridorGraph::wallChanged(uint16_t cell, uint8_t direction) {
+  if (!mValid) {
+    return;
+  }
+  if (mChangeCount >= MAX_CHANGES) {
+    invalidate();
+    return;
+  }
+  mChanges[mChangeCount].cell = cell;
+  mChanges[mChangeCount].direction = direction;
+  mChangeCount++;
+}
+
+int CorridorGraph::cellCount() const {
+  return mWidth * mWidth;
+}
+
+int CorridorGraph::nodeCount() const {
+  return (int)mNodeCell.size();
+}
+
+int CorridorGraph::edgeCount() const {
+  return (int)mEdges.size();
+}
+
+uint16_t CorridorGraph::node(uint16_t cell) const {
+  return mNode[cell];
+}
+
+/// A wall closed from either side is closed, so every corridor can be followed both ways
+uint8_t CorridorGraph::exitsOf(const Maze &maze, uint16_t cell) const {
+  const RuntimeWidth geometry(mWidth);
+  uint8_t exits = 0;
+  for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+    uint16_t next = geometry.neighbour(cell, dir);
+    if (!(maze.getXWalls(cell) & (mMask << dir)) && !(maze.getXWalls(next) & (mMask << Maze::opposite(dir)))) {
+      exits |= (uint8_t)(1 << dir);
+    }
+  }
+  return exits;
+}
+
+/*
+ * Only the exits of the cells either side of a logged wall can have
+ * changed. If none of them has, the graph still describes the maze.
+ */
+void CorridorGraph::update(const Maze &maze, int open_close_mask) {
+  if (mValid && open_close_mask == mMask && maze.width() == mWidth) {
+    bool changed = false;
+    const RuntimeWidth geometry(mWidth);
+    for (int i = 0; i < mChangeCount && !changed; i++) {
+      uint16_t cell = mChanges[i].cell;
+      uint16_t next = geometry.neighbour(cell, mChanges[i].direction);
+      changed = exitsOf(maze, cell) != mExits[cell] || exitsOf(maze, next) != mExits[next];
+    }
+    mChangeCount = 0;
+    if (!changed) {
+      mCounters.reuses++;
+      return;
+    }
+  }
+  mMask = open_close_mask;
+  mWidth = maze.width();
+  build(maze);
+  mValid = true;
+  mChangeCount = 0;
+}
+
+void CorridorGraph::addNode(uint16_t cell) {
+  mNode[cell] = (uint16_t)mNodeCell.size();
+  mNodeCell.push_back(cell);
+  mNodeEdges.insert(mNodeEdges.end(), 4, (uint16_t)NO_EDGE);
+}
+
+void CorridorGraph::addEdge(uint16_t node, uint8_t exit) {
+  const RuntimeWidth geometry(mWidth);
+  const auto id = (uint16_t)mEdges.size();
+  Edge edge{};
+  edge.from = node;
+  edge.fromExit = exit;
+  edge.firstCell = (uint16_t)mCorridorCells.size();
+  uint8_t dir = exit;
+  uint16_t cell = geometry.neighbour(mNodeCell[node], exit);
+  uint16_t length = 1;
+  uint16_t turns = 0;
+  while (mNode[cell] == NO_NODE) {
+    // a corridor cell has two exits, one of them the way in
+    uint8_t back = Maze::opposite(dir);
+    uint8_t ahead = NORTH;
+    while (ahead == back || !(mExits[cell] & (1 << ahead))) {
+      ahead++;
+    }
+    mEdgeOf[cell] = id;
+    mPosition[cell] = length;
+    mBackward[cell] = back;
+    mForward[cell] = ahead;
+    mCorridorCells.push_back(cell);
+    turns += ahead != dir;
+    dir = ahead;
+    cell = geometry.neighbour(cell, dir);
+    length++;
+  }
+  edge.to = mNode[cell];
+  edge.toExit = Maze::opposite(dir);
+  edge.lastStep = dir;
+  edge.length = length;
+  edge.turns = turns;
+  mEdges.push_back(edge);
+  mNodeEdges[node * 4 + exit] = id;
+  mNodeEdges[edge.to * 4 + edge.toExit] = id;
+}
+
+/*
+ * Every cell without exactly two exits is a node. The corridors are found
+ * by following each unused exit of each node to the next node. Any cell
+ * left over is on a ring with no junction, which is cut by making the
+ * cell a node and following the ring from it.
+ */
+void CorridorGraph::build(const Maze &maze) {
+  mCounters.builds++;
+  const uint16_t numCells = maze.numCells();
+  mNodeCell.clear();
+  mNodeEdges.clear();
+  mEdges.clear();
+  mCorridorCells.clear();
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    mExits[cell] = exitsOf(maze, cell);
+    mNode[cell] = NO_NODE;
+    mEdgeOf[cell] = NO_EDGE;
+  }
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    uint8_t exits = mExits[cell];
+    int degree = (exits & 1) + ((exits >> 1) & 1) + ((exits >> 2) & 1) + ((exits >> 3) & 1);
+    if (degree != 2) {
+      addNode(cell);
+    }
+  }
+  auto addEdges = [&](uint16_t node) {
+    for (uint8_t exit = NORTH; exit <= WEST; exit++) {
+      if ((mExits[mNodeCell[node]] & (1 << exit)) && mNodeEdges[node * 4 + exit] == NO_EDGE) {
+        addEdge(node, exit);
+      }
+    }
+  };
+  const auto junctions = (uint16_t)mNodeCell.size();
+  for (uint16_t node = 0; node < junctions; node++) {
+    addEdges(node);
+  }
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    if (mNode[cell] == NO_NODE && mEdgeOf[cell] == NO_EDGE) {
+      addNode(cell);
+      addEdges(mNode[cell]);
+    }
+  }
+}
+
+uint16_t CorridorGraph::edgeFrom(uint16_t node, uint8_t exit, bool &forward) const {
+  uint16_t id = mNodeEdges[node * 4 + exit];
+  if (id != NO_EDGE) {
+    forward = mEdges[id].from == node && mEdges[id].fromExit == exit;
+  }
+  return id;
+}
+
+/// step 1 leaves the node the edge is followed from and step length arrives at the other
+uint8_t CorridorGraph::stepDirection(const Edge &edge, bool forward, int step) const {
+  if (step == 1) {
+    return forward ? edge.fromExit : edge.toExit;
+  }
+  if (forward) {
+    return mForward[mCorridorCells[edge.firstCell + step - 2]];
+  }
+  return mBackward[mCorridorCells[edge.firstCell + edge.length - step]];
+}
+
+uint32_t CorridorGraph::walkCost(const Edge &edge, bool forward, int first, int last, uint8_t heading,
+                                 uint16_t cornerWeight) const {
+  uint32_t cost = 0;
+  for (int step = first; step <= last; step++) {
+    uint8_t dir = stepDirection(edge, forward, step);
+    cost += (heading == NO_HEADING || heading == dir) ? WeightedCost::AHEAD_COST : cornerWeight;
+    heading = dir;
+  }
+  return cost;
+}
+
+/*
+ * Dijkstra over the nodes with each corridor as one step of its length.
+ * A target inside a corridor seeds both ends of it. Each corridor cell
+ * then takes the cheaper of the ways in from its two ends, or the way
+ * along the corridor to a target inside it.
+ */
+uint16_t CorridorGraph::flood(Maze &maze, uint16_t target, int open_close_mask) {
+  update(maze, open_close_mask);
+  maze.mOpenCloseMask = open_close_mask;
+  mNodeCost.assign(mNodeCell.size(), UINT32_MAX);
+  mQueue.clear();
+  auto seed = [&](uint16_t node, uint32_t cost) {
+    if (cost < mNodeCost[node]) {
+      mNodeCost[node] = cost;
+      mQueue.push_back((uint64_t)cost << 32 | node);
+      std::push_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+    }
+  };
+  const uint16_t targetEdge = mEdgeOf[target];
+  if (mNode[target] != NO_NODE) {
+    seed(mNode[target], 0);
+  } else {
+    seed(mEdges[targetEdge].from, mPosition[target]);
+    seed(mEdges[targetEdge].to, (uint32_t)(mEdges[targetEdge].length - mPosition[target]));
+  }
+  while (!mQueue.empty()) {
+    std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+    uint64_t entry = mQueue.back();
+    mQueue.pop_back();
+    auto node = (uint16_t)(entry & 0xFFFF);
+    auto cost = (uint32_t)(entry >> 32);
+    if (cost != mNodeCost[node]) {
+      continue;  // a cheaper way to this node was found after this entry was queued
+    }
+    mCounters.nodeExpansions++;
+    for (uint8_t exit = NORTH; exit <= WEST; exit++) {
+      bool forward = true;
+      uint16_t id = edgeFrom(node, exit, forward);
+      if (id != NO_EDGE) {
+        seed(forward ? mEdges[id].to : mEdges[id].from, cost + mEdges[id].length);
+      }
+    }
+  }
+  for (size_t node = 0; node < mNodeCell.size(); node++) {
+    maze.mCost[mNodeCell[node]] = (uint16_t)std::min<uint32_t>(mNodeCost[node], MAX_COST);
+  }
+  for (uint16_t id = 0; id < mEdges.size(); id++) {
+    const Edge &edge = mEdges[id];
+    const uint32_t fromCost = mNodeCost[edge.from];
+    const uint32_t toCost = mNodeCost[edge.to];
+    for (int position = 1; position < edge.length; position++) {
+      uint32_t cost = std::min(fromCost == UINT32_MAX ? UINT32_MAX : fromCost + position,
+                               toCost == UINT32_MAX ? UINT32_MAX : toCost + edge.length - position);
+      if (id == targetEdge) {
+        cost = std::min<uint32_t>(cost, (uint32_t)std::abs(position - mPosition[target]));
+      }
+      maze.mCost[mCorridorCells[edge.firstCell + position - 1]] = (uint16_t)std::min<uint32_t>(cost, MAX_COST);
+    }
+  }
+  maze.updateDirections(target);
+  return maze.mCost[0];
+}
+
+void CorridorGraph::relax(int state, uint32_t cost, uint32_t from) {
+  if (cost >= mStateCost[state]) {
+    return;
+  }
+  mStateCost[state] = cost;
+  mStateFrom[state] = from;
+  mQueue.push_back((uint64_t)cost << 32 | (uint32_t)state);
+  std::push_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+}
+
+/*
+ * Dijkstra over (node, heading) states. A start or target inside a
+ * corridor is reached by walking part of that corridor, so the best way
+ * to the target is kept as a candidate and the search stops once no
+ * state in the queue is cheaper. The route is then put together from the
+ * edges the states were reached by.
+ */
+uint32_t CorridorGraph::route(const Maze &maze, uint16_t start, uint16_t target, int open_close_mask,
+                              uint16_t cornerWeight, std::vector<uint8_t> &route) {
+  update(maze, open_close_mask);
+  route.clear();
+  if (start == target) {
+    return 0;
+  }
+  mStateCost.assign(mNodeCell.size() * HEADINGS, UINT32_MAX);
+  mStateFrom.assign(mNodeCell.size() * HEADINGS, 0);
+  mQueue.clear();
+  const uint16_t targetNode = mNode[target];
+  const uint16_t targetEdge = mEdgeOf[target];
+  const int targetPosition = targetNode == NO_NODE ? mPosition[target] : 0;
+  // the best route found so far: the state it leaves the graph from, then a part of an edge
+  uint32_t best = UINT32_MAX;
+  uint32_t bestState = START_STATE;
+  uint16_t bestEdge = NO_EDGE;
+  bool bestForward = true;
+  int bestFirst = 0;
+  int bestLast = 0;
+  auto offer = [&](uint32_t cost, uint32_t state, uint16_t edge, bool forward, int first, int last) {
+    if (cost < best) {
+      best = cost;
+      bestState = state;
+      bestEdge = edge;
+      bestForward = forward;
+      bestFirst = first;
+      bestLast = last;
+    }
+  };
+  if (mNode[start] != NO_NODE) {
+    relax(mNode[start] * HEADINGS + NO_HEADING, 0, packFrom(START_STATE, NO_START_EDGE, true));
+  } else {
+    const uint16_t id = mEdgeOf[start];
+    const Edge &edge = mEdges[id];
+    const int position = mPosition[start];
+    relax(edge.to * HEADINGS + edge.lastStep,
+          walkCost(edge, true, position + 1, edge.length, NO_HEADING, cornerWeight),
+          packFrom(START_STATE, id, true));
+    relax(edge.from * HEADINGS + Maze::opposite(edge.fromExit),
+          walkCost(edge, false, edge.length - position + 1, edge.length, NO_HEADING, cornerWeight),
+          packFrom(START_STATE, id, false));
+    if (id == targetEdge && targetPosition > position) {
+      offer(walkCost(edge, true, position + 1, targetPosition, NO_HEADING, cornerWeight), START_STATE, id, true,
+            position + 1, targetPosition);
+    } else if (id == targetEdge) {
+      offer(walkCost(edge, false, edge.length - position + 1, edge.length - targetPosition, NO_HEADING, cornerWeight),
+            START_STATE, id, false, edge.length - position + 1, edge.length - targetPosition);
+    }
+  }
+  while (!mQueue.empty()) {
+    std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+    uint64_t entry = mQueue.back();
+    mQueue.pop_back();
+    auto state = (uint32_t)(entry & 0xFFFFFFFF);
+    auto cost = (uint32_t)(entry >> 32);
+    if (cost != mStateCost[state]) {
+      continue;  // a cheaper way to this state was found after this entry was queued
+    }
+    if (cost >= best) {
+      break;
+    }
+    mCounters.nodeExpansions++;
+    const auto node = (uint16_t)(state / HEADINGS);
+    const auto heading = (uint8_t)(state % HEADINGS);
+    if (node == targetNode) {
+      offer(cost, state, NO_EDGE, true, 0, 0);
+      continue;
+    }
+    for (uint8_t exit = NORTH; exit <= WEST; exit++) {
+      bool forward = true;
+      uint16_t id = edgeFrom(node, exit, forward);
+      if (id == NO_EDGE) {
+        continue;
+      }
+      const Edge &edge = mEdges[id];
+      if (id == targetEdge) {
+        int last = forward ? targetPosition : edge.length - targetPosition;
+        offer(cost + walkCost(edge, forward, 1, last, heading, cornerWeight), state, id, forward, 1, last);
+      }
+      uint32_t stepCost = (heading == NO_HEADING || heading == exit) ? WeightedCost::AHEAD_COST : cornerWeight;
+      uint32_t along = (uint32_t)(edge.length - 1 - edge.turns) * WeightedCost::AHEAD_COST + edge.turns * cornerWeight;
+      uint16_t next = forward ? edge.to : edge.from;
+      uint8_t arrival = forward ? edge.lastStep : Maze::opposite(edge.fromExit);
+      relax(next * HEADINGS + arrival, cost + stepCost + along, packFrom(state, id, forward));
+    }
+  }
+  if (best == UINT32_MAX) {
+    return MAX_COST;
+  }
+  // the pieces of the route from the target back to the start
+  struct Piece {
+    uint16_t edge;
+    bool forward;
+    int first;
+    int last;
+  };
+  std::vector<Piece> pieces;
+  if (bestEdge != NO_EDGE) {
+    pieces.push_back({bestEdge, bestForward, bestFirst, bestLast});
+  }
+  for (uint32_t state = bestState; state != START_STATE;) {
+    uint32_t from = mStateFrom[state];
+    auto id = (uint16_t)((from >> 1) & 0x7FFF);
+    bool forward = (from & 1) != 0;
+    state = from >> 16;
+    if (id == NO_START_EDGE) {
+      break;
+    }
+    const Edge &edge = mEdges[id];
+    int first = 1;
+    if (state == START_STATE) {
+      // the part of the corridor after the start
+      first = forward ? mPosition[start] + 1 : edge.length - mPosition[start] + 1;
+    }
+    pieces.push_back({id, forward, first, edge.length});
+  }
+  for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece) {
+    for (int step = piece->first; step <= piece->last; step++) {
+      route.push_back(stepDirection(mEdges[piece->edge], piece->forward, step));
+    }
+  }
+  return best;
+}
@@ -0,0 +1,176 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef CORRIDORGRAPH_H
+#define CORRIDORGRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * The maze contracted to a graph of junctions and corridors.
+ *
+ * Most cells of a contest maze have exactly two exits. They are the inside
+ * of a corridor and a flood gains nothing by visiting them one at a time.
+ * A CorridorGraph keeps every other cell - junctions, dead ends and closed
+ * cells - as a node and joins the nodes with one edge per corridor. Each
+ * edge holds the number of steps along it, the number of turns inside it
+ * and the cells it passes through, so both the manhattan and the weighted
+ * costs of a corridor are known without walking it. A ring with no
+ * junction at all gets one of its cells made into a node.
+ *
+ * A graph attached to a Maze with Maze::setCorridorGraph() is used for
+ * every manhattan flood. The nodes are flooded with Dijkstra and the
+ * corridor cells are then filled in from the two ends of each corridor,
+ * which gives exactly the costs of a full flood. The directions are then
+ * worked out by the maze as usual so they are the same as well.
+ *
+ * route() finds the best route between two cells under the weighted flood
+ * costs, AHEAD_COST for each step straight on and the corner weight for
+ * each step that turns. Its states are a node and the heading the mouse
+ * arrived with so, unlike the weighted flood, the cost is exact.
+ *
+ * The maze tells the graph about every wall that changes. The graph is
+ * only rebuilt, on the next flood or route, if one of those changes
+ * altered the exits of a cell under the mask it was built for. Changing
+ * the mask or the maze size, load() and clearData() also rebuild it. A
+ * graph that is not attached hears of no changes, so call invalidate()
+ * after changing the walls.
+ *
+ * About 30k bytes are held for a 32x32 maze.
+ */
+class CorridorGraph {
+ public:
+  /// running totals so that the work saved can be measured
+  struct Counters {
+    /// times the graph was built from the maze
+    uint32_t builds = 0;
+    /// floods and routes that found the graph up to date
+    uint32_t reuses = 0;
+    /// nodes taken from the queue, summed over all floods and routes
+    uint32_t nodeExpansions = 0;
+  };
+
+  static const int MAX_CELLS = 1024;
+  static const int MAX_CHANGES = 64;
+  static const uint16_t NO_NODE = UINT16_MAX;
+
+  CorridorGraph();
+
+  /// rebuild the graph if the walls, mask or maze size have changed since it was built
+  void update(const Maze &maze, int open_close_mask);
+  /// a manhattan flood of the maze for the given target, leaving the costs and directions in the maze
+  uint16_t flood(Maze &maze, uint16_t target, int open_close_mask);
+  /// The cost of the best route from start to target with the weighted flood step costs. The first step
+  /// costs AHEAD_COST. The directions of the steps are put in route. MAX_COST if there is no route.
+  uint32_t route(const Maze &maze, uint16_t start, uint16_t target, int open_close_mask, uint16_t cornerWeight,
+                 std::vector<uint8_t> &route);
+  /// called by the maze whenever the wall or seen flag between a cell and its neighbour changes
+  void wallChanged(uint16_t cell, uint8_t direction);
+  /// forget the graph so that the next flood or route builds it again
+  void invalidate();
+  /// true if the graph was built and no change since has been logged
+  bool isValid() const;
+
+  int cellCount() const;
+  int nodeCount() const;
+  int edgeCount() const;
+  /// the node index of the cell or NO_NODE if it is inside a corridor
+  uint16_t node(uint16_t cell) const;
+
+  const Counters &counters() const;
+  void resetCounters();
+
+ private:
+  /// a corridor from one node to another, or back to the same node
+  struct Edge {
+    uint16_t from;
+    uint16_t to;
+    /// the exit of the from node it starts by and the exit of the to node it ends by
+    uint8_t fromExit;
+    uint8_t toExit;
+    /// the direction of the last step, so the heading on arrival at the to node
+    uint8_t lastStep;
+    /// steps from node to node and the steps among them that turn
+    uint16_t length;
+    uint16_t turns;
+    /// where the length - 1 cells inside the corridor start in mCorridorCells
+    uint16_t firstCell;
+  };
+
+  struct WallChange {
+    uint16_t cell;
+    uint8_t direction;
+  };
+
+  static const uint8_t NO_EXIT = 0xFF;
+  static const uint16_t NO_EDGE = UINT16_MAX;
+  /// the heading given to a route before its first step
+  static const uint8_t NO_HEADING = 4;
+
+  uint8_t mExits[MAX_CELLS];
+  /// the node index of each node cell and NO_NODE for the corridor cells
+  uint16_t mNode[MAX_CELLS];
+  /// for corridor cells, the edge it is on and how many steps it is from the from end
+  uint16_t mEdgeOf[MAX_CELLS];
+  uint16_t mPosition[MAX_CELLS];
+  /// for corridor cells, the exit towards the to end and the exit towards the from end
+  uint8_t mForward[MAX_CELLS];
+  uint8_t mBackward[MAX_CELLS];
+  std::vector<uint16_t> mNodeCell;
+  /// the edge leaving each node by each exit, four to a node
+  std::vector<uint16_t> mNodeEdges;
+  std::vector<Edge> mEdges;
+  std::vector<uint16_t> mCorridorCells;
+  /// working storage for the floods and routes
+  std::vector<uint32_t> mNodeCost;
+  std::vector<uint32_t> mStateCost;
+  std::vector<uint32_t> mStateFrom;
+  std::vector<uint64_t> mQueue;
+  WallChange mChanges[MAX_CHANGES];
+  int mChangeCount = 0;
+  bool mValid = false;
+  int mMask = OPEN_MASK;
+  uint16_t mWidth = 0;
+  Counters mCounters;
+
+  void build(const Maze &maze);
+  uint8_t exitsOf(const Maze &maze, uint16_t cell) const;
+  void addNode(uint16_t cell);
+  /// follow the corridor out of a node by the exit and add it as an edge
+  void addEdge(uint16_t node, uint8_t exit);
+  /// the edge leaving a node by an exit and whether it is followed from its from end
+  uint16_t edgeFrom(uint16_t node, uint8_t exit, bool &forward) const;
+  /// the direction of each step along an edge in either direction
+  uint8_t stepDirection(const Edge &edge, bool forward, int step) const;
+  /// the weighted cost of the steps first to last of an edge, after arriving with the heading
+  uint32_t walkCost(const Edge &edge, bool forward, int first, int last, uint8_t heading, uint16_t cornerWeight) const;
+  void relax(int state, uint32_t cost, uint32_t from);
+};
+
+#endif  // CORRIDORGRAPH_H
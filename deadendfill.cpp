@@ -0,0 +1,232 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "deadendfill.h"
+#include <cstring>
+#include "maze.h"
+#include "mazegeometry.h"
+
+DeadEndFill::DeadEndFill() {
+  memset(mWalls, 0, sizeof(mWalls));
+  memset(mExits, 0, sizeof(mExits));
+  memset(mFilled, 0, sizeof(mFilled));
+  memset(mKept, 0, sizeof(mKept));
+}
+
+const DeadEndFill::Counters &DeadEndFill::counters() const {
+  return mCounters;
+}
+
+void DeadEndFill::resetCounters() {
+  mCounters = Counters();
+}
+
+bool DeadEndFill::isValid() const {
+  return mValid && mChangeCount == 0;
+}
+
+void DeadEndFill::invalidate() {
+  mValid = false;
+  mChangeCount = 0;
+}
+
+bool DeadEndFill::isFilled(uint16_t cell) const {
+  return mValid && test(mFilled, cell);
+}
+
+int DeadEndFill::filledCount() const {
+  return mValid ? mFilledCount : 0;
+}
+
+const uint8_t *DeadEndFill::walls() const {
+  return mWalls;
+}
+
+int DeadEndFill::mask() const {
+  return mMask;
+}
+
+bool DeadEndFill::isKept(uint16_t cell) const {
+  return test(mKept, cell);
+}
+
+void DeadEndFill::logChange(uint16_t cell, uint8_t direction) {
+  if (!mValid) {
+    return;
+  }
+  if (mChangeCount >= MAX_CHANGES) {
+    invalidate();
+    return;
+  }
+  mChanges[mChangeCount].cell = cell;
+  mChanges[mChangeCount].direction = direction;
+  mChangeCount++;
+}
+
+void DeadEndFill::wallChanged(uint16_t cell, uint8_t direction) {
+  logChange(cell, direction);
+}
+
+/// keeping a cell that is already filled would mean emptying it and its neighbours again
+void DeadEndFill::keep(uint16_t cell) {
+  if (test(mKept, cell)) {
+    return;
+  }
+  set(mKept, cell);
+  if (mValid && test(mFilled, cell)) {
+    invalidate();
+  }
+}
+
+void DeadEndFill::release(uint16_t cell) {
+  if (!test(mKept, cell)) {
+    return;
+  }
+  clear(mKept, cell);
+  logChange(cell, RELEASED);
+}
+
+bool DeadEndFill::isAlwaysKept(const Maze &maze, uint16_t cell) const {
+  return cell == 0 || test(mKept, cell) || maze.goalContains(cell);
+}
+
+uint8_t DeadEndFill::exitsOf(const Maze &maze, uint16_t cell) const {
+  const uint8_t walls = maze.getXWalls(cell);
+  uint8_t exits = 0;
+  for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+    if (!(walls & (mMask << dir))) {
+      exits |= (uint8_t)(1 << dir);
+    }
+  }
+  return exits;
+}
+
+void DeadEndFill::refreshWalls(const Maze &maze, uint16_t cell) {
+  if (test(mFilled, cell)) {
+    mWalls[cell] = (uint8_t)(maze.getXWalls(cell) | WALL_NORTH | WALL_EAST | WALL_SOUTH | WALL_WEST);
+    return;
+  }
+  const RuntimeWidth geometry(mWidth);
+  uint8_t walls = maze.getXWalls(cell);
+  for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+    if (test(mFilled, geometry.neighbour(cell, dir))) {
+      walls |= (uint8_t)(1 << dir);
+    }
+  }
+  mWalls[cell] = walls;
+}
+
+/*
+ * A pending cell is filled if it has at most one exit to a cell that is
+ * not filled. Its neighbours are then pending in case that was the exit
+ * that kept them open.
+ */
+void DeadEndFill::fillPending(const Maze &maze) {
+  const RuntimeWidth geometry(mWidth);
+  while (!mPending.empty()) {
+    uint16_t cell = mPending.back();
+    mPending.pop_back();
+    mCounters.cellsExamined++;
+    if (test(mFilled, cell) || isAlwaysKept(maze, cell)) {
+      continue;
+    }
+    int openExits = 0;
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      if ((mExits[cell] & (1 << dir)) && !test(mFilled, geometry.neighbour(cell, dir))) {
+        openExits++;
+      }
+    }
+    if (openExits > 1) {
+      continue;
+    }
+    set(mFilled, cell);
+    mFilledCount++;
+    refreshWalls(maze, cell);
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      uint16_t next = geometry.neighbour(cell, dir);
+      mWalls[next] |= (uint8_t)(1 << Maze::opposite(dir));
+      mPending.push_back(next);
+    }
+  }
+}
+
+void DeadEndFill::fill(const Maze &maze) {
+  mCounters.fills++;
+  mWidth = maze.width();
+  const uint16_t numCells = maze.numCells();
+  memset(mFilled, 0, sizeof(mFilled));
+  mFilledCount = 0;
+  mPending.clear();
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    mWalls[cell] = maze.getXWalls(cell);
+    mExits[cell] = exitsOf(maze, cell);
+    mPending.push_back((uint16_t)(numCells - 1 - cell));
+  }
+  fillPending(maze);
+}
+
+/*
+ * Closing a wall can only make more dead ends, so the cells either side
+ * of it are looked at again. Opening one may empty cells that were filled
+ * and only a fresh fill can find which.
+ */
+void DeadEndFill::update(const Maze &maze, int open_close_mask) {
+  if (!mValid || open_close_mask != mMask || maze.width() != mWidth) {
+    mMask = open_close_mask;
+    fill(maze);
+    mValid = true;
+    mChangeCount = 0;
+    return;
+  }
+  if (mChangeCount == 0) {
+    return;
+  }
+  const RuntimeWidth geometry(mWidth);
+  mPending.clear();
+  for (int i = 0; i < mChangeCount; i++) {
+    const uint16_t cell = mChanges[i].cell;
+    if (mChanges[i].direction == RELEASED) {
+      mPending.push_back(cell);
+      continue;
+    }
+    const uint16_t next = geometry.neighbour(cell, mChanges[i].direction);
+    const uint8_t cellExits = exitsOf(maze, cell);
+    const uint8_t nextExits = exitsOf(maze, next);
+    if ((cellExits & ~mExits[cell]) || (nextExits & ~mExits[next])) {
+      mChangeCount = 0;
+      fill(maze);
+      return;
+    }
+    mExits[cell] = cellExits;
+    mExits[next] = nextExits;
+    refreshWalls(maze, cell);
+    refreshWalls(maze, next);
+    mPending.push_back(cell);
+    mPending.push_back(next);
+  }
+  mChangeCount = 0;
+  mCounters.incrementalUpdates++;
+  fillPending(maze);
+}
@@ -0,0 +1,142 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef DEADENDFILL_H
+#define DEADENDFILL_H
+
+#include <cstdint>
+#include <vector>
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * Dead-end filling for the floods.
+ *
+ * A cell with one exit or none is a dead end. No route between two other
+ * cells can pass through it, and once it is filled in the cell that led
+ * to it may become a dead end in turn. Filling repeatedly leaves only the
+ * cells that can be on a route. Cell 0, the goal area and any cell passed
+ * to keep() are never filled, nor is anything on the way to them.
+ *
+ * A DeadEndFill attached with Maze::setDeadEndFill() gives the manhattan,
+ * weighted, runlength and direction floods a copy of the walls in which
+ * every filled cell is walled in. The floods never reach those cells and
+ * leave them at MAX_COST with INVALID_DIRECTION. Every other cell gets the
+ * same cost as it would without the fill, because a detour into a dead end
+ * always comes back out through the cell it went in by. The one exception
+ * is the runlength flood on the linear queue, which settles a cell when it
+ * is first reached and so can settle a few cells at another cost once the
+ * queue no longer holds the filled cells. A flood whose target has been
+ * filled uses the ordinary walls instead.
+ *
+ * The maze tells the fill about every wall that changes. While walls are
+ * only being closed under the mask, as they are in a search with the open
+ * mask, the fill is brought up to date by filling out from the cells either
+ * side of each change. A wall that opens, a change of mask or maze size,
+ * load() and clearData() start the fill again from scratch, as does a
+ * change to the goal area followed by invalidate().
+ */
+class DeadEndFill {
+ public:
+  /// running totals so that the work saved can be measured
+  struct Counters {
+    /// fills started from scratch
+    uint32_t fills = 0;
+    /// updates made by filling out from the changed cells
+    uint32_t incrementalUpdates = 0;
+    /// cells examined, summed over all fills and updates
+    uint32_t cellsExamined = 0;
+  };
+
+  static const int MAX_CELLS = 1024;
+  static const int MAX_CHANGES = 64;
+
+  DeadEndFill();
+
+  /// bring the fill up to date with the walls of the maze under the given mask
+  void update(const Maze &maze, int open_close_mask);
+  /// never fill the cell or the cells that lead to it
+  void keep(uint16_t cell);
+  /// let the cell be filled again. Cell 0 and the goal area are always kept.
+  void release(uint16_t cell);
+  bool isKept(uint16_t cell) const;
+  /// called by the maze whenever the wall or seen flag between a cell and its neighbour changes
+  void wallChanged(uint16_t cell, uint8_t direction);
+  /// forget the fill so that the next update starts from scratch
+  void invalidate();
+  /// true if the fill was made and nothing has changed since
+  bool isValid() const;
+
+  bool isFilled(uint16_t cell) const;
+  int filledCount() const;
+  /// the walls of the maze with every filled cell walled in, as of the last update
+  const uint8_t *walls() const;
+  /// the mask of the last update
+  int mask() const;
+
+  const Counters &counters() const;
+  void resetCounters();
+
+ private:
+  struct Change {
+    uint16_t cell;
+    uint8_t direction;
+  };
+
+  static const int WORDS = MAX_CELLS / 32;
+  /// a change logged by release() rather than by a wall
+  static const uint8_t RELEASED = 0xFF;
+
+  uint8_t mWalls[MAX_CELLS];
+  /// the open exits of each cell under the mask, ignoring the fill
+  uint8_t mExits[MAX_CELLS];
+  uint32_t mFilled[WORDS];
+  uint32_t mKept[WORDS];
+  int mFilledCount = 0;
+  Change mChanges[MAX_CHANGES];
+  int mChangeCount = 0;
+  bool mValid = false;
+  int mMask = OPEN_MASK;
+  uint16_t mWidth = 0;
+  /// cells to look at, which may hold the same cell more than once
+  std::vector<uint16_t> mPending;
+  Counters mCounters;
+
+  static bool test(const uint32_t *bits, uint16_t cell) { return (bits[cell / 32] >> (cell % 32)) & 1; }
+  static void set(uint32_t *bits, uint16_t cell) { bits[cell / 32] |= 1u << (cell % 32); }
+  static void clear(uint32_t *bits, uint16_t cell) { bits[cell / 32] &= ~(1u << (cell % 32)); }
+
+  void logChange(uint16_t cell, uint8_t direction);
+  void fill(const Maze &maze);
+  bool isAlwaysKept(const Maze &maze, uint16_t cell) const;
+  uint8_t exitsOf(const Maze &maze, uint16_t cell) const;
+  /// the walls of the maze for the cell, closed towards any filled neighbour
+  void refreshWalls(const Maze &maze, uint16_t cell);
+  /// fill every pending cell that has become a dead end, then any cell that leaves as a result
+  void fillPending(const Maze &maze);
+};
+
+#endif  // DEADENDFILL_H
@@ -0,0 +1,238 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "diagonalflood.h"
+#include <algorithm>
+#include <functional>
+#include "maze.h"
+#include "mazegeometry.h"
+
+using MazeLib::Direction;
+
+uint8_t DiagonalFlood::pieceHeading(uint8_t entryWall, uint8_t exitWall) {
+  // as in RunLengthCost
+  static const uint8_t headings[4][4] = {
+      {255, 3, 4, 5},
+      {7, 255, 5, 6},
+      {0, 1, 255, 7},
+      {1, 2, 3, 255},
+  };
+  return headings[entryWall][exitWall];
+}
+
+uint8_t DiagonalFlood::nextExitWall(Direction heading, uint8_t exitWall) {
+  if (heading.isOrthogonal()) {
+    return (uint8_t)(heading / 2);
+  }
+  // a diagonal leaves by each of its two walls in turn
+  uint8_t first = (uint8_t)(heading / 2);
+  return exitWall == first ? (uint8_t)((first + 1) % 4) : first;
+}
+
+int DiagonalFlood::turnSize(Direction from, Direction to) {
+  int size = to - from;
+  return size > 4 ? 8 - size : size;
+}
+
+int DiagonalFlood::state(uint16_t cell, uint8_t entryWall, Direction heading) {
+  // a mouse that came in by this wall has a heading within 45 degrees of straight across the cell
+  int across = 2 * ((entryWall + 2) % 4);
+  return (cell * 4 + entryWall) * 3 + (((int)heading - across + 1) & 7);
+}
+
+Direction DiagonalFlood::heading(int state) {
+  int entryWall = (state / 3) % 4;
+  int across = 2 * ((entryWall + 2) % 4);
+  return Direction(across + state % 3 - 1);
+}
+
+uint16_t DiagonalFlood::pieceCost(Direction heading, int runLength) const {
+  int index = std::min(runLength, RunLengthCostTables::LENGTHS - 1);
+  return heading.isOrthogonal() ? mOrthoCosts[index] : mDiagCosts[index];
+}
+
+uint32_t DiagonalFlood::expansions() const {
+  return mExpansions;
+}
+
+void DiagonalFlood::relax(int next, uint32_t cost, int from, int runLength) {
+  if (cost >= mCost[next]) {
+    return;
+  }
+  mCost[next] = cost;
+  mFrom[next] = (uint16_t)from;
+  mRunLength[next] = (uint8_t)runLength;
+  mQueue.push_back((uint64_t)cost << 32 | (uint32_t)next);
+  std::push_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+}
+
+void DiagonalFlood::run(uint16_t cell, uint8_t exitWall, Direction heading, uint32_t cost, int from) {
+  const RuntimeWidth geometry(mWidth);
+  for (int runLength = 1; mExits[cell] & (1 << exitWall); runLength++) {
+    cost += pieceCost(heading, runLength);
+    cell = geometry.neighbour(cell, exitWall);
+    relax(state(cell, (uint8_t)((exitWall + 2) % 4), heading), cost, from, runLength);
+    exitWall = nextExitWall(heading, exitWall);
+  }
+}
+
+uint16_t DiagonalFlood::flood(const Maze &maze, const uint16_t *sources, int sourceCount, uint8_t mask,
+                              uint16_t *cost, uint8_t *direction) {
+  mWidth = maze.width();
+  mOrthoCosts = maze.runLengthCosts().ortho;
+  mDiagCosts = maze.runLengthCosts().diag;
+  const uint16_t numCells = maze.numCells();
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    uint8_t walls = maze.getXWalls(cell);
+    mExits[cell] = 0;
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      if (!(walls & (mask << dir))) {
+        mExits[cell] |= (uint8_t)(1 << dir);
+      }
+    }
+    mIsSource[cell] = false;
+  }
+  const size_t stateCount = (size_t)numCells * STATES_PER_CELL;
+  mCost.assign(stateCount, UINT32_MAX);
+  mFrom.assign(stateCount, (uint16_t)NO_STATE);
+  mRunLength.assign(stateCount, 0);
+  mQueue.clear();
+  mExpansions = 0;
+  for (int i = 0; i < sourceCount; i++) {
+    mIsSource[sources[i]] = true;
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      run(sources[i], exitWall, Direction(2 * exitWall), 0, NO_STATE);
+    }
+  }
+  while (!mQueue.empty()) {
+    std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+    uint64_t entry = mQueue.back();
+    mQueue.pop_back();
+    int here = (int)(entry & 0xFFFFFFFF);
+    uint32_t hereCost = (uint32_t)(entry >> 32);
+    if (hereCost != mCost[here]) {
+      continue;  // a cheaper way to this state was found after this entry was queued
+    }
+    mExpansions++;
+    const uint16_t cell = (uint16_t)(here / STATES_PER_CELL);
+    const uint8_t entryWall = (uint8_t)((here / 3) % 4);
+    const Direction inHeading = heading(here);
+    // going on in the same heading is already covered by the run that ended here
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (exitWall == entryWall || !(mExits[cell] & (1 << exitWall))) {
+        continue;
+      }
+      Direction outHeading(pieceHeading(entryWall, exitWall));
+      if (outHeading != inHeading) {
+        uint32_t turnCost = (uint32_t)turnSize(inHeading, outHeading) * RunLengthCost::TURN_PENALTY;
+        run(cell, exitWall, outHeading, hereCost + turnCost, here);
+      }
+    }
+  }
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    int best = bestState(cell);
+    cost[cell] = best < 0 ? MAX_COST : (uint16_t)std::min<uint32_t>(mCost[best], MAX_COST - 1);
+    direction[cell] = best < 0 ? INVALID_DIRECTION : (uint8_t)((best / 3) % 4);
+  }
+  for (int i = 0; i < sourceCount; i++) {
+    cost[sources[i]] = 0;
+    direction[sources[i]] = NORTH;
+  }
+  traceRoute(cost, direction);
+  return cost[0];
+}
+
+int DiagonalFlood::bestState(uint16_t cell) const {
+  int best = -1;
+  for (int s = cell * STATES_PER_CELL; s < (cell + 1) * STATES_PER_CELL; s++) {
+    if (mCost[s] != UINT32_MAX && (best < 0 || mCost[s] < mCost[best])) {
+      best = s;
+    }
+  }
+  return best;
+}
+
+uint32_t DiagonalFlood::routeCost(uint16_t start) const {
+  if (mIsSource[start]) {
+    return 0;
+  }
+  int best = bestState(start);
+  return best < 0 ? MAX_COST : mCost[best];
+}
+
+/*
+ * Each state records the run that reached it and the state that run set
+ * out from, back to a run out of the target. Those runs, in order and
+ * turned round, are the route.
+ */
+MazeLib::Directions DiagonalFlood::route(uint16_t start) const {
+  MazeLib::Directions headings;
+  int here = bestState(start);
+  if (mIsSource[start] || here < 0) {
+    return headings;
+  }
+  headings.push_back(Direction(2 * ((here / 3) % 4)));
+  for (int s = here; s != NO_STATE; s = mFrom[s]) {
+    headings.insert(headings.end(), mRunLength[s], Direction(heading(s) + 4));
+  }
+  return headings;
+}
+
+/*
+ * The pieces are costed from the target end, as the flood costed them, so
+ * the cost left at each cell of the route is the sum of the pieces after
+ * it. A route that comes back to a cell leaves the direction from the
+ * later visit, so the directions never loop.
+ */
+void DiagonalFlood::traceRoute(uint16_t *cost, uint8_t *direction) const {
+  const MazeLib::Directions headings = route(0);
+  const int last = (int)headings.size() - 1;
+  if (last < 1) {
+    return;
+  }
+  std::vector<uint32_t> pieceCosts(headings.size(), 0);
+  int runLength = 0;
+  for (int i = last; i > 0; i--) {
+    bool turns = i < last && headings[i] != headings[i + 1];
+    runLength = (i == last || turns) ? 1 : runLength + 1;
+    pieceCosts[i] = pieceCost(headings[i], runLength);
+    if (turns) {
+      pieceCosts[i] += (uint32_t)turnSize(headings[i + 1], headings[i]) * RunLengthCost::TURN_PENALTY;
+    }
+  }
+  const RuntimeWidth geometry(mWidth);
+  uint32_t remaining = routeCost(0);
+  uint16_t cell = 0;
+  uint8_t exitWall = (uint8_t)(headings[0] / 2);
+  for (int i = 0; i < last; i++) {
+    if (i > 0) {
+      cell = geometry.neighbour(cell, exitWall);
+      exitWall = nextExitWall(headings[i], exitWall);
+      remaining -= pieceCosts[i];
+    }
+    cost[cell] = (uint16_t)std::min<uint32_t>(remaining, MAX_COST - 1);
+    direction[cell] = exitWall;
+  }
+}
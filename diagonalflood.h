@@ -0,0 +1,122 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef DIAGONALFLOOD_H
+#define DIAGONALFLOOD_H
+
+#include <cstdint>
+#include <vector>
+#include "direction.h"
+
+class Maze;
+
+/*
+ * A flood over the midpoints of the walls rather than the cells.
+ *
+ * A mouse that can run diagonals crosses each cell on a straight line from
+ * the wall it came in by to the wall it leaves by. If the walls are
+ * opposite the line is orthogonal and if they are adjacent it is diagonal.
+ * The route is then a list of these pieces, each with one of the eight
+ * headings of MazeLib::Direction, and runs of the same heading are the
+ * straights and diagonals the mouse actually drives.
+ *
+ * The costs are those of the runlength flood: each piece costs the entry
+ * in the ortho or diag table for its place in the run and each change of
+ * heading costs RunLengthCost::TURN_PENALTY per 45 degrees. The runlength
+ * flood keeps one run per cell and so only estimates this. Here every
+ * state is a wall and the heading the mouse crossed it with, and each
+ * step out of a state is a whole run in a new heading, so the costs are
+ * exact and never more than those of the runlength flood.
+ *
+ * The flood runs outward from the target. The half cell out of the target
+ * is the first piece of the first run and the half cell out of the cell
+ * being costed is not counted, as in the runlength flood. Each cell gets
+ * the cost of its best state and the direction through the wall of that
+ * state. The route from cell 0 is then traced and its cells are given the
+ * costs and directions of that route.
+ *
+ * route() gives the headings of the route from any cell and
+ * makeRouteCommands() in compiler.h turns them into mouse commands
+ * without going through a path string.
+ *
+ * About 90k bytes of state are held for a 32x32 maze. They are allocated
+ * by the first flood and reused after that.
+ */
+class DiagonalFlood {
+ public:
+  static const int MAX_CELLS = 1024;
+  /// a state is a cell, the wall it was entered by and one of the three headings that can cross that wall
+  static const int STATES_PER_CELL = 12;
+
+  /// Flood the maze from the sources with the given mask into cost and direction. Returns the cost from cell 0.
+  uint16_t flood(const Maze &maze, const uint16_t *sources, int sourceCount, uint8_t mask, uint16_t *cost,
+                 uint8_t *direction);
+  /// The headings of the best route from the start cell to the target found by the last flood. The first
+  /// is the half cell out of the start and the last is the half cell into the target. Empty if the start
+  /// is a target or the target cannot be reached.
+  MazeLib::Directions route(uint16_t start) const;
+  /// the exact cost of the route from the cell, MAX_COST if there is none
+  uint32_t routeCost(uint16_t start) const;
+  /// the states taken from the queue by the last flood
+  uint32_t expansions() const;
+
+  /// the state for a cell, the wall it was entered by and a heading within 45 degrees of straight across
+  static int state(uint16_t cell, uint8_t entryWall, MazeLib::Direction heading);
+  static MazeLib::Direction heading(int state);
+  /// the heading across a cell entered by one wall and left by another, as in RunLengthCost
+  static uint8_t pieceHeading(uint8_t entryWall, uint8_t exitWall);
+  /// the wall a mouse crossing the cell with this heading leaves by, given the wall it left the last cell by
+  static uint8_t nextExitWall(MazeLib::Direction heading, uint8_t exitWall);
+  /// the size of the change from one heading to the other in eighths of a turn
+  static int turnSize(MazeLib::Direction from, MazeLib::Direction to);
+
+ private:
+  static const uint16_t NO_STATE = UINT16_MAX;
+  uint16_t mWidth = 0;
+  uint32_t mExpansions = 0;
+  const uint16_t *mOrthoCosts = nullptr;
+  const uint16_t *mDiagCosts = nullptr;
+  /// the best cost of every state, indexed by state()
+  std::vector<uint32_t> mCost;
+  /// the state each run was started from and the number of pieces in it
+  std::vector<uint16_t> mFrom;
+  std::vector<uint8_t> mRunLength;
+  /// a binary heap of (cost << 32 | state). Stale entries are skipped when they come out.
+  std::vector<uint64_t> mQueue;
+  uint8_t mExits[MAX_CELLS];
+  bool mIsSource[MAX_CELLS];
+
+  /// the cost of a piece at the given place in a run
+  uint16_t pieceCost(MazeLib::Direction heading, int runLength) const;
+  void relax(int next, uint32_t cost, int from, int runLength);
+  /// follow one run out of the cell through exitWall, relaxing the state at the end of each piece
+  void run(uint16_t cell, uint8_t exitWall, MazeLib::Direction heading, uint32_t cost, int from);
+  /// the best state for a cell or -1
+  int bestState(uint16_t cell) const;
+  /// give the cells of the route from cell 0 its costs and directions
+  void traceRoute(uint16_t *cost, uint8_t *direction) const;
+};
+
+#endif  // DIAGONALFLOOD_H
@@ -0,0 +1,255 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef FLOODENGINE_H
+#define FLOODENGINE_H
+
+#include <cstdint>
+#include "floodinfo.h"
+#include "indexedheap.h"
+#include "mazeconstants.h"
+#include "priorityqueue.h"
+
+/*
+ * One flood loop for every cost model.
+ *
+ * floodEngine() seeds a queue from the flood sources and then repeatedly
+ * takes a cell from the queue, tries each exit and relaxes the neighbour.
+ * What a step costs, what state travels with it and how the directions are
+ * picked at the end all come from a cost policy. The policy is a template
+ * argument, so its functions are inlined into the loop with no virtual calls.
+ *
+ * A cost policy provides:
+ *
+ *   static const bool SEEDS_NEIGHBOURS   queue the open neighbours of each source at startCost()
+ *                                        rather than the source itself
+ *   static const bool SKIPS_ENTRY_WALL   never leave a cell through the wall it was entered by
+ *   static const bool RECORDS_DIRECTION  store arrivalDirection() as a cell's direction when its cost is set
+ *   static const FloodDirections DIRECTIONS  how the directions are found when the costs are done
+ *   uint16_t startCost() const
+ *   uint16_t stepCost(const FloodInfo &from, uint8_t exitWall, FloodInfo &to) const
+ *            the cost of leaving the state from through exitWall. Fill in the runLength, entryDir and
+ *            entryWall of to; the engine fills in its cost and cell.
+ *   uint8_t arrivalDirection(uint8_t exitWall) const
+ *
+ * FloodCostPolicy has defaults for all of these except stepCost(). The four
+ * built in floods of Maze are the policies below.
+ *
+ * The queue decides the order cells are taken in. A PriorityQueue<uint16_t>
+ * is used first-in first-out and the state of a cell is read back from its
+ * cost and direction. The other queues hold FloodInfo and give the cheapest
+ * first; an IndexedHeap replaces the queued entry when a cell gets cheaper.
+ *
+ * With SETTLE_ON_FIRST_REACH a cell's cost is fixed the first time it is
+ * reached, as the original runlength flood did. Otherwise it is lowered
+ * whenever a cheaper route turns up.
+ */
+
+/// How a flood finds the direction of each cell once its costs are done
+enum FloodDirections {
+  /// the exit to the cheapest neighbour, the first of north, east, south and west on a tie
+  CHEAPEST_NEIGHBOUR,
+  /// the exit to the cheapest neighbour, the one nearest the target on a tie
+  CHEAPEST_TOWARDS_TARGET,
+  /// keep the directions recorded by the flood
+  DIRECTIONS_FROM_FLOOD,
+};
+
+/// Defaults for a cost policy. Derive from this and provide stepCost().
+struct FloodCostPolicy {
+  static const bool SEEDS_NEIGHBOURS = false;
+  static const bool SKIPS_ENTRY_WALL = false;
+  static const bool RECORDS_DIRECTION = false;
+  static const FloodDirections DIRECTIONS = CHEAPEST_NEIGHBOUR;
+  uint16_t startCost() const { return 0; }
+  uint8_t arrivalDirection(uint8_t exitWall) const { return exitWall; }
+};
+
+/// Every step costs one. The directions favour the target on a tie.
+struct ManhattanCost : FloodCostPolicy {
+  static const FloodDirections DIRECTIONS = CHEAPEST_TOWARDS_TARGET;
+  uint16_t stepCost(const FloodInfo &, uint8_t, FloodInfo &) const { return 1; }
+};
+
+/// Going straight on costs AHEAD_COST and turning costs the corner weight.
+/// The direction of travel is kept in each cell's direction.
+struct WeightedCost : FloodCostPolicy {
+  static const bool RECORDS_DIRECTION = true;
+  static const uint16_t AHEAD_COST = 2;
+  explicit WeightedCost(uint16_t cornerWeight) : mCornerWeight(cornerWeight) {}
+  uint16_t stepCost(const FloodInfo &from, uint8_t exitWall, FloodInfo &to) const {
+    to.entryDir = exitWall;
+    return from.entryDir == exitWall ? AHEAD_COST : mCornerWeight;
+  }
+
+ private:
+  uint16_t mCornerWeight;
+};
+
+/// Every step costs one and each cell points back the way the flood reached it.
+/// No direction pass is needed.
+struct DirectionCost : FloodCostPolicy {
+  static const bool RECORDS_DIRECTION = true;
+  static const FloodDirections DIRECTIONS = DIRECTIONS_FROM_FLOOD;
+  uint16_t stepCost(const FloodInfo &, uint8_t, FloodInfo &) const { return 1; }
+  uint8_t arrivalDirection(uint8_t exitWall) const { return (uint8_t)((exitWall + 2) % 4); }
+};
+
+/*
+ * Straights get cheaper per cell the longer they run and diagonals are
+ * costed from their own table, both indexed by run length. A turn costs
+ * TURN_PENALTY for every 45 degrees. The state carries the run length, the
+ * direction of travel in eighths of a turn and the wall the cell was
+ * entered by.
+ */
+struct RunLengthCost : FloodCostPolicy {
+  static const bool SEEDS_NEIGHBOURS = true;
+  static const bool SKIPS_ENTRY_WALL = true;
+  /// the cost of each 45 degrees of a turn. Chosen by eye for the best looking routes.
+  static const uint16_t TURN_PENALTY = 22;
+
+  /// the tables are indexed by run length from 1 to maxRunLength. Runs longer than that use the last entry.
+  RunLengthCost(const uint16_t *orthoCosts, const uint16_t *diagCosts, uint8_t maxRunLength)
+      : mOrthoCosts(orthoCosts), mDiagCosts(diagCosts), mMaxRunLength(maxRunLength) {}
+
+  uint16_t startCost() const { return mOrthoCosts[1]; }
+
+  uint16_t stepCost(const FloodInfo &from, uint8_t exitWall, FloodInfo &to) const {
+    static const uint8_t exitDirection[4][4] = {
+        {255, 3, 4, 5},
+        {7, 255, 5, 6},
+        {0, 1, 255, 7},
+        {1, 2, 3, 255},
+    };
+    uint8_t exitDir = exitDirection[from.entryWall][exitWall];
+    uint8_t runLength = from.runLength;
+    uint16_t turnCost = 0;
+    if (from.entryDir == exitDir) {
+      if (runLength < mMaxRunLength) {
+        runLength++;
+      }
+    } else {
+      int turnSize = from.entryDir > exitDir ? from.entryDir - exitDir : exitDir - from.entryDir;
+      if (turnSize > 4) {
+        turnSize = 8 - turnSize;
+      }
+      runLength = 1;
+      turnCost = static_cast<uint16_t>(turnSize * TURN_PENALTY);
+    }
+    to.runLength = runLength;
+    to.entryDir = exitDir;
+    to.entryWall = (uint8_t)((exitWall + 2) % 4);
+    return (uint16_t)(((exitDir & 1) == 0 ? mOrthoCosts[runLength] : mDiagCosts[runLength]) + turnCost);
+  }
+
+ private:
+  const uint16_t *mOrthoCosts;
+  const uint16_t *mDiagCosts;
+  uint8_t mMaxRunLength;
+};
+
+/// add a state to the queue. A first-in first-out queue of cells only keeps the cell.
+inline void floodPush(PriorityQueue<uint16_t> &queue, const FloodInfo &info) {
+  queue.add(info.cell);
+}
+
+inline void floodPush(IndexedHeap<FloodInfo> &queue, const FloodInfo &info) {
+  queue.update(info.cell, info);
+}
+
+template <class queue_t>
+void floodPush(queue_t &queue, const FloodInfo &info) {
+  queue.add(info);
+}
+
+/// take the next state from the queue. For a queue of cells it is read back from the output.
+template <class output_t>
+FloodInfo floodPop(PriorityQueue<uint16_t> &queue, const output_t &out) {
+  uint16_t cell = queue.head();
+  return FloodInfo(out.getCost(cell), cell, 0, out.getDirection(cell));
+}
+
+template <class queue_t, class output_t>
+FloodInfo floodPop(queue_t &queue, const output_t &) {
+  return queue.fetchSmallest();
+}
+
+/*
+ * Flood from the sources, which must already have a cost of zero in out,
+ * with every other cell at MAX_COST. forEachSource(seed) calls seed(cell)
+ * for each source. The output provides hasExit(), getCost(), setCost(),
+ * getDirection() and setDirection() for the cells of the geometry.
+ */
+template <bool SETTLE_ON_FIRST_REACH, class policy_t, class geometry_t, class queue_t, class output_t,
+          class sources_t>
+void floodEngine(const policy_t &policy, geometry_t geometry, queue_t &queue, output_t &out, sources_t forEachSource) {
+  forEachSource([&](uint16_t source) {
+    if (!policy_t::SEEDS_NEIGHBOURS) {
+      floodPush(queue, FloodInfo(0, source, 0, NORTH));
+      return;
+    }
+    const uint8_t entryDirs[] = {DIR_N, DIR_E, DIR_S, DIR_W};
+    const uint16_t cost = policy.startCost();
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      uint16_t nextCell = geometry.neighbour(source, exitWall);
+      // other sources keep their zero cost when there are several
+      if (!out.hasExit(source, exitWall) || out.getCost(nextCell) <= cost) {
+        continue;
+      }
+      floodPush(queue, FloodInfo(cost, nextCell, 1, entryDirs[exitWall], (uint8_t)((exitWall + 2) % 4)));
+      out.setCost(nextCell, cost);
+    }
+  });
+  while (queue.size() > 0) {
+    FloodInfo info = floodPop(queue, out);
+    const uint16_t costHere = out.getCost(info.cell);
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (policy_t::SKIPS_ENTRY_WALL && exitWall == info.entryWall) {
+        continue;
+      }
+      if (!out.hasExit(info.cell, exitWall)) {
+        continue;
+      }
+      uint16_t nextCell = geometry.neighbour(info.cell, exitWall);
+      if (SETTLE_ON_FIRST_REACH && out.getCost(nextCell) < MAX_COST) {
+        continue;
+      }
+      FloodInfo next;
+      uint16_t newCost = (uint16_t)(costHere + policy.stepCost(info, exitWall, next));
+      if (!SETTLE_ON_FIRST_REACH && newCost >= out.getCost(nextCell)) {
+        continue;
+      }
+      out.setCost(nextCell, newCost);
+      if (policy_t::RECORDS_DIRECTION) {
+        out.setDirection(nextCell, policy.arrivalDirection(exitWall));
+      }
+      next.cost = newCost;
+      next.cell = nextCell;
+      floodPush(queue, next);
+    }
+  }
+}
+
+#endif  // FLOODENGINE_H
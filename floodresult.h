@@ -0,0 +1,80 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef FLOODRESULT_H
+#define FLOODRESULT_H
+
+#include <cstdint>
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * The costs and directions from one flood, held apart from the maze.
+ *
+ * Maze::flood() normally leaves its results in the maze, so each flood
+ * replaces the one before it. The const Maze::flood() overload writes into
+ * a FloodResult instead. Any number of results can then be kept at once,
+ * say one for the goal and one for the way home, and floods into different
+ * results can run on different threads while they share the same maze.
+ *
+ * A result also records the target, mask and width that produced it.
+ */
+class FloodResult {
+ public:
+  static const int MAX_CELLS = 1024;
+
+  FloodResult() {
+    for (int i = 0; i < MAX_CELLS; i++) {
+      mCost[i] = MAX_COST;
+      mDirection[i] = INVALID_DIRECTION;
+    }
+  }
+
+  /// the cost of the route from the cell to the target
+  uint16_t cost(uint16_t cell) const { return mCost[cell]; }
+  /// the direction to leave the cell in to follow the route to the target
+  uint8_t direction(uint16_t cell) const { return mDirection[cell]; }
+  /// the cost from cell 0, as returned by the flood
+  uint16_t pathCost() const { return mPathCost; }
+  uint16_t target() const { return mTarget; }
+  uint8_t mask() const { return mMask; }
+  /// the width of the maze that was flooded. Zero if there has been no flood.
+  uint16_t width() const { return mWidth; }
+  /// all the costs, for code that works on the whole array
+  const uint16_t *costs() const { return mCost; }
+  const uint8_t *directions() const { return mDirection; }
+
+ private:
+  friend class Maze;
+  uint16_t mCost[MAX_CELLS];
+  uint8_t mDirection[MAX_CELLS];
+  uint16_t mPathCost = MAX_COST;
+  uint16_t mTarget = 0;
+  uint8_t mMask = OPEN_MASK;
+  uint16_t mWidth = 0;
+};
+
+#endif  // FLOODRESULT_H
@@ -0,0 +1,126 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef FLOODWORKSPACE_H
+#define FLOODWORKSPACE_H
+
+#include <cstdint>
+#include "bucketqueue.h"
+#include "diagonalflood.h"
+#include "floodinfo.h"
+#include "indexedheap.h"
+#include "packedcells.h"
+#include "priorityqueue.h"
+#include "timeflood.h"
+
+/*
+ * The queues used by the floods, kept by the caller and reused.
+ *
+ * Without a workspace every flood builds its own queue, which allocates
+ * its storage on the way in and frees it on the way out. That is fine for
+ * a mouse but it shows up badly when millions of mazes are flooded in a
+ * batch. Attach a workspace with Maze::setFloodWorkspace() and the floods
+ * use these queues instead, so that a flood makes no heap allocations at
+ * all once the workspace has been built.
+ *
+ * The heap is given room for every cell up front so it never needs to grow.
+ * Each accessor empties its queue before handing it over. None of the
+ * queues walk their whole storage to do that: the bucket queue marks its
+ * buckets with a generation number and the heap only resets the keys that
+ * are still queued.
+ *
+ * It also holds the cell records for floods that use the packed or padded
+ * layouts, the closed maze costs for Maze::testForSolution() and the state
+ * of the time and diagonal floods, which grow to their full size on first
+ * use.
+ *
+ * One workspace can be shared by any number of mazes as long as they do
+ * not flood at the same time.
+ */
+class FloodWorkspace {
+ public:
+  static const int MAX_CELLS = 1024;
+  /// a 32x32 maze with the ring of sentinel cells used by the padded layout
+  static const int MAX_PADDED_CELLS = 34 * 34;
+  /// the same size as the queues the floods build for themselves
+  static const int QUEUE_SIZE = 128;
+
+  FloodWorkspace()
+      : mCellQueue(QUEUE_SIZE), mInfoQueue(QUEUE_SIZE), mBucketQueue(MAX_CELLS), mHeap(MAX_PADDED_CELLS, MAX_CELLS) {}
+
+  FloodWorkspace(const FloodWorkspace &rhs) = delete;
+  FloodWorkspace &operator=(const FloodWorkspace &rhs) = delete;
+
+  /// the first-in first-out queue of cells for the manhattan, weighted and direction floods
+  PriorityQueue<uint16_t> &cellQueue() {
+    mCellQueue.clear();
+    return mCellQueue;
+  }
+
+  /// the linear queue for the runlength flood
+  PriorityQueue<FloodInfo> &infoQueue() {
+    mInfoQueue.clear();
+    return mInfoQueue;
+  }
+
+  /// the bucket queue for the runlength flood
+  BucketQueue<FloodInfo> &bucketQueue() {
+    mBucketQueue.clear();
+    return mBucketQueue;
+  }
+
+  /// the indexed heap for the Dijkstra versions of the weighted and runlength floods
+  IndexedHeap<FloodInfo> &heap() {
+    mHeap.clear();
+    return mHeap;
+  }
+
+  /// room for every cell of a flood in the packed or padded layout. The flood fills it in itself.
+  PackedCell *packedCells() { return mPackedCells; }
+
+  /// room for the closed maze costs when Maze::testForSolution() floods both mazes together
+  uint16_t *closedCosts() { return mClosedCosts; }
+
+  /// the time flood, set up for the given motion profile
+  TimeFlood &timeFlood(const MotionProfile &profile) {
+    mTimeFlood.setProfile(profile);
+    return mTimeFlood;
+  }
+
+  /// the diagonal flood. route() gives the route found by the last diagonal flood that used this workspace.
+  DiagonalFlood &diagonalFlood() { return mDiagonalFlood; }
+
+ private:
+  PriorityQueue<uint16_t> mCellQueue;
+  PriorityQueue<FloodInfo> mInfoQueue;
+  BucketQueue<FloodInfo> mBucketQueue;
+  IndexedHeap<FloodInfo> mHeap;
+  PackedCell mPackedCells[MAX_PADDED_CELLS];
+  uint16_t mClosedCosts[MAX_CELLS];
+  TimeFlood mTimeFlood;
+  DiagonalFlood mDiagonalFlood;
+};
+
+#endif  // FLOODWORKSPACE_H
@@ -0,0 +1,96 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef GOALAREA_H
+#define GOALAREA_H
+
+#include <cstdint>
+
+/*
+ * The cells of the goal area.
+ *
+ * Membership is one bit per cell so goalContains() is a single bit test,
+ * however many cells the goal has. The cells are also kept in the order
+ * they were added in a small inline array, because the first cell is the
+ * flood target and the multi-source floods walk them all. Nothing here
+ * touches the heap.
+ *
+ * A cell can only be in the area once. Adding a cell that is already there,
+ * or adding more than MAX_SIZE cells, is ignored and add() returns false.
+ */
+class GoalArea {
+ public:
+  static const int MAX_CELLS = 1024;
+  /// the most cells the goal area can hold. Contest goals have four or nine.
+  static const int MAX_SIZE = 64;
+
+  void clear() {
+    for (int i = 0; i < mSize; i++) {
+      mBits[mCells[i] / 32] = 0;
+    }
+    mSize = 0;
+  }
+
+  bool add(int cell) {
+    if (!isValid(cell) || contains(cell) || mSize >= MAX_SIZE) {
+      return false;
+    }
+    mBits[cell / 32] |= 1u << (cell % 32);
+    mCells[mSize++] = static_cast<uint16_t>(cell);
+    return true;
+  }
+
+  /// remove a cell, keeping the order of the rest. No effect if it is not there.
+  void remove(int cell) {
+    if (!contains(cell)) {
+      return;
+    }
+    mBits[cell / 32] &= ~(1u << (cell % 32));
+    int i = 0;
+    while (mCells[i] != cell) {
+      i++;
+    }
+    for (; i < mSize - 1; i++) {
+      mCells[i] = mCells[i + 1];
+    }
+    mSize--;
+  }
+
+  bool contains(int cell) const { return isValid(cell) && (mBits[cell / 32] >> (cell % 32)) & 1u; }
+  int size() const { return mSize; }
+  bool empty() const { return mSize == 0; }
+  /// the first cell added. Meaningless if the area is empty.
+  uint16_t front() const { return mCells[0]; }
+  const uint16_t *begin() const { return mCells; }
+  const uint16_t *end() const { return mCells + mSize; }
+
+ private:
+  static bool isValid(int cell) { return cell >= 0 && cell < MAX_CELLS; }
+  uint32_t mBits[MAX_CELLS / 32] = {0};
+  uint16_t mCells[MAX_SIZE] = {0};
+  int mSize = 0;
+};
+
+#endif  // GOALAREA_H
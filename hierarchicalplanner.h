@@ -0,0 +1,629 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef HIERARCHICALPLANNER_H
+#define HIERARCHICALPLANNER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include "largemaze.h"
+#include "mazeconstants.h"
+
+/*
+ * Hierarchical route planning for very large mazes.
+ *
+ * A flood of a LargeMaze touches every cell, so replanning after each new
+ * wall costs time in proportion to the area of the maze. The planner cuts
+ * the maze into square clusters and keeps an abstract graph over them:
+ *
+ *  - Along each border between two clusters the open walls are grouped in
+ *    runs whose cells are joined along the border on both sides. Each run
+ *    gets an entrance in the middle, or one at each end if it is longer
+ *    than LONG_RUN. The cells either side of an entrance are nodes, one
+ *    step apart.
+ *  - Within a cluster the node to node distances are found by breadth
+ *    first searches that never leave the cluster.
+ *
+ * A query searches the start and target clusters locally, runs A* over the
+ * nodes with the manhattan distance as the estimate, and then refines each
+ * abstract step into cells with a local search inside one cluster. A query
+ * touches the nodes that A* expands and the cells of the clusters it starts,
+ * ends and refines in, never the whole maze. In a maze the estimate is weak
+ * and A* still expands a share of the nodes that grows with the area.
+ *
+ * Costs are unit steps as in the manhattan flood. Routes are restricted to
+ * pass through the entrances so they can be longer than the shortest route,
+ * but a route is found whenever one exists. Exits that wrap round the edge
+ * of the maze are never used. Mazes with their boundary walls in place
+ * never need them.
+ *
+ * The planner rebuilds only what a wall change touches. A wall inside a
+ * cluster rebuilds that cluster, a wall on a border, or along one where it
+ * decides how the crossings are grouped, rebuilds the border and the two
+ * clusters either side of it. Wall changes reach the planner through
+ * updateMap(), which updates the maze as well, or through wallChanged() for
+ * walls written some other way. A new mask or maze width rebuilds everything.
+ * If walls change without the planner being told, a query whose route no
+ * longer fits the maze finds no route; invalidate() starts again.
+ */
+template <class cell_t = uint32_t, class cost_t = uint32_t>
+class HierarchicalPlanner {
+ public:
+  using maze_t = LargeMaze<cell_t, cost_t>;
+
+  /// running totals so that the work saved can be measured
+  struct Counters {
+    /// clusters whose nodes and distances were found
+    uint32_t clusterBuilds = 0;
+    /// borders whose entrances were found
+    uint32_t borderBuilds = 0;
+    /// route queries answered
+    uint32_t queries = 0;
+    /// abstract nodes taken from the queue, summed over all queries
+    uint32_t nodeExpansions = 0;
+    /// cells visited by the local searches, in building the clusters and in the queries
+    uint32_t cellsSearched = 0;
+  };
+
+  static const uint16_t NO_NODE = 0xFFFF;
+  /// runs of open border longer than this get an entrance at each end
+  static const int LONG_RUN = 6;
+
+  explicit HierarchicalPlanner(cell_t clusterSize = 16) : mClusterSize(clusterSize) { assert(clusterSize > 1); }
+
+  cell_t clusterSize() const { return mClusterSize; }
+  size_t clusterCount() const { return mClusters.size(); }
+
+  /// the number of abstract nodes in the graph
+  size_t nodeCount() const {
+    size_t count = 0;
+    for (const Cluster &cluster : mClusters) {
+      count += cluster.nodes.size();
+    }
+    return count;
+  }
+
+  /// true if the graph has been built and no wall has changed since
+  bool isValid() const { return mBuilt && mDirtyClusters.empty() && mDirtyBorders.empty(); }
+
+  /// bring the graph up to date with the walls of the maze under the mask
+  void update(const maze_t &maze, uint8_t openCloseMask) {
+    if (!mBuilt || openCloseMask != mMask || maze.width() != mWidth) {
+      build(maze, openCloseMask);
+      return;
+    }
+    for (size_t border : mDirtyBorders) {
+      findEntrances(maze, border);
+    }
+    mDirtyBorders.clear();
+    for (size_t cluster : mDirtyClusters) {
+      buildCluster(maze, cluster);
+    }
+    mDirtyClusters.clear();
+  }
+
+  /// USE THIS FOR SEARCH. Update the maze with Maze::updateMap() rules and note the walls that changed.
+  void updateMap(maze_t &maze, cell_t cell, uint8_t wallData) {
+    uint8_t before = maze.getXWalls(cell);
+    maze.updateMap(cell, wallData);
+    uint8_t changed = before ^ maze.getXWalls(cell);
+    for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+      if (changed & ((WALL_PRESENT | WALL_UNSEEN) << direction)) {
+        wallChanged(cell, direction);
+      }
+    }
+  }
+
+  /// note that a wall of the cell has changed so that the clusters it touches are rebuilt by the next update
+  void wallChanged(cell_t cell, uint8_t direction) {
+    if (!mBuilt || direction > WEST) {
+      return;
+    }
+    cell_t col = cell / mWidth;
+    cell_t row = cell % mWidth;
+    switch (direction) {
+      case NORTH:
+        if (row + 1 < mWidth) {
+          borderChanged(cell, cell + 1, borderIndex(clusterOf(cell), NORTH_BORDER));
+          runWallChanged(cell, EAST_BORDER);
+        }
+        break;
+      case EAST:
+        if (col + 1 < mWidth) {
+          borderChanged(cell, cell + mWidth, borderIndex(clusterOf(cell), EAST_BORDER));
+          runWallChanged(cell, NORTH_BORDER);
+        }
+        break;
+      case SOUTH:
+        if (row > 0) {
+          borderChanged(cell, cell - 1, borderIndex(clusterOf(cell - 1), NORTH_BORDER));
+          runWallChanged(cell - 1, EAST_BORDER);
+        }
+        break;
+      default:
+        if (col > 0) {
+          borderChanged(cell, cell - mWidth, borderIndex(clusterOf(cell - mWidth), EAST_BORDER));
+          runWallChanged(cell - mWidth, NORTH_BORDER);
+        }
+        break;
+    }
+  }
+
+  /// forget the graph so that the next update builds it from scratch
+  void invalidate() { mBuilt = false; }
+
+  /*
+   * Find a route from start to target under the mask, bringing the graph up
+   * to date first. The directions of the steps are left in directions and the
+   * number of steps is returned, or maxCost() if there is no route.
+   */
+  cost_t route(const maze_t &maze, cell_t start, cell_t target, uint8_t openCloseMask,
+               std::vector<uint8_t> &directions) {
+    directions.clear();
+    update(maze, openCloseMask);
+    mCounters.queries++;
+    if (start == target) {
+      return 0;
+    }
+    nextSearch();
+    const size_t startCluster = clusterOf(start);
+    const size_t targetCluster = clusterOf(target);
+    // the distances from the start and from the target to the nodes of their own clusters
+    localSearch(maze, start);
+    mStartDistance.clear();
+    for (const Node &node : mClusters[startCluster].nodes) {
+      mStartDistance.push_back(localDistance(node.cell));
+    }
+    const cost_t direct = startCluster == targetCluster ? localDistance(target) : maxCost();
+    localSearch(maze, target);
+    mTargetDistance.clear();
+    for (const Node &node : mClusters[targetCluster].nodes) {
+      mTargetDistance.push_back(localDistance(node.cell));
+    }
+
+    const cell_t targetCol = target / mWidth;
+    const cell_t targetRow = target % mWidth;
+    auto estimate = [&](cell_t cell) -> cost_t {
+      return (cost_t)(std::labs((long)(cell / mWidth) - (long)targetCol) +
+                      std::labs((long)(cell % mWidth) - (long)targetRow));
+    };
+    auto relax = [&](cell_t from, cell_t to, cost_t cost) {
+      if (mSearch[to] != mSearchNumber || cost < mCost[to]) {
+        mSearch[to] = mSearchNumber;
+        mCost[to] = cost;
+        mParent[to] = from;
+        mQueue.push_back({cost + estimate(to), cost, to});
+        std::push_heap(mQueue.begin(), mQueue.end(), std::greater<Entry>());
+      }
+    };
+    mQueue.clear();
+    mSearch[start] = mSearchNumber;
+    mCost[start] = 0;
+    mParent[start] = start;
+    mQueue.push_back({estimate(start), 0, start});
+    while (!mQueue.empty()) {
+      std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<Entry>());
+      Entry entry = mQueue.back();
+      mQueue.pop_back();
+      if (entry.cost != mCost[entry.cell]) {
+        continue;  // a cheaper way to this cell was found after this entry was queued
+      }
+      const cell_t here = entry.cell;
+      if (here == target) {
+        break;
+      }
+      mCounters.nodeExpansions++;
+      if (here == start) {
+        const Cluster &cluster = mClusters[startCluster];
+        for (size_t i = 0; i < cluster.nodes.size(); i++) {
+          if (mStartDistance[i] != maxCost()) {
+            relax(here, cluster.nodes[i].cell, mStartDistance[i]);
+          }
+        }
+        if (direct != maxCost()) {
+          relax(here, target, direct);
+        }
+      }
+      const uint16_t slot = mSlot[here];
+      if (slot == NO_NODE) {
+        continue;
+      }
+      const size_t clusterIndex = clusterOf(here);
+      const Cluster &cluster = mClusters[clusterIndex];
+      const size_t count = cluster.nodes.size();
+      for (size_t i = 0; i < count; i++) {
+        cost_t distance = cluster.distances[slot * count + i];
+        if (i != slot && distance != maxCost()) {
+          relax(here, cluster.nodes[i].cell, entry.cost + distance);
+        }
+      }
+      const Node &node = cluster.nodes[slot];
+      for (int i = 0; i < node.acrossCount; i++) {
+        relax(here, node.across[i], entry.cost + 1);
+      }
+      if (clusterIndex == targetCluster && mTargetDistance[slot] != maxCost()) {
+        relax(here, target, entry.cost + mTargetDistance[slot]);
+      }
+    }
+    if (mSearch[target] != mSearchNumber || !refine(maze, start, target, directions)) {
+      directions.clear();
+      return maxCost();
+    }
+    return (cost_t)directions.size();
+  }
+
+  const Counters &counters() const { return mCounters; }
+  void resetCounters() { mCounters = Counters(); }
+
+  static cost_t maxCost() { return maze_t::maxCost(); }
+
+ protected:
+  enum { NORTH_BORDER, EAST_BORDER };
+
+  /// a cell next to an entrance. across holds the cells one step away in the neighbouring clusters.
+  struct Node {
+    cell_t cell = 0;
+    cell_t across[4] = {0, 0, 0, 0};
+    uint8_t acrossCount = 0;
+  };
+
+  struct Cluster {
+    std::vector<Node> nodes;
+    /// the distance from each node to each other, row by row, or maxCost() if there is no way inside the cluster
+    std::vector<cost_t> distances;
+    bool dirty = false;
+  };
+
+  struct Entry {
+    cost_t priority;
+    cost_t cost;
+    cell_t cell;
+    bool operator>(const Entry &rhs) const { return priority > rhs.priority; }
+  };
+
+  cell_t mClusterSize;
+  cell_t mWidth = 0;
+  cell_t mClustersPerSide = 0;
+  uint8_t mMask = OPEN_MASK;
+  bool mBuilt = false;
+  std::vector<Cluster> mClusters;
+  /// for each cluster the entrances on its north border and then its east border, as the cells inside it
+  std::vector<std::vector<cell_t>> mBorders;
+  std::vector<bool> mBorderDirty;
+  std::vector<size_t> mDirtyBorders;
+  std::vector<size_t> mDirtyClusters;
+  /// the node index of each cell within its cluster, or NO_NODE
+  std::vector<uint16_t> mSlot;
+
+  /// per-cell search data, marked with a search number rather than cleared
+  std::vector<uint32_t> mSearch;
+  std::vector<cost_t> mCost;
+  std::vector<cell_t> mParent;
+  uint32_t mSearchNumber = 0;
+  std::vector<Entry> mQueue;
+  std::vector<cost_t> mStartDistance;
+  std::vector<cost_t> mTargetDistance;
+
+  /// the local search of one cluster, indexed by the position of the cell in the cluster
+  size_t mLocalCluster = 0;
+  std::vector<cost_t> mLocalDistance;
+  std::vector<uint8_t> mLocalEntry;
+  std::vector<cell_t> mLocalQueue;
+
+  Counters mCounters;
+
+  size_t clusterOf(cell_t cell) const {
+    return (size_t)(cell / mWidth / mClusterSize) * mClustersPerSide + (cell % mWidth) / mClusterSize;
+  }
+  size_t borderIndex(size_t cluster, int side) const { return cluster * 2 + side; }
+
+  cell_t firstCol(size_t cluster) const { return (cell_t)(cluster / mClustersPerSide) * mClusterSize; }
+  cell_t firstRow(size_t cluster) const { return (cell_t)(cluster % mClustersPerSide) * mClusterSize; }
+  cell_t endCol(size_t cluster) const { return std::min<cell_t>(firstCol(cluster) + mClusterSize, mWidth); }
+  cell_t endRow(size_t cluster) const { return std::min<cell_t>(firstRow(cluster) + mClusterSize, mWidth); }
+
+  bool hasExit(const maze_t &maze, cell_t cell, uint8_t direction) const {
+    return (maze.getXWalls(cell) & (mMask << direction)) == 0;
+  }
+
+  void markCluster(size_t cluster) {
+    if (!mClusters[cluster].dirty) {
+      mClusters[cluster].dirty = true;
+      mDirtyClusters.push_back(cluster);
+    }
+  }
+
+  /// the border needs its entrances found again, and so the clusters either side of it need rebuilding
+  void markBorder(size_t border) {
+    const size_t cluster = border / 2;
+    markCluster(cluster);
+    markCluster(border % 2 == NORTH_BORDER ? cluster + 1 : cluster + mClustersPerSide);
+    if (!mBorderDirty[border]) {
+      mBorderDirty[border] = true;
+      mDirtyBorders.push_back(border);
+    }
+  }
+
+  void borderChanged(cell_t cell, cell_t next, size_t border) {
+    markCluster(clusterOf(cell));
+    if (clusterOf(next) != clusterOf(cell)) {
+      markBorder(border);
+    }
+  }
+
+  /*
+   * findEntrances() joins crossings into runs by the walls that lie along the
+   * border on both sides of it: the east walls of the rows either side of a
+   * north border and the north walls of the columns either side of an east
+   * border. A change to one of those can split or join runs, so the border
+   * is found again. The wall is given by the cell to its south or west.
+   */
+  void runWallChanged(cell_t cell, int side) {
+    const cell_t across = side == NORTH_BORDER ? cell % mWidth : cell / mWidth;
+    const cell_t step = side == NORTH_BORDER ? 1 : mWidth;
+    if ((across + 1) % mClusterSize == 0 && across + 1 < mWidth) {
+      markBorder(borderIndex(clusterOf(cell), side));
+    } else if (across % mClusterSize == 0 && across > 0) {
+      markBorder(borderIndex(clusterOf(cell - step), side));
+    }
+  }
+
+  void build(const maze_t &maze, uint8_t openCloseMask) {
+    mMask = openCloseMask;
+    mWidth = maze.width();
+    mClustersPerSide = (mWidth + mClusterSize - 1) / mClusterSize;
+    const size_t clusters = (size_t)mClustersPerSide * mClustersPerSide;
+    mClusters.assign(clusters, Cluster());
+    mBorders.assign(clusters * 2, std::vector<cell_t>());
+    mBorderDirty.assign(clusters * 2, false);
+    mDirtyBorders.clear();
+    mDirtyClusters.clear();
+    mSlot.assign(maze.numCells(), (uint16_t)NO_NODE);
+    mSearch.assign(maze.numCells(), 0);
+    mCost.assign(maze.numCells(), maxCost());
+    mParent.assign(maze.numCells(), 0);
+    mSearchNumber = 0;
+    mLocalDistance.assign((size_t)mClusterSize * mClusterSize, maxCost());
+    mLocalEntry.assign((size_t)mClusterSize * mClusterSize, INVALID_DIRECTION);
+    mLocalQueue.reserve((size_t)mClusterSize * mClusterSize);
+    for (size_t border = 0; border < mBorders.size(); border++) {
+      findEntrances(maze, border);
+    }
+    for (size_t cluster = 0; cluster < clusters; cluster++) {
+      buildCluster(maze, cluster);
+    }
+    mBuilt = true;
+  }
+
+  /*
+   * Group the open walls of a border into runs whose cells are joined along
+   * the border on both sides, so that any crossing in a run can reach the
+   * entrance without leaving the two clusters.
+   */
+  void findEntrances(const maze_t &maze, size_t border) {
+    mBorderDirty[border] = false;
+    std::vector<cell_t> &entrances = mBorders[border];
+    entrances.clear();
+    mCounters.borderBuilds++;
+    const size_t cluster = border / 2;
+    const bool north = border % 2 == NORTH_BORDER;
+    cell_t first;
+    cell_t count;
+    cell_t step;
+    uint8_t crossing;
+    uint8_t along;
+    if (north) {
+      if (endRow(cluster) >= mWidth) {
+        return;
+      }
+      first = firstCol(cluster) * mWidth + endRow(cluster) - 1;
+      count = endCol(cluster) - firstCol(cluster);
+      step = mWidth;
+      crossing = NORTH;
+      along = EAST;
+    } else {
+      if (endCol(cluster) >= mWidth) {
+        return;
+      }
+      first = (endCol(cluster) - 1) * mWidth + firstRow(cluster);
+      count = endRow(cluster) - firstRow(cluster);
+      step = 1;
+      crossing = EAST;
+      along = NORTH;
+    }
+    const cell_t acrossStep = north ? 1 : mWidth;
+    cell_t runStart = 0;
+    cell_t runLength = 0;
+    for (cell_t i = 0; i <= count; i++) {
+      cell_t cell = first + i * step;
+      bool open = i < count && hasExit(maze, cell, crossing);
+      bool joined = open && runLength > 0 && hasExit(maze, cell - step, along) &&
+                    hasExit(maze, cell - step + acrossStep, along);
+      if (runLength > 0 && !joined) {
+        if (runLength > LONG_RUN) {
+          entrances.push_back(first + runStart * step);
+          entrances.push_back(first + (runStart + runLength - 1) * step);
+        } else {
+          entrances.push_back(first + (runStart + runLength / 2) * step);
+        }
+        runLength = 0;
+      }
+      if (open) {
+        if (runLength == 0) {
+          runStart = i;
+        }
+        runLength++;
+      }
+    }
+  }
+
+  /// the node for a cell of the cluster, added if the cell does not have one yet
+  Node &nodeFor(Cluster &cluster, cell_t cell) {
+    if (mSlot[cell] == NO_NODE) {
+      assert(cluster.nodes.size() < NO_NODE);
+      mSlot[cell] = (uint16_t)cluster.nodes.size();
+      cluster.nodes.push_back(Node());
+      cluster.nodes.back().cell = cell;
+    }
+    return cluster.nodes[mSlot[cell]];
+  }
+
+  /// collect the nodes of a cluster from the entrances on its four borders and find the distances between them
+  void buildCluster(const maze_t &maze, size_t index) {
+    Cluster &cluster = mClusters[index];
+    cluster.dirty = false;
+    for (const Node &node : cluster.nodes) {
+      mSlot[node.cell] = NO_NODE;
+    }
+    cluster.nodes.clear();
+    mCounters.clusterBuilds++;
+    auto addEntrance = [&](cell_t inside, cell_t outside) {
+      Node &node = nodeFor(cluster, inside);
+      node.across[node.acrossCount++] = outside;
+    };
+    for (cell_t cell : mBorders[borderIndex(index, NORTH_BORDER)]) {
+      addEntrance(cell, cell + 1);
+    }
+    for (cell_t cell : mBorders[borderIndex(index, EAST_BORDER)]) {
+      addEntrance(cell, cell + mWidth);
+    }
+    if (firstRow(index) > 0) {
+      for (cell_t cell : mBorders[borderIndex(index - 1, NORTH_BORDER)]) {
+        addEntrance(cell + 1, cell);
+      }
+    }
+    if (firstCol(index) > 0) {
+      for (cell_t cell : mBorders[borderIndex(index - mClustersPerSide, EAST_BORDER)]) {
+        addEntrance(cell + mWidth, cell);
+      }
+    }
+    const size_t count = cluster.nodes.size();
+    cluster.distances.assign(count * count, maxCost());
+    for (size_t i = 0; i < count; i++) {
+      localSearch(maze, cluster.nodes[i].cell);
+      for (size_t j = 0; j < count; j++) {
+        cluster.distances[i * count + j] = localDistance(cluster.nodes[j].cell);
+      }
+    }
+  }
+
+  size_t localIndex(cell_t cell) const {
+    size_t cluster = mLocalCluster;
+    return (size_t)(cell / mWidth - firstCol(cluster)) * (endRow(cluster) - firstRow(cluster)) +
+           (cell % mWidth - firstRow(cluster));
+  }
+
+  /// the distance from the source of the last local search, or maxCost() if it was not reached
+  cost_t localDistance(cell_t cell) const {
+    if (clusterOf(cell) != mLocalCluster) {
+      return maxCost();
+    }
+    return mLocalDistance[localIndex(cell)];
+  }
+
+  /// breadth first search from the cell that never leaves its cluster
+  void localSearch(const maze_t &maze, cell_t source) {
+    const size_t cluster = clusterOf(source);
+    mLocalCluster = cluster;
+    const cell_t col0 = firstCol(cluster);
+    const cell_t col1 = endCol(cluster);
+    const cell_t row0 = firstRow(cluster);
+    const cell_t row1 = endRow(cluster);
+    std::fill(mLocalDistance.begin(), mLocalDistance.end(), maxCost());
+    mLocalQueue.clear();
+    mLocalQueue.push_back(source);
+    mLocalDistance[localIndex(source)] = 0;
+    for (size_t head = 0; head < mLocalQueue.size(); head++) {
+      const cell_t cell = mLocalQueue[head];
+      const cost_t next = mLocalDistance[localIndex(cell)] + 1;
+      const cell_t col = cell / mWidth;
+      const cell_t row = cell % mWidth;
+      const bool inside[] = {row + 1 < row1, col + 1 < col1, row > row0, col > col0};
+      const cell_t neighbours[] = {cell + 1, cell + mWidth, cell - 1, cell - mWidth};
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        if (!inside[direction] || !hasExit(maze, cell, direction)) {
+          continue;
+        }
+        size_t local = localIndex(neighbours[direction]);
+        if (mLocalDistance[local] == maxCost()) {
+          mLocalDistance[local] = next;
+          mLocalEntry[local] = direction;
+          mLocalQueue.push_back(neighbours[direction]);
+        }
+      }
+    }
+    mCounters.cellsSearched += (uint32_t)mLocalQueue.size();
+  }
+
+  void nextSearch() {
+    mSearchNumber++;
+    if (mSearchNumber == 0) {
+      std::fill(mSearch.begin(), mSearch.end(), 0);
+      mSearchNumber = 1;
+    }
+  }
+
+  /// turn the abstract route into steps, searching inside one cluster for each step between two of its cells.
+  /// False if a step cannot be made, which happens only when walls changed without the planner being told.
+  bool refine(const maze_t &maze, cell_t start, cell_t target, std::vector<uint8_t> &directions) {
+    std::vector<cell_t> waypoints;
+    for (cell_t cell = target; cell != start; cell = mParent[cell]) {
+      waypoints.push_back(cell);
+    }
+    waypoints.push_back(start);
+    std::reverse(waypoints.begin(), waypoints.end());
+    std::vector<uint8_t> steps;
+    for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+      const cell_t from = waypoints[i];
+      const cell_t to = waypoints[i + 1];
+      if (clusterOf(from) != clusterOf(to)) {
+        uint8_t direction = to == from + 1 ? NORTH : to == from + mWidth ? EAST : to + 1 == from ? SOUTH : WEST;
+        if (!hasExit(maze, from, direction)) {
+          return false;
+        }
+        directions.push_back(direction);
+        continue;
+      }
+      localSearch(maze, from);
+      if (localDistance(to) == maxCost()) {
+        return false;
+      }
+      steps.clear();
+      for (cell_t cell = to; cell != from;) {
+        uint8_t direction = mLocalEntry[localIndex(cell)];
+        steps.push_back(direction);
+        cell = maze.neighbour(cell, (direction + 2) & 0x03);
+      }
+      directions.insert(directions.end(), steps.rbegin(), steps.rend());
+    }
+    return true;
+  }
+};
+
+#endif  // HIERARCHICALPLANNER_H
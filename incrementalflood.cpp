@@ -0,0 +1,184 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "incrementalflood.h"
+#include <cstring>
+#include "maze.h"
+
+IncrementalFlood::IncrementalFlood() : mQueue(MAX_CELLS) {
+  memset(mDirty, 0, sizeof(mDirty));
+}
+
+const IncrementalFlood::Counters &IncrementalFlood::counters() const {
+  return mCounters;
+}
+
+void IncrementalFlood::resetCounters() {
+  mCounters = Counters();
+}
+
+bool IncrementalFlood::isValid() const {
+  return mValid;
+}
+
+void IncrementalFlood::invalidate() {
+  mValid = false;
+  mChangeCount = 0;
+}
+
+void IncrementalFlood::wallChanged(uint16_t cell, uint8_t direction) {
+  if (!mValid) {
+    return;
+  }
+  if (mChangeCount >= MAX_CHANGES) {
+    invalidate();
+    return;
+  }
+  mChanges[mChangeCount].cell = cell;
+  mChanges[mChangeCount].direction = direction;
+  mChangeCount++;
+}
+
+uint16_t IncrementalFlood::flood(Maze &maze, uint16_t target, int open_close_mask) {
+  maze.mOpenCloseMask = open_close_mask;
+  mCounters.floods++;
+  bool canRepair = mValid && target == mTarget && open_close_mask == mMask && maze.width() == mWidth;
+  mTarget = target;
+  mMask = open_close_mask;
+  mWidth = maze.width();
+  uint32_t expansions = canRepair ? repair(maze) : fullFlood(maze);
+  mCounters.lastExpansions = expansions;
+  mCounters.cellExpansions += expansions;
+  mChangeCount = 0;
+  mValid = true;
+  return maze.mCost[0];
+}
+
+/*
+ * An ordinary manhattan flood leaves every cell consistent, so its costs
+ * serve as both the g and rhs values of LPA*.
+ */
+uint32_t IncrementalFlood::fullFlood(Maze &maze) {
+  mCounters.fullFloods++;
+  mQueue.clear();
+  maze.manhattanFlood(mTarget);
+  uint32_t expansions = 0;
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    mCost[cell] = maze.mCost[cell];
+    mRhs[cell] = mCost[cell];
+    mDirection[cell] = maze.mDirection[cell];
+    if (mCost[cell] != MAX_COST) {
+      expansions++;
+    }
+  }
+  return expansions;
+}
+
+/*
+ * Both ends of each changed wall may have a new rhs value. LPA* then
+ * expands only the cells that become inconsistent. Directions depend on
+ * the walls of a cell and the costs of its neighbours so they are
+ * recalculated around every changed wall and every changed cost.
+ */
+uint32_t IncrementalFlood::repair(Maze &maze) {
+  mCounters.incrementalFloods++;
+  mDirtyCount = 0;
+  for (int i = 0; i < mChangeCount; i++) {
+    uint16_t cell = mChanges[i].cell;
+    uint16_t next = maze.neighbour(cell, mChanges[i].direction);
+    updateCell(maze, cell);
+    updateCell(maze, next);
+    markDirty(cell);
+    markDirty(next);
+  }
+  uint32_t expansions = 0;
+  while (mQueue.size() > 0) {
+    auto cell = static_cast<uint16_t>(mQueue.topKey());
+    mQueue.fetchSmallest();
+    expansions++;
+    if (mCost[cell] > mRhs[cell]) {
+      mCost[cell] = mRhs[cell];
+    } else {
+      mCost[cell] = MAX_COST;
+      updateCell(maze, cell);
+    }
+    markCostChanged(maze, cell);
+    for (uint8_t direction = 0; direction < 4; direction++) {
+      if (hasExit(maze, cell, direction)) {
+        updateCell(maze, maze.neighbour(cell, direction));
+      }
+    }
+  }
+  memcpy(maze.mCost, mCost, maze.numCells() * sizeof(mCost[0]));
+  for (int i = 0; i < mDirtyCount; i++) {
+    uint16_t cell = mDirtyList[i];
+    mDirection[cell] = maze.directionToSmallest(cell, mTarget);
+    mDirty[cell] = 0;
+  }
+  memcpy(maze.mDirection, mDirection, maze.numCells() * sizeof(mDirection[0]));
+  return expansions;
+}
+
+bool IncrementalFlood::hasExit(const Maze &maze, uint16_t cell, uint8_t direction) const {
+  return (maze.getXWalls(cell) & (mMask << direction)) == 0;
+}
+
+/// The best cost offered by any neighbour with an exit into this cell
+uint16_t IncrementalFlood::calculateRhs(Maze &maze, uint16_t cell) const {
+  if (cell == mTarget) {
+    return 0;
+  }
+  uint16_t best = MAX_COST;
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    uint16_t next = maze.neighbour(cell, direction);
+    if (mCost[next] < best - 1 && hasExit(maze, next, Maze::behind(direction))) {
+      best = mCost[next] + 1;
+    }
+  }
+  return best;
+}
+
+void IncrementalFlood::updateCell(Maze &maze, uint16_t cell) {
+  mRhs[cell] = calculateRhs(maze, cell);
+  if (mCost[cell] != mRhs[cell]) {
+    mQueue.set(cell, mCost[cell] < mRhs[cell] ? mCost[cell] : mRhs[cell]);
+  } else {
+    mQueue.remove(cell);
+  }
+}
+
+void IncrementalFlood::markDirty(uint16_t cell) {
+  if (mDirty[cell] == 0) {
+    mDirty[cell] = 1;
+    mDirtyList[mDirtyCount++] = cell;
+  }
+}
+
+void IncrementalFlood::markCostChanged(Maze &maze, uint16_t cell) {
+  markDirty(cell);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    markDirty(maze.neighbour(cell, direction));
+  }
+}
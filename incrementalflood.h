@@ -0,0 +1,116 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef INCREMENTALFLOOD_H
+#define INCREMENTALFLOOD_H
+
+#include <cstdint>
+#include "indexedheap.h"
+#include "mazeconstants.h"
+
+class Maze;
+
+/*
+ * Incremental replanning for the manhattan flood.
+ *
+ * During a search the map is flooded after every cell but each new cell
+ * changes only a handful of walls. An IncrementalFlood attached to a Maze
+ * with Maze::setIncrementalFlood() is told about every wall that changes.
+ * The next manhattan flood with the same target and mask repairs only the
+ * cells whose cost is affected, using Lifelong Planning A* with a zero
+ * heuristic, and then recalculates directions around those cells.
+ *
+ * The costs and directions left in the maze are exactly those a full
+ * flood would give. A full flood is run instead whenever the target, mask
+ * or maze size changes, after load() or clearData(), or if more walls
+ * have changed than the change log can hold.
+ *
+ * The planner keeps its own copy of the costs so other floods may use the
+ * maze in between. It needs about 6k bytes for a 32x32 maze.
+ */
+class IncrementalFlood {
+ public:
+  /// running totals so that the work saved can be measured
+  struct Counters {
+    /// all floods handled by the planner
+    uint32_t floods = 0;
+    /// floods that had to start from scratch
+    uint32_t fullFloods = 0;
+    /// floods that repaired the previous result
+    uint32_t incrementalFloods = 0;
+    /// cells taken from the queue and expanded, summed over all floods
+    uint32_t cellExpansions = 0;
+    /// cells expanded by the most recent flood
+    uint32_t lastExpansions = 0;
+  };
+
+  static const int MAX_CELLS = 1024;
+  static const int MAX_CHANGES = 64;
+
+  IncrementalFlood();
+
+  /// flood the maze for the given target, repairing the last result if possible
+  uint16_t flood(Maze &maze, uint16_t target, int open_close_mask);
+  /// called by the maze whenever the wall or seen flag between a cell and its neighbour changes
+  void wallChanged(uint16_t cell, uint8_t direction);
+  /// forget the last result so that the next flood starts from scratch
+  void invalidate();
+  /// true if the next flood with the same target and mask can be a repair
+  bool isValid() const;
+
+  const Counters &counters() const;
+  void resetCounters();
+
+ private:
+  struct WallChange {
+    uint16_t cell;
+    uint8_t direction;
+  };
+
+  uint16_t mCost[MAX_CELLS];
+  uint16_t mRhs[MAX_CELLS];
+  uint8_t mDirection[MAX_CELLS];
+  uint8_t mDirty[MAX_CELLS];
+  uint16_t mDirtyList[MAX_CELLS];
+  int mDirtyCount = 0;
+  WallChange mChanges[MAX_CHANGES];
+  int mChangeCount = 0;
+  bool mValid = false;
+  uint16_t mTarget = 0;
+  int mMask = OPEN_MASK;
+  uint16_t mWidth = 0;
+  IndexedHeap<uint16_t> mQueue;
+  Counters mCounters;
+
+  uint32_t fullFlood(Maze &maze);
+  uint32_t repair(Maze &maze);
+  bool hasExit(const Maze &maze, uint16_t cell, uint8_t direction) const;
+  uint16_t calculateRhs(Maze &maze, uint16_t cell) const;
+  void updateCell(Maze &maze, uint16_t cell);
+  void markDirty(uint16_t cell);
+  void markCostChanged(Maze &maze, uint16_t cell);
+};
+
+#endif  // INCREMENTALFLOOD_H
@@ -0,0 +1,262 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+#include <cassert>
+#include <cstdint>
+
+/*
+ * An indexed d-ary min-heap for the floods.
+ *
+ * Every queued item is filed under an integer key - normally the cell
+ * address - and a position map records where each key currently sits
+ * in the heap. That lets a flood lower the cost of a cell that is
+ * already queued (decrease-key) instead of adding a second copy of it.
+ *
+ * Unlike PriorityQueue, both fetchSmallest() and update() are O(log n)
+ * and the item storage grows as needed so there is no fixed limit on
+ * the number of queued items. Only the key range is fixed at construction.
+ *
+ * Items with equal priority are returned in the order they were first
+ * queued so that floods are deterministic.
+ *
+ * item_t must provide operator<.
+ */
+template <class item_t, int ARITY = 4>
+class IndexedHeap {
+ public:
+  explicit IndexedHeap(int keyCount = 1024, int capacity = 128) : mKeyCount(keyCount), mCapacity(capacity) {
+    assert(keyCount > 0);
+    assert(capacity > 0);
+    mData = new Entry[mCapacity];
+    mPosition = new int[mKeyCount];
+    for (int i = 0; i < mKeyCount; i++) {
+      mPosition[i] = NOT_QUEUED;
+    }
+  }
+
+  IndexedHeap(const IndexedHeap<item_t, ARITY> &rhs) = delete;
+  IndexedHeap<item_t, ARITY> &operator=(const IndexedHeap<item_t, ARITY> &rhs) = delete;
+
+  ~IndexedHeap() {
+    delete[] mData;
+    delete[] mPosition;
+  }
+
+  int size() const { return mItemCount; }
+
+  int capacity() const { return mCapacity; }
+
+  int keyCount() const { return mKeyCount; }
+
+  bool contains(int key) const { return mPosition[key] != NOT_QUEUED; }
+
+  /*
+   * Only the keys actually queued are touched so clearing a nearly
+   * empty heap is cheap.
+   */
+  void clear() {
+    for (int i = 0; i < mItemCount; i++) {
+      mPosition[mData[i].key] = NOT_QUEUED;
+    }
+    mItemCount = 0;
+    mSequence = 0;
+  }
+
+  /*
+   * Queue the item under the given key. If the key is already queued, the
+   * stored item is replaced only if the new one is smaller (decrease-key).
+   * Returns true if the heap was changed.
+   */
+  bool update(int key, item_t item) {
+    assert(key >= 0 && key < mKeyCount);
+    int pos = mPosition[key];
+    if (pos == NOT_QUEUED) {
+      if (mItemCount == mCapacity) {
+        grow();
+      }
+      pos = mItemCount++;
+      mData[pos].item = item;
+      mData[pos].key = key;
+      mData[pos].sequence = mSequence++;
+      mPosition[key] = pos;
+      siftUp(pos);
+      return true;
+    }
+    if (!(item < mData[pos].item)) {
+      return false;
+    }
+    mData[pos].item = item;
+    siftUp(pos);
+    return true;
+  }
+
+  /*
+   * Queue the item under the given key, replacing any item already queued
+   * under that key whether it is larger or smaller.
+   */
+  void set(int key, item_t item) {
+    assert(key >= 0 && key < mKeyCount);
+    int pos = mPosition[key];
+    if (pos == NOT_QUEUED) {
+      update(key, item);
+      return;
+    }
+    mData[pos].item = item;
+    siftUp(pos);
+    siftDown(mPosition[key]);
+  }
+
+  /// remove the item queued under the given key, if there is one
+  void remove(int key) {
+    assert(key >= 0 && key < mKeyCount);
+    int pos = mPosition[key];
+    if (pos == NOT_QUEUED) {
+      return;
+    }
+    mPosition[key] = NOT_QUEUED;
+    --mItemCount;
+    if (pos == mItemCount) {
+      return;
+    }
+    int movedKey = mData[mItemCount].key;
+    place(pos, mData[mItemCount]);
+    siftUp(pos);
+    siftDown(mPosition[movedKey]);
+  }
+
+  /// return the key of the smallest item without removing it
+  int topKey() const {
+    assert(mItemCount > 0);
+    return mData[0].key;
+  }
+
+  /*
+   * Remove and return the smallest item. Where items are equal, the
+   * one queued first is returned.
+   */
+  item_t fetchSmallest() {
+    assert(mItemCount > 0);
+    item_t smallest = mData[0].item;
+    mPosition[mData[0].key] = NOT_QUEUED;
+    --mItemCount;
+    if (mItemCount > 0) {
+      mData[0] = mData[mItemCount];
+      mPosition[mData[0].key] = 0;
+      siftDown(0);
+    }
+    return smallest;
+  }
+
+ protected:
+  static const int NOT_QUEUED = -1;
+
+  struct Entry {
+    item_t item;
+    int key;
+    uint32_t sequence;
+  };
+
+  Entry *mData;
+  int *mPosition;
+  const int mKeyCount;
+  int mCapacity;
+  int mItemCount = 0;
+  uint32_t mSequence = 0;
+
+  bool isBefore(Entry &a, Entry &b) {
+    if (a.item < b.item) {
+      return true;
+    }
+    if (b.item < a.item) {
+      return false;
+    }
+    return a.sequence < b.sequence;
+  }
+
+  void place(int pos, const Entry &entry) {
+    mData[pos] = entry;
+    mPosition[entry.key] = pos;
+  }
+
+  void siftUp(int pos) {
+    Entry entry = mData[pos];
+    while (pos > 0) {
+      int parent = (pos - 1) / ARITY;
+      if (!isBefore(entry, mData[parent])) {
+        break;
+      }
+      place(pos, mData[parent]);
+      pos = parent;
+    }
+    place(pos, entry);
+  }
+
+  void siftDown(int pos) {
+    Entry entry = mData[pos];
+    while (true) {
+      int first = pos * ARITY + 1;
+      if (first >= mItemCount) {
+        break;
+      }
+      int last = first + ARITY;
+      if (last > mItemCount) {
+        last = mItemCount;
+      }
+      int best = first;
+      for (int child = first + 1; child < last; child++) {
+        if (isBefore(mData[child], mData[best])) {
+          best = child;
+        }
+      }
+      if (!isBefore(mData[best], entry)) {
+        break;
+      }
+      place(pos, mData[best]);
+      pos = best;
+    }
+    place(pos, entry);
+  }
+
+  /// A key can only be queued once so the heap never needs more than mKeyCount entries
+  void grow() {
+    int newCapacity = mCapacity * 2;
+    if (newCapacity > mKeyCount) {
+      newCapacity = mKeyCount;
+    }
+    assert(newCapacity > mCapacity);
+    Entry *newData = new Entry[newCapacity];
+    for (int i = 0; i < mItemCount; i++) {
+      newData[i] = mData[i];
+    }
+    delete[] mData;
+    mData = newData;
+    mCapacity = newCapacity;
+  }
+};
+
+#endif  // INDEXEDHEAP_H
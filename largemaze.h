@@ -0,0 +1,385 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef LARGEMAZE_H
+#define LARGEMAZE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include "floodinfo.h"
+#include "indexedheap.h"
+#include "maze.h"
+#include "mazeconstants.h"
+
+/*
+ * A maze of any width with storage sized to fit.
+ *
+ * Maze keeps fixed arrays for 32x32 cells and 16 bit cell addresses and
+ * costs, which is all a contest maze needs. LargeMaze holds the same wall
+ * bytes, costs and directions in vectors of width * width entries so that
+ * memory grows with the maze rather than being fixed at the largest size.
+ *
+ * The cell address and cost types are template parameters. The defaults
+ * of 32 bits give room for mazes of 1024x1024 and more and for runlength
+ * costs well beyond MAX_COST.
+ *
+ * Cells are numbered and wrap at the edges exactly as in Maze and the
+ * wall bytes use the same format, so data can be copied between the two
+ * with load() and save().
+ *
+ * The floods are the same as the Maze floods with HEAP_QUEUE. For any maze
+ * that both can hold, the costs and directions are identical. The linear
+ * PriorityQueue and its fixed capacity would not cope with larger mazes.
+ * TIME_FLOOD and DIAGONAL_FLOOD are not available here: their state tables
+ * are sized for Maze.
+ */
+template <class cell_t = uint32_t, class cost_t = uint32_t>
+class LargeMaze {
+ public:
+  explicit LargeMaze(cell_t width) { setWidth(width); }
+
+  /// the cost of a cell that no flood has reached
+  static cost_t maxCost() { return std::numeric_limits<cost_t>::max(); }
+
+  cell_t width() const { return mWidth; }
+  size_t numCells() const { return mWalls.size(); }
+
+  /// resize the maze and clear all the data
+  void setWidth(cell_t width) {
+    assert(width > 0);
+    assert((uint64_t)width * width - 1 <= std::numeric_limits<cell_t>::max());
+    mWidth = width;
+    size_t cells = (size_t)width * width;
+    mWalls.assign(cells, ALL_UNSEEN);
+    mCost.assign(cells, maxCost());
+    mDirection.assign(cells, NORTH);
+  }
+
+  /// the bytes used by the maze data
+  size_t memoryUsed() const {
+    return sizeof(*this) + mWalls.capacity() * sizeof(uint8_t) + mCost.capacity() * sizeof(cost_t) +
+           mDirection.capacity() * sizeof(uint8_t);
+  }
+
+  ///  reset the wall, cost and direction data to defaults
+  void clearData() {
+    std::fill(mWalls.begin(), mWalls.end(), ALL_UNSEEN);
+    std::fill(mCost.begin(), mCost.end(), maxCost());
+    std::fill(mDirection.begin(), mDirection.end(), NORTH);
+  }
+
+  /// clear the data and then set all the walls that exist in an empty maze
+  void resetToEmptyMaze() {
+    clearData();
+    for (cell_t i = 0; i < mWidth; i++) {
+      setWall(i, WEST);
+      setWall(mWidth * (mWidth - 1) + i, EAST);
+      setWall(i * mWidth, SOUTH);
+      setWall(mWidth * i + mWidth - 1, NORTH);
+    }
+    setWall(0, EAST);
+    clearWall(0, NORTH);
+  }
+
+  cell_t col(cell_t cell) const { return cell / mWidth; }
+  cell_t row(cell_t cell) const { return cell % mWidth; }
+  cell_t cellAt(cell_t col, cell_t row) const { return col * mWidth + row; }
+
+  /// the neighbouring cell, wrapping modulo numCells() as Maze::neighbour() does
+  cell_t neighbour(cell_t cell, uint8_t direction) const {
+    const size_t cells = numCells();
+    switch (direction) {
+      case NORTH:
+        return (cell_t)((cell + 1) % cells);
+      case EAST:
+        return (cell_t)((cell + mWidth) % cells);
+      case SOUTH:
+        return (cell_t)((cell + cells - 1) % cells);
+      default:
+        return (cell_t)((cell + cells - mWidth) % cells);
+    }
+  }
+
+  /// the raw wall byte, including the unseen flags
+  uint8_t getXWalls(cell_t cell) const { return mWalls[cell]; }
+
+  /// the walls of a cell with unseen walls treated as absent
+  uint8_t walls(cell_t cell) const { return mWalls[cell] & 0x0f; }
+
+  ///  test for the absence of a wall using the mask from the most recent flood
+  bool hasExit(cell_t cell, uint8_t direction) const { return (mWalls[cell] & (mOpenCloseMask << direction)) == 0; }
+
+  bool isVisited(cell_t cell) const { return (mWalls[cell] & ALL_UNSEEN) == 0; }
+
+  /// NOT TO BE USED IN SEARCH. Unconditionally set a  wall in a cell and mark as seen.
+  void setWall(cell_t cell, uint8_t direction) { writeWall(cell, direction, true); }
+
+  /// NOT TO BE USED IN SEARCH. Unconditionally clear a  wall in a cell and mark as seen.
+  void clearWall(cell_t cell, uint8_t direction) { writeWall(cell, direction, false); }
+
+  /// USE THIS FOR SEARCH. Update the unseen walls of a single cell with wall data
+  void updateMap(cell_t cell, uint8_t wallData) {
+    for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+      if (mWalls[cell] & (WALL_UNSEEN << direction)) {
+        writeWall(cell, direction, (wallData & (WALL_PRESENT << direction)) != 0);
+      }
+    }
+  }
+
+  /// copy wall bytes, including the unseen flags, from an array of numCells() entries
+  void load(const uint8_t *data) { std::copy(data, data + numCells(), mWalls.begin()); }
+
+  /// copy wall bytes, including the unseen flags, into an array of numCells() entries
+  void save(uint8_t *data) const { std::copy(mWalls.begin(), mWalls.end(), data); }
+
+  cost_t cost(cell_t cell) const { return mCost[cell]; }
+  uint8_t direction(cell_t cell) const { return mDirection[cell]; }
+
+  void setFloodType(Maze::FloodType floodType) { mFloodType = floodType; }
+  Maze::FloodType getFloodType() const { return mFloodType; }
+  uint16_t getCornerWeight() const { return mCornerWeight; }
+  void setCornerWeight(uint16_t cornerWeight) { mCornerWeight = cornerWeight; }
+  /// the costs of the runlength flood, as for Maze. A new maze has Maze::LOW_SPEED_PROFILE.
+  void setRunLengthProfile(Maze::RunLengthProfile profile) { mRunLengthTables = &Maze::runLengthProfileCosts(profile); }
+  /// tables of your own. They are not copied so they must last as long as the maze uses them.
+  void setRunLengthCosts(const RunLengthCostTables &tables) { mRunLengthTables = &tables; }
+  const RunLengthCostTables &runLengthCosts() const { return *mRunLengthTables; }
+
+  /// flood the maze for the given target and return the cost of cell zero.
+  /// A flood type that LargeMaze does not have leaves every cell unreached and returns maxCost().
+  cost_t flood(cell_t target, uint8_t openCloseMask) {
+    mOpenCloseMask = openCloseMask;
+    initialiseFloodCosts(target);
+    switch (mFloodType) {
+      case Maze::MANHATTAN_FLOOD:
+        manhattanFlood(target);
+        break;
+      case Maze::WEIGHTED_FLOOD:
+        weightedFlood(target);
+        break;
+      case Maze::RUNLENGTH_FLOOD:
+        runLengthFlood(target);
+        break;
+      case Maze::DIRECTION_FLOOD:
+        directionFlood(target);
+        return mCost[0];
+      case Maze::TIME_FLOOD:
+      case Maze::DIAGONAL_FLOOD:
+        mCost[target] = maxCost();
+        mDirection[target] = INVALID_DIRECTION;
+        return maxCost();
+    }
+    updateDirections(target);
+    return mCost[0];
+  }
+
+ protected:
+  /// queue entries for the floods. The same fields as FloodInfo but with wider cells and costs.
+  struct Entry {
+    cost_t cost = 0;
+    cell_t cell = 0;
+    uint8_t runLength = 0;
+    uint8_t entryDir = 0;
+    uint8_t entryWall = 0;
+
+    Entry() = default;
+    Entry(cost_t _cost, cell_t _cell, uint8_t _length, uint8_t inDir, uint8_t inWall = 0)
+        : cost(_cost), cell(_cell), runLength(_length), entryDir(inDir), entryWall(inWall) {}
+
+    bool operator<(const Entry &rhs) const { return cost < rhs.cost; }
+  };
+
+  void writeWall(cell_t cell, uint8_t direction, bool present) {
+    if (direction > WEST) {
+      return;
+    }
+    cell_t nextCell = neighbour(cell, direction);
+    uint8_t back = (direction + 2) & 0x03;
+    mWalls[cell] &= ~(WALL_UNSEEN << direction);
+    mWalls[nextCell] &= ~(WALL_UNSEEN << back);
+    if (present) {
+      mWalls[cell] |= WALL_PRESENT << direction;
+      mWalls[nextCell] |= WALL_PRESENT << back;
+    } else {
+      mWalls[cell] &= ~(WALL_PRESENT << direction);
+      mWalls[nextCell] &= ~(WALL_PRESENT << back);
+    }
+  }
+
+  void initialiseFloodCosts(cell_t target) {
+    std::fill(mCost.begin(), mCost.end(), maxCost());
+    std::fill(mDirection.begin(), mDirection.end(), INVALID_DIRECTION);
+    mCost[target] = 0;
+    mDirection[target] = NORTH;
+  }
+
+  /// breadth first. Each cell is queued once so a plain array serves as the queue.
+  void manhattanFlood(cell_t target) {
+    std::vector<cell_t> queue;
+    queue.reserve(numCells());
+    queue.push_back(target);
+    for (size_t head = 0; head < queue.size(); head++) {
+      cell_t cell = queue[head];
+      cost_t newCost = mCost[cell] + 1;
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        if (hasExit(cell, direction)) {
+          cell_t nextCell = neighbour(cell, direction);
+          if (mCost[nextCell] > newCost) {
+            mCost[nextCell] = newCost;
+            queue.push_back(nextCell);
+          }
+        }
+      }
+    }
+  }
+
+  void directionFlood(cell_t target) {
+    std::vector<cell_t> queue;
+    queue.reserve(numCells());
+    queue.push_back(target);
+    for (size_t head = 0; head < queue.size(); head++) {
+      cell_t here = queue[head];
+      cost_t nextCost = mCost[here] + 1;
+      for (uint8_t exit = NORTH; exit <= WEST; exit++) {
+        if (hasExit(here, exit)) {
+          cell_t next = neighbour(here, exit);
+          if (mDirection[next] == INVALID_DIRECTION) {
+            mDirection[next] = Maze::behind(exit);
+            mCost[next] = nextCost;
+            queue.push_back(next);
+          }
+        }
+      }
+    }
+  }
+
+  /// the same as Maze::weightedFloodHeap()
+  void weightedFlood(cell_t target) {
+    IndexedHeap<Entry> queue((int)numCells());
+    const cost_t aheadCost = 2;
+    queue.update(target, Entry(0, target, 0, NORTH));
+    while (queue.size() > 0) {
+      cell_t here = queue.fetchSmallest().cell;
+      cost_t costHere = mCost[here];
+      uint8_t thisDirection = mDirection[here];
+      for (uint8_t exitDirection = NORTH; exitDirection <= WEST; exitDirection++) {
+        if (!hasExit(here, exitDirection)) {
+          continue;
+        }
+        cell_t nextCell = neighbour(here, exitDirection);
+        cost_t newCost = costHere + (thisDirection == exitDirection ? aheadCost : mCornerWeight);
+        if (mCost[nextCell] > newCost) {
+          mCost[nextCell] = newCost;
+          mDirection[nextCell] = exitDirection;
+          queue.update(nextCell, Entry(newCost, nextCell, 0, exitDirection));
+        }
+      }
+    }
+  }
+
+  /// the same as Maze::runLengthFloodHeap(), using the runlength costs set on this maze
+  void runLengthFlood(cell_t target) {
+    IndexedHeap<Entry> queue((int)numCells());
+    const uint8_t entryDirs[] = {DIR_N, DIR_E, DIR_S, DIR_W};
+    const RunLengthCost policy(mRunLengthTables->ortho, mRunLengthTables->diag, RunLengthCostTables::LENGTHS - 1);
+    const cost_t startCost = policy.startCost();
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (hasExit(target, exitWall)) {
+        cell_t nextCell = neighbour(target, exitWall);
+        queue.update(nextCell, Entry(startCost, nextCell, 1, entryDirs[exitWall], (exitWall + 2) & 0x03));
+        mCost[nextCell] = startCost;
+      }
+    }
+    while (queue.size() > 0) {
+      Entry entry = queue.fetchSmallest();
+      FloodInfo info(0, 0, entry.runLength, entry.entryDir, entry.entryWall);
+      for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+        if (exitWall == entry.entryWall || !hasExit(entry.cell, exitWall)) {
+          continue;
+        }
+        cell_t nextCell = neighbour(entry.cell, exitWall);
+        FloodInfo next;
+        cost_t newCost = mCost[entry.cell] + policy.stepCost(info, exitWall, next);
+        if (newCost >= mCost[nextCell]) {
+          continue;
+        }
+        mCost[nextCell] = newCost;
+        queue.update(nextCell, Entry(newCost, nextCell, next.runLength, next.entryDir, next.entryWall));
+      }
+    }
+  }
+
+  /*
+   * Point each cell at its cheapest open neighbour. The manhattan flood breaks
+   * ties by the chebyshev distance to the target, as Maze does, and the others
+   * take the first cheapest exit clockwise from north.
+   */
+  void updateDirections(cell_t target) {
+    const bool chebyshevTies = mFloodType == Maze::MANHATTAN_FLOOD;
+    const long targetCol = col(target);
+    const long targetRow = row(target);
+    for (size_t cell = 0; cell < numCells(); cell++) {
+      uint8_t smallestDirection = INVALID_DIRECTION;
+      cost_t smallestCost = maxCost();
+      long smallestChebyshev = std::numeric_limits<long>::max();
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        if (!hasExit((cell_t)cell, direction)) {
+          continue;
+        }
+        cell_t next = neighbour((cell_t)cell, direction);
+        cost_t neighbourCost = mCost[next];
+        if (neighbourCost > smallestCost || neighbourCost == maxCost()) {
+          continue;
+        }
+        long cheb = 0;
+        if (chebyshevTies) {
+          cheb = std::max(std::labs((long)col(next) - targetCol), std::labs((long)row(next) - targetRow));
+        }
+        if (neighbourCost < smallestCost || cheb < smallestChebyshev) {
+          smallestCost = neighbourCost;
+          smallestDirection = direction;
+          smallestChebyshev = cheb;
+        }
+      }
+      mDirection[cell] = smallestDirection;
+    }
+  }
+
+  cell_t mWidth = 0;
+  /// wall and unseen flags in the same format as Maze
+  std::vector<uint8_t> mWalls;
+  std::vector<cost_t> mCost;
+  std::vector<uint8_t> mDirection;
+  uint8_t mOpenCloseMask = OPEN_MASK;
+  Maze::FloodType mFloodType = Maze::RUNLENGTH_FLOOD;
+  uint16_t mCornerWeight = 3;
+  const RunLengthCostTables *mRunLengthTables = &Maze::runLengthProfileCosts(Maze::LOW_SPEED_PROFILE);
+};
+
+#endif  // LARGEMAZE_H
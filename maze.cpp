@@ -25,31 +25,36 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
+#include "bucketqueue.h"
+#include "corridorgraph.h"
+#include "deadendfill.h"
 #include "floodinfo.h"
+#include "incrementalflood.h"
 #include "maze.h"
 #include "mazeconstants.h"
 #include "priorityqueue.h"
 
 /*
- * The runlength flood calculates costs based on the length of straights
+ * The runlength flood calculates costs based on the length of straights.
+ * The tables for the built in profiles are made when the library is compiled.
  */
-const uint16_t orthoCostTable[] =
-    // low speed costs ( vturn = 1.5m/s/s, acc = 13000 mm/s/s)
-    {
-        0, 98, 75, 63, 55, 50, 46, 43, 40, 38, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+static constexpr RunLengthCostTables runLengthProfiles[] = {
+    makeRunLengthCosts(LOW_SPEED_MOTION),
+    makeRunLengthCosts(HIGH_SPEED_MOTION),
 };
 
-const uint16_t diagCostTable[] =
-    // low speed costs ( vturn = 1.5m/s/s, acc = 13000 mm/s/s)
-    {
-        0, 73, 58, 50, 44, 40, 37, 35, 33, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31,
-};
-
-// high speed costs (vturn = 2000 mm/s, acc = 16667 mm/s/s)
-//{0,56,47,41,37,34,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31,31};
+// the tables that were pasted in by hand before they were generated
+static_assert(runLengthProfiles[Maze::LOW_SPEED_PROFILE].ortho[1] == 98, "low speed straights");
+static_assert(runLengthProfiles[Maze::LOW_SPEED_PROFILE].ortho[30] == 36, "low speed straights");
+static_assert(runLengthProfiles[Maze::LOW_SPEED_PROFILE].diag[1] == 73, "low speed diagonals");
+static_assert(runLengthProfiles[Maze::LOW_SPEED_PROFILE].diag[30] == 31, "low speed diagonals");
 
-Maze::Maze(uint16_t width) : mWidth(width) {
+Maze::Maze(uint16_t width) : mWidth(width), mPlanes(width) {
+  for (uint16_t i = 0; i < numCells(); i++) {
+    mPlanes.setCellWalls(i, xWalls[i]);
+  }
   addToGoalArea(DEFAULT_GOAL);
   //  resetToEmptyMaze();
 };
@@ -58,7 +63,7 @@ uint16_t Maze::width() const {
   return mWidth;
 }
 
-uint16_t Maze::numCells() {
+uint16_t Maze::numCells() const {
   return mWidth * mWidth;
 }
 
@@ -67,8 +72,18 @@ void Maze::clearData() {
     mCost[i] = MAX_COST;
     mDirection[i] = NORTH;
     xWalls[i] = 0xf0;  // all unseen exits
+    mPlanes.setCellWalls(i, xWalls[i]);
   }
   clearGoalArea();
+  if (mIncremental) {
+    mIncremental->invalidate();
+  }
+  if (mCorridors) {
+    mCorridors->invalidate();
+  }
+  if (mDeadEnds) {
+    mDeadEnds->invalidate();
+  }
 }
 
 void Maze::resetToEmptyMaze() {
@@ -168,27 +183,27 @@ uint8_t Maze::differenceBetween(uint8_t oldDirection, uint8_t newDirection) {
   return static_cast<uint8_t>((newDirection - oldDirection) & 0x03);
 }
 
-uint16_t Maze::cellNorth(uint16_t cell) {
+uint16_t Maze::cellNorth(uint16_t cell) const {
   uint16_t nextCell = (cell + uint16_t(1)) % numCells();
   return nextCell;
 }
 
-uint16_t Maze::cellEast(uint16_t cell) {
+uint16_t Maze::cellEast(uint16_t cell) const {
   uint16_t nextCell = (cell + width()) % numCells();
   return nextCell;
 }
 
-uint16_t Maze::cellSouth(uint16_t cell) {
+uint16_t Maze::cellSouth(uint16_t cell) const {
   uint16_t nextCell = (cell + numCells() - uint16_t(1)) % numCells();
   return nextCell;
 }
 
-uint16_t Maze::cellWest(uint16_t cell) {
+uint16_t Maze::cellWest(uint16_t cell) const {
   uint16_t nextCell = (cell + numCells() - width()) % numCells();
   return nextCell;
 }
 
-uint16_t Maze::neighbour(uint16_t cell, uint16_t direction) {
+uint16_t Maze::neighbour(uint16_t cell, uint16_t direction) const {
   uint16_t neighbour;
   switch (direction) {
     case NORTH:
@@ -209,7 +224,7 @@ uint16_t Maze::neighbour(uint16_t cell, uint16_t direction) {
   return neighbour;
 }
 
-uint16_t Maze::home() {
+uint16_t Maze::home() const {
   return 0;
 }
 
@@ -238,7 +253,7 @@ uint16_t Maze::goal() const {
  */
 void Maze::setGoal(uint16_t goal) {
   clearGoalArea();
-  goalArea.push_back(goal);
+  goalArea.add(goal);
 }
 
 /***
@@ -250,57 +265,51 @@ void Maze::setGoal(uint16_t goal) {
 void Maze::setGoalArea(const int *goal_area, const int count) {
   clearGoalArea();
   for (int i = 0; i < count; i++) {
-    goalArea.push_back(goal_area[i]);
+    goalArea.add(goal_area[i]);
   }
 }
 
 uint8_t Maze::walls(uint16_t cell) const {
-  uint8_t result = 0;
-  for (int i = 0; i < 4; i++) {
-    if (!hasExit(cell, i)) {
-      result |= (1 << i);
-    }
-  }
-  return result;
+  return walls(cell, mOpenCloseMask);
 }
 
-uint8_t Maze::openWalls(uint16_t cell) {
-  int openCloseMask = mOpenCloseMask;
-  mOpenCloseMask = OPEN_MASK;
+uint8_t Maze::walls(uint16_t cell, uint8_t open_close_mask) const {
   uint8_t result = 0;
   for (int i = 0; i < 4; i++) {
-    if (!hasExit(cell, i)) {
+    if (!hasExit(cell, i, open_close_mask)) {
       result |= (1 << i);
     }
   }
-  mOpenCloseMask = openCloseMask;
   return result;
 }
 
-uint8_t Maze::closedWalls(uint16_t cell) {
-  int openCloseMask = mOpenCloseMask;
-  mOpenCloseMask = CLOSED_MASK;
-  uint8_t result = 0;
-  for (int i = 0; i < 4; i++) {
-    if (!hasExit(cell, i)) {
-      result |= (1 << i);
-    }
-  }
-  mOpenCloseMask = openCloseMask;
-  return result;
+/*
+ * These used to swap mOpenCloseMask in and out around the query, which meant
+ * two threads could not read the same maze. They now pass the mask down.
+ */
+uint8_t Maze::openWalls(uint16_t cell) const {
+  return walls(cell, OPEN_MASK);
+}
+
+uint8_t Maze::closedWalls(uint16_t cell) const {
+  return walls(cell, CLOSED_MASK);
 }
 
 bool Maze::hasExit(uint16_t cell, uint8_t direction) const {
-  uint8_t maskedWalls = xWalls[cell] & (mOpenCloseMask << direction);
+  return hasExit(cell, direction, mOpenCloseMask);
+}
+
+bool Maze::hasExit(uint16_t cell, uint8_t direction, uint8_t open_close_mask) const {
+  uint8_t maskedWalls = xWalls[cell] & (open_close_mask << direction);
   return maskedWalls == 0;
 }
 
-bool Maze::hasRealExit(uint16_t cell, uint8_t direction) {
+bool Maze::hasRealExit(uint16_t cell, uint8_t direction) const {
   uint8_t maskedWalls = xWalls[cell] & (CLOSED_MASK << direction);
   return maskedWalls == 0;
 }
 
-uint8_t Maze::direction(uint16_t cell) {
+uint8_t Maze::direction(uint16_t cell) const {
   return mDirection[cell];
 }
 
@@ -308,23 +317,58 @@ void Maze::setDirection(uint16_t cell, uint8_t direction) {
   mDirection[cell] = direction;
 }
 
-bool Maze::isVisited(uint16_t cell) {
+bool Maze::isVisited(uint16_t cell) const {
   return (xWalls[cell] & ALL_UNSEEN) == 0;
 }
 
-bool Maze::isVisited(uint16_t cell, uint8_t direction) {
+bool Maze::isVisited(uint16_t cell, uint8_t direction) const {
   return (xWalls[cell] & WALL_UNSEEN << direction) == 0;
 }
-bool Maze::is_not_seen(uint16_t cell, uint8_t direction) {
+bool Maze::is_not_seen(uint16_t cell, uint8_t direction) const {
   return (xWalls[cell] & WALL_UNSEEN << direction) != 0;
 }
 
 void Maze::setVisited(uint16_t cell) {
+  uint8_t oldWalls = xWalls[cell];
   xWalls[cell] &= ~ALL_UNSEEN;
+  mPlanes.setCellWalls(cell, xWalls[cell]);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    notifyWallChange(cell, direction, oldWalls, 0, MAX_COST);
+  }
 }
 
 void Maze::clearVisited(uint16_t cell) {
+  uint8_t oldWalls = xWalls[cell];
   xWalls[cell] |= ALL_UNSEEN;
+  mPlanes.setCellWalls(cell, xWalls[cell]);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    notifyWallChange(cell, direction, oldWalls, 0, MAX_COST);
+  }
+}
+
+/*
+ * Only changes that affect the given wall, as seen from either side, are passed on.
+ * A nextCell of MAX_COST means that only the wall as seen from cell can have changed.
+ */
+void Maze::notifyWallChange(uint16_t cell, uint8_t direction, uint8_t oldWalls, uint8_t oldNextWalls, uint16_t nextCell) {
+  if (!mIncremental && !mCorridors && !mDeadEnds) {
+    return;
+  }
+  const uint8_t wallBits = (uint8_t)((WALL_PRESENT | WALL_UNSEEN) << direction);
+  bool changed = ((oldWalls ^ xWalls[cell]) & wallBits) != 0;
+  if (nextCell != MAX_COST) {
+    const uint8_t nextWallBits = (uint8_t)((WALL_PRESENT | WALL_UNSEEN) << opposite(direction));
+    changed = changed || ((oldNextWalls ^ xWalls[nextCell]) & nextWallBits) != 0;
+  }
+  if (changed && mIncremental) {
+    mIncremental->wallChanged(cell, direction);
+  }
+  if (changed && mCorridors) {
+    mCorridors->wallChanged(cell, direction);
+  }
+  if (changed && mDeadEnds) {
+    mDeadEnds->wallChanged(cell, direction);
+  }
 }
 
 /*
@@ -334,7 +378,12 @@ void Maze::clearVisited(uint16_t cell) {
  * To update the maze when running, use updateWalls(cell,wallData)
  */
 void Maze::setWall(uint16_t cell, uint8_t direction) {
+  if (direction > WEST) {
+    return;  // do nothing -although this is an error
+  }
   uint16_t nextCell = neighbour(cell, direction);
+  uint8_t oldWalls = xWalls[cell];
+  uint8_t oldNextWalls = xWalls[nextCell];
   switch (direction) {
     case NORTH:
       xWalls[cell] &= ~UNSEEN_NORTH;
@@ -363,6 +412,9 @@ void Maze::setWall(uint16_t cell, uint8_t direction) {
     default:;  // do nothing -although this is an error
       break;
   }
+  mPlanes.setCellWalls(cell, xWalls[cell]);
+  mPlanes.setCellWalls(nextCell, xWalls[nextCell]);
+  notifyWallChange(cell, direction, oldWalls, oldNextWalls, nextCell);
 }
 
 /*
@@ -372,7 +424,12 @@ void Maze::setWall(uint16_t cell, uint8_t direction) {
  * To update the maze when running, use updateMap(cell,wallData)
  */
 void Maze::clearWall(uint16_t cell, uint8_t direction) {
+  if (direction > WEST) {
+    return;  // do nothing -although this is an error
+  }
   uint16_t nextCell = neighbour(cell, direction);
+  uint8_t oldWalls = xWalls[cell];
+  uint8_t oldNextWalls = xWalls[nextCell];
   switch (direction) {
     case NORTH:
       xWalls[cell] &= ~UNSEEN_NORTH;
@@ -401,6 +458,9 @@ void Maze::clearWall(uint16_t cell, uint8_t direction) {
     default:;  // do nothing -although this is an error
       break;
   }
+  mPlanes.setCellWalls(cell, xWalls[cell]);
+  mPlanes.setCellWalls(nextCell, xWalls[nextCell]);
+  notifyWallChange(cell, direction, oldWalls, oldNextWalls, nextCell);
 }
 
 /*
@@ -439,7 +499,7 @@ void Maze::updateMap(uint16_t cell, uint8_t wallData) {
   }
 }
 
-uint16_t Maze::cost(uint16_t cell) {
+uint16_t Maze::cost(uint16_t cell) const {
   return mCost[cell];
 }
 
@@ -447,7 +507,7 @@ uint16_t Maze::cost(uint16_t cell) {
  * Distance is returned based upon the setting of the wall flag.
  * No account is taken of the 'wall seen' flag.
  */
-uint16_t Maze::costNorth(uint16_t cell) {
+uint16_t Maze::costNorth(uint16_t cell) const {
   if (!hasExit(cell, NORTH)) {
     return MAX_COST;
   }
@@ -455,7 +515,7 @@ uint16_t Maze::costNorth(uint16_t cell) {
   return mCost[cell];
 }
 
-uint16_t Maze::costEast(uint16_t cell) {
+uint16_t Maze::costEast(uint16_t cell) const {
   if (hasExit(cell, EAST)) {
     cell = cellEast(cell);
     return mCost[cell];
@@ -464,7 +524,7 @@ uint16_t Maze::costEast(uint16_t cell) {
   }
 }
 
-uint16_t Maze::costSouth(uint16_t cell) {
+uint16_t Maze::costSouth(uint16_t cell) const {
   if (hasExit(cell, SOUTH)) {
     cell = cellSouth(cell);
     return mCost[cell];
@@ -473,7 +533,7 @@ uint16_t Maze::costSouth(uint16_t cell) {
   }
 }
 
-uint16_t Maze::costWest(uint16_t cell) {
+uint16_t Maze::costWest(uint16_t cell) const {
   if (hasExit(cell, WEST)) {
     cell = cellWest(cell);
     return mCost[cell];
@@ -482,7 +542,7 @@ uint16_t Maze::costWest(uint16_t cell) {
   }
 }
 
-uint16_t Maze::cost(uint16_t cell, uint16_t direction) {
+uint16_t Maze::cost(uint16_t cell, uint16_t direction) const {
   uint16_t result;
   switch (direction) {
     case NORTH:
@@ -503,11 +563,18 @@ uint16_t Maze::cost(uint16_t cell, uint16_t direction) {
   return result;
 }
 
+uint16_t Maze::cost(uint16_t cell, uint16_t direction, uint8_t open_close_mask) const {
+  if (direction > WEST || !hasExit(cell, direction, open_close_mask)) {
+    return MAX_COST;
+  }
+  return mCost[neighbour(cell, direction)];
+}
+
 void Maze::setCost(uint16_t cell, uint16_t cost) {
   mCost[cell] = cost;
 }
 
-uint8_t Maze::directionToSmallest(uint16_t cell) {
+uint8_t Maze::directionToSmallest(uint16_t cell) const {
   const uint8_t directions[] = {NORTH, EAST, SOUTH, WEST};
   uint8_t smallestDirection = INVALID_DIRECTION;
   uint16_t smallestCost = MAX_COST;
@@ -521,7 +588,7 @@ uint8_t Maze::directionToSmallest(uint16_t cell) {
   return smallestDirection;
 }
 
-uint8_t Maze::directionToSmallest(uint16_t cell, uint16_t target) {
+uint8_t Maze::directionToSmallest(uint16_t cell, uint16_t target) const {
   const uint8_t directions[] = {NORTH, EAST, SOUTH, WEST};
   uint8_t smallestDirection = INVALID_DIRECTION;
   uint16_t smallestCost = MAX_COST;
@@ -547,35 +614,185 @@ uint8_t Maze::directionToSmallest(uint16_t cell, uint16_t target) {
 }
 
 void Maze::updateDirections(const uint16_t target) {
-  for (uint16_t i = 0; i < numCells(); i++) {
-    if (mFloodType == MANHATTAN_FLOOD) {
-      mDirection[i] = directionToSmallest(i, target);
-    } else {
-      mDirection[i] = directionToSmallest(i);
+  const FloodDirections directions = mFloodType == MANHATTAN_FLOOD ? CHEAPEST_TOWARDS_TARGET : CHEAPEST_NEIGHBOUR;
+  FloodOutput out = ownOutput();
+  withWidthPolicy([&](auto geometry) {
+    updateDirections(geometry, out, target, directions);
+    return 0;
+  });
+}
+
+template <class geometry_t>
+void Maze::updateDirections(geometry_t geometry, FloodOutput &out, const uint16_t target,
+                            FloodDirections directions) const {
+  if (directions == DIRECTIONS_FROM_FLOOD) {
+    return;
+  }
+  if (directions == CHEAPEST_TOWARDS_TARGET) {
+    updateManhattanDirections(out, target);
+    return;
+  }
+  for (uint16_t i = 0; i < geometry.numCells(); i++) {
+    out.setDirection(i, directionToSmallest(geometry, out, i));
+  }
+}
+
+/// the same as directionToSmallest(cell) using the width policy for the neighbours
+template <class geometry_t>
+uint8_t Maze::directionToSmallest(geometry_t geometry, const FloodOutput &out, uint16_t cell) const {
+  uint8_t smallestDirection = INVALID_DIRECTION;
+  uint16_t smallestCost = MAX_COST;
+  for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+    if (!out.hasExit(cell, dir)) {
+      continue;
+    }
+    uint16_t neighbourCost = out.getCost(geometry.neighbour(cell, dir));
+    if (neighbourCost < smallestCost) {
+      smallestCost = neighbourCost;
+      smallestDirection = dir;
     }
   }
+  return smallestDirection;
+}
+
+/// the neighbours of the cell in column c and row r, wrapping at the edges as neighbour() does
+static inline void wrappedNeighbours(int c, int r, int top, int *neighbourCol, int *neighbourRow) {
+  neighbourCol[NORTH] = r < top ? c : (c < top ? c + 1 : 0);
+  neighbourRow[NORTH] = r < top ? r + 1 : 0;
+  neighbourCol[EAST] = c < top ? c + 1 : 0;
+  neighbourRow[EAST] = r;
+  neighbourCol[SOUTH] = r > 0 ? c : (c > 0 ? c - 1 : top);
+  neighbourRow[SOUTH] = r > 0 ? r - 1 : top;
+  neighbourCol[WEST] = c > 0 ? c - 1 : top;
+  neighbourRow[WEST] = r;
 }
 
-uint16_t Maze::chebyshevDistance(uint16_t cell, uint16_t target) {
+/// the exit to the cheapest neighbour, ties going to the one nearest the target
+static inline uint8_t smallestManhattanDirection(uint8_t walls, uint8_t mask, const uint16_t *cost, int width,
+                                                 const int *neighbourCol, const int *neighbourRow, int targetCol,
+                                                 int targetRow) {
+  uint8_t smallestDirection = INVALID_DIRECTION;
+  uint16_t smallestCost = MAX_COST;
+  int smallestChebyshev = MAX_COST;
+  for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+    if (walls & (mask << dir)) {
+      continue;  // same as cost(cell, dir) returning MAX_COST
+    }
+    uint16_t neighbourCost = cost[neighbourCol[dir] * width + neighbourRow[dir]];
+    if (neighbourCost > smallestCost || neighbourCost == MAX_COST) {
+      continue;
+    }
+    int cheb = std::max(std::abs(neighbourCol[dir] - targetCol), std::abs(neighbourRow[dir] - targetRow));
+    if (neighbourCost < smallestCost || cheb < smallestChebyshev) {
+      smallestCost = neighbourCost;
+      smallestDirection = dir;
+      smallestChebyshev = cheb;
+    }
+  }
+  return smallestDirection;
+}
+
+/*
+ * Gives the same result as calling directionToSmallest(cell, target) for every
+ * cell but walks the maze by column and row so that the neighbours and their
+ * chebyshev distances need no division. The wrap at the edges is the same
+ * as neighbour(): north from the top of a column is the bottom of the next
+ * and south from the bottom of a column is the top of the one before.
+ */
+void Maze::updateManhattanDirections(FloodOutput &out, const uint16_t target) const {
+  const int top = mWidth - 1;
+  const int targetCol = col(target);
+  const int targetRow = row(target);
+  uint16_t cell = 0;
+  for (int c = 0; c < mWidth; c++) {
+    for (int r = 0; r < mWidth; r++, cell++) {
+      int neighbourCol[4];
+      int neighbourRow[4];
+      wrappedNeighbours(c, r, top, neighbourCol, neighbourRow);
+      out.setDirection(cell, smallestManhattanDirection(out.walls[cell], out.mask, out.cost, mWidth, neighbourCol,
+                                                       neighbourRow, targetCol, targetRow));
+    }
+  }
+}
+
+uint16_t Maze::chebyshevDistance(uint16_t cell, uint16_t target) const {
   int dx = std::abs(col(cell) - col(target));
   int dy = std::abs(row(cell) - row(target));
   return static_cast<uint16_t>(std::max(dx, dy));
 }
 
-uint16_t Maze::manhattanDistance(uint16_t cell, uint16_t target) {
+uint16_t Maze::manhattanDistance(uint16_t cell, uint16_t target) const {
   int dx = std::abs(col(cell) - col(target));
   int dy = std::abs(row(cell) - row(target));
   return static_cast<uint16_t>(dx + dy);
 }
 
+/*
+ * The manhattan flood with BitFlood floods the closed and open mazes together
+ * when there is somewhere to put the closed costs. The maze keeps no room
+ * for them itself so without a workspace they go into a result on the stack.
+ */
 bool Maze::testForSolution() {  // takes less than 3ms
-  mPathCostClosed = flood(goal(), CLOSED_MASK);
-  mPathCostOpen = flood(goal(), OPEN_MASK);
+  if (!mWorkspace || !canFloodPair()) {
+    FloodResult closed;
+    return testForSolution(closed);
+  }
+  const uint16_t target = goal();
+  uint16_t *closedCost = mWorkspace->closedCosts();
+  BitFlood::floodPair(mPlanes, target, closedCost, mCost);
+  mPathCostClosed = closedCost[0];
+  finishPairedFlood(target);
   mIsSolved = mPathCostClosed == mPathCostOpen;
   return mIsSolved;
 };
 
-int32_t Maze::costDifference() {
+/*
+ * After a paired flood the closed directions are found from the closed
+ * costs in the same way as the open ones, so the result is the same as
+ * that of a separate closed flood.
+ *
+ * Otherwise the closed flood goes straight to the flood types, as the const
+ * flood() does, past the incremental planner, the corridor graph and the
+ * dead-end fill. They stay with the open mask that a search floods with and
+ * are not rebuilt for every change of mask.
+ */
+bool Maze::testForSolution(FloodResult &closed) {
+  const uint16_t target = goal();
+  if (canFloodPair()) {
+    BitFlood::floodPair(mPlanes, target, closed.mCost, mCost);
+    FloodOutput closedOut = {closed.mCost, closed.mDirection, xWalls, CLOSED_MASK, false};
+    updateManhattanDirections(closedOut, target);
+    mPathCostClosed = closed.mCost[0];
+    finishPairedFlood(target);
+  } else {
+    FloodOutput closedOut = ownOutput();
+    closedOut.cost = closed.mCost;
+    closedOut.direction = closed.mDirection;
+    closedOut.mask = CLOSED_MASK;
+    closedOut.fromGoalArea = false;
+    mPathCostClosed = flood(closedOut, mWorkspace, target);
+    mPathCostOpen = flood(target, OPEN_MASK);
+  }
+  closed.mPathCost = mPathCostClosed;
+  closed.mTarget = target;
+  closed.mMask = CLOSED_MASK;
+  closed.mWidth = mWidth;
+  mIsSolved = mPathCostClosed == mPathCostOpen;
+  return mIsSolved;
+}
+
+bool Maze::canFloodPair() const {
+  return mFloodType == MANHATTAN_FLOOD && mBitParallelFlood && !mIncremental && !mDeadEnds;
+}
+
+void Maze::finishPairedFlood(uint16_t target) {
+  mOpenCloseMask = OPEN_MASK;
+  FloodOutput out = ownOutput();
+  updateManhattanDirections(out, target);
+  mPathCostOpen = mCost[0];
+}
+
+int32_t Maze::costDifference() const {
   return int32_t(mPathCostClosed) - int32_t(mPathCostOpen);
 }
 
@@ -587,47 +804,337 @@ uint16_t Maze::closedMazeCost() const {
   return mPathCostClosed;
 }
 
+/*
+ * The floods are templates on a width policy. The 16 and 32 cell mazes get
+ * their own copies with the width fixed at compile time. Other widths, or
+ * any width once setFixedWidthFloods(false) is called, use RuntimeWidth.
+ */
+template <class function_t>
+auto Maze::withWidthPolicy(function_t function) const -> decltype(function(RuntimeWidth(16))) {
+  if (mFixedWidthFloods) {
+    switch (mWidth) {
+      case 16:
+        return function(FixedWidth<16>());
+      case 32:
+        return function(FixedWidth<32>());
+      default:
+        break;
+    }
+  }
+  return function(RuntimeWidth(mWidth));
+}
+
 uint16_t Maze::flood(uint16_t target, int open_close_mask) {
+  if (mIncremental && mFloodType == MANHATTAN_FLOOD) {
+    return mIncremental->flood(*this, target, open_close_mask);
+  }
+  if (mCorridors && mFloodType == MANHATTAN_FLOOD) {
+    return mCorridors->flood(*this, target, open_close_mask);
+  }
+  if (mDeadEnds && mFloodType <= DIRECTION_FLOOD) {
+    mDeadEnds->update(*this, open_close_mask);
+  }
   mOpenCloseMask = open_close_mask;
+  FloodOutput out = ownOutput();
+  return flood(out, mWorkspace, target);
+}
+
+/*
+ * Nothing in the maze is changed so any number of these can run at once,
+ * each with its own result and workspace. That includes the dead-end fill,
+ * which is used as it stands or not at all.
+ */
+uint16_t Maze::flood(uint16_t target, int open_close_mask, FloodResult &result, FloodWorkspace *workspace) const {
+  FloodOutput out = {result.mCost, result.mDirection, xWalls, static_cast<uint8_t>(open_close_mask), false};
+  result.mPathCost = flood(out, workspace, target);
+  result.mTarget = target;
+  result.mMask = static_cast<uint8_t>(open_close_mask);
+  result.mWidth = mWidth;
+  return result.mPathCost;
+}
+
+/*
+ * The first four flood types read the walls from out, so a dead-end fill
+ * only has to swap in its own walls for the length of the flood.
+ */
+uint16_t Maze::flood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
   uint16_t cost = MAX_COST;
+  const uint8_t *walls = out.walls;
+  if (mDeadEnds && mFloodType <= DIRECTION_FLOOD) {
+    out.walls = deadEndWalls(out, target);
+  }
   switch (mFloodType) {
     case MANHATTAN_FLOOD:
-      cost = manhattanFlood(target);
+      cost = manhattanFlood(out, workspace, target);
       break;
     case WEIGHTED_FLOOD:
-      cost = weightedFlood(target);
+      cost = weightedFlood(out, workspace, target);
       break;
     case RUNLENGTH_FLOOD:
-      cost = runLengthFlood(target);
+      cost = runLengthFlood(out, workspace, target);
       break;
     case DIRECTION_FLOOD:
-      cost = directionFlood(target);
+      cost = directionFlood(out, workspace, target);
+      break;
+    case TIME_FLOOD:
+      cost = timeFlood(out, workspace, target);
+      break;
+    case DIAGONAL_FLOOD:
+      cost = diagonalFlood(out, workspace, target);
       break;
   }
+  out.walls = walls;
   return cost;
 }
 
-static uint8_t getExitDirection[4][4] = {
-    {
-        255,
-        3,
-        4,
-        5,
-    },
-    {
-        7,
-        255,
-        5,
-        6,
-    },
-    {
-        0,
-        1,
-        255,
-        7,
-    },
-    {1, 2, 3, 255},
-};
+/// the walls of the dead-end fill, unless it is out of date for the mask or the flood starts from a filled cell
+const uint8_t *Maze::deadEndWalls(const FloodOutput &out, uint16_t target) const {
+  if (!mDeadEnds->isValid() || mDeadEnds->mask() != out.mask) {
+    return xWalls;
+  }
+  bool sourceFilled = false;
+  forEachFloodSource(out, target, [&](uint16_t source) { sourceFilled = sourceFilled || mDeadEnds->isFilled(source); });
+  return sourceFilled ? xWalls : mDeadEnds->walls();
+}
+
+Maze::FloodOutput Maze::ownOutput() {
+  FloodOutput out = {mCost, mDirection, xWalls, mOpenCloseMask, mFloodFromGoalArea};
+  if (mCellLayout != SPLIT_CELLS && !mWorkspace) {
+    mPackedCells.resize(PaddedOutput::storageSize(mWidth));
+    out.packedCells = mPackedCells.data();
+  }
+  return out;
+}
+
+/*
+ * With the packed and padded layouts the flood works on PackedCell records
+ * and finishFlood() copies the results back into out. The records come from
+ * the workspace if there is one, or else from the maze for a flood into the
+ * maze. Only a flood into a FloodResult with no workspace has to allocate
+ * them, since the maze may be shared by floods on other threads.
+ */
+template <class function_t>
+uint16_t Maze::withCellLayout(FloodOutput &out, FloodWorkspace *workspace, function_t function) const {
+  if (mCellLayout == SPLIT_CELLS) {
+    return function(out);
+  }
+  std::vector<PackedCell> localCells;
+  PackedCell *cells = out.packedCells;
+  if (workspace) {
+    cells = workspace->packedCells();
+  } else if (!cells) {
+    localCells.resize(PaddedOutput::storageSize(mWidth));
+    cells = localCells.data();
+  }
+  if (mCellLayout == PADDED_CELLS) {
+    PaddedOutput padded = {cells, &out, out.mask, out.fromGoalArea, mWidth};
+    return function(padded);
+  }
+  PackedOutput packed = {cells, &out, out.mask, out.fromGoalArea};
+  return function(packed);
+}
+
+template <class output_t, class function_t>
+uint16_t Maze::withGrid(const output_t &cells, function_t function) const {
+  return withWidthPolicy([&](auto geometry) { return function(cells.grid(geometry)); });
+}
+
+template <class geometry_t, class output_t>
+uint16_t Maze::finishFlood(geometry_t geometry, output_t &out, uint16_t target, FloodDirections directions) const {
+  FloodOutput &result = out.unpack(geometry.numCells());
+  updateDirections(geometry, result, target, directions);
+  return result.cost[0];
+}
+
+uint16_t Maze::finishFlood(FloodOutput &out, uint16_t target, FloodDirections directions, FloodResult &result) const {
+  withWidthPolicy([&](auto geometry) {
+    updateDirections(geometry, out, target, directions);
+    return 0;
+  });
+  result.mPathCost = out.cost[0];
+  result.mTarget = target;
+  result.mMask = out.mask;
+  result.mWidth = mWidth;
+  return result.mPathCost;
+}
+
+/*
+ * The same choices as updateDirections(): the cheapest neighbour, first in
+ * the order north, east, south, west, or for CHEAPEST_TOWARDS_TARGET the
+ * cheapest with ties going to the neighbour nearest the target. The edge
+ * cells have their outer walls closed so no direction leaves the maze.
+ */
+template <class geometry_t>
+uint16_t Maze::finishFlood(Padded<geometry_t> grid, PaddedOutput &out, uint16_t target,
+                           FloodDirections directions) const {
+  if (directions == DIRECTIONS_FROM_FLOOD) {
+    return out.unpack(grid.numCells()).cost[0];
+  }
+  const int targetCol = col(target);
+  const int targetRow = row(target);
+  const bool manhattan = directions == CHEAPEST_TOWARDS_TARGET;
+  for (int c = 0; c < mWidth; c++) {
+    uint16_t here = grid.index((uint16_t)(c * mWidth));
+    for (int r = 0; r < mWidth; r++, here++) {
+      uint8_t smallestDirection = INVALID_DIRECTION;
+      uint16_t smallestCost = MAX_COST;
+      int smallestChebyshev = MAX_COST;
+      for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+        if (!out.hasExit(here, dir)) {
+          continue;
+        }
+        uint16_t neighbourCost = out.getCost(grid.neighbour(here, dir));
+        if (!manhattan) {
+          if (neighbourCost < smallestCost) {
+            smallestCost = neighbourCost;
+            smallestDirection = dir;
+          }
+          continue;
+        }
+        if (neighbourCost > smallestCost || neighbourCost == MAX_COST) {
+          continue;
+        }
+        int nextCol = c + (dir == EAST) - (dir == WEST);
+        int nextRow = r + (dir == NORTH) - (dir == SOUTH);
+        int cheb = std::max(std::abs(nextCol - targetCol), std::abs(nextRow - targetRow));
+        if (neighbourCost < smallestCost || cheb < smallestChebyshev) {
+          smallestCost = neighbourCost;
+          smallestDirection = dir;
+          smallestChebyshev = cheb;
+        }
+      }
+      out.setDirection(here, smallestDirection);
+    }
+  }
+  return out.unpack(grid.numCells()).cost[0];
+}
+
+/*
+ * Every goal cell starts with a cost of zero so one flood finds the best
+ * route into the goal area from everywhere. The floods do not record where
+ * each route came from; since the directions always lead to a cheaper
+ * neighbour, following them from any reachable cell must end at a goal cell.
+ */
+uint16_t Maze::floodGoalArea(int open_close_mask) {
+  if (mDeadEnds && mFloodType <= DIRECTION_FLOOD) {
+    mDeadEnds->update(*this, open_close_mask);
+  }
+  mOpenCloseMask = open_close_mask;
+  mFloodFromGoalArea = true;
+  FloodOutput out = ownOutput();
+  uint16_t cost = flood(out, mWorkspace, goal());
+  mFloodFromGoalArea = false;
+  return cost;
+}
+
+/*
+ * A goal cell has a cost of zero and an unreachable cell has MAX_COST.
+ * Anything else leads on to a cheaper neighbour, so the walk ends unless
+ * the directions have been changed since the flood. It gives up after
+ * visiting every cell in case they have.
+ */
+uint16_t Maze::goalCellFor(uint16_t cell) const {
+  uint16_t here = cell;
+  for (uint16_t steps = 0; steps < numCells(); steps++) {
+    if (mCost[here] == 0) {
+      return here;
+    }
+    if (mCost[here] == MAX_COST || mDirection[here] == INVALID_DIRECTION) {
+      return MAX_COST;
+    }
+    here = neighbour(here, mDirection[here]);
+  }
+  return MAX_COST;
+}
+
+/*
+ * Each route is walked until it reaches a goal, a dead end or a cell whose
+ * goal is already known, then walked again to fill in every cell on the way
+ * so that no cell is visited more than twice.
+ */
+void Maze::goalCells(uint16_t *goalCell) const {
+  const uint16_t unknown = MAX_COST - 1;
+  for (uint16_t cell = 0; cell < numCells(); cell++) {
+    goalCell[cell] = unknown;
+  }
+  for (uint16_t cell = 0; cell < numCells(); cell++) {
+    uint16_t here = cell;
+    uint16_t steps = 0;
+    while (goalCell[here] == unknown && mCost[here] != 0 && mCost[here] != MAX_COST &&
+           mDirection[here] != INVALID_DIRECTION && steps < numCells()) {
+      here = neighbour(here, mDirection[here]);
+      steps++;
+    }
+    uint16_t found = goalCell[here];
+    if (found == unknown) {
+      found = mCost[here] == 0 ? here : MAX_COST;
+    }
+    here = cell;
+    for (uint16_t i = 0; i < steps; i++) {
+      goalCell[here] = found;
+      here = neighbour(here, mDirection[here]);
+    }
+    goalCell[here] = found;
+  }
+}
+
+RunLengthCost Maze::runLengthCost() const {
+  return RunLengthCost(mRunLengthTables->ortho, mRunLengthTables->diag, RunLengthCostTables::LENGTHS - 1);
+}
+
+void Maze::setRunLengthProfile(RunLengthProfile profile) {
+  mRunLengthTables = &runLengthProfiles[profile];
+}
+
+void Maze::setRunLengthCosts(const RunLengthCostTables &tables) {
+  mRunLengthTables = &tables;
+}
+
+const RunLengthCostTables &Maze::runLengthCosts() const {
+  return *mRunLengthTables;
+}
+
+const RunLengthCostTables &Maze::runLengthProfileCosts(RunLengthProfile profile) {
+  return runLengthProfiles[profile];
+}
+
+/*
+ * The cost of leaving the cell described by info through the given exit wall.
+ * Updates the run length and the new direction of travel.
+ */
+uint16_t Maze::runLengthStepCost(const FloodInfo &info, uint8_t exitWall, uint8_t &newRunLength,
+                                 uint8_t &exitDir) const {
+  FloodInfo next;
+  uint16_t cost = runLengthCost().stepCost(info, exitWall, next);
+  newRunLength = next.runLength;
+  exitDir = next.entryDir;
+  return cost;
+}
+
+uint16_t Maze::runLengthStartCost() const {
+  return mRunLengthTables->ortho[1];
+}
+
+uint16_t Maze::runLengthLeastStepCost() const {
+  uint16_t least = MAX_COST;
+  for (int i = 1; i < RunLengthCostTables::LENGTHS; i++) {
+    least = std::min(least, std::min(mRunLengthTables->ortho[i], mRunLengthTables->diag[i]));
+  }
+  return least;
+}
+
+/*
+ * Every flood is floodEngine() with the cost policy for its type. The
+ * policies and the engine are in floodengine.h.
+ */
+template <bool SETTLE_ON_FIRST_REACH, class policy_t, class geometry_t, class queue_t, class output_t>
+uint16_t Maze::runFlood(const policy_t &policy, geometry_t geometry, queue_t &queue, output_t &out,
+                        uint16_t target) const {
+  initialiseFloodCosts(geometry, out, target);
+  floodEngine<SETTLE_ON_FIRST_REACH>(policy, geometry, queue, out,
+                                     [&](auto seed) { forEachFloodSource(out, target, seed); });
+  return finishFlood(geometry, out, target, policy_t::DIRECTIONS);
+}
 
 /*
  * TODO: Initialising the queue needs to be more clever.
@@ -637,96 +1144,74 @@ static uint8_t getExitDirection[4][4] = {
  * exits
  */
 uint16_t Maze::runLengthFlood(uint16_t target) {
-  PriorityQueue<FloodInfo> queue;
-  initialiseFloodCosts(target);
-  seedQueue(queue, target, orthoCostTable[1]);
-  // each (accessible) cell will be processed only once
-  while ((queue.size() > 0)) {
-    FloodInfo info = queue.fetchSmallest();
-    /*
-     * test each wall for an exit. Skip any blocked, or already used exits
-     */
-    for (uint8_t exitWall = 0; exitWall < 4; exitWall++) {
-      if (exitWall == info.entryWall) {
-        continue;
-      }
-      if (!hasExit(info.cell, exitWall)) {
-        continue;
-      }
-      uint16_t nextCell = neighbour(info.cell, exitWall);
-      if (mCost[nextCell] < MAX_COST) {
-        continue;
+  FloodOutput out = ownOutput();
+  return runLengthFlood(out, mWorkspace, target);
+}
+
+/*
+ * The linear and bucket queues fix the cost of a cell the first time it is
+ * reached. With the heap a cell stays queued until it is the cheapest one
+ * left and any cheaper route found in the meantime replaces the queued
+ * entry, along with its run length and direction. The costs can therefore
+ * be lower than those from the linear queue.
+ */
+uint16_t Maze::runLengthFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  const RunLengthCost policy = runLengthCost();
+  return withCellLayout(out, workspace, [&](auto &cells) {
+    switch (mQueueType) {
+      case HEAP_QUEUE: {
+        if (workspace) {
+          IndexedHeap<FloodInfo> &queue = workspace->heap();
+          return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+        }
+        IndexedHeap<FloodInfo> queue(cells.storageSize(mWidth));
+        return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
       }
-      uint8_t exitDir = getExitDirection[info.entryWall][exitWall];
-      uint8_t newRunLength = info.runLength;
-      int turnSize = abs(info.entryDir - exitDir);
-      if (turnSize > 4) {
-        turnSize = static_cast<uint16_t>(8 - turnSize);
+      case BUCKET_QUEUE: {
+        if (workspace) {
+          BucketQueue<FloodInfo> &queue = workspace->bucketQueue();
+          return withGrid(cells, [&](auto grid) { return runFlood<true>(policy, grid, queue, cells, target); });
+        }
+        BucketQueue<FloodInfo> queue(cells.storageSize(mWidth));
+        return withGrid(cells, [&](auto grid) { return runFlood<true>(policy, grid, queue, cells, target); });
       }
-      uint16_t turnCost = 0;
-      ;
-      if (info.entryDir == exitDir) {
-        newRunLength++;
-      } else {
-        newRunLength = 1;
-        turnCost = static_cast<uint16_t>(turnSize * 22);  // MAGIC: empirical value for best-looking routes
+      default: {
+        if (workspace) {
+          PriorityQueue<FloodInfo> &queue = workspace->infoQueue();
+          return withGrid(cells, [&](auto grid) { return runFlood<true>(policy, grid, queue, cells, target); });
+        }
+        PriorityQueue<FloodInfo> queue;
+        return withGrid(cells, [&](auto grid) { return runFlood<true>(policy, grid, queue, cells, target); });
       }
-      uint16_t newCost = ((exitDir & 1) == 0) ? orthoCostTable[newRunLength] : diagCostTable[newRunLength];
-      newCost += turnCost + mCost[info.cell];
-      mCost[nextCell] = newCost;
-      queue.add(FloodInfo(newCost, nextCell, newRunLength, exitDir, opposite(exitWall)));
     }
-  }
-  updateDirections(target);
-  return mCost[0];
+  });
 }
 
 uint16_t Maze::manhattanFlood(uint16_t target) {
-  PriorityQueue<uint16_t> queue;
-  initialiseFloodCosts(target);
-  queue.add(target);
-  while (queue.size() > 0) {
-    uint16_t cell = queue.head();
-    uint16_t newCost = mCost[cell];
-    newCost++;
-    for (uint8_t direction = 0; direction < 4; direction++) {
-      if (hasExit(cell, direction)) {
-        uint16_t nextCell = neighbour(cell, direction);
-        if (mCost[nextCell] > newCost) {
-          mCost[nextCell] = newCost;
-          queue.add(nextCell);
-        }
-      }
-    }
-  }
-  updateDirections(target);
-  return mCost[0];
-};
+  FloodOutput out = ownOutput();
+  return manhattanFlood(out, mWorkspace, target);
+}
 
-void Maze::seedQueue(PriorityQueue<FloodInfo> &queue, uint16_t goal, uint16_t cost) {
-  if (hasExit(goal, NORTH)) {
-    uint16_t nextCell = cellNorth(goal);
-    queue.add(FloodInfo(cost, nextCell, 1, DIR_N, SOUTH));
-    mCost[nextCell] = cost;
-  }
-  if (hasExit(goal, EAST)) {
-    uint16_t nextCell = cellEast(goal);
-    queue.add(FloodInfo(cost, nextCell, 1, DIR_E, WEST));
-    mCost[nextCell] = cost;
+uint16_t Maze::manhattanFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  // BitFlood works from the planes of the maze walls so it cannot see a dead-end fill
+  if (mBitParallelFlood && !out.fromGoalArea && out.walls == xWalls) {
+    BitFlood::flood(mPlanes, target, out.mask, out.cost);
+    return withWidthPolicy([&](auto geometry) {
+      return finishFlood(geometry, out, target, ManhattanCost::DIRECTIONS);
+    });
   }
-  if (hasExit(goal, SOUTH)) {
-    uint16_t nextCell = cellSouth(goal);
-    queue.add(FloodInfo(cost, nextCell, 1, DIR_S, NORTH));
-    mCost[nextCell] = cost;
-  }
-  if (hasExit(goal, WEST)) {
-    uint16_t nextCell = cellWest(goal);
-    queue.add(FloodInfo(cost, nextCell, 1, DIR_W, EAST));
-    mCost[nextCell] = cost;
-  }
-}
+  const ManhattanCost policy;
+  return withCellLayout(out, workspace, [&](auto &cells) {
+    if (workspace) {
+      PriorityQueue<uint16_t> &queue = workspace->cellQueue();
+      return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+    }
+    PriorityQueue<uint16_t> queue;
+    return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+  });
+};
 
-bool Maze::isSolved() {
+bool Maze::isSolved() const {
   return mIsSolved;
 }
 
@@ -739,49 +1224,70 @@ void Maze::save(uint8_t *data) {
 void Maze::load(const uint8_t *data) {
   for (int i = 0; i < numCells(); i++) {
     xWalls[i] = data[i];
+    mPlanes.setCellWalls(i, xWalls[i]);
+  }
+  if (mIncremental) {
+    mIncremental->invalidate();
+  }
+  if (mCorridors) {
+    mCorridors->invalidate();
+  }
+  if (mDeadEnds) {
+    mDeadEnds->invalidate();
   }
 }
 
-void Maze::initialiseFloodCosts(uint16_t target) {
+template <class geometry_t, class output_t>
+void Maze::initialiseFloodCosts(geometry_t geometry, output_t &out, uint16_t target) const {
   // set every cell as unexamined
-  for (uint16_t i = 0; i < numCells(); i++) {
-    mCost[i] = MAX_COST;
-    mDirection[i] = INVALID_DIRECTION;
+  out.reset(geometry.numCells());
+  // except the target or targets
+  forEachFloodSource(out, target, [&](uint16_t source) {
+    out.setCost(source, 0);
+    out.setDirection(source, NORTH);
+  });
+}
+
+template <class output_t, class function_t>
+void Maze::forEachFloodSource(const output_t &out, uint16_t target, function_t function) const {
+  if (!out.fromGoalArea || goalArea.empty()) {
+    function(out.index(target));
+    return;
+  }
+  for (uint16_t cell : goalArea) {
+    function(out.index(cell));
   }
-  // except the target
-  mCost[target] = 0;
-  mDirection[target] = NORTH;
 }
 
 uint16_t Maze::weightedFlood(uint16_t target) {
-  PriorityQueue<int> queue;
-  const uint16_t aheadCost = 2;
-
-  initialiseFloodCosts(target);
-  queue.add(target);
-  while (queue.size() > 0) {
-    uint16_t newCost;
-    auto here = static_cast<uint16_t>(queue.head());
-    uint16_t costHere = mCost[here];
-    uint8_t thisDirection = mDirection[here];
-    for (uint8_t exitDirection = 0; exitDirection < 4; exitDirection++) {
-      if (hasExit(here, exitDirection)) {
-        uint16_t nextCell = neighbour(here, exitDirection);
-        if (thisDirection == exitDirection) {
-          newCost = costHere + aheadCost;
-        } else {
-          newCost = costHere + mCornerWeight;
-        }
-        if (mCost[nextCell] > newCost) {
-          mCost[nextCell] = newCost;
-          mDirection[nextCell] = exitDirection;
-          queue.add(nextCell);
-        }
+  FloodOutput out = ownOutput();
+  return weightedFlood(out, mWorkspace, target);
+}
+
+/*
+ * With the linear queue, used first-in first-out, a cell goes back on the
+ * queue every time its cost is lowered. With the heap the cheapest cell is
+ * always expanded next and is never expanded twice. A queued cell whose cost
+ * is lowered just has its heap entry updated.
+ */
+uint16_t Maze::weightedFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  const WeightedCost policy(mCornerWeight);
+  return withCellLayout(out, workspace, [&](auto &cells) {
+    if (mQueueType == HEAP_QUEUE) {
+      if (workspace) {
+        IndexedHeap<FloodInfo> &queue = workspace->heap();
+        return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
       }
+      IndexedHeap<FloodInfo> queue(cells.storageSize(mWidth));
+      return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
     }
-  }
-  updateDirections(target);
-  return mCost[0];
+    if (workspace) {
+      PriorityQueue<uint16_t> &queue = workspace->cellQueue();
+      return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+    }
+    PriorityQueue<uint16_t> queue;
+    return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+  });
 }
 
 /** Although the direction flood uses only directions
@@ -790,34 +1296,145 @@ uint16_t Maze::weightedFlood(uint16_t target) {
  */
 
 uint16_t Maze::directionFlood(uint16_t target) {
-  PriorityQueue<int> queue;
-  initialiseFloodCosts(target);
-  queue.add(target);
-  while (queue.size() > 0) {
-    auto here = static_cast<uint16_t>(queue.head());
-    auto nextCost = static_cast<uint16_t>(mCost[here] + 1);
-    for (uint8_t exit = 0; exit < 4; exit++) {
-      if (hasExit(here, exit)) {
-        uint16_t next = neighbour(here, exit);
-        if (mDirection[next] == INVALID_DIRECTION) {
-          mDirection[next] = behind(exit);
-          mCost[next] = nextCost;
-          queue.add(next);
-        }
-      }
+  FloodOutput out = ownOutput();
+  return directionFlood(out, mWorkspace, target);
+}
+
+uint16_t Maze::directionFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  const DirectionCost policy;
+  return withCellLayout(out, workspace, [&](auto &cells) {
+    if (workspace) {
+      PriorityQueue<uint16_t> &queue = workspace->cellQueue();
+      return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
     }
+    PriorityQueue<uint16_t> queue;
+    return withGrid(cells, [&](auto grid) { return runFlood<false>(policy, grid, queue, cells, target); });
+  });
+}
+
+uint16_t Maze::timeFlood(uint16_t target) {
+  FloodOutput out = ownOutput();
+  return timeFlood(out, mWorkspace, target);
+}
+
+uint16_t Maze::timeFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  uint16_t sources[GoalArea::MAX_SIZE];
+  int sourceCount = 0;
+  forEachFloodSource(out, target, [&](uint16_t source) { sources[sourceCount++] = source; });
+  if (workspace) {
+    workspace->timeFlood(mMotionProfile).flood(*this, sources, sourceCount, out.mask, out.cost, out.direction);
+  } else {
+    TimeFlood flood(mMotionProfile);
+    flood.flood(*this, sources, sourceCount, out.mask, out.cost, out.direction);
   }
-  return mCost[0];
+  return out.cost[0];
+}
+
+uint16_t Maze::diagonalFlood(uint16_t target) {
+  FloodOutput out = ownOutput();
+  return diagonalFlood(out, mWorkspace, target);
+}
+
+uint16_t Maze::diagonalFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const {
+  uint16_t sources[GoalArea::MAX_SIZE];
+  int sourceCount = 0;
+  forEachFloodSource(out, target, [&](uint16_t source) { sources[sourceCount++] = source; });
+  if (workspace) {
+    return workspace->diagonalFlood().flood(*this, sources, sourceCount, out.mask, out.cost, out.direction);
+  }
+  DiagonalFlood flood;
+  return flood.flood(*this, sources, sourceCount, out.mask, out.cost, out.direction);
 }
 
 void Maze::setFloodType(Maze::FloodType mFloodType) {
   Maze::mFloodType = mFloodType;
 }
 
+void Maze::setQueueType(Maze::QueueType queueType) {
+  mQueueType = queueType;
+}
+
+Maze::QueueType Maze::getQueueType() const {
+  return mQueueType;
+}
+
+void Maze::setCellLayout(Maze::CellLayout layout) {
+  mCellLayout = layout;
+}
+
+Maze::CellLayout Maze::getCellLayout() const {
+  return mCellLayout;
+}
+
+void Maze::setIncrementalFlood(IncrementalFlood *planner) {
+  mIncremental = planner;
+  if (mIncremental) {
+    mIncremental->invalidate();
+  }
+}
+
+IncrementalFlood *Maze::incrementalFlood() const {
+  return mIncremental;
+}
+
+void Maze::setCorridorGraph(CorridorGraph *graph) {
+  mCorridors = graph;
+  if (mCorridors) {
+    mCorridors->invalidate();
+  }
+}
+
+CorridorGraph *Maze::corridorGraph() const {
+  return mCorridors;
+}
+
+void Maze::setDeadEndFill(DeadEndFill *fill) {
+  mDeadEnds = fill;
+  if (mDeadEnds) {
+    mDeadEnds->invalidate();
+  }
+}
+
+DeadEndFill *Maze::deadEndFill() const {
+  return mDeadEnds;
+}
+
+void Maze::setFloodWorkspace(FloodWorkspace *workspace) {
+  mWorkspace = workspace;
+}
+
+FloodWorkspace *Maze::floodWorkspace() const {
+  return mWorkspace;
+}
+
+void Maze::setBitParallelFlood(bool enabled) {
+  mBitParallelFlood = enabled;
+}
+
+bool Maze::getBitParallelFlood() const {
+  return mBitParallelFlood;
+}
+
+void Maze::setFixedWidthFloods(bool enabled) {
+  mFixedWidthFloods = enabled;
+}
+
+bool Maze::getFixedWidthFloods() const {
+  return mFixedWidthFloods;
+}
+
 uint16_t Maze::getCornerWeight() const {
   return mCornerWeight;
 }
 
+const MotionProfile &Maze::getMotionProfile() const {
+  return mMotionProfile;
+}
+
+void Maze::setMotionProfile(const MotionProfile &profile) {
+  mMotionProfile = profile;
+}
+
 void Maze::setCornerWeight(uint16_t cornerWeight) {
   Maze::mCornerWeight = cornerWeight;
 }
@@ -828,6 +1445,7 @@ Maze::FloodType Maze::getFloodType() const {
 
 void Maze::setWidth(uint16_t mWidth) {
   Maze::mWidth = mWidth;
+  mPlanes.setWidth(mWidth);
   resetToEmptyMaze();
 }
 
@@ -835,12 +1453,16 @@ uint8_t Maze::getXWalls(int cell) const {
   return xWalls[cell];
 }
 
+const WallPlanes &Maze::wallPlanes() const {
+  return mPlanes;
+}
+
 void Maze::clearGoalArea() {
   goalArea.clear();
 }
 
 void Maze::addToGoalArea(int cell) {
-  goalArea.push_back(cell);
+  goalArea.add(cell);
 }
 
 /***
@@ -853,7 +1475,7 @@ void Maze::removeFromGoalArea(int cell) {
 }
 
 bool Maze::goalContains(int cell) const {
-  return end(goalArea) != find(begin(goalArea), end(goalArea), cell);
+  return goalArea.contains(cell);
 }
 
 int Maze::goalAreaSize() const {
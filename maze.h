@@ -29,23 +29,52 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstdio>
-#include <list>
 #include <vector>
+#include "bitflood.h"
+#include "bucketqueue.h"
+#include "floodengine.h"
 #include "floodinfo.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "goalarea.h"
+#include "indexedheap.h"
+#include "mazegeometry.h"
 #include "mazeconstants.h"
+#include "packedcells.h"
 #include "priorityqueue.h"
+#include "runlengthcosts.h"
+#include "wallplanes.h"
 
 /// TODO: is the closed maze needed? is it enough to see if the path has unvisited cells?
 
+class CorridorGraph;
+class DeadEndFill;
+class IncrementalFlood;
+
 using namespace std;
 class Maze {
  public:
   explicit Maze(uint16_t width);
-  enum FloodType { MANHATTAN_FLOOD, WEIGHTED_FLOOD, RUNLENGTH_FLOOD, DIRECTION_FLOOD };
+  /// TIME_FLOOD finds the quickest route for the motion profile rather than the shortest. See timeflood.h
+  /// DIAGONAL_FLOOD floods the wall midpoints with runlength costs. See diagonalflood.h
+  enum FloodType { MANHATTAN_FLOOD, WEIGHTED_FLOOD, RUNLENGTH_FLOOD, DIRECTION_FLOOD, TIME_FLOOD, DIAGONAL_FLOOD };
+  /// The runlength cost profiles built in to the library. LOW_SPEED_PROFILE is the default. See runlengthcosts.h
+  enum RunLengthProfile { LOW_SPEED_PROFILE, HIGH_SPEED_PROFILE };
+  /// The queue used by the weighted and runlength floods.
+  /// LINEAR_QUEUE is the original PriorityQueue with a linear search for the smallest item.
+  /// HEAP_QUEUE is an IndexedHeap that lowers the cost of queued cells in place (decrease-key).
+  /// BUCKET_QUEUE is a BucketQueue. Only used by the runlength flood, with results identical to LINEAR_QUEUE.
+  enum QueueType { LINEAR_QUEUE, HEAP_QUEUE, BUCKET_QUEUE };
+  /// How the queue based floods hold the cells while they run.
+  /// SPLIT_CELLS works directly on the separate wall, cost and direction arrays.
+  /// PACKED_CELLS floods on one PackedCell record per cell and copies the results back. See packedcells.h
+  /// PADDED_CELLS uses the same records with a ring of closed sentinel cells round the maze so that moving
+  /// to a neighbour is a single add from an offset table. The floods never wrap from one edge to the other.
+  enum CellLayout { SPLIT_CELLS, PACKED_CELLS, PADDED_CELLS };
 
   /// the maze is assumed to be square
   uint16_t width() const;  ///
-  uint16_t numCells();     ///
+  uint16_t numCells() const;  ///
 
   ///  reset the wall, cost and direction data to defaults
   void clearData();
@@ -57,9 +86,9 @@ class Maze {
 
   /// return the column number of  given cell
 
-  inline uint16_t col(uint16_t cell) { return cell / mWidth; }
+  inline uint16_t col(uint16_t cell) const { return cell / mWidth; }
   /// return the roww number of a given cell
-  inline uint16_t row(uint16_t cell) { return cell % mWidth; }
+  inline uint16_t row(uint16_t cell) const { return cell % mWidth; }
 
   /// return the address of the cell ahead from this cardinal direction
   static uint8_t ahead(uint8_t direction);
@@ -75,19 +104,19 @@ class Maze {
 
   // static functions about neighbours
   /// return the address of the cell in the indicated direction
-  uint16_t cellNorth(uint16_t cell);
+  uint16_t cellNorth(uint16_t cell) const;
   /// return the address of the cell in the indicated direction
-  uint16_t cellEast(uint16_t cell);
+  uint16_t cellEast(uint16_t cell) const;
   /// return the address of the cell in the indicated direction
-  uint16_t cellSouth(uint16_t cell);
+  uint16_t cellSouth(uint16_t cell) const;
   /// return the address of the cell in the indicated direction
-  uint16_t cellWest(uint16_t cell);
+  uint16_t cellWest(uint16_t cell) const;
 
   /// return the address of the cell in the given direction
-  uint16_t neighbour(uint16_t cell, uint16_t direction);
+  uint16_t neighbour(uint16_t cell, uint16_t direction) const;
 
   /// return the address of the home cell. Nearly always cell zero
-  uint16_t home();
+  uint16_t home() const;
   /// return the cell address of the current goal
   uint16_t goal() const;
   ///  set the current goal to a new value
@@ -96,21 +125,25 @@ class Maze {
 
   /// return the state of the four walls surrounding a given cell
   uint8_t walls(uint16_t cell) const;
-  uint8_t openWalls(uint16_t cell);
-  uint8_t closedWalls(uint16_t cell);
+  /// the walls of a cell with unseen walls treated as given by the mask (OPEN_MASK or CLOSED_MASK)
+  uint8_t walls(uint16_t cell, uint8_t open_close_mask) const;
+  uint8_t openWalls(uint16_t cell) const;
+  uint8_t closedWalls(uint16_t cell) const;
   ///  test for the absence of a wall. Don't care if it is seen or not
   bool hasExit(uint16_t cell, uint8_t direction) const;
+  /// test for the absence of a wall with unseen walls treated as given by the mask
+  bool hasExit(uint16_t cell, uint8_t direction, uint8_t open_close_mask) const;
 
   ///  it is not clear that these two mthods have any actual use
   ///  test for the definite, observed absence of a wall.
-  bool hasRealExit(uint16_t cell, uint8_t direction);
+  bool hasRealExit(uint16_t cell, uint8_t direction) const;
 
-  bool has_real_wall(uint16_t cell, uint8_t direction) {
+  bool has_real_wall(uint16_t cell, uint8_t direction) const {
     uint8_t maskedWalls = xWalls[cell] & (CLOSED_MASK << direction);
     return maskedWalls == OPEN_MASK << direction;
   }
 
-  bool has_wall_left(uint16_t cell, uint8_t direction) {
+  bool has_wall_left(uint16_t cell, uint8_t direction) const {
     switch (direction) {
       case NORTH:
         return has_real_wall(cell, WEST);
@@ -125,7 +158,7 @@ class Maze {
     }
   }
 
-  bool has_wall_right(uint16_t cell, uint8_t direction) {
+  bool has_wall_right(uint16_t cell, uint8_t direction) const {
     switch (direction) {
       case NORTH:
         return has_real_wall(cell, EAST);
@@ -141,14 +174,14 @@ class Maze {
   }
 
   /// return the stored direction for the given cell
-  uint8_t direction(uint16_t cell);
+  uint8_t direction(uint16_t cell) const;
   /// set the direction for the given cell
   void setDirection(uint16_t cell, uint8_t direction);
 
   /// test to see if  all the walls of a given cell have been seen
-  bool isVisited(uint16_t cell);
-  bool isVisited(uint16_t cell, uint8_t direction);
-  bool is_not_seen(uint16_t cell, uint8_t direction);
+  bool isVisited(uint16_t cell) const;
+  bool isVisited(uint16_t cell, uint8_t direction) const;
+  bool is_not_seen(uint16_t cell, uint8_t direction) const;
   /// set a cell as having all the walls seen
   void setVisited(uint16_t cell);
   /// set a cell as having none of the walls seen
@@ -163,17 +196,19 @@ class Maze {
   void updateMap(uint16_t cell, uint8_t wallData);
 
   /// return the cost value for a given cell. Used in flooding and searching
-  uint16_t cost(uint16_t cell);
+  uint16_t cost(uint16_t cell) const;
   /// return the cost in the neighbouring cell in the given direction
-  uint16_t cost(uint16_t cell, uint16_t direction);
+  uint16_t cost(uint16_t cell, uint16_t direction) const;
+  /// the cost in the neighbouring cell in the given direction with unseen walls treated as given by the mask
+  uint16_t cost(uint16_t cell, uint16_t direction, uint8_t open_close_mask) const;
   /// return the cost in the neighbouring cell to the North
-  uint16_t costNorth(uint16_t cell);
+  uint16_t costNorth(uint16_t cell) const;
   /// return the cost in the neighbouring cell to the East
-  uint16_t costEast(uint16_t cell);
+  uint16_t costEast(uint16_t cell) const;
   /// return the cost in the neighbouring cell to the South
-  uint16_t costSouth(uint16_t cell);
+  uint16_t costSouth(uint16_t cell) const;
   /// return the cost in the neighbouring cell to the West
-  uint16_t costWest(uint16_t cell);
+  uint16_t costWest(uint16_t cell) const;
 
   /// set the cost in the given cell.
   void setCost(uint16_t cell, uint16_t cost);  ///
@@ -183,9 +218,14 @@ class Maze {
   /// return the cost of the current best path assuming unknowns are present
   uint16_t closedMazeCost() const;
   /// return the difference between the open and closed cost. Zero when the best route is found.
-  int32_t costDifference();
+  int32_t costDifference() const;
   /// flood the maze for the give goal
   uint16_t flood(uint16_t target, int open_close_mask);
+  /// Flood with the current flood type into the result instead of this maze. The maze is not changed,
+  /// so several floods can run at once, each with its own result and workspace. The incremental planner is
+  /// not used, and neither is an attached dead-end fill unless it is already up to date for the mask, since
+  /// bringing it up to date would change it. Returns the cost from cell 0, as flood() does.
+  uint16_t flood(uint16_t target, int open_close_mask, FloodResult &result, FloodWorkspace *workspace = nullptr) const;
   /// RunLengthFlood is a specific kind of flood used in this mouse
   uint16_t runLengthFlood(uint16_t target);
   /// manhattanFlood is a the simplest kind of flood used in this mouse
@@ -194,21 +234,68 @@ class Maze {
   uint16_t weightedFlood(uint16_t target);
   /// directionFlood does not care about costs, only using direction pointers
   uint16_t directionFlood(uint16_t target);
+  /// timeFlood costs each cell by the time to run from it to the target, in ms. The cost from cell 0,
+  /// which it returns, is the estimated run time. It ignores the queue type and cell layout.
+  uint16_t timeFlood(uint16_t target);
+  /// diagonalFlood costs each cell by the exact runlength cost of its best route on the wall midpoints,
+  /// diagonals included. It ignores the queue type and cell layout.
+  uint16_t diagonalFlood(uint16_t target);
+  /// The runlength cost of leaving a cell through exitWall after arriving as described by info.
+  /// Also returns the run length and direction for the next cell. Shared with the route queries.
+  uint16_t runLengthStepCost(const FloodInfo &info, uint8_t exitWall, uint8_t &newRunLength, uint8_t &exitDir) const;
+  /// The runlength cost of the first step out of the target cell
+  uint16_t runLengthStartCost() const;
+  /// The least that any one step can cost in the runlength flood
+  uint16_t runLengthLeastStepCost() const;
+  /// The cost policy of the runlength flood, for use with floodWith()
+  RunLengthCost runLengthCost() const;
+  /// Choose the costs of the runlength flood for this maze from the profiles built in to the library.
+  /// A new maze has LOW_SPEED_PROFILE. AStar, BidirectionalSearch, DiagonalFlood and ContractionIndex use
+  /// the costs of the maze they are given.
+  void setRunLengthProfile(RunLengthProfile profile);
+  /// Use tables made by makeRunLengthCosts() for a profile of your own. They are not copied so they must
+  /// last as long as the maze uses them. See runlengthcosts.h
+  void setRunLengthCosts(const RunLengthCostTables &tables);
+  const RunLengthCostTables &runLengthCosts() const;
+  /// the tables of one of the profiles built in to the library
+  static const RunLengthCostTables &runLengthProfileCosts(RunLengthProfile profile);
+  /// Flood with a cost policy of your own into the result. See floodengine.h. The maze is not changed.
+  /// The flood always uses an IndexedHeap, from the workspace if there is one, so the step costs
+  /// only need to be positive. Returns the cost from cell 0, as flood() does.
+  template <class policy_t>
+  uint16_t floodWith(const policy_t &policy, uint16_t target, int open_close_mask, FloodResult &result,
+                     FloodWorkspace *workspace = nullptr) const;
+
+  /// Flood from every cell of the goal area at once with the current flood type.
+  /// Afterwards goalCellFor() tells which goal cell the route from any cell ends at.
+  uint16_t floodGoalArea(int open_close_mask);
+  /// The goal cell reached by following the directions from the cell after floodGoalArea(), found by
+  /// walking the route. MAX_COST if the goal area cannot be reached from the cell. Only valid until the
+  /// next flood into the maze.
+  uint16_t goalCellFor(uint16_t cell) const;
+  /// goalCellFor() for every cell at once, into an array of numCells() entries supplied by the caller
+  void goalCells(uint16_t *goalCell) const;
 
   /// Flood the maze both open and closed and then test the cost difference
-  /// leaves the maze with unknowns clear
+  /// leaves the maze with unknowns clear. The open maze results are left in cost() and direction().
+  /// The manhattan flood floods both mazes in one pass when a workspace is attached to hold the
+  /// closed costs, and runs two floods otherwise. The incremental planner, corridor graph and dead-end
+  /// fill are only used for the open flood so that they follow the walls of a search without starting
+  /// again for every change of mask.
   bool testForSolution();
+  /// As above, keeping the costs and directions of the closed maze flood in the given result
+  bool testForSolution(FloodResult &closed);
   /// returns the result of the most recent test for a solution
-  bool isSolved();
+  bool isSolved() const;
 
   ///  return the direction from the given cell to the least costly neighbour
-  uint8_t directionToSmallest(uint16_t cell);
-  uint8_t directionToSmallest(uint16_t cell, uint16_t target);
+  uint8_t directionToSmallest(uint16_t cell) const;
+  uint8_t directionToSmallest(uint16_t cell, uint16_t target) const;
   /// for every cell in the maze, calculate and store the least costly direction
   void updateDirections(const uint16_t target);
 
-  uint16_t chebyshevDistance(uint16_t cell, uint16_t target);
-  uint16_t manhattanDistance(uint16_t cell, uint16_t target);
+  uint16_t chebyshevDistance(uint16_t cell, uint16_t target) const;
+  uint16_t manhattanDistance(uint16_t cell, uint16_t target) const;
   /// save the wall data, including visited flags in the target array. Not checked for overflow.
   void save(uint8_t *data);
 
@@ -218,11 +305,49 @@ class Maze {
   /// set the Flood Type to use
   void setFloodType(FloodType mFloodType);
   FloodType getFloodType() const;
+  /// set the queue used by the weighted and runlength floods
+  void setQueueType(QueueType queueType);
+  QueueType getQueueType() const;
+  /// set the cell layout used by the queue based floods. SPLIT_CELLS and PACKED_CELLS give the same results.
+  /// PADDED_CELLS treats the outer wall as closed even where it is unseen or missing, so it only gives the
+  /// same results when the outer walls are closed. Elsewhere the other layouts wrap to the opposite edge.
+  void setCellLayout(CellLayout layout);
+  CellLayout getCellLayout() const;
+  /// Attach a planner that lets manhattan floods repair the previous result after
+  /// a few walls have changed. Pass nullptr to go back to full floods. Not owned by the maze.
+  void setIncrementalFlood(IncrementalFlood *planner);
+  IncrementalFlood *incrementalFlood() const;
+  /// Attach a corridor graph that manhattan floods run on when no incremental planner is attached.
+  /// It is rebuilt when a wall change alters the exits. Pass nullptr to go back to full floods. Not owned.
+  void setCorridorGraph(CorridorGraph *graph);
+  CorridorGraph *corridorGraph() const;
+  /// Attach a dead-end fill whose filled cells the manhattan, weighted, runlength and direction floods
+  /// skip. A flood into the maze brings it up to date for its mask first. Pass nullptr to flood every cell.
+  /// Not owned by the maze.
+  void setDeadEndFill(DeadEndFill *fill);
+  DeadEndFill *deadEndFill() const;
+  /// Let the floods use the queues in a workspace instead of building their own, so that they
+  /// make no heap allocations. Pass nullptr to go back to local queues. Not owned by the maze.
+  void setFloodWorkspace(FloodWorkspace *workspace);
+  FloodWorkspace *floodWorkspace() const;
+  /// Use the BitFlood kernel for manhattan floods. On by default. The results are the
+  /// same either way; turn it off to get the original queue based flood.
+  void setBitParallelFlood(bool enabled);
+  bool getBitParallelFlood() const;
+  /// Use copies of the floods compiled for a fixed width of 16 or 32. On by default.
+  /// The results are the same either way; turn it off to use the runtime width for every size.
+  void setFixedWidthFloods(bool enabled);
+  bool getFixedWidthFloods() const;
   /// used only for the weighted Flood
   uint16_t getCornerWeight() const;
   void setCornerWeight(uint16_t cornerWeight);
+  /// the performance of the mouse, used by the time flood
+  const MotionProfile &getMotionProfile() const;
+  void setMotionProfile(const MotionProfile &profile);
 
   uint8_t getXWalls(int cell) const;
+  /// the walls as one word per column for each direction. Kept in step with the wall bytes.
+  const WallPlanes &wallPlanes() const;
 
   void setWidth(uint16_t mWidth);
   void clearGoalArea();
@@ -233,41 +358,262 @@ class Maze {
 
   void printGoalArea() {
     printf("Goal Area: [");
-    for (const int &cell : goalArea) {
+    for (uint16_t cell : goalArea) {
       printf("0x%02X ", cell);
     }
     printf("]\n");
   }
 
  protected:
-  /// stores the wall and visited flags. Allows for 32x32 maze but wastes space
-  uint8_t xWalls[1024] = {0xf0};
+  /*
+   * The members are ordered by how often a flood touches them. The settings
+   * a flood reads once come first, then the per-cell arrays the flood reads
+   * on every step, then the bitplanes, and last what is only used between
+   * floods. This is only an ordering: the rarely used members are still part
+   * of the object, not moved out of line.
+   */
   /// the width of the maze in cells. Assume mazes are always square
   uint16_t mWidth = 16;
   uint8_t mOpenCloseMask = OPEN_MASK;
+  /// Remember which type of flood is to be used
+  FloodType mFloodType = RUNLENGTH_FLOOD;
+  /// Remember which queue the weighted and runlength floods use
+  QueueType mQueueType = LINEAR_QUEUE;
+  /// how the queue based floods hold the cells while they run
+  CellLayout mCellLayout = SPLIT_CELLS;
+  /// the weighted flood needs a cost for corners
+  uint16_t mCornerWeight = 3;
+  /// the time flood needs the speeds and acceleration
+  MotionProfile mMotionProfile = LOW_SPEED_MOTION;
+  /// the costs of the runlength flood. Not owned by the maze.
+  const RunLengthCostTables *mRunLengthTables = &runLengthProfileCosts(LOW_SPEED_PROFILE);
+  /// manhattan floods use BitFlood rather than a queue
+  bool mBitParallelFlood = true;
+  /// 16 and 32 cell wide mazes use floods compiled for that width
+  bool mFixedWidthFloods = true;
+  /// set while floodGoalArea() runs so that the floods start from every goal cell
+  bool mFloodFromGoalArea = false;
+  /// told about every wall change when incremental flooding is in use
+  IncrementalFlood *mIncremental = nullptr;
+  /// told about every wall change when manhattan floods run on a corridor graph
+  CorridorGraph *mCorridors = nullptr;
+  /// told about every wall change and used by the floods when set
+  DeadEndFill *mDeadEnds = nullptr;
+  /// the queues used by the floods when set
+  FloodWorkspace *mWorkspace = nullptr;
+  /// stores the wall and visited flags. Allows for 32x32 maze but wastes space
+  uint8_t xWalls[1024] = {0xf0};
   /// stores the least costly direction. Allows for 32x32 maze but wastes space
   uint8_t mDirection[1024] = {NORTH};
   /// stores the cost information from a flood. Allows for 32x32 maze but wastes space
   uint16_t mCost[1024] = {MAX_COST};
-  /// The goal is an area so a list of locations is needed. Must have one or more entries
-  std::list<int> goalArea;
+  /// the same walls as xWalls held as bitplanes for bulk queries
+  WallPlanes mPlanes;
+  /// The goal is an area so a set of locations is needed. Must have one or more entries
+  GoalArea goalArea;
   /// The cost of the best path assuming unseen walls are absent
   uint16_t mPathCostOpen = MAX_COST;
   /// The cost of the best path assuming unseen walls are present
   uint16_t mPathCostClosed = MAX_COST;
   /// flag set when maze has been solved
   bool mIsSolved = false;
-  /// Remember which type of flood is to be used
-  FloodType mFloodType = RUNLENGTH_FLOOD;
-  /// the weighted flood needs a cost for corners
-  uint16_t mCornerWeight = 3;
+  /// the records for floods into the maze with the packed or padded layouts and no workspace.
+  /// Grown by the first of them and reused after that.
+  std::vector<PackedCell> mPackedCells;
+  friend class CorridorGraph;
+  friend class IncrementalFlood;
   Maze() = default;
-  /// used to set up the queue before running the more complex floods
-  void seedQueue(PriorityQueue<FloodInfo> &queue, uint16_t goal, uint16_t cost);
+  /// Where a flood writes its costs and directions, and the walls it may pass through.
+  /// The floods only read the maze so they can write into a FloodResult as well as this maze.
+  struct FloodOutput {
+    uint16_t *cost;
+    uint8_t *direction;
+    const uint8_t *walls;
+    uint8_t mask;
+    bool fromGoalArea;
+    /// room for the records of the packed and padded layouts when there is no workspace.
+    /// nullptr makes the flood allocate its own.
+    PackedCell *packedCells = nullptr;
+    /// hasExit() with the mask of the flood
+    bool hasExit(uint16_t cell, uint8_t exit) const { return (walls[cell] & (mask << exit)) == 0; }
+    uint16_t getCost(uint16_t cell) const { return cost[cell]; }
+    void setCost(uint16_t cell, uint16_t value) { cost[cell] = value; }
+    uint8_t getDirection(uint16_t cell) const { return direction[cell]; }
+    void setDirection(uint16_t cell, uint8_t value) { direction[cell] = value; }
+    /// mark every cell as unexamined
+    void reset(uint16_t numCells) {
+      for (uint16_t i = 0; i < numCells; i++) {
+        cost[i] = MAX_COST;
+        direction[i] = INVALID_DIRECTION;
+      }
+    }
+    /// the output with the results in it
+    FloodOutput &unpack(uint16_t) { return *this; }
+    /// where a maze cell is stored, and the geometry to move between stored cells
+    uint16_t index(uint16_t cell) const { return cell; }
+    template <class geometry_t>
+    geometry_t grid(geometry_t geometry) const {
+      return geometry;
+    }
+    /// the number of cells stored for a maze of the given width
+    static uint16_t storageSize(uint16_t width) { return (uint16_t)(width * width); }
+  };
+  /// The same interface as FloodOutput over PackedCell records. reset() copies the walls in
+  /// and unpack() copies the costs and directions out to the result.
+  struct PackedOutput {
+    PackedCell *cells;
+    FloodOutput *result;
+    uint8_t mask;
+    bool fromGoalArea;
+    bool hasExit(uint16_t cell, uint8_t exit) const { return (cells[cell].walls & (mask << exit)) == 0; }
+    uint16_t getCost(uint16_t cell) const { return cells[cell].cost; }
+    void setCost(uint16_t cell, uint16_t value) { cells[cell].cost = value; }
+    uint8_t getDirection(uint16_t cell) const { return cells[cell].direction; }
+    void setDirection(uint16_t cell, uint8_t value) { cells[cell].direction = value; }
+    void reset(uint16_t numCells) {
+      for (uint16_t i = 0; i < numCells; i++) {
+        cells[i] = {result->walls[i], INVALID_DIRECTION, MAX_COST};
+      }
+    }
+    FloodOutput &unpack(uint16_t numCells) {
+      for (uint16_t i = 0; i < numCells; i++) {
+        result->cost[i] = cells[i].cost;
+        result->direction[i] = cells[i].direction;
+      }
+      return *result;
+    }
+    uint16_t index(uint16_t cell) const { return cell; }
+    template <class geometry_t>
+    geometry_t grid(geometry_t geometry) const {
+      return geometry;
+    }
+    static uint16_t storageSize(uint16_t width) { return (uint16_t)(width * width); }
+  };
+  /// PackedOutput in the padded layout of Padded<geometry_t>. Cells are padded indices. reset() closes
+  /// the outer walls of the edge cells as well as the sentinels so that nothing ever leaves the maze.
+  struct PaddedOutput {
+    PackedCell *cells;
+    FloodOutput *result;
+    uint8_t mask;
+    bool fromGoalArea;
+    uint16_t width;
+    bool hasExit(uint16_t cell, uint8_t exit) const { return (cells[cell].walls & (mask << exit)) == 0; }
+    uint16_t getCost(uint16_t cell) const { return cells[cell].cost; }
+    void setCost(uint16_t cell, uint16_t value) { cells[cell].cost = value; }
+    uint8_t getDirection(uint16_t cell) const { return cells[cell].direction; }
+    void setDirection(uint16_t cell, uint8_t value) { cells[cell].direction = value; }
+    uint16_t stride() const { return (uint16_t)(width + 2); }
+    uint16_t index(uint16_t cell) const { return (uint16_t)((cell / width + 1) * stride() + cell % width + 1); }
+    void reset(uint16_t) {
+      const PackedCell sentinel = {0xFF, NORTH, MAX_COST};
+      PackedCell *stored = cells;
+      for (uint16_t r = 0; r < stride(); r++) {
+        *stored++ = sentinel;
+      }
+      const uint8_t *walls = result->walls;
+      for (uint16_t c = 0; c < width; c++) {
+        const uint8_t sides = (c == 0 ? WALL_WEST : 0) | (c == width - 1 ? WALL_EAST : 0);
+        *stored++ = sentinel;
+        *stored++ = {(uint8_t)(*walls++ | sides | WALL_SOUTH), INVALID_DIRECTION, MAX_COST};
+        for (uint16_t r = 1; r < width - 1; r++) {
+          *stored++ = {(uint8_t)(*walls++ | sides), INVALID_DIRECTION, MAX_COST};
+        }
+        *stored++ = {(uint8_t)(*walls++ | sides | WALL_NORTH), INVALID_DIRECTION, MAX_COST};
+        *stored++ = sentinel;
+      }
+      for (uint16_t r = 0; r < stride(); r++) {
+        *stored++ = sentinel;
+      }
+    }
+    FloodOutput &unpack(uint16_t) {
+      uint16_t cell = 0;
+      for (uint16_t c = 0; c < width; c++) {
+        for (uint16_t r = 0; r < width; r++, cell++) {
+          const PackedCell &stored = cells[(c + 1) * stride() + r + 1];
+          result->cost[cell] = stored.cost;
+          result->direction[cell] = stored.direction;
+        }
+      }
+      return *result;
+    }
+    template <class geometry_t>
+    Padded<geometry_t> grid(geometry_t geometry) const {
+      return Padded<geometry_t>(geometry);
+    }
+    static uint16_t storageSize(uint16_t width) { return (uint16_t)((width + 2) * (width + 2)); }
+  };
+  /// the output for a flood into this maze's own costs and directions with the current mask
+  FloodOutput ownOutput();
+  /// the floods by type, using the queues in the workspace or, if it is nullptr, their own
+  uint16_t flood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  /// the walls a flood into out should use when a dead-end fill is attached. The fill is not updated here.
+  const uint8_t *deadEndWalls(const FloodOutput &out, uint16_t target) const;
+  uint16_t manhattanFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  uint16_t weightedFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  uint16_t runLengthFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  uint16_t directionFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  uint16_t timeFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  uint16_t diagonalFlood(FloodOutput &out, FloodWorkspace *workspace, uint16_t target) const;
+  /// call the function with each cell a flood starts from: the target or, in floodGoalArea(), the goal area
+  template <class output_t, class function_t>
+  void forEachFloodSource(const output_t &out, uint16_t target, function_t function) const;
+  /// call the function with the output for the cell layout: out itself or a PackedOutput or PaddedOutput
+  /// that unpacks into it
+  template <class function_t>
+  uint16_t withCellLayout(FloodOutput &out, FloodWorkspace *workspace, function_t function) const;
+  /// withWidthPolicy() with the width policy turned into the geometry of the cell layout
+  template <class output_t, class function_t>
+  uint16_t withGrid(const output_t &cells, function_t function) const;
+  /// unpack the costs, find the directions and return the cost from cell 0
+  template <class geometry_t, class output_t>
+  uint16_t finishFlood(geometry_t geometry, output_t &out, uint16_t target, FloodDirections directions) const;
+  /// the padded layout finds the directions before it unpacks so that they never wrap either
+  template <class geometry_t>
+  uint16_t finishFlood(Padded<geometry_t> grid, PaddedOutput &out, uint16_t target, FloodDirections directions) const;
+  /// finishFlood() for floodWith(), filling in the rest of the result
+  uint16_t finishFlood(FloodOutput &out, uint16_t target, FloodDirections directions, FloodResult &result) const;
+  /// call the function with the width policy to use for this maze and return its result
+  template <class function_t>
+  auto withWidthPolicy(function_t function) const -> decltype(function(RuntimeWidth(16)));
+  /// flood with the policy for a given width policy, queue and cell layout. See floodengine.h and mazegeometry.h
+  template <bool SETTLE_ON_FIRST_REACH, class policy_t, class geometry_t, class queue_t, class output_t>
+  uint16_t runFlood(const policy_t &policy, geometry_t geometry, queue_t &queue, output_t &out,
+                    uint16_t target) const;
+  template <class geometry_t>
+  void updateDirections(geometry_t geometry, FloodOutput &out, uint16_t target, FloodDirections directions) const;
+  template <class geometry_t>
+  uint8_t directionToSmallest(geometry_t geometry, const FloodOutput &out, uint16_t cell) const;
+  /// updateDirections() for the manhattan flood, with the same result as directionToSmallest(cell, target)
+  void updateManhattanDirections(FloodOutput &out, uint16_t target) const;
+  /// true if testForSolution() can use BitFlood::floodPair()
+  bool canFloodPair() const;
+  /// the open maze half of a paired flood: find the directions and the open path cost
+  void finishPairedFlood(uint16_t target);
   /// set all the cell costs to their maxumum value, except the target
-  void initialiseFloodCosts(uint16_t target);
+  template <class geometry_t, class output_t>
+  void initialiseFloodCosts(geometry_t geometry, output_t &out, uint16_t target) const;
   /// NOT TO BE USED IN SEARCH. Update a single cell from stored map data.
   void copyCellFromFileData(uint16_t cell, uint8_t wallData);
+  /// pass on any change to the wall between a cell and its neighbour to the incremental planner
+  void notifyWallChange(uint16_t cell, uint8_t direction, uint8_t oldWalls, uint8_t oldNextWalls, uint16_t nextCell);
 };
 
+template <class policy_t>
+uint16_t Maze::floodWith(const policy_t &policy, uint16_t target, int open_close_mask, FloodResult &result,
+                         FloodWorkspace *workspace) const {
+  FloodOutput out = {result.mCost, result.mDirection, xWalls, static_cast<uint8_t>(open_close_mask), false};
+  const RuntimeWidth geometry(mWidth);
+  out.reset(geometry.numCells());
+  out.setCost(target, 0);
+  out.setDirection(target, NORTH);
+  auto sources = [&](auto seed) { seed(target); };
+  if (workspace) {
+    floodEngine<false>(policy, geometry, workspace->heap(), out, sources);
+  } else {
+    IndexedHeap<FloodInfo> queue(geometry.numCells());
+    floodEngine<false>(policy, geometry, queue, out, sources);
+  }
+  return finishFlood(out, target, policy_t::DIRECTIONS, result);
+}
+
 #endif
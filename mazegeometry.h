@@ -0,0 +1,129 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef MAZEGEOMETRY_H
+#define MAZEGEOMETRY_H
+
+#include <cstdint>
+#include "mazeconstants.h"
+
+/*
+ * Width policies for the flood loops.
+ *
+ * Cells are numbered up each column so the neighbour to the north is the
+ * next cell, the one to the east is a whole column further on and so on.
+ * Neighbours wrap modulo the number of cells, exactly as Maze::neighbour()
+ * does. The floods are templates on one of these policies.
+ *
+ * FixedWidth<WIDTH> makes the width, the cell count and the neighbour
+ * offsets compile-time constants. For the usual 16 and 32 cell mazes the
+ * modulo becomes a mask and loops over the cells have a fixed trip count.
+ *
+ * RuntimeWidth has the same interface but holds the width in a member.
+ * It is used for any other size.
+ */
+template <uint16_t WIDTH>
+struct FixedWidth {
+  static_assert(WIDTH > 0 && WIDTH <= 32, "mazes are at most 32 cells wide");
+
+  static constexpr uint16_t width() { return WIDTH; }
+  static constexpr uint16_t numCells() { return WIDTH * WIDTH; }
+
+  /// the offset to add, modulo numCells(), to move one cell in the given direction
+  static constexpr uint16_t offset(uint8_t direction) {
+    return direction == NORTH  ? 1
+           : direction == EAST ? WIDTH
+           : direction == SOUTH ? numCells() - 1
+                                : numCells() - WIDTH;
+  }
+
+  static constexpr uint16_t neighbour(uint16_t cell, uint8_t direction) {
+    return (uint16_t)((cell + offset(direction)) % numCells());
+  }
+};
+
+struct RuntimeWidth {
+  explicit RuntimeWidth(uint16_t width) : mWidth(width), mNumCells(width * width) {}
+
+  uint16_t width() const { return mWidth; }
+  uint16_t numCells() const { return mNumCells; }
+
+  uint16_t offset(uint8_t direction) const {
+    return direction == NORTH  ? 1
+           : direction == EAST ? mWidth
+           : direction == SOUTH ? mNumCells - 1
+                                : mNumCells - mWidth;
+  }
+
+  uint16_t neighbour(uint16_t cell, uint8_t direction) const {
+    return (uint16_t)((cell + offset(direction)) % mNumCells);
+  }
+
+ private:
+  uint16_t mWidth;
+  uint16_t mNumCells;
+};
+
+/*
+ * The padded layout used with Maze::setCellLayout(PADDED_CELLS).
+ *
+ * The maze is stored with a ring of sentinel cells all the way round it so
+ * each column is width() + 2 cells long and column c, row r of the maze is
+ * stored at (c + 1) * stride() + r + 1. Moving one cell is then just adding
+ * an offset from a table built for the width, with no wrap and no bounds
+ * test. The sentinels are closed cells that a flood never enters, so the
+ * opposite edges of the maze are never linked the way neighbour() links them.
+ *
+ * Cell numbers here are indices into the padded storage. index() and cellAt()
+ * convert to and from the usual maze cell numbers.
+ */
+template <class geometry_t>
+struct Padded {
+  explicit Padded(geometry_t geometry)
+      : mGeometry(geometry),
+        mOffset{1, static_cast<int16_t>(stride()), -1, static_cast<int16_t>(-stride())} {}
+
+  uint16_t width() const { return mGeometry.width(); }
+  uint16_t stride() const { return (uint16_t)(mGeometry.width() + 2); }
+  /// the number of cells in the padded storage, sentinels included
+  uint16_t numCells() const { return (uint16_t)(stride() * stride()); }
+
+  int16_t offset(uint8_t direction) const { return mOffset[direction]; }
+
+  uint16_t neighbour(uint16_t cell, uint8_t direction) const { return (uint16_t)(cell + mOffset[direction]); }
+
+  /// the padded index of a maze cell
+  uint16_t index(uint16_t cell) const {
+    return (uint16_t)((cell / width() + 1) * stride() + cell % width() + 1);
+  }
+  /// the maze cell at a padded index that is not a sentinel
+  uint16_t cellAt(uint16_t index) const { return (uint16_t)((index / stride() - 1) * width() + index % stride() - 1); }
+
+ private:
+  geometry_t mGeometry;
+  int16_t mOffset[4];
+};
+
+#endif  // MAZEGEOMETRY_H
@@ -203,6 +203,49 @@ void PathFinder::generatePath(const uint16_t start, const uint16_t target, Maze
   mDistance = distance;
 }
 
+/*
+ * The route path has the same form as the flood path: a forward move out of
+ * the start, one command for each cell after that and a final stop.
+ */
+void PathFinder::generateRoutePath(uint16_t start, const uint8_t *directions, int count, Maze *maze) {
+  char *pPath = mBuffer;
+  uint16_t distance = 0;
+  uint16_t here = start;
+  mStartCell = start;
+  mStartHeading = count > 0 ? directions[0] : INVALID_DIRECTION;
+  mEndHeading = mStartHeading;
+  mCellCount = 0;
+  mStopAtUnvisited = false;
+  *pPath++ = 'B';
+  if (count <= 0) {
+    *pPath++ = 'S';
+    *pPath = 0;
+    mEndCell = start;
+    mReachesTarget = true;
+    mDistance = 0;
+    return;
+  }
+  for (int i = 0; i < count && mCellCount < MAX_PATH_LENGTH; i++) {
+    uint8_t headingLast = i > 0 ? directions[i - 1] : directions[0];
+    char command = pathOptions[headingLast * 4 + directions[i]];
+    if (command == 'R' || command == 'L') {
+      distance += 127;
+    } else {
+      distance += 180;
+    }
+    *pPath++ = command;
+    mCellCount++;
+    here = maze->neighbour(here, directions[i]);
+  }
+  mEndHeading = directions[mCellCount - 1];
+  mEndCell = here;
+  mReachesTarget = mCellCount == count;
+  *pPath++ = mReachesTarget ? 'S' : 'X';
+  mCellCount++;
+  *pPath = 0;
+  mDistance = distance;
+}
+
 /**
  * The length will always include the final move ('S" or 'X') as it is
  * a cell through which the mouse moves.
@@ -111,6 +111,9 @@ class PathFinder {
   ///  Create a simple pathstring representing the route from start to finsh in the maze
   /// but do not stop at unvisited cells
   void generateUnsafePath(uint16_t start, uint16_t finish, Maze *maze);
+  ///  Create a simple pathstring that follows a list of directions from the start cell, such as
+  /// the route found by a point to point search. The path begins facing the first direction.
+  void generateRoutePath(uint16_t start, const uint8_t *directions, int count, Maze *maze);
   /// this is not well suited here but it makes migration easier
   void listCommands(uint8_t *commands);
 
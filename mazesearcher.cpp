@@ -29,13 +29,26 @@
 #include "mazeprinter.h"
 
 MazeSearcher::MazeSearcher()
-    : mLocation(0), mHeading(NORTH), mMap(nullptr), mRealMaze(nullptr), mVerbose(false), mSearchMethod(SEARCH_NORMAL) {
+    : mLocation(0),
+      mHeading(NORTH),
+      mMap(nullptr),
+      mRealMaze(nullptr),
+      mVerbose(false),
+      mSearchMethod(SEARCH_NORMAL),
+      mIncremental(nullptr),
+      mDeadEnds(nullptr),
+      mRouteFinder(nullptr),
+      mBidirectionalSearch(nullptr) {
   mMap = new Maze(16);
   mMap->setFloodType(Maze::MANHATTAN_FLOOD);
 }
 
 MazeSearcher::~MazeSearcher() {
   delete mMap;
+  delete mIncremental;
+  delete mDeadEnds;
+  delete mRouteFinder;
+  delete mBidirectionalSearch;
 }
 
 bool MazeSearcher::isVerbose() const {
@@ -86,20 +99,90 @@ void MazeSearcher::setRealMaze(const Maze *maze) {
 }
 
 int MazeSearcher::runTo(uint16_t target) {
+  if (mBidirectionalSearch) {
+    return runBidirectionalTo(target);
+  }
+  if (mRouteFinder) {
+    return runRouteTo(target);
+  }
   int steps = 0;
-  mMap->flood(target, CLOSED_MASK);
+  // flood into a result of its own so that the map keeps the search flood
+  mMap->flood(target, CLOSED_MASK, mRunResult, mMap->floodWorkspace());
   while (mLocation != target) {
-    uint8_t heading = mMap->direction(mLocation);
+    uint8_t heading = mRunResult.direction(mLocation);
     if (heading == INVALID_DIRECTION) {
-      steps = -1;
+      steps = E_NO_ROUTE;
       break;
     }
 
     setHeading(heading);
     move();
     steps++;
-    if (steps > 256) {
-      steps = -2;
+    if (steps > mMap->numCells()) {
+      steps = E_ROUTE_TOO_LONG;
+      break;
+    }
+    if (isVerbose()) {
+      MazePrinter::printVisitedDirs(mMap);
+    }
+  }
+  return steps;
+}
+
+/*
+ * The route is costed in the same way as the map's flood type: the runlength
+ * flood uses the runlength model and the others count cells.
+ */
+int MazeSearcher::runRouteTo(uint16_t target) {
+  bool runLength = mMap->getFloodType() == Maze::RUNLENGTH_FLOOD;
+  mRouteFinder->setCostModel(runLength ? AStar::RUNLENGTH_COST : AStar::UNIT_COST);
+  if (mRouteFinder->findRoute(*mMap, mLocation, target, CLOSED_MASK) == MAX_COST) {
+    return E_NO_ROUTE;
+  }
+  int steps = 0;
+  for (int i = 0; i + 1 < mRouteFinder->routeLength(); i++) {
+    setHeading(mRouteFinder->routeDirection(i));
+    move();
+    steps++;
+    if (steps > mMap->numCells()) {
+      steps = E_ROUTE_TOO_LONG;
+      break;
+    }
+    if (isVerbose()) {
+      MazePrinter::printVisitedDirs(mMap);
+    }
+  }
+  return steps;
+}
+
+/*
+ * The route is costed in the same way as the map's flood type, with the
+ * weighted flood's corner weight, and the first move is costed from the
+ * current heading.
+ */
+int MazeSearcher::runBidirectionalTo(uint16_t target) {
+  switch (mMap->getFloodType()) {
+    case Maze::WEIGHTED_FLOOD:
+      mBidirectionalSearch->setCostModel(BidirectionalSearch::WEIGHTED_COST);
+      mBidirectionalSearch->setCornerWeight(mMap->getCornerWeight());
+      break;
+    case Maze::RUNLENGTH_FLOOD:
+      mBidirectionalSearch->setCostModel(BidirectionalSearch::RUNLENGTH_COST);
+      break;
+    default:
+      mBidirectionalSearch->setCostModel(BidirectionalSearch::UNIT_COST);
+      break;
+  }
+  if (mBidirectionalSearch->findRoute(*mMap, mLocation, mHeading, target, CLOSED_MASK) == MAX_COST) {
+    return E_NO_ROUTE;
+  }
+  int steps = 0;
+  for (int i = 0; i + 1 < mBidirectionalSearch->routeLength(); i++) {
+    setHeading(mBidirectionalSearch->routeDirection(i));
+    move();
+    steps++;
+    if (steps > mMap->numCells()) {
+      steps = E_ROUTE_TOO_LONG;
       break;
     }
     if (isVerbose()) {
@@ -111,10 +194,21 @@ int MazeSearcher::runTo(uint16_t target) {
 
 // TODO: this needs looking at.
 // the returned number of steps may be inconsistent
+/*
+ * With a dead-end fill the target and the cell the mouse is in are kept
+ * clear. Each cell the mouse leaves is released, so that a dead end it has
+ * just backed out of is filled by the next flood.
+ */
 int MazeSearcher::searchTo(uint16_t target) {
   int stepCount = 0;
+  if (mDeadEnds) {
+    mDeadEnds->keep(target);
+  }
   while (mLocation != target) {
     mMap->updateMap(mLocation, mRealMaze->walls(mLocation));
+    if (mDeadEnds) {
+      mDeadEnds->keep(mLocation);
+    }
     uint8_t newHeading;
     switch (mSearchMethod) {
       case SEARCH_LEFT_WALL:
@@ -144,7 +238,11 @@ int MazeSearcher::searchTo(uint16_t target) {
       stepCount = E_ROUTE_TOO_LONG;
       break;
     }
+    uint16_t previous = mLocation;
     move();
+    if (mDeadEnds) {
+      mDeadEnds->release(previous);
+    }
     if (isVerbose()) {
       MazePrinter::printVisitedDirs(mMap);
     }
@@ -192,6 +290,64 @@ void MazeSearcher::setSearchMethod(int mSearchMethod) {
   MazeSearcher::mSearchMethod = mSearchMethod;
 }
 
+void MazeSearcher::setIncrementalFlood(bool enabled) {
+  if (enabled && !mIncremental) {
+    mIncremental = new IncrementalFlood();
+  }
+  if (!enabled && mIncremental) {
+    delete mIncremental;
+    mIncremental = nullptr;
+  }
+  mMap->setIncrementalFlood(mIncremental);
+}
+
+const IncrementalFlood *MazeSearcher::incrementalFlood() const {
+  return mIncremental;
+}
+
+void MazeSearcher::setDeadEndFill(bool enabled) {
+  if (enabled && !mDeadEnds) {
+    mDeadEnds = new DeadEndFill();
+  }
+  if (!enabled && mDeadEnds) {
+    delete mDeadEnds;
+    mDeadEnds = nullptr;
+  }
+  mMap->setDeadEndFill(mDeadEnds);
+}
+
+const DeadEndFill *MazeSearcher::deadEndFill() const {
+  return mDeadEnds;
+}
+
+void MazeSearcher::setRouteQueries(bool enabled) {
+  if (enabled && !mRouteFinder) {
+    mRouteFinder = new AStar();
+  }
+  if (!enabled && mRouteFinder) {
+    delete mRouteFinder;
+    mRouteFinder = nullptr;
+  }
+}
+
+const AStar *MazeSearcher::routeFinder() const {
+  return mRouteFinder;
+}
+
+void MazeSearcher::setBidirectionalRoutes(bool enabled) {
+  if (enabled && !mBidirectionalSearch) {
+    mBidirectionalSearch = new BidirectionalSearch();
+  }
+  if (!enabled && mBidirectionalSearch) {
+    delete mBidirectionalSearch;
+    mBidirectionalSearch = nullptr;
+  }
+}
+
+const BidirectionalSearch *MazeSearcher::bidirectionalSearch() const {
+  return mBidirectionalSearch;
+}
+
 void MazeSearcher::turnRight() {
   mHeading = Maze::rightOf(mHeading);
 }
@@ -47,6 +47,10 @@
  */
 
 #include <cstdint>
+#include "astar.h"
+#include "bidirectionalsearch.h"
+#include "deadendfill.h"
+#include "incrementalflood.h"
 #include "maze.h"
 
 class MazeSearcher {
@@ -78,14 +82,32 @@ class MazeSearcher {
   void turnRight();
   void turnLeft();
   void turnAround();
-  /// follow direction data in the maze to get to the given target cell
-  /// return the number of steps needed
+  /// follow a flood of the map to get to the given target cell. The flood goes into a result of its own
+  /// and the costs and directions in the map are left alone.
+  /// return the number of steps needed, E_NO_ROUTE or E_ROUTE_TOO_LONG if the route visits more than numCells() cells
   int runTo(uint16_t target);
   /// search unknown maze for target cell
   /// return the number of steps needed
   int searchTo(uint16_t target);
 
   void setSearchMethod(int mSearchMethod);
+  /// let the search repair the previous flood after each cell instead of flooding from scratch
+  void setIncrementalFlood(bool enabled);
+  /// the incremental planner, with its counters, or nullptr if not in use
+  const IncrementalFlood *incrementalFlood() const;
+  /// let the floods of a search skip the dead ends found so far, keeping the mouse and the target clear
+  void setDeadEndFill(bool enabled);
+  /// the dead-end fill, with its counters, or nullptr if not in use
+  const DeadEndFill *deadEndFill() const;
+  /// let runTo() find just the route from the current cell with an AStar query instead of flooding the map
+  void setRouteQueries(bool enabled);
+  /// the route finder used by runTo(), or nullptr if not in use
+  const AStar *routeFinder() const;
+  /// let runTo() search for the route from both ends at once, starting from the current heading.
+  /// This takes precedence over the AStar route queries.
+  void setBidirectionalRoutes(bool enabled);
+  /// the bidirectional search used by runTo(), or nullptr if not in use
+  const BidirectionalSearch *bidirectionalSearch() const;
   bool isVerbose() const;
   void setVerbose(bool mVerbose);
 
@@ -100,6 +122,16 @@ class MazeSearcher {
   const Maze *mRealMaze;
   bool mVerbose;
   int mSearchMethod;
+  IncrementalFlood *mIncremental;
+  DeadEndFill *mDeadEnds;
+  AStar *mRouteFinder;
+  BidirectionalSearch *mBidirectionalSearch;
+  /// the flood used by runTo(), kept apart from the map
+  FloodResult mRunResult;
+  /// runTo() using the route finder
+  int runRouteTo(uint16_t target);
+  /// runTo() using the bidirectional search
+  int runBidirectionalTo(uint16_t target);
   MazeSearcher &operator=(const MazeSearcher &rhs);
   MazeSearcher(const MazeSearcher &orig);
 };
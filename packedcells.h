@@ -0,0 +1,50 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef PACKEDCELLS_H
+#define PACKEDCELLS_H
+
+#include <cstdint>
+
+/*
+ * One cell of a flood with its walls, direction and cost packed into a
+ * single 32-bit record.
+ *
+ * The maze keeps its walls, directions and costs in three separate arrays,
+ * so a flood that looks at a cell touches three places in memory that are
+ * one or two kilobytes apart. With Maze::setCellLayout(PACKED_CELLS) the
+ * queue based floods copy the walls into an array of these records first,
+ * flood on the records and copy the costs and directions back out at the end.
+ * Everything the flood needs for a cell is then in the same word.
+ */
+struct PackedCell {
+  uint8_t walls;
+  uint8_t direction;
+  uint16_t cost;
+};
+
+static_assert(sizeof(PackedCell) == 4, "a packed cell must fit in 32 bits");
+
+#endif  // PACKEDCELLS_H
@@ -0,0 +1,121 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef RUNLENGTHCOSTS_H
+#define RUNLENGTHCOSTS_H
+
+#include <cstdint>
+
+/*
+ * The runlength flood charges each cell of a straight by how much the
+ * straight takes longer to run than one a cell shorter. The mouse leaves
+ * and enters every straight at the turn speed, accelerates as hard as it
+ * can, cruises at the top speed if it gets there and brakes back down in
+ * time for the next turn. Longer straights are faster per cell so the
+ * flood prefers them.
+ *
+ * makeRunLengthCosts() works the tables out from a MotionProfile. It is
+ * constexpr so that a profile known at compile time costs nothing at run
+ * time:
+ *
+ *   static constexpr RunLengthCostTables costs = makeRunLengthCosts({180, 1800, 15000, 5000, 4000});
+ *   maze.setRunLengthCosts(costs);
+ *
+ * Costs are in milliseconds, rounded down.
+ */
+
+/// the performance of the mouse. Lengths are in mm, speeds in mm/s and the acceleration in mm/s/s.
+struct MotionProfile {
+  /// the distance from one cell to the next along a straight. Diagonal steps are this over root 2.
+  double cellSize;
+  /// the speed at the start and end of every straight
+  double turnSpeed;
+  double acceleration;
+  double maxSpeed;
+  double maxDiagonalSpeed;
+};
+
+/// run length costs for straights and diagonals, indexed by run length. Entry 0 is not used.
+struct RunLengthCostTables {
+  static const int LENGTHS = 31;
+  uint16_t ortho[LENGTHS];
+  uint16_t diag[LENGTHS];
+};
+
+/// square root by Newton's method, since std::sqrt is not constexpr
+constexpr double constexprSqrt(double value) {
+  if (value <= 0) {
+    return 0;
+  }
+  double root = value > 1 ? value : 1;
+  double last = 0;
+  while (root != last) {
+    last = root;
+    root = (root + value / root) / 2;
+    if (root >= last) {
+      break;  // converged, or stuck one step apart in the last bit
+    }
+  }
+  return root;
+}
+
+/// the time to run a straight of the given length starting and ending at the turn speed
+constexpr double straightTime(double distance, double turnSpeed, double acceleration, double maxSpeed) {
+  // the speed reached half way if the mouse never stops accelerating
+  double peakSpeed = constexprSqrt(turnSpeed * turnSpeed + acceleration * distance);
+  if (peakSpeed <= maxSpeed) {
+    return 2 * (peakSpeed - turnSpeed) / acceleration;
+  }
+  double rampDistance = (maxSpeed * maxSpeed - turnSpeed * turnSpeed) / acceleration;
+  return 2 * (maxSpeed - turnSpeed) / acceleration + (distance - rampDistance) / maxSpeed;
+}
+
+/// the cost in ms of each extra step of a straight
+constexpr uint16_t runLengthStepTime(int runLength, double step, double turnSpeed, double acceleration,
+                                     double maxSpeed) {
+  double extra = straightTime(runLength * step, turnSpeed, acceleration, maxSpeed) -
+                 straightTime((runLength - 1) * step, turnSpeed, acceleration, maxSpeed);
+  // a little is added so that costs which come out a whole number of ms are not rounded down by the error
+  return (uint16_t)(extra * 1000 + 1e-6);
+}
+
+constexpr RunLengthCostTables makeRunLengthCosts(const MotionProfile &profile) {
+  RunLengthCostTables tables{};
+  const double diagonalStep = profile.cellSize / constexprSqrt(2);
+  for (int runLength = 1; runLength < RunLengthCostTables::LENGTHS; runLength++) {
+    tables.ortho[runLength] =
+        runLengthStepTime(runLength, profile.cellSize, profile.turnSpeed, profile.acceleration, profile.maxSpeed);
+    tables.diag[runLength] = runLengthStepTime(runLength, diagonalStep, profile.turnSpeed, profile.acceleration,
+                                               profile.maxDiagonalSpeed);
+  }
+  return tables;
+}
+
+/// the profile the original hand made tables came from (vturn = 1500 mm/s, acc = 13000 mm/s/s)
+constexpr MotionProfile LOW_SPEED_MOTION = {180, 1500, 13000, 5000, 4000};
+/// a faster mouse (vturn = 2000 mm/s, acc = 16667 mm/s/s)
+constexpr MotionProfile HIGH_SPEED_MOTION = {180, 2000, 16667, 5000, 4000};
+
+#endif  // RUNLENGTHCOSTS_H
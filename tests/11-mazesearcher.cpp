@@ -5,6 +5,8 @@
 #include "mazeconstants.h"
 #include "mazesearcher.h"
 
+#include <string>
+
 #include "gtest/gtest.h"
 
 static constexpr uint16_t WIDTH = 16;
@@ -118,6 +120,36 @@ TEST_F(TEST_11_MazeSearcher, 30_RunToReachesGoalWithFullMap) {
   EXPECT_EQ(GOAL, searcher.location());
 }
 
+TEST_F(TEST_11_MazeSearcher, 31_VerboseRouteQueryPrintsEveryStep) {
+  searcher.map()->copyMazeFromFileData(apec1996, CELL_COUNT);
+  for (uint16_t i = 0; i < CELL_COUNT; i++) {
+    searcher.map()->setVisited(i);
+  }
+  searcher.setRouteQueries(true);
+  searcher.setVerbose(true);
+  ::testing::internal::CaptureStdout();
+  int steps = searcher.runTo(GOAL);
+  std::string printed = ::testing::internal::GetCapturedStdout();
+  EXPECT_GT(steps, 0);
+  EXPECT_EQ(GOAL, searcher.location());
+  EXPECT_FALSE(printed.empty());
+}
+
+TEST_F(TEST_11_MazeSearcher, 32_VerboseBidirectionalRoutePrintsEveryStep) {
+  searcher.map()->copyMazeFromFileData(apec1996, CELL_COUNT);
+  for (uint16_t i = 0; i < CELL_COUNT; i++) {
+    searcher.map()->setVisited(i);
+  }
+  searcher.setBidirectionalRoutes(true);
+  searcher.setVerbose(true);
+  ::testing::internal::CaptureStdout();
+  int steps = searcher.runTo(GOAL);
+  std::string printed = ::testing::internal::GetCapturedStdout();
+  EXPECT_GT(steps, 0);
+  EXPECT_EQ(GOAL, searcher.location());
+  EXPECT_FALSE(printed.empty());
+}
+
 // ---------------------------------------------------------------------------
 // Wall-follow modes (smoke: no crash, terminates, visits cells)
 // ---------------------------------------------------------------------------
@@ -0,0 +1,213 @@
+// Tests for IndexedHeap<T> and the HEAP_QUEUE flood option.
+//
+// The heap must hand back items in ascending order, break ties in the order
+// items were first queued, lower the cost of a queued key in place and grow
+// past its initial capacity.
+
+#include "corpus-mazes.h"
+#include "floodinfo.h"
+#include "indexedheap.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+
+#include "gtest/gtest.h"
+
+class TEST_12_IndexedHeap : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+// ---------------------------------------------------------------------------
+// Construction, update() and size()
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_12_IndexedHeap, 00_DefaultConstructionIsEmpty) {
+  IndexedHeap<int> q;
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(1024, q.keyCount());
+}
+
+TEST_F(TEST_12_IndexedHeap, 01_UpdateNewKeyAddsItem) {
+  IndexedHeap<int> q(16);
+  EXPECT_TRUE(q.update(3, 42));
+  EXPECT_EQ(1, q.size());
+  EXPECT_TRUE(q.contains(3));
+  EXPECT_FALSE(q.contains(4));
+}
+
+TEST_F(TEST_12_IndexedHeap, 02_ClearEmptiesHeapAndKeys) {
+  IndexedHeap<int> q(16);
+  q.update(1, 10);
+  q.update(2, 20);
+  q.clear();
+  EXPECT_EQ(0, q.size());
+  EXPECT_FALSE(q.contains(1));
+  EXPECT_FALSE(q.contains(2));
+  q.update(2, 5);
+  EXPECT_EQ(5, q.fetchSmallest());
+}
+
+// ---------------------------------------------------------------------------
+// fetchSmallest() ordering
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_12_IndexedHeap, 10_FetchSmallestGivesAscendingOrder) {
+  IndexedHeap<int> q(16);
+  q.update(0, 50);
+  q.update(1, 10);
+  q.update(2, 40);
+  q.update(3, 20);
+  q.update(4, 30);
+  EXPECT_EQ(1, q.topKey());
+  EXPECT_EQ(10, q.fetchSmallest());
+  EXPECT_EQ(20, q.fetchSmallest());
+  EXPECT_EQ(30, q.fetchSmallest());
+  EXPECT_EQ(40, q.fetchSmallest());
+  EXPECT_EQ(50, q.fetchSmallest());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST_F(TEST_12_IndexedHeap, 11_FetchSmallestRemovesKey) {
+  IndexedHeap<int> q(16);
+  q.update(7, 1);
+  q.fetchSmallest();
+  EXPECT_FALSE(q.contains(7));
+}
+
+TEST_F(TEST_12_IndexedHeap, 12_EqualItemsComeOutInQueueOrder) {
+  IndexedHeap<FloodInfo> q(64);
+  for (uint16_t cell = 20; cell > 0; cell--) {
+    q.update(cell, FloodInfo(7, cell, 1, DIR_N));
+  }
+  for (uint16_t cell = 20; cell > 0; cell--) {
+    EXPECT_EQ(cell, q.fetchSmallest().cell);
+  }
+}
+
+TEST_F(TEST_12_IndexedHeap, 13_BinaryHeapGivesSameOrder) {
+  IndexedHeap<int, 2> q(256);
+  for (int key = 0; key < 256; key++) {
+    q.update(key, (key * 37) % 101);
+  }
+  int last = -1;
+  while (q.size() > 0) {
+    int item = q.fetchSmallest();
+    EXPECT_LE(last, item);
+    last = item;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Decrease-key
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_12_IndexedHeap, 20_SmallerItemReplacesQueuedItem) {
+  IndexedHeap<int> q(16);
+  q.update(1, 30);
+  q.update(2, 20);
+  EXPECT_TRUE(q.update(1, 10));
+  EXPECT_EQ(2, q.size());
+  EXPECT_EQ(1, q.topKey());
+  EXPECT_EQ(10, q.fetchSmallest());
+  EXPECT_EQ(20, q.fetchSmallest());
+}
+
+TEST_F(TEST_12_IndexedHeap, 21_LargerItemIsIgnored) {
+  IndexedHeap<int> q(16);
+  q.update(1, 10);
+  EXPECT_FALSE(q.update(1, 30));
+  EXPECT_FALSE(q.update(1, 10));
+  EXPECT_EQ(1, q.size());
+  EXPECT_EQ(10, q.fetchSmallest());
+}
+
+TEST_F(TEST_12_IndexedHeap, 22_DecreaseKeyReplacesWholeFloodInfo) {
+  IndexedHeap<FloodInfo> q(16);
+  q.update(5, FloodInfo(100, 5, 1, DIR_N, SOUTH));
+  q.update(5, FloodInfo(60, 5, 3, DIR_E, WEST));
+  FloodInfo info = q.fetchSmallest();
+  EXPECT_EQ(60, info.cost);
+  EXPECT_EQ(3, info.runLength);
+  EXPECT_EQ(DIR_E, info.entryDir);
+  EXPECT_EQ(WEST, info.entryWall);
+}
+
+// ---------------------------------------------------------------------------
+// Capacity
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_12_IndexedHeap, 30_GrowsPastInitialCapacity) {
+  IndexedHeap<int> q(1024, 8);
+  for (int key = 0; key < 1024; key++) {
+    q.update(key, 1024 - key);
+  }
+  EXPECT_EQ(1024, q.size());
+  EXPECT_GE(q.capacity(), 1024);
+  EXPECT_EQ(1, q.fetchSmallest());
+}
+
+// ---------------------------------------------------------------------------
+// Maze floods using the heap
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_12_IndexedHeap, 40_DefaultQueueTypeIsLinear) {
+  Maze maze(16);
+  EXPECT_EQ(Maze::LINEAR_QUEUE, maze.getQueueType());
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  EXPECT_EQ(Maze::HEAP_QUEUE, maze.getQueueType());
+}
+
+TEST_F(TEST_12_IndexedHeap, 41_HeapFloodsReachTheSameCellsAsLinearFloods) {
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze linear(width);
+    Maze heap(width);
+    loadCorpusMaze(linear, i);
+    loadCorpusMaze(heap, i);
+    heap.setQueueType(Maze::HEAP_QUEUE);
+    uint16_t goal = width == 16 ? 0x77 : 0x1EF;
+    for (Maze::FloodType type : {Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD}) {
+      linear.setFloodType(type);
+      heap.setFloodType(type);
+      linear.flood(goal, OPEN_MASK);
+      heap.flood(goal, OPEN_MASK);
+      for (uint16_t cell = 0; cell < linear.numCells(); cell++) {
+        ASSERT_EQ(linear.cost(cell) == MAX_COST, heap.cost(cell) == MAX_COST) << mazeList[i].title << " cell " << cell;
+      }
+      EXPECT_EQ(0u, heap.cost(goal));
+    }
+  }
+}
+
+TEST_F(TEST_12_IndexedHeap, 42_HeapWeightedFloodIsNeverWorseThanLinear) {
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze linear(width);
+    Maze heap(width);
+    loadCorpusMaze(linear, i);
+    loadCorpusMaze(heap, i);
+    heap.setQueueType(Maze::HEAP_QUEUE);
+    uint16_t goal = width == 16 ? 0x77 : 0x1EF;
+    linear.weightedFlood(goal);
+    heap.weightedFlood(goal);
+    EXPECT_LE(heap.cost(0), linear.cost(0)) << mazeList[i].title;
+  }
+}
+
+TEST_F(TEST_12_IndexedHeap, 43_HeapRunLengthFloodDirectionsLeadToGoal) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  maze.runLengthFlood(0x77);
+  uint16_t cell = 0;
+  int steps = 0;
+  while (cell != 0x77 && steps < 256) {
+    uint8_t direction = maze.direction(cell);
+    ASSERT_NE(INVALID_DIRECTION, direction);
+    cell = maze.neighbour(cell, direction);
+    steps++;
+  }
+  EXPECT_EQ(0x77, cell);
+}
@@ -0,0 +1,182 @@
+// Tests for BucketQueue<T> and the BUCKET_QUEUE flood option.
+//
+// The bucket queue must return items in exactly the order that
+// PriorityQueue::fetchSmallest() does, so a runlength flood gives the same
+// costs and directions with either queue.
+
+#include <cstdlib>
+
+#include "bucketqueue.h"
+#include "corpus-mazes.h"
+#include "floodinfo.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "priorityqueue.h"
+
+#include "gtest/gtest.h"
+
+class TEST_13_BucketQueue : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+// ---------------------------------------------------------------------------
+// Basic queue behaviour
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_13_BucketQueue, 00_DefaultConstructionIsEmpty) {
+  BucketQueue<FloodInfo> q;
+  EXPECT_EQ(0, q.size());
+}
+
+TEST_F(TEST_13_BucketQueue, 01_AddIncreasesSize) {
+  BucketQueue<FloodInfo> q(8);
+  q.add(FloodInfo(10, 1, 1, DIR_N));
+  q.add(FloodInfo(20, 2, 1, DIR_N));
+  EXPECT_EQ(2, q.size());
+}
+
+TEST_F(TEST_13_BucketQueue, 02_FetchSmallestGivesAscendingCost) {
+  BucketQueue<FloodInfo> q(8);
+  q.add(FloodInfo(50, 1, 1, DIR_N));
+  q.add(FloodInfo(10, 2, 1, DIR_N));
+  q.add(FloodInfo(40, 3, 1, DIR_N));
+  q.add(FloodInfo(20, 4, 1, DIR_N));
+  EXPECT_EQ(10, q.fetchSmallest().cost);
+  EXPECT_EQ(20, q.fetchSmallest().cost);
+  EXPECT_EQ(40, q.fetchSmallest().cost);
+  EXPECT_EQ(50, q.fetchSmallest().cost);
+  EXPECT_EQ(0, q.size());
+}
+
+TEST_F(TEST_13_BucketQueue, 03_CostsWrapAroundTheBuckets) {
+  BucketQueue<FloodInfo, 16> q(8);
+  q.add(FloodInfo(14, 1, 1, DIR_N));
+  EXPECT_EQ(14, q.fetchSmallest().cost);
+  q.add(FloodInfo(20, 2, 1, DIR_N));
+  q.add(FloodInfo(17, 3, 1, DIR_N));
+  EXPECT_EQ(17, q.fetchSmallest().cost);
+  EXPECT_EQ(20, q.fetchSmallest().cost);
+}
+
+TEST_F(TEST_13_BucketQueue, 04_ClearEmptiesQueue) {
+  BucketQueue<FloodInfo> q(8);
+  q.add(FloodInfo(10, 1, 1, DIR_N));
+  q.clear();
+  EXPECT_EQ(0, q.size());
+  q.add(FloodInfo(3, 7, 1, DIR_N));
+  EXPECT_EQ(7, q.fetchSmallest().cell);
+}
+
+TEST_F(TEST_13_BucketQueue, 05_ClearLeavesNoStaleItemsInTheBuckets) {
+  BucketQueue<FloodInfo> q(8);
+  for (uint16_t i = 0; i < 8; i++) {
+    q.add(FloodInfo(10 + i % 3, i, 1, DIR_N));
+  }
+  q.fetchSmallest();
+  q.fetchSmallest();
+  q.clear();
+  // the same buckets again, and every node, after a clear with items still queued
+  for (uint16_t i = 0; i < 8; i++) {
+    q.add(FloodInfo(12 - i % 3, 100 + i, 1, DIR_N));
+  }
+  EXPECT_EQ(8, q.size());
+  int lastCost = 0;
+  for (int i = 0; i < 8; i++) {
+    FloodInfo info = q.fetchSmallest();
+    EXPECT_GE(info.cell, 100);
+    EXPECT_GE(info.cost, lastCost);
+    lastCost = info.cost;
+  }
+  EXPECT_EQ(0, q.size());
+}
+
+// ---------------------------------------------------------------------------
+// Pop order matches PriorityQueue
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_13_BucketQueue, 10_TiesFollowPriorityQueueSwapOrder) {
+  // PriorityQueue swaps the head item into the slot of the item it removes
+  PriorityQueue<FloodInfo> linear(16);
+  BucketQueue<FloodInfo> buckets(16);
+  const uint16_t costs[] = {30, 10, 30, 20, 30};
+  for (uint16_t i = 0; i < 5; i++) {
+    linear.add(FloodInfo(costs[i], i, 1, DIR_N));
+    buckets.add(FloodInfo(costs[i], i, 1, DIR_N));
+  }
+  while (linear.size() > 0) {
+    EXPECT_EQ(linear.fetchSmallest().cell, buckets.fetchSmallest().cell);
+  }
+}
+
+TEST_F(TEST_13_BucketQueue, 11_RandomFloodLikeWorkloadMatchesPriorityQueue) {
+  srand(1234);
+  for (int trial = 0; trial < 50; trial++) {
+    PriorityQueue<FloodInfo> linear(128);
+    BucketQueue<FloodInfo> buckets(128);
+    uint16_t cell = 0;
+    for (int i = 0; i < 4; i++) {
+      linear.add(FloodInfo(98, cell, 1, DIR_N));
+      buckets.add(FloodInfo(98, cell, 1, DIR_N));
+      cell++;
+    }
+    int pops = 0;
+    while (linear.size() > 0 && pops < 500) {
+      FloodInfo a = linear.fetchSmallest();
+      FloodInfo b = buckets.fetchSmallest();
+      ASSERT_EQ(a.cell, b.cell) << "trial " << trial << " pop " << pops;
+      ASSERT_EQ(a.cost, b.cost);
+      pops++;
+      int children = rand() % 4;
+      for (int c = 0; c < children && linear.size() < 120; c++) {
+        // few distinct step costs so that there are plenty of ties
+        auto newCost = static_cast<uint16_t>(a.cost + 31 + 22 * (rand() % 3));
+        linear.add(FloodInfo(newCost, cell, 1, DIR_N));
+        buckets.add(FloodInfo(newCost, cell, 1, DIR_N));
+        cell++;
+      }
+    }
+    EXPECT_EQ(linear.size(), buckets.size());
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Maze runlength flood using the bucket queue
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_13_BucketQueue, 20_BucketRunLengthFloodMatchesLinearOnCorpus) {
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze linear(width);
+    Maze buckets(width);
+    loadCorpusMaze(linear, i);
+    loadCorpusMaze(buckets, i);
+    buckets.setQueueType(Maze::BUCKET_QUEUE);
+    uint16_t goal = width == 16 ? 0x77 : 0x1EF;
+    for (int mask : {OPEN_MASK, CLOSED_MASK}) {
+      uint16_t linearCost = linear.flood(goal, mask);
+      uint16_t bucketCost = buckets.flood(goal, mask);
+      EXPECT_EQ(linearCost, bucketCost) << mazeList[i].title;
+      for (uint16_t cell = 0; cell < linear.numCells(); cell++) {
+        ASSERT_EQ(linear.cost(cell), buckets.cost(cell)) << mazeList[i].title << " cell " << cell;
+        ASSERT_EQ(linear.direction(cell), buckets.direction(cell)) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+}
+
+TEST_F(TEST_13_BucketQueue, 21_BucketRunLengthFloodMatchesLinearOnEmptyMaze) {
+  Maze linear(16);
+  Maze buckets(16);
+  linear.resetToEmptyMaze();
+  buckets.resetToEmptyMaze();
+  buckets.setQueueType(Maze::BUCKET_QUEUE);
+  linear.runLengthFlood(0x77);
+  buckets.runLengthFlood(0x77);
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    EXPECT_EQ(linear.cost(cell), buckets.cost(cell)) << "cell " << cell;
+    EXPECT_EQ(linear.direction(cell), buckets.direction(cell)) << "cell " << cell;
+  }
+}
@@ -0,0 +1,242 @@
+// Tests for IncrementalFlood, the incremental replanner for manhattan floods.
+//
+// A map is explored one cell at a time, as in MazeSearcher::searchTo(). After
+// every cell, the incremental flood must leave exactly the same costs and
+// directions as a full flood of the same walls.
+
+#include "floodresult.h"
+#include "incrementalflood.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+static constexpr uint16_t WIDTH = 16;
+static constexpr uint16_t CELL_COUNT = WIDTH * WIDTH;
+static constexpr uint16_t GOAL = 0x77;
+static constexpr uint16_t HOME = 0;
+
+class TEST_14_IncrementalFlood : public ::testing::Test {
+ protected:
+  IncrementalFlood planner;
+
+  /// follow the map directions from home, flooding after each cell, and compare with full floods
+  void exploreAndCompare(const uint8_t *mazeData, uint16_t width, uint16_t target, int mask) {
+    Maze realMaze(width);
+    realMaze.copyMazeFromFileData(mazeData, width * width);
+    Maze map(width);
+    map.resetToEmptyMaze();
+    map.setFloodType(Maze::MANHATTAN_FLOOD);
+    map.setIncrementalFlood(&planner);
+    Maze reference(width);
+    reference.setFloodType(Maze::MANHATTAN_FLOOD);
+    uint8_t walls[1024];
+
+    uint16_t location = HOME;
+    int steps = 0;
+    while (location != target && steps < 4 * map.numCells()) {
+      map.updateMap(location, realMaze.walls(location));
+      uint16_t cost = map.flood(target, mask);
+      map.save(walls);
+      reference.load(walls);
+      ASSERT_EQ(reference.flood(target, mask), cost) << "step " << steps;
+      for (uint16_t cell = 0; cell < map.numCells(); cell++) {
+        ASSERT_EQ(reference.cost(cell), map.cost(cell)) << "step " << steps << " cell " << cell;
+        ASSERT_EQ(reference.direction(cell), map.direction(cell)) << "step " << steps << " cell " << cell;
+      }
+      uint8_t heading = map.direction(location);
+      if (heading == INVALID_DIRECTION) {
+        break;
+      }
+      location = map.neighbour(location, heading);
+      steps++;
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Equivalence with a full flood
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_14_IncrementalFlood, 00_FirstFloodIsFull) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  EXPECT_EQ(1u, planner.counters().floods);
+  EXPECT_EQ(1u, planner.counters().fullFloods);
+  EXPECT_EQ(CELL_COUNT, planner.counters().lastExpansions);
+  EXPECT_TRUE(planner.isValid());
+}
+
+TEST_F(TEST_14_IncrementalFlood, 01_SearchOfApec1996MatchesFullFloods) {
+  exploreAndCompare(apec1996, WIDTH, GOAL, OPEN_MASK);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 02_SearchOfJapan2007efMatchesFullFloods) {
+  exploreAndCompare(japan2007ef, WIDTH, GOAL, OPEN_MASK);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 03_ClosedMaskSearchMatchesFullFloods) {
+  // with the closed mask, newly seen walls open up routes rather than close them
+  exploreAndCompare(uk2014f, WIDTH, GOAL, CLOSED_MASK);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 04_HalfSizeSearchMatchesFullFloods) {
+  exploreAndCompare(japan2015ef_half, 32, 0x1EF, OPEN_MASK);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 05_SetWallAndClearWallAreRepaired) {
+  Maze maze(WIDTH);
+  Maze reference(WIDTH);
+  maze.resetToEmptyMaze();
+  reference.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  reference.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  for (uint16_t cell = 0x10; cell < 0x70; cell += 0x11) {
+    maze.setWall(cell, NORTH);
+    reference.setWall(cell, NORTH);
+    maze.clearWall(cell, EAST);
+    reference.clearWall(cell, EAST);
+    maze.flood(GOAL, OPEN_MASK);
+    reference.flood(GOAL, OPEN_MASK);
+    for (uint16_t i = 0; i < CELL_COUNT; i++) {
+      ASSERT_EQ(reference.cost(i), maze.cost(i)) << "cell " << i;
+      ASSERT_EQ(reference.direction(i), maze.direction(i)) << "cell " << i;
+    }
+  }
+  EXPECT_GT(planner.counters().incrementalFloods, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// When a full flood is needed
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_14_IncrementalFlood, 10_NewTargetForcesFullFlood) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  maze.flood(HOME, OPEN_MASK);
+  EXPECT_EQ(2u, planner.counters().fullFloods);
+  maze.flood(HOME, CLOSED_MASK);
+  EXPECT_EQ(3u, planner.counters().fullFloods);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 11_LoadInvalidates) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  uint8_t walls[256];
+  maze.save(walls);
+  maze.load(walls);
+  EXPECT_FALSE(planner.isValid());
+}
+
+TEST_F(TEST_14_IncrementalFlood, 12_TooManyChangesInvalidates) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  for (uint16_t cell = 1; cell <= IncrementalFlood::MAX_CHANGES + 1; cell++) {
+    maze.setWall(cell, EAST);
+  }
+  EXPECT_FALSE(planner.isValid());
+}
+
+TEST_F(TEST_14_IncrementalFlood, 13_UnchangedWallIsNotLogged) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  maze.setWall(0, WEST);  // already set by resetToEmptyMaze
+  maze.flood(GOAL, OPEN_MASK);
+  EXPECT_EQ(1u, planner.counters().incrementalFloods);
+  EXPECT_EQ(0u, planner.counters().lastExpansions);
+}
+
+// ---------------------------------------------------------------------------
+// MazeSearcher and the counters
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_14_IncrementalFlood, 20_SearcherGivesSameResultWithIncrementalFlood) {
+  Maze realMaze(WIDTH);
+  realMaze.copyMazeFromFileData(japan2007ef, CELL_COUNT);
+  MazeSearcher full;
+  MazeSearcher incremental;
+  full.setRealMaze(&realMaze);
+  incremental.setRealMaze(&realMaze);
+  incremental.setIncrementalFlood(true);
+  ASSERT_NE(nullptr, incremental.incrementalFlood());
+  EXPECT_EQ(full.searchTo(GOAL), incremental.searchTo(GOAL));
+  EXPECT_EQ(full.location(), incremental.location());
+  EXPECT_EQ(full.searchTo(HOME), incremental.searchTo(HOME));
+  EXPECT_EQ(full.location(), incremental.location());
+}
+
+TEST_F(TEST_14_IncrementalFlood, 21_SearchExpandsFarFewerCells) {
+  // a full flood of an open-mask map expands every cell
+  Maze realMaze(WIDTH);
+  realMaze.copyMazeFromFileData(japan2007ef, CELL_COUNT);
+  MazeSearcher searcher;
+  searcher.setRealMaze(&realMaze);
+  searcher.setIncrementalFlood(true);
+  searcher.searchTo(GOAL);
+  const IncrementalFlood::Counters &counters = searcher.incrementalFlood()->counters();
+  EXPECT_EQ(1u, counters.fullFloods);
+  EXPECT_GT(counters.incrementalFloods, 20u);
+  EXPECT_LT(counters.cellExpansions * 5, counters.floods * CELL_COUNT);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 22_ResetCounters) {
+  Maze maze(WIDTH);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setIncrementalFlood(&planner);
+  maze.flood(GOAL, OPEN_MASK);
+  planner.resetCounters();
+  EXPECT_EQ(0u, planner.counters().floods);
+  EXPECT_EQ(0u, planner.counters().cellExpansions);
+}
+
+TEST_F(TEST_14_IncrementalFlood, 23_TestForSolutionKeepsTheOpenMask) {
+  Maze realMaze(WIDTH);
+  realMaze.copyMazeFromFileData(japan2007ef, CELL_COUNT);
+  Maze map(WIDTH);
+  map.resetToEmptyMaze();
+  map.setFloodType(Maze::MANHATTAN_FLOOD);
+  map.setIncrementalFlood(&planner);
+  Maze reference(WIDTH);
+  reference.resetToEmptyMaze();
+  reference.setFloodType(Maze::MANHATTAN_FLOOD);
+  FloodResult closed;
+  uint16_t location = HOME;
+  uint32_t tests = 0;
+  // the closed flood of each test goes round the planner, which only ever sees the open mask
+  while (location != GOAL && tests < 4u * CELL_COUNT) {
+    map.updateMap(location, realMaze.walls(location));
+    reference.updateMap(location, realMaze.walls(location));
+    const bool solved = tests % 2 ? map.testForSolution(closed) : map.testForSolution();
+    ASSERT_EQ(reference.testForSolution(), solved) << "test " << tests;
+    ASSERT_EQ(reference.closedMazeCost(), map.closedMazeCost()) << "test " << tests;
+    ASSERT_EQ(reference.openMazeCost(), map.openMazeCost()) << "test " << tests;
+    uint8_t heading = map.direction(location);
+    ASSERT_NE(INVALID_DIRECTION, heading);
+    location = map.neighbour(location, heading);
+    tests++;
+  }
+  EXPECT_EQ(tests, planner.counters().floods);
+  EXPECT_EQ(1u, planner.counters().fullFloods);
+  EXPECT_EQ(tests - 1, planner.counters().incrementalFloods);
+  EXPECT_LT(planner.counters().cellExpansions * 5, tests * CELL_COUNT);
+}
@@ -0,0 +1,172 @@
+// Tests for WallPlanes, the bitplane copy of the maze walls.
+//
+// Every bulk query must agree with the per-cell Maze API, and the planes
+// must follow every change made through the Maze wall writers.
+
+#include "corpus-mazes.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "wallplanes.h"
+
+#include "gtest/gtest.h"
+
+class TEST_15_WallPlanes : public ::testing::Test {
+ protected:
+  /// check that the planes give back the wall byte of every cell in the maze
+  static void expectPlanesMatchMaze(Maze &maze) {
+    const WallPlanes &planes = maze.wallPlanes();
+    ASSERT_EQ(maze.width(), planes.width());
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(maze.getXWalls(cell), planes.cellWalls(cell)) << "cell " << cell;
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Storage
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_15_WallPlanes, 00_CellWallsRoundTrip) {
+  WallPlanes planes(16);
+  for (uint16_t value = 0; value < 256; value++) {
+    planes.setCellWalls(value, (uint8_t)value);
+  }
+  for (uint16_t value = 0; value < 256; value++) {
+    EXPECT_EQ(value, planes.cellWalls(value));
+  }
+}
+
+TEST_F(TEST_15_WallPlanes, 01_RowMaskFollowsWidth) {
+  WallPlanes planes(16);
+  EXPECT_EQ(0xFFFFu, planes.rowMask());
+  planes.setWidth(5);
+  EXPECT_EQ(0x1Fu, planes.rowMask());
+  planes.setWidth(32);
+  EXPECT_EQ(0xFFFFFFFFu, planes.rowMask());
+}
+
+TEST_F(TEST_15_WallPlanes, 02_ClearLeavesNoWalls) {
+  WallPlanes planes(16);
+  planes.setCellWalls(0x23, 0xFF);
+  planes.clear();
+  EXPECT_EQ(0, planes.cellWalls(0x23));
+}
+
+// ---------------------------------------------------------------------------
+// Keeping up with the Maze
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_15_WallPlanes, 10_NewMazeMatches) {
+  Maze maze(16);
+  expectPlanesMatchMaze(maze);
+  maze.resetToEmptyMaze();
+  expectPlanesMatchMaze(maze);
+}
+
+TEST_F(TEST_15_WallPlanes, 11_WallWritersAreMirrored) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setWall(0x33, NORTH);
+  maze.setWall(0x4F, NORTH);  // wraps into the next column
+  maze.clearWall(0x10, WEST);
+  maze.setVisited(0x55);
+  maze.clearVisited(0x00);
+  maze.updateMap(0x66, 0x0B);
+  expectPlanesMatchMaze(maze);
+}
+
+TEST_F(TEST_15_WallPlanes, 12_LoadAndCorpusMatch) {
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze maze(width);
+    loadCorpusMaze(maze, i);
+    expectPlanesMatchMaze(maze);
+  }
+  Maze maze(16);
+  maze.load(japan2007ef);
+  expectPlanesMatchMaze(maze);
+}
+
+TEST_F(TEST_15_WallPlanes, 13_SetWidthResizesPlanes) {
+  Maze maze(16);
+  maze.setWidth(32);
+  expectPlanesMatchMaze(maze);
+  maze.setWidth(7);
+  expectPlanesMatchMaze(maze);
+}
+
+// ---------------------------------------------------------------------------
+// Bulk queries
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_15_WallPlanes, 20_ExitsAgreeWithHasExit) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  for (int i = 0; i < 60; i++) {
+    maze.clearVisited((uint16_t)(i * 37 % 256));  // leave some walls unseen
+  }
+  const WallPlanes &planes = maze.wallPlanes();
+  for (int mask : {OPEN_MASK, CLOSED_MASK}) {
+    maze.flood(0x77, mask);
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      for (uint8_t direction = 0; direction < 4; direction++) {
+        bool bit = (planes.exits(maze.col(cell), direction, (uint8_t)mask) >> maze.row(cell)) & 1;
+        ASSERT_EQ(maze.hasExit(cell, direction), bit) << "cell " << cell << " direction " << int(direction);
+      }
+    }
+  }
+}
+
+TEST_F(TEST_15_WallPlanes, 21_VisitedAgreesWithIsVisited) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.updateMap(0x00, 0x0E);
+  maze.updateMap(0x01, 0x0A);
+  maze.setVisited(0xA5);
+  const WallPlanes &planes = maze.wallPlanes();
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    bool bit = (planes.visited(maze.col(cell)) >> maze.row(cell)) & 1;
+    EXPECT_EQ(maze.isVisited(cell), bit) << "cell " << cell;
+  }
+}
+
+TEST_F(TEST_15_WallPlanes, 22_ExpandMatchesNeighbourWalk) {
+  for (uint16_t width : {16, 32}) {
+    Maze maze(width);
+    maze.copyMazeFromFileData(width == 16 ? japan2007ef : japan2015ef_half, width * width);
+    for (int i = 0; i < 40; i++) {
+      maze.clearWall((uint16_t)(i * 53 % maze.numCells()), (uint8_t)(i % 4));  // opens some border walls too
+    }
+    const WallPlanes &planes = maze.wallPlanes();
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      maze.flood(0, mask);  // hasExit() uses the mask from the last flood
+      WallPlanes::column_t frontier[WallPlanes::MAX_WIDTH] = {};
+      WallPlanes::column_t reached[WallPlanes::MAX_WIDTH] = {};
+      WallPlanes::column_t expected[WallPlanes::MAX_WIDTH] = {};
+      for (uint16_t cell = 0; cell < maze.numCells(); cell += 3) {
+        frontier[maze.col(cell)] |= WallPlanes::column_t(1) << maze.row(cell);
+        for (uint8_t direction = 0; direction < 4; direction++) {
+          if (maze.hasExit(cell, direction)) {
+            uint16_t next = maze.neighbour(cell, direction);
+            expected[maze.col(next)] |= WallPlanes::column_t(1) << maze.row(next);
+          }
+        }
+      }
+      planes.expand(frontier, reached, mask);
+      for (uint16_t col = 0; col < width; col++) {
+        ASSERT_EQ(expected[col], reached[col]) << "width " << width << " col " << col;
+      }
+    }
+  }
+}
+
+TEST_F(TEST_15_WallPlanes, 23_CountAddsEveryColumn) {
+  WallPlanes planes(16);
+  WallPlanes::column_t cells[WallPlanes::MAX_WIDTH] = {};
+  cells[0] = 0x0001;
+  cells[7] = 0x00FF;
+  cells[15] = 0xFFFF;
+  cells[16] = 0xFFFF;  // outside a 16 wide maze
+  EXPECT_EQ(25, planes.count(cells));
+}
@@ -0,0 +1,151 @@
+// Tests for BitFlood, the bit-parallel manhattan flood.
+//
+// Every kernel must give exactly the costs of the original queue based
+// manhattan flood, and Maze::manhattanFlood() must leave the same costs and
+// directions whichever flood it uses.
+
+#include "bitflood.h"
+#include "corpus-mazes.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+
+#include "gtest/gtest.h"
+
+class TEST_16_BitFlood : public ::testing::Test {
+ protected:
+  static const BitFlood::Kernel kernels[3];
+
+  /// compare a queue flood with a bit-parallel flood of the same maze
+  static void expectSameFlood(Maze &maze, uint16_t target, int mask, const char *title) {
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    maze.setBitParallelFlood(false);
+    uint16_t queueCost = maze.flood(target, mask);
+    uint16_t costs[1024];
+    uint8_t directions[1024];
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      costs[cell] = maze.cost(cell);
+      directions[cell] = maze.direction(cell);
+    }
+    maze.setBitParallelFlood(true);
+    ASSERT_EQ(queueCost, maze.flood(target, mask)) << title;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(costs[cell], maze.cost(cell)) << title << " cell " << cell;
+      ASSERT_EQ(directions[cell], maze.direction(cell)) << title << " cell " << cell;
+    }
+    for (BitFlood::Kernel kernel : kernels) {
+      uint16_t kernelCosts[1024];
+      BitFlood::flood(maze.wallPlanes(), target, (uint8_t)mask, kernelCosts, kernel);
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(costs[cell], kernelCosts[cell]) << title << " " << BitFlood::kernelName(kernel) << " cell " << cell;
+      }
+    }
+  }
+};
+
+const BitFlood::Kernel TEST_16_BitFlood::kernels[3] = {BitFlood::PORTABLE_KERNEL, BitFlood::SSE2_KERNEL,
+                                                       BitFlood::AVX2_KERNEL};
+
+// ---------------------------------------------------------------------------
+// Kernel selection
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_16_BitFlood, 00_PortableKernelIsAlwaysSupported) {
+  EXPECT_TRUE(BitFlood::isSupported(BitFlood::PORTABLE_KERNEL));
+}
+
+TEST_F(TEST_16_BitFlood, 01_BestKernelIsSupported) {
+  EXPECT_TRUE(BitFlood::isSupported(BitFlood::bestKernel()));
+}
+
+TEST_F(TEST_16_BitFlood, 02_BitParallelFloodIsTheDefault) {
+  Maze maze(16);
+  EXPECT_TRUE(maze.getBitParallelFlood());
+}
+
+// ---------------------------------------------------------------------------
+// Same results as the queue flood
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_16_BitFlood, 10_EmptyMaze) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  expectSameFlood(maze, 0x77, OPEN_MASK, "empty");
+  expectSameFlood(maze, 0x00, CLOSED_MASK, "empty");
+}
+
+TEST_F(TEST_16_BitFlood, 11_ClearedMazeWrapsLikeNeighbour) {
+  // with no border walls every move wraps around the maze
+  for (uint16_t width : {5, 16, 32}) {
+    Maze maze(width);
+    maze.clearData();
+    expectSameFlood(maze, 0, OPEN_MASK, "cleared");
+    expectSameFlood(maze, (uint16_t)(maze.numCells() - 1), OPEN_MASK, "cleared");
+  }
+}
+
+TEST_F(TEST_16_BitFlood, 12_WholeCorpusBothMasks) {
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze maze(width);
+    loadCorpusMaze(maze, i);
+    uint16_t goal = width == 16 ? 0x77 : 0x1EF;
+    expectSameFlood(maze, goal, OPEN_MASK, mazeList[i].title);
+    expectSameFlood(maze, goal, CLOSED_MASK, mazeList[i].title);
+    expectSameFlood(maze, 0, OPEN_MASK, mazeList[i].title);
+  }
+}
+
+TEST_F(TEST_16_BitFlood, 13_PartlySeenMazeWithOddWidths) {
+  // a mix of seen and unseen walls makes the two masks give different floods
+  for (uint16_t width : {3, 7, 9, 16, 17, 31, 32}) {
+    Maze maze(width);
+    maze.resetToEmptyMaze();
+    for (int i = 0; i < maze.numCells(); i++) {
+      uint16_t cell = (uint16_t)(i * 97 % maze.numCells());
+      if (i % 3 == 0) {
+        maze.setWall(cell, (uint8_t)(i % 4));
+      } else if (i % 5 == 0) {
+        maze.clearWall(cell, (uint8_t)(i % 4));
+      }
+    }
+    expectSameFlood(maze, (uint16_t)(maze.numCells() / 2), OPEN_MASK, "partly seen");
+    expectSameFlood(maze, (uint16_t)(maze.numCells() / 2), CLOSED_MASK, "partly seen");
+  }
+}
+
+TEST_F(TEST_16_BitFlood, 14_UnreachableCellsKeepMaxCost) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    maze.setWall(0x55, direction);
+  }
+  uint16_t costs[256];
+  EXPECT_EQ(1, BitFlood::flood(maze.wallPlanes(), 0x55, OPEN_MASK, costs));
+  EXPECT_EQ(0, costs[0x55]);
+  EXPECT_EQ(MAX_COST, costs[0x56]);
+  EXPECT_EQ(255, BitFlood::flood(maze.wallPlanes(), 0x00, OPEN_MASK, costs));
+}
+
+TEST_F(TEST_16_BitFlood, 15_DirectionsMatchDirectionToSmallest) {
+  // the manhattan direction pass walks the maze by column and row instead of using neighbour()
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    Maze maze(width);
+    loadCorpusMaze(maze, i);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    for (uint16_t target : {(uint16_t)0, (uint16_t)(width == 16 ? 0x77 : 0x1EF), (uint16_t)(width * width - 1)}) {
+      maze.flood(target, OPEN_MASK);
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(maze.directionToSmallest(cell, target), maze.direction(cell)) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+  Maze maze(7);
+  maze.clearData();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.flood(20, OPEN_MASK);
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    ASSERT_EQ(maze.directionToSmallest(cell, 20), maze.direction(cell)) << "cell " << cell;
+  }
+}
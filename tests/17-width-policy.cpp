@@ -0,0 +1,117 @@
+// Tests for the width policies in mazegeometry.h and the floods built on them.
+//
+// FixedWidth and RuntimeWidth must give the same neighbours as
+// Maze::neighbour(), and every flood must give the same costs and
+// directions whether it is compiled for a fixed width or not.
+
+#include "corpus-mazes.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "mazegeometry.h"
+
+#include "gtest/gtest.h"
+
+// the fixed width arithmetic is available at compile time
+static_assert(FixedWidth<16>::numCells() == 256, "16x16 cell count");
+static_assert(FixedWidth<16>::neighbour(0x0F, NORTH) == 0x10, "north wraps into the next column");
+static_assert(FixedWidth<16>::neighbour(0x00, SOUTH) == 0xFF, "south wraps round the maze");
+static_assert(FixedWidth<32>::neighbour(0x3E0, EAST) == 0x000, "east wraps round the maze");
+static_assert(FixedWidth<32>::neighbour(0x005, WEST) == 0x3E5, "west wraps round the maze");
+
+class TEST_17_WidthPolicy : public ::testing::Test {
+ protected:
+  template <class geometry_t>
+  static void expectSameNeighbours(geometry_t geometry) {
+    Maze maze(geometry.width());
+    ASSERT_EQ(maze.numCells(), geometry.numCells());
+    for (uint16_t cell = 0; cell < geometry.numCells(); cell++) {
+      for (uint8_t direction = 0; direction < 4; direction++) {
+        ASSERT_EQ(maze.neighbour(cell, direction), geometry.neighbour(cell, direction))
+            << "cell " << cell << " direction " << int(direction);
+      }
+    }
+  }
+
+  /// flood with and without the fixed width copies and compare the results
+  static void expectSameFloods(Maze &maze, uint16_t target, const char *title) {
+    const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                          Maze::DIRECTION_FLOOD};
+    const Maze::QueueType queueTypes[] = {Maze::LINEAR_QUEUE, Maze::HEAP_QUEUE, Maze::BUCKET_QUEUE};
+    maze.setBitParallelFlood(false);
+    for (Maze::FloodType floodType : floodTypes) {
+      for (Maze::QueueType queueType : queueTypes) {
+        for (int mask : {OPEN_MASK, CLOSED_MASK}) {
+          maze.setFloodType(floodType);
+          maze.setQueueType(queueType);
+          maze.setFixedWidthFloods(false);
+          uint16_t runtimeCost = maze.flood(target, mask);
+          uint16_t costs[1024];
+          uint8_t directions[1024];
+          for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+            costs[cell] = maze.cost(cell);
+            directions[cell] = maze.direction(cell);
+          }
+          maze.setFixedWidthFloods(true);
+          ASSERT_EQ(runtimeCost, maze.flood(target, mask)) << title;
+          for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+            ASSERT_EQ(costs[cell], maze.cost(cell)) << title << " flood " << floodType << " cell " << cell;
+            ASSERT_EQ(directions[cell], maze.direction(cell)) << title << " flood " << floodType << " cell " << cell;
+          }
+        }
+      }
+    }
+    maze.setBitParallelFlood(true);
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Neighbours
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_17_WidthPolicy, 00_FixedWidth16MatchesMaze) {
+  expectSameNeighbours(FixedWidth<16>());
+}
+
+TEST_F(TEST_17_WidthPolicy, 01_FixedWidth32MatchesMaze) {
+  expectSameNeighbours(FixedWidth<32>());
+}
+
+TEST_F(TEST_17_WidthPolicy, 02_RuntimeWidthMatchesMaze) {
+  for (uint16_t width : {1, 5, 16, 21, 32}) {
+    expectSameNeighbours(RuntimeWidth(width));
+  }
+}
+
+TEST_F(TEST_17_WidthPolicy, 03_FixedWidthFloodsAreTheDefault) {
+  Maze maze(16);
+  EXPECT_TRUE(maze.getFixedWidthFloods());
+}
+
+// ---------------------------------------------------------------------------
+// Floods
+// ---------------------------------------------------------------------------
+
+TEST_F(TEST_17_WidthPolicy, 10_CorpusFloodsMatch) {
+  for (int i = 0; i < mazeCount; i += 4) {
+    uint16_t width = corpusWidth(i);
+    Maze maze(width);
+    loadCorpusMaze(maze, i);
+    expectSameFloods(maze, width == 16 ? 0x77 : 0x1EF, mazeList[i].title);
+  }
+}
+
+TEST_F(TEST_17_WidthPolicy, 11_ClearedMazeFloodsMatch) {
+  // no boundary walls, so every flood wraps round the edges
+  Maze maze(16);
+  maze.clearData();
+  expectSameFloods(maze, 0x00, "cleared");
+}
+
+TEST_F(TEST_17_WidthPolicy, 12_OtherWidthsUseRuntimeWidth) {
+  Maze maze(9);
+  maze.resetToEmptyMaze();
+  maze.setWall(0x20, NORTH);
+  maze.setWall(0x31, EAST);
+  expectSameFloods(maze, 0x28, "9x9");
+}
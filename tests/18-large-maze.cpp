@@ -0,0 +1,215 @@
+// Tests for LargeMaze (largemaze.h).
+//
+// For any maze that Maze can hold, LargeMaze must give the same costs and
+// directions as Maze with HEAP_QUEUE. Beyond that it must cope with mazes
+// much wider than 32 cells and with costs that do not fit in 16 bits.
+// The runTo() step limit is tested here too since it only shows up on
+// routes longer than 256 cells.
+
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "largemaze.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+class TEST_18_LargeMaze : public ::testing::Test {
+ protected:
+  /// wall bytes for a maze with one corridor that snakes up and down every
+  /// column from cell zero. It ends at the bottom of the last column.
+  static std::vector<uint8_t> serpentine(uint32_t width) {
+    std::vector<uint8_t> walls((size_t)width * width, 0);
+    for (uint32_t c = 0; c < width; c++) {
+      for (uint32_t r = 0; r < width; r++) {
+        uint8_t cellWalls = 0;
+        if (r == width - 1) {
+          cellWalls |= WALL_NORTH;
+        }
+        if (r == 0) {
+          cellWalls |= WALL_SOUTH;
+        }
+        if (c == width - 1 || r != gapRow(width, c)) {
+          cellWalls |= WALL_EAST;
+        }
+        if (c == 0 || r != gapRow(width, c - 1)) {
+          cellWalls |= WALL_WEST;
+        }
+        walls[(size_t)c * width + r] = cellWalls;
+      }
+    }
+    return walls;
+  }
+
+  /// the row where column c opens into column c + 1
+  static uint32_t gapRow(uint32_t width, uint32_t c) { return (c % 2 == 0) ? width - 1 : 0; }
+
+  /// flood both mazes and compare every cost and direction
+  template <class large_t>
+  static void expectSameFlood(Maze &maze, large_t &large, Maze::FloodType floodType, uint8_t mask, uint16_t target,
+                              const char *title) {
+    maze.setFloodType(floodType);
+    large.setFloodType(floodType);
+    uint16_t mazeCost = maze.flood(target, mask);
+    auto largeCost = large.flood(target, mask);
+    if (mazeCost == MAX_COST) {
+      ASSERT_EQ(large.maxCost(), largeCost) << title;
+    } else {
+      ASSERT_EQ(mazeCost, largeCost) << title;
+    }
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      if (maze.cost(cell) == MAX_COST) {
+        ASSERT_EQ(large.maxCost(), large.cost(cell)) << title << " flood " << floodType << " cell " << cell;
+      } else {
+        ASSERT_EQ(maze.cost(cell), large.cost(cell)) << title << " flood " << floodType << " cell " << cell;
+      }
+      ASSERT_EQ(maze.direction(cell), large.direction(cell)) << title << " flood " << floodType << " cell " << cell;
+    }
+  }
+};
+
+TEST_F(TEST_18_LargeMaze, 00_StorageScalesWithWidth) {
+  LargeMaze<> maze(64);
+  EXPECT_EQ(64u, maze.width());
+  EXPECT_EQ(4096u, maze.numCells());
+  size_t small = maze.memoryUsed();
+  maze.setWidth(128);
+  EXPECT_EQ(16384u, maze.numCells());
+  EXPECT_GT(maze.memoryUsed(), 3 * small);
+  EXPECT_LT(maze.memoryUsed(), 5 * small);
+}
+
+TEST_F(TEST_18_LargeMaze, 01_NeighboursMatchMaze) {
+  for (uint16_t width : {16, 32}) {
+    Maze maze(width);
+    LargeMaze<> large(width);
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        ASSERT_EQ(maze.neighbour(cell, direction), large.neighbour(cell, direction));
+      }
+    }
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 02_WallsMatchMaze) {
+  Maze maze(16);
+  LargeMaze<uint16_t, uint16_t> large(16);
+  maze.resetToEmptyMaze();
+  large.resetToEmptyMaze();
+  maze.updateMap(0x12, WALL_NORTH | WALL_WEST);
+  large.updateMap(0x12, WALL_NORTH | WALL_WEST);
+  maze.setWall(0x45, EAST);
+  large.setWall(0x45, EAST);
+  maze.clearWall(0x45, EAST);
+  large.clearWall(0x45, EAST);
+  maze.setWall(0xFF, NORTH);
+  large.setWall(0xFF, NORTH);
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    ASSERT_EQ(maze.getXWalls(cell), large.getXWalls(cell)) << "cell " << cell;
+    ASSERT_EQ(maze.isVisited(cell), large.isVisited(cell)) << "cell " << cell;
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 10_CorpusFloodsMatchMazeHeapFloods) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  Maze maze(16);
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  std::vector<uint8_t> data(1024);
+  for (int i = 0; i < mazeCount; i++) {
+    uint16_t width = corpusWidth(i);
+    maze.setWidth(width);
+    loadCorpusMaze(maze, i);
+    uint16_t goal = maze.goalAreaSize() > 0 ? maze.goal() : (uint16_t)((width / 2 - 1) * (width + 1));
+    LargeMaze<> large(width);
+    maze.save(data.data());
+    large.load(data.data());
+    for (Maze::FloodType floodType : floodTypes) {
+      expectSameFlood(maze, large, floodType, OPEN_MASK, goal, mazeList[i].title);
+    }
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 11_PartlySeenFloodsMatchMaze) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  Maze maze(32);
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  LargeMaze<uint16_t, uint32_t> large(32);
+  maze.resetToEmptyMaze();
+  large.resetToEmptyMaze();
+  std::vector<uint8_t> walls = serpentine(32);
+  for (uint16_t cell = 0; cell < 1024; cell += 3) {
+    maze.updateMap(cell, walls[cell]);
+    large.updateMap(cell, walls[cell]);
+  }
+  for (Maze::FloodType floodType : floodTypes) {
+    expectSameFlood(maze, large, floodType, OPEN_MASK, 0x1EF, "open");
+    expectSameFlood(maze, large, floodType, CLOSED_MASK, 0x1EF, "closed");
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 12_TimeFloodLeavesEveryCellUnreached) {
+  LargeMaze<> large(16);
+  large.setFloodType(Maze::MANHATTAN_FLOOD);
+  ASSERT_NE(large.maxCost(), large.flood(0x77, OPEN_MASK));
+  large.setFloodType(Maze::TIME_FLOOD);
+  EXPECT_EQ(large.maxCost(), large.flood(0x77, OPEN_MASK));
+  for (uint32_t cell = 0; cell < large.numCells(); cell++) {
+    ASSERT_EQ(large.maxCost(), large.cost(cell)) << "cell " << cell;
+    ASSERT_EQ(INVALID_DIRECTION, large.direction(cell)) << "cell " << cell;
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 13_DiagonalFloodLeavesEveryCellUnreached) {
+  LargeMaze<> large(16);
+  large.setFloodType(Maze::RUNLENGTH_FLOOD);
+  ASSERT_NE(large.maxCost(), large.flood(0x77, OPEN_MASK));
+  large.setFloodType(Maze::DIAGONAL_FLOOD);
+  EXPECT_EQ(large.maxCost(), large.flood(0x77, OPEN_MASK));
+  for (uint32_t cell = 0; cell < large.numCells(); cell++) {
+    ASSERT_EQ(large.maxCost(), large.cost(cell)) << "cell " << cell;
+    ASSERT_EQ(INVALID_DIRECTION, large.direction(cell)) << "cell " << cell;
+  }
+}
+
+TEST_F(TEST_18_LargeMaze, 20_WideMazeCostsNeedMoreThanSixteenBits) {
+  const uint32_t width = 256;
+  LargeMaze<> maze(width);
+  std::vector<uint8_t> walls = serpentine(width);
+  maze.load(walls.data());
+  const uint32_t target = maze.cellAt(width - 1, 0);
+
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  EXPECT_EQ(width * width - 1, maze.flood(target, CLOSED_MASK));
+
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  uint32_t cost = maze.flood(target, CLOSED_MASK);
+  EXPECT_GT(cost, (uint32_t)MAX_COST);
+  EXPECT_LT(cost, maze.maxCost());
+
+  // follow the directions from the start to the target
+  uint32_t cell = 0;
+  uint32_t steps = 0;
+  while (cell != target && steps <= maze.numCells()) {
+    ASSERT_NE(INVALID_DIRECTION, maze.direction(cell));
+    cell = maze.neighbour(cell, maze.direction(cell));
+    steps++;
+  }
+  EXPECT_EQ(width * width - 1, steps);
+}
+
+TEST_F(TEST_18_LargeMaze, 30_RunToFollowsRoutesLongerThan256Steps) {
+  MazeSearcher searcher;
+  std::vector<uint8_t> walls = serpentine(32);
+  searcher.map()->setWidth(32);
+  searcher.setMapFromFileData(walls.data(), 1024);
+  searcher.map()->setFloodType(Maze::MANHATTAN_FLOOD);
+  searcher.setLocation(0);
+  const uint16_t target = 31 * 32;
+  EXPECT_EQ(1023, searcher.runTo(target));
+  EXPECT_EQ(target, searcher.location());
+}
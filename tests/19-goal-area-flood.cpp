@@ -0,0 +1,184 @@
+// Tests for Maze::floodGoalArea() and Maze::goalCellFor().
+//
+// A flood from the whole goal area must give the same manhattan costs as
+// the best of separate floods from each goal cell. For every flood type the
+// directions from any cell must lead to the goal cell that goalCellFor()
+// reports, and goalCells() must agree with it for every cell.
+
+#include <algorithm>
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+
+#include "gtest/gtest.h"
+
+class TEST_19_GoalAreaFlood : public ::testing::Test {
+ protected:
+  /// load a corpus maze and make the four centre cells the goal area
+  static void loadWithCentreGoal(Maze &maze, int index) {
+    uint16_t width = corpusWidth(index);
+    maze.setWidth(width);
+    loadCorpusMaze(maze, index);
+    uint16_t half = width / 2;
+    maze.clearGoalArea();
+    maze.addToGoalArea((half - 1) * width + half - 1);
+    maze.addToGoalArea((half - 1) * width + half);
+    maze.addToGoalArea(half * width + half - 1);
+    maze.addToGoalArea(half * width + half);
+  }
+
+  /// follow the directions from every cell and check where they end
+  static void expectRoutesEndAtGoalCell(Maze &maze, const char *title) {
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      uint16_t goalCell = maze.goalCellFor(cell);
+      if (maze.cost(cell) == MAX_COST) {
+        ASSERT_EQ(MAX_COST, goalCell) << title << " cell " << cell;
+        continue;
+      }
+      ASSERT_TRUE(maze.goalContains(goalCell)) << title << " cell " << cell;
+      uint16_t here = cell;
+      int steps = 0;
+      while (maze.cost(here) != 0 && steps <= maze.numCells()) {
+        here = maze.neighbour(here, maze.direction(here));
+        steps++;
+      }
+      ASSERT_EQ(goalCell, here) << title << " cell " << cell;
+    }
+  }
+};
+
+TEST_F(TEST_19_GoalAreaFlood, 00_SingleCellGoalIsTheSameAsFlood) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  Maze maze(16);
+  Maze single(16);
+  for (Maze::FloodType floodType : floodTypes) {
+    maze.copyMazeFromFileData(japan2007ef, 256);
+    single.copyMazeFromFileData(japan2007ef, 256);
+    maze.setGoal(0x77);
+    maze.setFloodType(floodType);
+    single.setFloodType(floodType);
+    EXPECT_EQ(single.flood(0x77, OPEN_MASK), maze.floodGoalArea(OPEN_MASK));
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(single.cost(cell), maze.cost(cell)) << "flood " << floodType << " cell " << cell;
+      ASSERT_EQ(single.direction(cell), maze.direction(cell)) << "flood " << floodType << " cell " << cell;
+      ASSERT_EQ(maze.cost(cell) == MAX_COST ? MAX_COST : 0x77, maze.goalCellFor(cell));
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 01_EveryGoalCellCostsNothing) {
+  Maze maze(16);
+  loadWithCentreGoal(maze, 0);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  maze.floodGoalArea(OPEN_MASK);
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    if (maze.goalContains(cell)) {
+      EXPECT_EQ(0, maze.cost(cell));
+      EXPECT_EQ(cell, maze.goalCellFor(cell));
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 10_ManhattanCostIsTheBestOfTheGoalCells) {
+  Maze maze(16);
+  Maze single(16);
+  for (int i = 0; i < mazeCount; i++) {
+    loadWithCentreGoal(maze, i);
+    loadWithCentreGoal(single, i);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    single.setFloodType(Maze::MANHATTAN_FLOOD);
+    maze.floodGoalArea(CLOSED_MASK);
+    std::vector<uint16_t> best(maze.numCells(), MAX_COST);
+    for (int goalCell = 0; goalCell < maze.numCells(); goalCell++) {
+      if (!maze.goalContains(goalCell)) {
+        continue;
+      }
+      single.flood(goalCell, CLOSED_MASK);
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        best[cell] = std::min(best[cell], single.cost(cell));
+      }
+    }
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(best[cell], maze.cost(cell)) << mazeList[i].title << " cell " << cell;
+      if (best[cell] != MAX_COST) {
+        // the reported goal cell really is one of the nearest
+        single.flood(maze.goalCellFor(cell), CLOSED_MASK);
+        ASSERT_EQ(best[cell], single.cost(cell)) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 11_RoutesEndAtTheReportedGoalCell) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  const Maze::QueueType queueTypes[] = {Maze::LINEAR_QUEUE, Maze::HEAP_QUEUE, Maze::BUCKET_QUEUE};
+  Maze maze(16);
+  for (int i = 0; i < mazeCount; i++) {
+    loadWithCentreGoal(maze, i);
+    for (Maze::FloodType floodType : floodTypes) {
+      for (Maze::QueueType queueType : queueTypes) {
+        maze.setFloodType(floodType);
+        maze.setQueueType(queueType);
+        maze.floodGoalArea(OPEN_MASK);
+        expectRoutesEndAtGoalCell(maze, mazeList[i].title);
+      }
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 12_BitParallelSettingMakesNoDifference) {
+  Maze maze(16);
+  Maze queueMaze(16);
+  queueMaze.setBitParallelFlood(false);
+  for (int i = 0; i < mazeCount; i++) {
+    loadWithCentreGoal(maze, i);
+    loadWithCentreGoal(queueMaze, i);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    queueMaze.setFloodType(Maze::MANHATTAN_FLOOD);
+    maze.floodGoalArea(OPEN_MASK);
+    queueMaze.floodGoalArea(OPEN_MASK);
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(queueMaze.cost(cell), maze.cost(cell)) << mazeList[i].title << " cell " << cell;
+      ASSERT_EQ(queueMaze.direction(cell), maze.direction(cell)) << mazeList[i].title << " cell " << cell;
+      ASSERT_EQ(queueMaze.goalCellFor(cell), maze.goalCellFor(cell)) << mazeList[i].title << " cell " << cell;
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 13_GoalCellsMatchesGoalCellFor) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  Maze maze(16);
+  std::vector<uint16_t> goalCells;
+  for (int i = 0; i < mazeCount; i++) {
+    loadWithCentreGoal(maze, i);
+    goalCells.assign(maze.numCells(), 0);
+    for (Maze::FloodType floodType : floodTypes) {
+      maze.setFloodType(floodType);
+      maze.floodGoalArea(OPEN_MASK);
+      maze.goalCells(goalCells.data());
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(maze.goalCellFor(cell), goalCells[cell]) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+}
+
+TEST_F(TEST_19_GoalAreaFlood, 20_LaterFloodsStartFromTheTargetOnly) {
+  Maze maze(16);
+  Maze single(16);
+  loadWithCentreGoal(maze, 0);
+  loadWithCentreGoal(single, 0);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  single.setFloodType(Maze::RUNLENGTH_FLOOD);
+  maze.floodGoalArea(OPEN_MASK);
+  uint16_t first = maze.goal();
+  uint16_t last = (maze.width() / 2) * (maze.width() + 1);
+  EXPECT_EQ(single.flood(last, OPEN_MASK), maze.flood(last, OPEN_MASK));
+  EXPECT_NE(0, maze.cost(first));
+}
@@ -0,0 +1,141 @@
+// Tests for the paired closed and open flood used by testForSolution().
+//
+// BitFlood::floodPair() must give exactly the costs of two separate floods
+// with every kernel, and testForSolution() must leave the same costs,
+// directions and path costs whether or not it floods both masks together.
+// The closed maze results are kept in a FloodResult supplied by the caller,
+// or the closed costs in the attached workspace.
+
+#include "bitflood.h"
+#include "corpus-mazes.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+
+#include "gtest/gtest.h"
+
+class TEST_20_PairedFlood : public ::testing::Test {
+ protected:
+  static const BitFlood::Kernel kernels[3];
+
+  static void expectSamePair(const Maze &maze, uint16_t target, const char *title) {
+    uint16_t closed[1024];
+    uint16_t open[1024];
+    BitFlood::flood(maze.wallPlanes(), target, CLOSED_MASK, closed, BitFlood::PORTABLE_KERNEL);
+    BitFlood::flood(maze.wallPlanes(), target, OPEN_MASK, open, BitFlood::PORTABLE_KERNEL);
+    const uint16_t cellCount = maze.width() * maze.width();
+    for (BitFlood::Kernel kernel : kernels) {
+      uint16_t pairClosed[1024];
+      uint16_t pairOpen[1024];
+      BitFlood::floodPair(maze.wallPlanes(), target, pairClosed, pairOpen, kernel);
+      for (uint16_t cell = 0; cell < cellCount; cell++) {
+        ASSERT_EQ(closed[cell], pairClosed[cell]) << title << " " << BitFlood::kernelName(kernel) << " cell " << cell;
+        ASSERT_EQ(open[cell], pairOpen[cell]) << title << " " << BitFlood::kernelName(kernel) << " cell " << cell;
+      }
+    }
+  }
+
+  /// run testForSolution() with and without the paired flood and compare everything it leaves behind
+  static void expectSameSolutionTest(Maze &maze, Maze::FloodType floodType, const char *title) {
+    Maze separate(maze.width());
+    uint8_t data[1024];
+    maze.save(data);
+    separate.load(data);
+    separate.setGoal(maze.goal());
+    maze.setFloodType(floodType);
+    separate.setFloodType(floodType);
+    separate.setBitParallelFlood(false);
+    FloodResult separateClosed;
+    FloodResult closed;
+    ASSERT_EQ(separate.testForSolution(separateClosed), maze.testForSolution(closed)) << title;
+    EXPECT_EQ(separate.openMazeCost(), maze.openMazeCost()) << title;
+    EXPECT_EQ(separate.closedMazeCost(), maze.closedMazeCost()) << title;
+    EXPECT_EQ(separateClosed.pathCost(), closed.pathCost()) << title;
+    EXPECT_EQ(CLOSED_MASK, closed.mask()) << title;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(separate.cost(cell), maze.cost(cell)) << title << " cell " << cell;
+      ASSERT_EQ(separate.direction(cell), maze.direction(cell)) << title << " cell " << cell;
+      ASSERT_EQ(separateClosed.cost(cell), closed.cost(cell)) << title << " cell " << cell;
+      ASSERT_EQ(separateClosed.direction(cell), closed.direction(cell)) << title << " cell " << cell;
+    }
+  }
+
+  /// testForSolution() without a result, with and without a workspace for the paired flood
+  static void expectSameWithWorkspace(Maze &maze, const char *title) {
+    FloodWorkspace workspace;
+    Maze separate(maze.width());
+    uint8_t data[1024];
+    maze.save(data);
+    separate.load(data);
+    separate.setGoal(maze.goal());
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    separate.setFloodType(Maze::MANHATTAN_FLOOD);
+    maze.setFloodWorkspace(&workspace);
+    ASSERT_EQ(separate.testForSolution(), maze.testForSolution()) << title;
+    EXPECT_EQ(separate.openMazeCost(), maze.openMazeCost()) << title;
+    EXPECT_EQ(separate.closedMazeCost(), maze.closedMazeCost()) << title;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(separate.cost(cell), maze.cost(cell)) << title << " cell " << cell;
+      ASSERT_EQ(separate.direction(cell), maze.direction(cell)) << title << " cell " << cell;
+    }
+    maze.setFloodWorkspace(nullptr);
+  }
+};
+
+const BitFlood::Kernel TEST_20_PairedFlood::kernels[3] = {BitFlood::PORTABLE_KERNEL, BitFlood::SSE2_KERNEL,
+                                                          BitFlood::AVX2_KERNEL};
+
+TEST_F(TEST_20_PairedFlood, 00_PairMatchesTwoFloodsOnTheCorpus) {
+  Maze maze(16);
+  for (int i = 0; i < mazeCount; i++) {
+    for (int every : {1, 2, 3, 7}) {
+      loadPartlySeenCorpusMaze(maze, i, every);
+      uint16_t half = maze.width() / 2 - 1;
+      expectSamePair(maze, half * maze.width() + half, mazeList[i].title);
+      expectSamePair(maze, 0, mazeList[i].title);
+    }
+  }
+}
+
+TEST_F(TEST_20_PairedFlood, 01_PairMatchesTwoFloodsWhenExitsWrap) {
+  Maze maze(16);
+  maze.clearData();
+  maze.updateMap(0x37, 0);
+  maze.setWall(0x40, WEST);
+  expectSamePair(maze, 0x77, "wrapping");
+}
+
+TEST_F(TEST_20_PairedFlood, 10_SolutionTestMatchesSeparateFloods) {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  Maze maze(16);
+  for (int i = 0; i < mazeCount; i++) {
+    for (int every : {1, 3}) {
+      for (Maze::FloodType floodType : floodTypes) {
+        loadPartlySeenCorpusMaze(maze, i, every);
+        maze.setGoal(maze.width() == 16 ? 0x77 : 0x1EF);
+        expectSameSolutionTest(maze, floodType, mazeList[i].title);
+      }
+    }
+  }
+}
+
+TEST_F(TEST_20_PairedFlood, 11_FullySeenMazeIsSolved) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setGoal(0x77);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  EXPECT_TRUE(maze.testForSolution());
+  EXPECT_EQ(maze.openMazeCost(), maze.closedMazeCost());
+}
+
+TEST_F(TEST_20_PairedFlood, 12_WorkspaceHoldsTheClosedCosts) {
+  Maze maze(16);
+  for (int i = 0; i < mazeCount; i++) {
+    loadPartlySeenCorpusMaze(maze, i, 3);
+    maze.setGoal(maze.width() == 16 ? 0x77 : 0x1EF);
+    expectSameWithWorkspace(maze, mazeList[i].title);
+  }
+}
@@ -0,0 +1,231 @@
+// Tests for AStar, the point to point route query.
+//
+// With unit costs the route must be as short as the manhattan flood says.
+// With runlength costs the reported cost must be the cost of the route as
+// the runlength flood would cost it, and the cheapest there is: the same as
+// a diagonal flood from the start and sometimes less than a runlength flood
+// from the start, which keeps only one run for each cell. Every route must
+// follow open exits.
+
+#include <thread>
+#include <vector>
+
+#include "astar.h"
+#include "corpus-mazes.h"
+#include "diagonalflood.h"
+#include "maze.h"
+#include "mazedata.h"
+#include "mazeconstants.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+class TEST_21_AStar : public ::testing::Test {
+ protected:
+  /// check that the route runs from start to target through open exits
+  static void expectValidRoute(const Maze &maze, const AStar &astar, uint16_t start, uint16_t target, uint8_t mask) {
+    ASSERT_GT(astar.routeLength(), 0);
+    ASSERT_EQ(start, astar.route()[0]);
+    ASSERT_EQ(target, astar.route()[astar.routeLength() - 1]);
+    for (int i = 0; i + 1 < astar.routeLength(); i++) {
+      uint8_t direction = astar.routeDirection(i);
+      ASSERT_NE(INVALID_DIRECTION, direction);
+      ASSERT_EQ(0, maze.getXWalls(astar.route()[i]) & (mask << direction)) << "step " << i;
+      ASSERT_EQ(maze.neighbour(astar.route()[i], direction), astar.route()[i + 1]) << "step " << i;
+    }
+    EXPECT_EQ(INVALID_DIRECTION, astar.routeDirection(astar.routeLength() - 1));
+  }
+
+  /// the runlength cost of a route, step by step as the runlength flood costs it
+  static uint32_t runLengthCost(const Maze &maze, const AStar &astar) {
+    if (astar.routeLength() < 2) {
+      return 0;
+    }
+    uint8_t firstWall = astar.routeDirection(0);
+    uint32_t cost = maze.runLengthStartCost();
+    FloodInfo info(0, 0, 1, firstWall * 2, Maze::opposite(firstWall));
+    for (int i = 1; i + 1 < astar.routeLength(); i++) {
+      uint8_t exitWall = astar.routeDirection(i);
+      uint8_t runLength;
+      uint8_t exitDir;
+      cost += maze.runLengthStepCost(info, exitWall, runLength, exitDir);
+      info = FloodInfo(0, 0, runLength, exitDir, Maze::opposite(exitWall));
+    }
+    return cost;
+  }
+};
+
+TEST_F(TEST_21_AStar, 00_Defaults) {
+  AStar astar;
+  EXPECT_EQ(AStar::UNIT_COST, astar.costModel());
+  EXPECT_EQ(AStar::MANHATTAN_HEURISTIC, astar.heuristic());
+  EXPECT_EQ(0, astar.routeLength());
+}
+
+TEST_F(TEST_21_AStar, 01_RouteToSelfIsOneCell) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  AStar astar;
+  EXPECT_EQ(0, astar.findRoute(maze, 0x34, 0x34, OPEN_MASK));
+  EXPECT_EQ(1, astar.routeLength());
+  EXPECT_EQ(0x34, astar.route()[0]);
+}
+
+TEST_F(TEST_21_AStar, 02_NoRoute) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+    maze.setWall(0x55, direction);
+  }
+  AStar astar;
+  EXPECT_EQ(MAX_COST, astar.findRoute(maze, 0, 0x55, OPEN_MASK));
+  EXPECT_EQ(0, astar.routeLength());
+}
+
+TEST_F(TEST_21_AStar, 10_UnitCostMatchesManhattanFlood) {
+  const AStar::Heuristic heuristics[] = {AStar::MANHATTAN_HEURISTIC, AStar::CHEBYSHEV_HEURISTIC};
+  Maze maze(16);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  AStar astar;
+  for (int i = 0; i < mazeCount; i++) {
+    for (int every : {1, 3}) {
+      loadPartlySeenCorpusMaze(maze, i, every);
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        const uint16_t targets[] = {0, (uint16_t)(maze.numCells() / 2 + maze.width() / 2), 37};
+        for (uint16_t target : targets) {
+          maze.flood(target, mask);
+          for (uint16_t start = 0; start < maze.numCells(); start += 29) {
+            for (AStar::Heuristic heuristic : heuristics) {
+              astar.setHeuristic(heuristic);
+              ASSERT_EQ(maze.cost(start), astar.findRoute(maze, start, target, mask))
+                  << mazeList[i].title << " from " << start << " to " << target;
+              if (maze.cost(start) != MAX_COST) {
+                expectValidRoute(maze, astar, start, target, mask);
+                ASSERT_EQ(maze.cost(start) + 1, astar.routeLength());
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_21_AStar, 11_ShortRoutesExpandFewCells) {
+  Maze maze(32);
+  maze.resetToEmptyMaze();
+  AStar astar;
+  EXPECT_EQ(3, astar.findRoute(maze, 0x210, 0x213, OPEN_MASK));
+  EXPECT_LE(astar.expandedCount(), 3);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  EXPECT_EQ(4, astar.findRoute(maze, 0x210, 0x252, OPEN_MASK));
+  EXPECT_LT(astar.expandedCount(), 20);
+}
+
+TEST_F(TEST_21_AStar, 20_RunLengthCostIsTheCostOfTheRoute) {
+  Maze maze(16);
+  AStar astar(AStar::RUNLENGTH_COST);
+  for (int i = 0; i < mazeCount; i++) {
+    loadPartlySeenCorpusMaze(maze, i, 1);
+    uint16_t target = (maze.width() / 2 - 1) * (maze.width() + 1);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    bool reachable = maze.flood(target, CLOSED_MASK) != MAX_COST;
+    uint16_t cost = astar.findRoute(maze, 0, target, CLOSED_MASK);
+    ASSERT_EQ(reachable, cost != MAX_COST) << mazeList[i].title;
+    if (!reachable) {
+      continue;
+    }
+    expectValidRoute(maze, astar, 0, target, CLOSED_MASK);
+    ASSERT_EQ(runLengthCost(maze, astar), cost) << mazeList[i].title;
+  }
+}
+
+TEST_F(TEST_21_AStar, 21_RunLengthPrefersTheDiagonal) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  AStar astar(AStar::RUNLENGTH_COST);
+  // across an empty maze the cheapest route is one long diagonal, a zigzag of single cell steps
+  uint16_t cost = astar.findRoute(maze, 0x00, 0xFF, OPEN_MASK);
+  EXPECT_EQ(31, astar.routeLength());
+  EXPECT_EQ(runLengthCost(maze, astar), cost);
+  int turns = 0;
+  for (int i = 1; i + 1 < astar.routeLength(); i++) {
+    turns += astar.routeDirection(i) != astar.routeDirection(i - 1);
+  }
+  EXPECT_EQ(29, turns);
+}
+
+TEST_F(TEST_21_AStar, 22_RunLengthCostIsExact) {
+  Maze maze(16);
+  AStar astar(AStar::RUNLENGTH_COST);
+  DiagonalFlood diagonal;
+  int cheaper = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    for (int every : {1, 3}) {
+      loadPartlySeenCorpusMaze(maze, i, every);
+      const uint16_t start = 0;
+      maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+      maze.flood(start, CLOSED_MASK);
+      uint16_t cost[1024];
+      uint8_t direction[1024];
+      diagonal.flood(maze, &start, 1, CLOSED_MASK, cost, direction);
+      for (uint16_t target = 1; target < maze.numCells(); target += 7) {
+        uint16_t found = astar.findRoute(maze, start, target, CLOSED_MASK);
+        ASSERT_EQ(diagonal.routeCost(target), found) << mazeList[i].title << " target " << target;
+        if (found == MAX_COST) {
+          continue;
+        }
+        expectValidRoute(maze, astar, start, target, CLOSED_MASK);
+        ASSERT_EQ(runLengthCost(maze, astar), found) << mazeList[i].title << " target " << target;
+        ASSERT_LE(found, maze.cost(target)) << mazeList[i].title << " target " << target;
+        cheaper += found < maze.cost(target);
+      }
+    }
+  }
+  EXPECT_GT(cheaper, 0);
+}
+
+TEST_F(TEST_21_AStar, 23_SearchersShareOneConstMaze) {
+  const int threadCount = 4;
+  Maze maze(16);
+  loadPartlySeenCorpusMaze(maze, 2, 1);
+  const Maze &reader = maze;
+  std::vector<uint16_t> expected(threadCount);
+  for (int t = 0; t < threadCount; t++) {
+    AStar astar;
+    astar.setCostModel(t % 2 ? AStar::RUNLENGTH_COST : AStar::UNIT_COST);
+    expected[t] = astar.findRoute(reader, (uint16_t)(t * 37), reader.goal(), OPEN_MASK);
+  }
+  std::vector<uint16_t> found(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t]() {
+      AStar astar;
+      astar.setCostModel(t % 2 ? AStar::RUNLENGTH_COST : AStar::UNIT_COST);
+      for (int repeat = 0; repeat < 20; repeat++) {
+        found[t] = astar.findRoute(reader, (uint16_t)(t * 37), reader.goal(), OPEN_MASK);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(expected, found);
+}
+
+TEST_F(TEST_21_AStar, 30_RunToWithRouteQueries) {
+  MazeSearcher flooding;
+  MazeSearcher querying;
+  querying.setRouteQueries(true);
+  ASSERT_NE(nullptr, querying.routeFinder());
+  for (MazeSearcher *searcher : {&flooding, &querying}) {
+    searcher->map()->copyMazeFromFileData(japan2007ef, 256);
+    searcher->setLocation(0);
+  }
+  int steps = flooding.runTo(0x77);
+  EXPECT_GT(steps, 0);
+  EXPECT_EQ(steps, querying.runTo(0x77));
+  EXPECT_EQ(0x77, querying.location());
+  querying.setRouteQueries(false);
+  EXPECT_EQ(nullptr, querying.routeFinder());
+}
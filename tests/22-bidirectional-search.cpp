@@ -0,0 +1,269 @@
+// Tests for BidirectionalSearch, the point to point route query that searches
+// from both ends.
+//
+// With unit and weighted costs the search from both ends must find routes as
+// cheap as the search from the start alone. Every route must follow open
+// exits and the routes back to the start of a 32x32 maze should need far
+// fewer expansions.
+
+#include <thread>
+#include <vector>
+
+#include "bidirectionalsearch.h"
+#include "corpus-mazes.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "mazepathfinder.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+class TEST_22_BidirectionalSearch : public ::testing::Test {
+ protected:
+  /// check that the route runs from start to target through open exits
+  static void expectValidRoute(const Maze &maze, const BidirectionalSearch &search, uint16_t start, uint16_t target,
+                               uint8_t mask) {
+    ASSERT_GT(search.routeLength(), 0);
+    ASSERT_EQ(start, search.route()[0]);
+    ASSERT_EQ(target, search.route()[search.routeLength() - 1]);
+    for (int i = 0; i + 1 < search.routeLength(); i++) {
+      uint8_t direction = search.routeDirection(i);
+      ASSERT_NE(INVALID_DIRECTION, direction);
+      ASSERT_EQ(0, maze.getXWalls(search.route()[i]) & (mask << direction)) << "step " << i;
+      ASSERT_EQ(maze.neighbour(search.route()[i], direction), search.route()[i + 1]) << "step " << i;
+    }
+    EXPECT_EQ(INVALID_DIRECTION, search.routeDirection(search.routeLength() - 1));
+  }
+
+  /// the weighted cost of the route, with the first move costed from the start heading
+  static uint32_t weightedCost(const BidirectionalSearch &search, uint8_t heading) {
+    uint32_t cost = 0;
+    for (int i = 0; i + 1 < search.routeLength(); i++) {
+      uint8_t direction = search.routeDirection(i);
+      cost += (heading == INVALID_DIRECTION || heading == direction) ? BidirectionalSearch::AHEAD_COST
+                                                                     : search.cornerWeight();
+      heading = direction;
+    }
+    return cost;
+  }
+};
+
+TEST_F(TEST_22_BidirectionalSearch, 00_Defaults) {
+  BidirectionalSearch search;
+  EXPECT_EQ(BidirectionalSearch::UNIT_COST, search.costModel());
+  EXPECT_EQ(3, search.cornerWeight());
+  EXPECT_TRUE(search.isBidirectional());
+  EXPECT_EQ(0, search.routeLength());
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 01_RouteToSelfIsOneCell) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  BidirectionalSearch search(BidirectionalSearch::WEIGHTED_COST);
+  EXPECT_EQ(0, search.findRoute(maze, 0x34, NORTH, 0x34, OPEN_MASK));
+  EXPECT_EQ(1, search.routeLength());
+  EXPECT_EQ(0x34, search.route()[0]);
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 02_NoRoute) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+    maze.setWall(0x55, direction);
+  }
+  BidirectionalSearch search;
+  for (bool bidirectional : {true, false}) {
+    search.setBidirectional(bidirectional);
+    EXPECT_EQ(MAX_COST, search.findRoute(maze, 0, NORTH, 0x55, OPEN_MASK));
+    EXPECT_EQ(0, search.routeLength());
+    EXPECT_EQ(MAX_COST, search.findRoute(maze, 0x55, NORTH, 0, OPEN_MASK));
+  }
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 03_StartHeadingCostsTheFirstTurn) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  BidirectionalSearch search(BidirectionalSearch::WEIGHTED_COST);
+  EXPECT_EQ(3 * BidirectionalSearch::AHEAD_COST, search.findRoute(maze, 0x00, NORTH, 0x03, OPEN_MASK));
+  EXPECT_EQ(3 * BidirectionalSearch::AHEAD_COST, search.findRoute(maze, 0x00, INVALID_DIRECTION, 0x03, OPEN_MASK));
+  EXPECT_EQ(2 * BidirectionalSearch::AHEAD_COST + 3, search.findRoute(maze, 0x00, EAST, 0x03, OPEN_MASK));
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 10_UnitCostMatchesManhattanFlood) {
+  Maze maze(16);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  BidirectionalSearch search;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      const uint16_t targets[] = {0, (uint16_t)(maze.numCells() / 2 + maze.width() / 2), 37};
+      for (uint16_t target : targets) {
+        maze.flood(target, mask);
+        for (uint16_t start = 0; start < maze.numCells(); start += 29) {
+          ASSERT_EQ(maze.cost(start), search.findRoute(maze, start, NORTH, target, mask))
+              << mazeList[i].title << " from " << start << " to " << target;
+          if (maze.cost(start) != MAX_COST) {
+            expectValidRoute(maze, search, start, target, mask);
+            ASSERT_EQ(maze.cost(start) + 1, search.routeLength());
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 11_WeightedCostMatchesOneSidedSearch) {
+  Maze maze(16);
+  BidirectionalSearch both(BidirectionalSearch::WEIGHTED_COST);
+  BidirectionalSearch one(BidirectionalSearch::WEIGHTED_COST);
+  one.setBidirectional(false);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    const uint16_t target = (uint16_t)(maze.numCells() / 2 + maze.width() / 2);
+    for (uint16_t start = 0; start < maze.numCells(); start += 37) {
+      for (uint8_t heading : {(uint8_t)NORTH, (uint8_t)EAST, (uint8_t)SOUTH, (uint8_t)INVALID_DIRECTION}) {
+        uint16_t cost = both.findRoute(maze, start, heading, target, OPEN_MASK);
+        ASSERT_EQ(one.findRoute(maze, start, heading, target, OPEN_MASK), cost)
+            << mazeList[i].title << " from " << start << " heading " << (int)heading;
+        if (cost != MAX_COST) {
+          expectValidRoute(maze, both, start, target, OPEN_MASK);
+          ASSERT_EQ(weightedCost(both, heading), cost);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 12_RunLengthRoutesAreCloseToTheBest) {
+  Maze maze(16);
+  BidirectionalSearch both(BidirectionalSearch::RUNLENGTH_COST);
+  BidirectionalSearch one(BidirectionalSearch::RUNLENGTH_COST);
+  one.setBidirectional(false);
+  uint32_t bothTotal = 0;
+  uint32_t oneTotal = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    const uint16_t target = (uint16_t)(maze.numCells() / 2 + maze.width() / 2);
+    for (uint16_t start = 0; start < maze.numCells(); start += 53) {
+      uint16_t cost = both.findRoute(maze, start, NORTH, target, OPEN_MASK);
+      uint16_t oneCost = one.findRoute(maze, start, NORTH, target, OPEN_MASK);
+      ASSERT_EQ(oneCost == MAX_COST, cost == MAX_COST);
+      if (cost != MAX_COST) {
+        expectValidRoute(maze, both, start, target, OPEN_MASK);
+        bothTotal += cost;
+        oneTotal += oneCost;
+      }
+    }
+  }
+  EXPECT_LE(bothTotal, oneTotal + oneTotal / 20);
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 20_ReturnToStartExpandsFewerStates) {
+  const BidirectionalSearch::CostModel models[] = {BidirectionalSearch::UNIT_COST, BidirectionalSearch::WEIGHTED_COST,
+                                                   BidirectionalSearch::RUNLENGTH_COST};
+  Maze maze(32);
+  for (BidirectionalSearch::CostModel model : models) {
+    BidirectionalSearch both(model);
+    BidirectionalSearch one(model);
+    one.setBidirectional(false);
+    long bothExpanded = 0;
+    long oneExpanded = 0;
+    for (int i = 0; i < mazeCount; i++) {
+      if (corpusWidth(i) != 32) {
+        continue;
+      }
+      loadCorpusMaze(maze, i);
+      const uint16_t goal = (uint16_t)(maze.numCells() / 2 + maze.width() / 2);
+      if (both.findRoute(maze, goal, SOUTH, 0, CLOSED_MASK) == MAX_COST) {
+        continue;
+      }
+      bothExpanded += both.expandedCount();
+      one.findRoute(maze, goal, SOUTH, 0, CLOSED_MASK);
+      oneExpanded += one.expandedCount();
+    }
+    ASSERT_GT(oneExpanded, 0);
+    // unit costs have one state per cell and gain a little less than the heading-aware models
+    const long percent = model == BidirectionalSearch::UNIT_COST ? 75 : 60;
+    EXPECT_LE(bothExpanded * 100, oneExpanded * percent) << "cost model " << model;
+  }
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 21_SearchesShareOneConstMaze) {
+  const int threadCount = 3;
+  const BidirectionalSearch::CostModel models[] = {BidirectionalSearch::UNIT_COST,
+                                                   BidirectionalSearch::WEIGHTED_COST,
+                                                   BidirectionalSearch::RUNLENGTH_COST};
+  Maze maze(16);
+  loadCorpusMaze(maze, 2);
+  const Maze &reader = maze;
+  std::vector<uint16_t> expected(threadCount);
+  for (int t = 0; t < threadCount; t++) {
+    BidirectionalSearch search(models[t]);
+    expected[t] = search.findRoute(reader, 0, NORTH, reader.goal(), OPEN_MASK);
+  }
+  std::vector<uint16_t> found(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t]() {
+      BidirectionalSearch search(models[t]);
+      for (int repeat = 0; repeat < 20; repeat++) {
+        found[t] = search.findRoute(reader, 0, NORTH, reader.goal(), OPEN_MASK);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(expected, found);
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 30_RunToWithBidirectionalRoutes) {
+  MazeSearcher flooding;
+  MazeSearcher searching;
+  searching.setBidirectionalRoutes(true);
+  ASSERT_NE(nullptr, searching.bidirectionalSearch());
+  for (MazeSearcher *searcher : {&flooding, &searching}) {
+    searcher->map()->copyMazeFromFileData(japan2007ef, 256);
+    searcher->map()->setFloodType(Maze::MANHATTAN_FLOOD);
+    searcher->setLocation(0);
+  }
+  int steps = flooding.runTo(0x77);
+  EXPECT_GT(steps, 0);
+  EXPECT_EQ(steps, searching.runTo(0x77));
+  EXPECT_EQ(0x77, searching.location());
+  EXPECT_EQ(steps, searching.runTo(0));
+  EXPECT_EQ(0, searching.location());
+  searching.map()->setFloodType(Maze::WEIGHTED_FLOOD);
+  EXPECT_GE(searching.runTo(0x77), steps);
+  EXPECT_EQ(0x77, searching.location());
+  EXPECT_EQ(BidirectionalSearch::WEIGHTED_COST, searching.bidirectionalSearch()->costModel());
+  searching.setBidirectionalRoutes(false);
+  EXPECT_EQ(nullptr, searching.bidirectionalSearch());
+}
+
+TEST_F(TEST_22_BidirectionalSearch, 31_RoutePathMatchesFloodPath) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.flood(0x77, CLOSED_MASK);
+  PathFinder floodPath;
+  floodPath.generateUnsafePath(0, 0x77, &maze);
+  BidirectionalSearch search;
+  search.findRoute(maze, 0, NORTH, 0x77, CLOSED_MASK);
+  PathFinder routePath;
+  routePath.generateRoutePath(0, search.routeDirections(), search.routeLength() - 1, &maze);
+  EXPECT_EQ(floodPath.cellCount(), routePath.cellCount());
+  EXPECT_EQ(0x77, routePath.endCell());
+  EXPECT_TRUE(routePath.reachesTarget());
+  EXPECT_EQ(NORTH, routePath.startHeading());
+  EXPECT_EQ('B', routePath.path()[0]);
+  EXPECT_EQ('F', routePath.path()[1]);
+  EXPECT_EQ('S', routePath.path()[routePath.cellCount()]);
+  // starting north on an empty maze the cheapest weighted route goes north and then turns east
+  maze.resetToEmptyMaze();
+  search.setCostModel(BidirectionalSearch::WEIGHTED_COST);
+  search.findRoute(maze, 0x00, NORTH, 0xF3, OPEN_MASK);
+  routePath.generateRoutePath(0x00, search.routeDirections(), search.routeLength() - 1, &maze);
+  EXPECT_STREQ("BFFFRFFFFFFFFFFFFFFS", routePath.path());
+}
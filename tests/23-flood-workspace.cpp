@@ -0,0 +1,115 @@
+// Tests for FloodWorkspace.
+//
+// A maze with a workspace attached must flood to the same costs and
+// directions as one without, and once the workspace has been built the
+// floods must not touch the heap. Allocations are counted by replacing the
+// global operator new, so these tests are built as a program of their own
+// (maze_allocation_tests) and the hook does not reach the other tests.
+
+#include "allocation-counter.h"
+#include "corpus-mazes.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_23_FloodWorkspace : public ::testing::Test {
+ protected:
+  struct Setting {
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+    bool bitParallel;
+  };
+
+  static std::vector<Setting> settings() {
+    return {
+        {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE, true}, {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE, false},
+        {Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE, true},  {Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE, true},
+        {Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE, true}, {Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE, true},
+        {Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE, true},   {Maze::DIRECTION_FLOOD, Maze::LINEAR_QUEUE, true},
+    };
+  }
+
+  static void apply(Maze &maze, const Setting &setting) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    maze.setBitParallelFlood(setting.bitParallel);
+  }
+};
+
+TEST_F(TEST_23_FloodWorkspace, 00_NoWorkspaceByDefault) {
+  Maze maze(16);
+  EXPECT_EQ(nullptr, maze.floodWorkspace());
+  FloodWorkspace workspace;
+  maze.setFloodWorkspace(&workspace);
+  EXPECT_EQ(&workspace, maze.floodWorkspace());
+  maze.setFloodWorkspace(nullptr);
+  EXPECT_EQ(nullptr, maze.floodWorkspace());
+}
+
+TEST_F(TEST_23_FloodWorkspace, 10_SameResultsWithAWorkspace) {
+  FloodWorkspace workspace;
+  Maze plain(16);
+  Maze shared(16);
+  shared.setFloodWorkspace(&workspace);
+  for (const Setting &setting : settings()) {
+    apply(plain, setting);
+    apply(shared, setting);
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(plain, i);
+      loadCorpusMaze(shared, i);
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        uint16_t target = (uint16_t)(plain.numCells() / 2 + plain.width() / 2);
+        ASSERT_EQ(plain.flood(target, mask), shared.flood(target, mask));
+        for (uint16_t cell = 0; cell < plain.numCells(); cell++) {
+          ASSERT_EQ(plain.cost(cell), shared.cost(cell))
+              << mazeList[i].title << " flood " << setting.floodType << " queue " << setting.queueType;
+          ASSERT_EQ(plain.direction(cell), shared.direction(cell))
+              << mazeList[i].title << " flood " << setting.floodType << " queue " << setting.queueType;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_23_FloodWorkspace, 20_FloodsMakeNoAllocations) {
+  FloodWorkspace workspace;
+  Maze maze(16);
+  for (const Setting &setting : settings()) {
+    apply(maze, setting);
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      maze.setFloodWorkspace(&workspace);
+      long before = allocationCount();
+      maze.flood(maze.goal(), CLOSED_MASK);
+      maze.flood(0, OPEN_MASK);
+      EXPECT_EQ(before, allocationCount())
+          << mazeList[i].title << " flood " << setting.floodType << " queue " << setting.queueType;
+      maze.setFloodWorkspace(nullptr);
+    }
+  }
+}
+
+TEST_F(TEST_23_FloodWorkspace, 21_FloodsWithoutAWorkspaceAllocate) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  long before = allocationCount();
+  maze.flood(maze.goal(), CLOSED_MASK);
+  EXPECT_LT(before, allocationCount());
+}
+
+TEST_F(TEST_23_FloodWorkspace, 30_GoalAreaChangesMakeNoAllocations) {
+  Maze maze(16);
+  long before = allocationCount();
+  maze.clearGoalArea();
+  for (int cell = 0x66; cell < 0x6A; cell++) {
+    maze.addToGoalArea(cell);
+  }
+  maze.removeFromGoalArea(0x67);
+  maze.setGoal(0x77);
+  EXPECT_TRUE(maze.goalContains(0x77));
+  EXPECT_EQ(before, allocationCount());
+}
@@ -0,0 +1,142 @@
+// Tests for FloodResult and the const Maze::flood() that writes into one.
+//
+// A flood into a result must match the same flood into the maze, must
+// leave the maze alone, and must give the same answers when several run at
+// once on different threads.
+
+#include <thread>
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+class TEST_24_FloodResult : public ::testing::Test {
+ protected:
+  struct Setting {
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+    bool bitParallel;
+  };
+
+  static std::vector<Setting> settings() {
+    return {
+        {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE, true}, {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE, false},
+        {Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE, true},  {Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE, true},
+        {Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE, true}, {Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE, true},
+        {Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE, true},   {Maze::DIRECTION_FLOOD, Maze::LINEAR_QUEUE, true},
+    };
+  }
+
+  static void apply(Maze &maze, const Setting &setting) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    maze.setBitParallelFlood(setting.bitParallel);
+  }
+};
+
+TEST_F(TEST_24_FloodResult, 00_NewResultIsEmpty) {
+  FloodResult result;
+  EXPECT_EQ(0, result.width());
+  EXPECT_EQ(MAX_COST, result.pathCost());
+  EXPECT_EQ(MAX_COST, result.cost(0));
+  EXPECT_EQ(INVALID_DIRECTION, result.direction(1023));
+}
+
+TEST_F(TEST_24_FloodResult, 10_ResultMatchesTheMazeFlood) {
+  Maze maze(16);
+  FloodResult result;
+  for (const Setting &setting : settings()) {
+    apply(maze, setting);
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        uint16_t target = (uint16_t)(maze.numCells() / 2 + maze.width() / 2);
+        const Maze &reader = maze;
+        uint16_t cost = reader.flood(target, mask, result);
+        ASSERT_EQ(maze.flood(target, mask), cost);
+        EXPECT_EQ(cost, result.pathCost());
+        EXPECT_EQ(target, result.target());
+        EXPECT_EQ(mask, result.mask());
+        EXPECT_EQ(maze.width(), result.width());
+        for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+          ASSERT_EQ(maze.cost(cell), result.cost(cell))
+              << mazeList[i].title << " flood " << setting.floodType << " queue " << setting.queueType;
+          ASSERT_EQ(maze.direction(cell), result.direction(cell))
+              << mazeList[i].title << " flood " << setting.floodType << " queue " << setting.queueType;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_24_FloodResult, 11_TheMazeKeepsItsOwnFlood) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  maze.flood(maze.goal(), OPEN_MASK);
+  uint16_t goalCost[256];
+  uint8_t goalDirection[256];
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    goalCost[cell] = maze.cost(cell);
+    goalDirection[cell] = maze.direction(cell);
+  }
+  FloodResult home;
+  EXPECT_NE(MAX_COST, maze.flood(0, CLOSED_MASK, home));
+  EXPECT_EQ(0, home.cost(0));
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    ASSERT_EQ(goalCost[cell], maze.cost(cell));
+    ASSERT_EQ(goalDirection[cell], maze.direction(cell));
+  }
+}
+
+TEST_F(TEST_24_FloodResult, 20_FloodsRunTogetherOnThreads) {
+  const int threadCount = 4;
+  Maze maze(16);
+  loadCorpusMaze(maze, 0);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  maze.setQueueType(Maze::BUCKET_QUEUE);
+  const Maze &shared = maze;
+  std::vector<FloodResult> expected(threadCount);
+  for (int t = 0; t < threadCount; t++) {
+    shared.flood((uint16_t)(t * 97), OPEN_MASK, expected[t]);
+  }
+  std::vector<FloodResult> results(threadCount);
+  std::vector<FloodWorkspace> workspaces(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t]() {
+      for (int repeat = 0; repeat < 20; repeat++) {
+        shared.flood((uint16_t)(t * 97), OPEN_MASK, results[t], &workspaces[t]);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < threadCount; t++) {
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(expected[t].cost(cell), results[t].cost(cell)) << "thread " << t;
+      ASSERT_EQ(expected[t].direction(cell), results[t].direction(cell)) << "thread " << t;
+    }
+  }
+}
+
+TEST_F(TEST_24_FloodResult, 30_RunToLeavesTheMapFloodAlone) {
+  MazeSearcher mouse;
+  mouse.map()->copyMazeFromFileData(japan2007ef, 256);
+  mouse.map()->setFloodType(Maze::MANHATTAN_FLOOD);
+  mouse.map()->flood(0x77, OPEN_MASK);
+  uint16_t before = mouse.map()->cost(0x42);
+  mouse.setLocation(0x77);
+  EXPECT_GT(mouse.runTo(0), 0);
+  EXPECT_EQ(0, mouse.location());
+  EXPECT_EQ(before, mouse.map()->cost(0x42));
+  EXPECT_EQ(0, mouse.map()->cost(0x77));
+}
@@ -0,0 +1,121 @@
+// Tests for the const, mask-parameterized maze queries.
+//
+// A const Maze must answer every wall, cost and visited query, with the
+// mask passed in rather than taken from the last flood, so that several
+// readers can share one map.
+
+#include <thread>
+#include <vector>
+
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_25_ConstQueries : public ::testing::Test {
+ protected:
+  Maze maze{16};
+  void SetUp() override {
+    maze.copyMazeFromFileData(japan2007ef, 256);
+    for (uint16_t cell = 0; cell < 256; cell += 3) {
+      maze.clearVisited(cell);
+    }
+  }
+};
+
+TEST_F(TEST_25_ConstQueries, 00_MaskedWallsMatchOpenAndClosedWalls) {
+  const Maze &reader = maze;
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    EXPECT_EQ(reader.openWalls(cell), reader.walls(cell, OPEN_MASK));
+    EXPECT_EQ(reader.closedWalls(cell), reader.walls(cell, CLOSED_MASK));
+    for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+      EXPECT_EQ(!(reader.openWalls(cell) & (1 << direction)), reader.hasExit(cell, direction, OPEN_MASK));
+      EXPECT_EQ(!(reader.closedWalls(cell) & (1 << direction)), reader.hasExit(cell, direction, CLOSED_MASK));
+    }
+  }
+}
+
+TEST_F(TEST_25_ConstQueries, 01_QueriesDoNotChangeTheFloodMask) {
+  maze.flood(maze.goal(), CLOSED_MASK);
+  uint8_t before[256];
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    before[cell] = maze.walls(cell);
+  }
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    maze.openWalls(cell);
+  }
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    EXPECT_EQ(before[cell], maze.walls(cell));
+    EXPECT_EQ(maze.closedWalls(cell), maze.walls(cell));
+  }
+}
+
+TEST_F(TEST_25_ConstQueries, 02_MaskedCostMatchesTheFloodMask) {
+  for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+    maze.flood(maze.goal(), mask);
+    const Maze &reader = maze;
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        EXPECT_EQ(reader.cost(cell, direction), reader.cost(cell, direction, mask));
+      }
+      EXPECT_EQ(MAX_COST, reader.cost(cell, INVALID_DIRECTION, mask));
+    }
+  }
+}
+
+TEST_F(TEST_25_ConstQueries, 03_OtherQueriesWorkOnAConstMaze) {
+  maze.flood(maze.goal(), OPEN_MASK);
+  const Maze &reader = maze;
+  EXPECT_EQ(0, reader.home());
+  EXPECT_TRUE(reader.isVisited(1));
+  EXPECT_FALSE(reader.isVisited(0));
+  EXPECT_TRUE(reader.is_not_seen(0, NORTH));
+  EXPECT_EQ(0, reader.cost(maze.goal()));
+  EXPECT_NE(INVALID_DIRECTION, reader.direction(0));
+  EXPECT_EQ(reader.direction(1), reader.directionToSmallest(1));
+  EXPECT_EQ(15, reader.manhattanDistance(0, 0xF0 + 0));
+  EXPECT_EQ(15, reader.chebyshevDistance(0, 0xFF));
+  EXPECT_FALSE(reader.isSolved());
+  EXPECT_EQ(0, reader.costDifference());
+}
+
+TEST_F(TEST_25_ConstQueries, 10_ReadersShareOneMaze) {
+  const int threadCount = 4;
+  const Maze &reader = maze;
+  uint8_t expectedWalls[2][256];
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    expectedWalls[0][cell] = reader.walls(cell, OPEN_MASK);
+    expectedWalls[1][cell] = reader.walls(cell, CLOSED_MASK);
+  }
+  std::vector<FloodResult> expected(threadCount);
+  for (int t = 0; t < threadCount; t++) {
+    reader.flood((uint16_t)(t * 61), t % 2 ? CLOSED_MASK : OPEN_MASK, expected[t]);
+  }
+  std::vector<FloodResult> results(threadCount);
+  std::vector<FloodWorkspace> workspaces(threadCount);
+  std::vector<int> wallErrors(threadCount, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t]() {
+      uint8_t mask = t % 2 ? CLOSED_MASK : OPEN_MASK;
+      for (int repeat = 0; repeat < 20; repeat++) {
+        for (uint16_t cell = 0; cell < 256; cell++) {
+          wallErrors[t] += reader.walls(cell, mask) != expectedWalls[t % 2][cell];
+        }
+        reader.flood((uint16_t)(t * 61), mask, results[t], &workspaces[t]);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < threadCount; t++) {
+    EXPECT_EQ(0, wallErrors[t]);
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      ASSERT_EQ(expected[t].cost(cell), results[t].cost(cell)) << "thread " << t;
+    }
+  }
+}
@@ -0,0 +1,106 @@
+// Tests for GoalArea, the bitset and ordered list behind the maze goal area.
+
+#include "goalarea.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_26_GoalArea : public ::testing::Test {
+ protected:
+  GoalArea area;
+};
+
+TEST_F(TEST_26_GoalArea, 00_NewAreaIsEmpty) {
+  EXPECT_TRUE(area.empty());
+  EXPECT_EQ(0, area.size());
+  EXPECT_EQ(area.begin(), area.end());
+  for (int cell = 0; cell < GoalArea::MAX_CELLS; cell++) {
+    ASSERT_FALSE(area.contains(cell));
+  }
+}
+
+TEST_F(TEST_26_GoalArea, 01_CellsKeepTheOrderTheyWereAddedIn) {
+  const int cells[] = {0x88, 0x77, 0x3FF, 0x00, 0x78};
+  for (int cell : cells) {
+    EXPECT_TRUE(area.add(cell));
+  }
+  EXPECT_EQ(5, area.size());
+  EXPECT_EQ(0x88, area.front());
+  int i = 0;
+  for (uint16_t cell : area) {
+    EXPECT_EQ(cells[i++], cell);
+  }
+  for (int cell : cells) {
+    EXPECT_TRUE(area.contains(cell));
+  }
+  EXPECT_FALSE(area.contains(0x87));
+}
+
+TEST_F(TEST_26_GoalArea, 02_AddingACellTwiceIsIgnored) {
+  EXPECT_TRUE(area.add(0x77));
+  EXPECT_FALSE(area.add(0x77));
+  EXPECT_EQ(1, area.size());
+  area.remove(0x77);
+  EXPECT_TRUE(area.empty());
+  EXPECT_FALSE(area.contains(0x77));
+}
+
+TEST_F(TEST_26_GoalArea, 03_CellsOutsideTheMazeAreRejected) {
+  EXPECT_FALSE(area.add(-1));
+  const int maxCells = GoalArea::MAX_CELLS;
+  EXPECT_FALSE(area.add(maxCells));
+  EXPECT_FALSE(area.contains(-1));
+  EXPECT_FALSE(area.contains(maxCells));
+  EXPECT_TRUE(area.empty());
+}
+
+TEST_F(TEST_26_GoalArea, 04_TheAreaStopsGrowingWhenFull) {
+  const int maxSize = GoalArea::MAX_SIZE;
+  for (int cell = 0; cell < maxSize; cell++) {
+    EXPECT_TRUE(area.add(cell * 3));
+  }
+  EXPECT_FALSE(area.add(1));
+  EXPECT_FALSE(area.contains(1));
+  EXPECT_EQ(maxSize, area.size());
+}
+
+TEST_F(TEST_26_GoalArea, 10_RemoveKeepsTheOrderOfTheRest) {
+  for (int cell : {10, 20, 30, 40}) {
+    area.add(cell);
+  }
+  area.remove(10);
+  area.remove(30);
+  area.remove(99);
+  ASSERT_EQ(2, area.size());
+  EXPECT_EQ(20, area.begin()[0]);
+  EXPECT_EQ(40, area.begin()[1]);
+  EXPECT_FALSE(area.contains(10));
+  EXPECT_TRUE(area.contains(40));
+}
+
+TEST_F(TEST_26_GoalArea, 11_ClearEmptiesTheBitset) {
+  for (int cell = 0; cell < 32; cell++) {
+    area.add(cell * 31);
+  }
+  area.clear();
+  EXPECT_TRUE(area.empty());
+  for (int cell = 0; cell < GoalArea::MAX_CELLS; cell++) {
+    ASSERT_FALSE(area.contains(cell));
+  }
+  EXPECT_TRUE(area.add(31));
+  EXPECT_EQ(31, area.front());
+}
+
+TEST_F(TEST_26_GoalArea, 20_MazeGoalIsTheFirstCellAdded) {
+  Maze maze(16);
+  maze.clearGoalArea();
+  maze.addToGoalArea(0x88);
+  maze.addToGoalArea(0x77);
+  maze.addToGoalArea(0x88);
+  EXPECT_EQ(0x88, maze.goal());
+  EXPECT_EQ(2, maze.goalAreaSize());
+  maze.removeFromGoalArea(0x88);
+  EXPECT_EQ(0x77, maze.goal());
+}
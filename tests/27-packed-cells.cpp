@@ -0,0 +1,120 @@
+// Tests for the packed cell layout.
+//
+// Floods on PackedCell records must give exactly the same costs and
+// directions as floods on the separate arrays, for every flood type and
+// queue, with and without a workspace.
+
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "packedcells.h"
+
+#include "gtest/gtest.h"
+
+class TEST_27_PackedCells : public ::testing::Test {
+ protected:
+  struct Setting {
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+  };
+
+  static std::vector<Setting> settings() {
+    return {
+        {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE}, {Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE},
+        {Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE},    {Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE},
+        {Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE}, {Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE},
+        {Maze::DIRECTION_FLOOD, Maze::LINEAR_QUEUE},
+    };
+  }
+
+  /// flood with both layouts and compare everything the flood leaves behind
+  static void expectSameFloods(Maze &maze, const Setting &setting, FloodWorkspace *workspace, const char *title) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    maze.setBitParallelFlood(false);
+    maze.setFloodWorkspace(workspace);
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      maze.setCellLayout(Maze::SPLIT_CELLS);
+      uint16_t splitCost = maze.flood(maze.goal(), mask);
+      std::vector<uint16_t> cost(maze.numCells());
+      std::vector<uint8_t> direction(maze.numCells());
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        cost[cell] = maze.cost(cell);
+        direction[cell] = maze.direction(cell);
+      }
+      maze.setCellLayout(Maze::PACKED_CELLS);
+      ASSERT_EQ(splitCost, maze.flood(maze.goal(), mask)) << title;
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(cost[cell], maze.cost(cell)) << title << " flood " << setting.floodType << " cell " << cell;
+        ASSERT_EQ(direction[cell], maze.direction(cell)) << title << " flood " << setting.floodType << " cell " << cell;
+      }
+    }
+    maze.setFloodWorkspace(nullptr);
+  }
+};
+
+TEST_F(TEST_27_PackedCells, 00_PackedCellIsOneWord) {
+  EXPECT_EQ(4u, sizeof(PackedCell));
+  Maze maze(16);
+  EXPECT_EQ(Maze::SPLIT_CELLS, maze.getCellLayout());
+  maze.setCellLayout(Maze::PACKED_CELLS);
+  EXPECT_EQ(Maze::PACKED_CELLS, maze.getCellLayout());
+}
+
+TEST_F(TEST_27_PackedCells, 10_SameResultsAsSplitCells) {
+  Maze maze(16);
+  for (const Setting &setting : settings()) {
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      expectSameFloods(maze, setting, nullptr, mazeList[i].title);
+    }
+  }
+}
+
+TEST_F(TEST_27_PackedCells, 11_SameResultsWithAWorkspace) {
+  FloodWorkspace workspace;
+  Maze maze(16);
+  for (const Setting &setting : settings()) {
+    for (int i = 0; i < mazeCount; i += 7) {
+      loadCorpusMaze(maze, i);
+      expectSameFloods(maze, setting, &workspace, mazeList[i].title);
+    }
+  }
+}
+
+TEST_F(TEST_27_PackedCells, 12_SameResultsFromTheGoalArea) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  maze.floodGoalArea(OPEN_MASK);
+  uint16_t cost[256];
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    cost[cell] = maze.cost(cell);
+  }
+  maze.setCellLayout(Maze::PACKED_CELLS);
+  maze.floodGoalArea(OPEN_MASK);
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    ASSERT_EQ(cost[cell], maze.cost(cell));
+  }
+}
+
+TEST_F(TEST_27_PackedCells, 20_ConstFloodIntoAResult) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setFloodType(Maze::WEIGHTED_FLOOD);
+  FloodResult split;
+  FloodResult packed;
+  maze.flood(maze.goal(), CLOSED_MASK, split);
+  maze.setCellLayout(Maze::PACKED_CELLS);
+  maze.flood(maze.goal(), CLOSED_MASK, packed);
+  EXPECT_EQ(split.pathCost(), packed.pathCost());
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    ASSERT_EQ(split.cost(cell), packed.cost(cell));
+    ASSERT_EQ(split.direction(cell), packed.direction(cell));
+  }
+}
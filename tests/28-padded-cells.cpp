@@ -0,0 +1,191 @@
+// Tests for the padded cell layout and the Padded geometry.
+//
+// On a maze with closed outer walls the padded floods must match the split
+// floods exactly. Where an outer wall is missing or unseen the split floods
+// wrap to the opposite edge and the padded floods must not: they treat it as
+// closed.
+
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "mazegeometry.h"
+
+#include "gtest/gtest.h"
+
+class TEST_28_PaddedCells : public ::testing::Test {
+ protected:
+  struct Setting {
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+  };
+
+  static std::vector<Setting> settings() {
+    return {
+        {Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE}, {Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE},
+        {Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE},    {Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE},
+        {Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE}, {Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE},
+        {Maze::DIRECTION_FLOOD, Maze::LINEAR_QUEUE},
+    };
+  }
+
+  static bool hasClosedBorder(const Maze &maze) {
+    uint16_t top = maze.width() - 1;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      if ((maze.row(cell) == top && maze.hasExit(cell, NORTH, OPEN_MASK)) ||
+          (maze.col(cell) == top && maze.hasExit(cell, EAST, OPEN_MASK)) ||
+          (maze.row(cell) == 0 && maze.hasExit(cell, SOUTH, OPEN_MASK)) ||
+          (maze.col(cell) == 0 && maze.hasExit(cell, WEST, OPEN_MASK))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+TEST_F(TEST_28_PaddedCells, 00_PaddedIndicesSkipTheSentinels) {
+  Padded<FixedWidth<16>> grid{FixedWidth<16>()};
+  EXPECT_EQ(18, grid.stride());
+  EXPECT_EQ(18 * 18, grid.numCells());
+  EXPECT_EQ(19, grid.index(0));
+  EXPECT_EQ(16 * 18 + 16, grid.index(255));
+  for (uint16_t cell = 0; cell < 256; cell++) {
+    ASSERT_EQ(cell, grid.cellAt(grid.index(cell)));
+  }
+}
+
+TEST_F(TEST_28_PaddedCells, 01_NeighboursAreOneAdd) {
+  Padded<RuntimeWidth> grid{RuntimeWidth(5)};
+  EXPECT_EQ(1, grid.offset(NORTH));
+  EXPECT_EQ(7, grid.offset(EAST));
+  EXPECT_EQ(-1, grid.offset(SOUTH));
+  EXPECT_EQ(-7, grid.offset(WEST));
+  uint16_t middle = grid.index(12);
+  EXPECT_EQ(grid.index(13), grid.neighbour(middle, NORTH));
+  EXPECT_EQ(grid.index(17), grid.neighbour(middle, EAST));
+  EXPECT_EQ(grid.index(11), grid.neighbour(middle, SOUTH));
+  EXPECT_EQ(grid.index(7), grid.neighbour(middle, WEST));
+  // the top of column 0 does not run on into column 1 as neighbour() does
+  EXPECT_NE(grid.index(5), grid.neighbour(grid.index(4), NORTH));
+}
+
+TEST_F(TEST_28_PaddedCells, 10_SameResultsAsSplitCells) {
+  FloodWorkspace workspace;
+  Maze maze(16);
+  maze.setBitParallelFlood(false);
+  for (const Setting &setting : settings()) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      if (!hasClosedBorder(maze)) {
+        continue;
+      }
+      maze.setFloodWorkspace(i % 2 ? &workspace : nullptr);
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        maze.setCellLayout(Maze::SPLIT_CELLS);
+        uint16_t splitCost = maze.flood(maze.goal(), mask);
+        std::vector<uint16_t> cost(maze.numCells());
+        std::vector<uint8_t> direction(maze.numCells());
+        for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+          cost[cell] = maze.cost(cell);
+          direction[cell] = maze.direction(cell);
+        }
+        maze.setCellLayout(Maze::PADDED_CELLS);
+        ASSERT_EQ(splitCost, maze.flood(maze.goal(), mask)) << mazeList[i].title;
+        for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+          ASSERT_EQ(cost[cell], maze.cost(cell)) << mazeList[i].title << " flood " << setting.floodType;
+          ASSERT_EQ(direction[cell], maze.direction(cell)) << mazeList[i].title << " flood " << setting.floodType;
+        }
+      }
+      maze.setFloodWorkspace(nullptr);
+    }
+  }
+}
+
+TEST_F(TEST_28_PaddedCells, 11_TheCorpusHasClosedBorders) {
+  Maze maze(16);
+  int closed = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    closed += hasClosedBorder(maze);
+  }
+  EXPECT_EQ(mazeCount, closed);
+}
+
+TEST_F(TEST_28_PaddedCells, 20_NoWrapThroughAMissingOuterWall) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setBitParallelFlood(false);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  // box in cell 0x0F at the top of column 0 except for its outer north wall
+  maze.setWall(0x0F, SOUTH);
+  maze.setWall(0x0F, EAST);
+  maze.clearWall(0x0F, NORTH);
+  maze.setCellLayout(Maze::SPLIT_CELLS);
+  maze.flood(0, OPEN_MASK);
+  EXPECT_NE(MAX_COST, maze.cost(0x0F));  // reached by wrapping in from cell 0x10
+  maze.setCellLayout(Maze::PADDED_CELLS);
+  maze.flood(0, OPEN_MASK);
+  EXPECT_EQ(MAX_COST, maze.cost(0x0F));
+  EXPECT_EQ(INVALID_DIRECTION, maze.direction(0x0F));
+  EXPECT_EQ(1, maze.cost(0x01));
+}
+
+TEST_F(TEST_28_PaddedCells, 21_UnseenOuterWallsCountAsClosed) {
+  Maze real(16);
+  real.copyMazeFromFileData(japan2007ef, 256);
+  // only the inner cells are seen, so every outer wall is unseen
+  Maze maze(16);
+  maze.clearData();
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    if (maze.col(cell) > 0 && maze.col(cell) < 15 && maze.row(cell) > 0 && maze.row(cell) < 15) {
+      maze.updateMap(cell, real.walls(cell));
+    }
+  }
+  uint8_t data[1024];
+  maze.save(data);
+  Maze walled(16);
+  walled.load(data);
+  for (uint16_t i = 0; i < 16; i++) {
+    walled.setWall(i, WEST);
+    walled.setWall(15 * 16 + i, EAST);
+    walled.setWall(i * 16, SOUTH);
+    walled.setWall(i * 16 + 15, NORTH);
+  }
+  maze.setBitParallelFlood(false);
+  walled.setBitParallelFlood(false);
+  int wrapped = 0;
+  for (const Setting &setting : settings()) {
+    for (Maze *m : {&maze, &walled}) {
+      m->setFloodType(setting.floodType);
+      m->setQueueType(setting.queueType);
+    }
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      maze.setCellLayout(Maze::SPLIT_CELLS);
+      maze.flood(0x77, mask);
+      std::vector<uint16_t> splitCost(maze.numCells());
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        splitCost[cell] = maze.cost(cell);
+      }
+      maze.setCellLayout(Maze::PACKED_CELLS);
+      maze.flood(0x77, mask);
+      walled.flood(0x77, mask);
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(splitCost[cell], maze.cost(cell)) << "flood " << setting.floodType << " cell " << cell;
+        wrapped += splitCost[cell] != walled.cost(cell);
+      }
+      maze.setCellLayout(Maze::PADDED_CELLS);
+      maze.flood(0x77, mask);
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(walled.cost(cell), maze.cost(cell)) << "flood " << setting.floodType << " cell " << cell;
+        ASSERT_EQ(walled.direction(cell), maze.direction(cell)) << "flood " << setting.floodType << " cell " << cell;
+      }
+    }
+  }
+  // the split and packed floods did go through the unseen outer walls
+  EXPECT_GT(wrapped, 0);
+}
@@ -0,0 +1,194 @@
+// Tests for the flood engine and its cost policies.
+//
+// The built in policies must give the same results through floodWith() as
+// the flood types of the maze, and a policy written outside the library
+// must flood without any change to the maze.
+
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "floodengine.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_29_FloodEngine : public ::testing::Test {
+ protected:
+  /// flood into the maze with the flood type and the heap, as floodWith() does, and check the result against it
+  static void expectSameAsFloodType(Maze &maze, Maze::FloodType floodType, const FloodResult &result,
+                                    bool compareDirections, const char *title) {
+    maze.setFloodType(floodType);
+    maze.setQueueType(Maze::HEAP_QUEUE);
+    ASSERT_EQ(maze.flood(result.target(), result.mask()), result.pathCost()) << title;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(maze.cost(cell), result.cost(cell)) << title << " flood " << floodType << " cell " << cell;
+      if (compareDirections) {
+        ASSERT_EQ(maze.direction(cell), result.direction(cell)) << title << " flood " << floodType << " cell " << cell;
+      }
+    }
+  }
+};
+
+/// every step costs the same, like the manhattan flood but scaled
+struct UniformCost : FloodCostPolicy {
+  uint16_t stepCost(const FloodInfo &, uint8_t, FloodInfo &) const { return 3; }
+};
+
+/// straight on is free and each turn costs one, so the costs count the turns to the target
+struct TurnCountCost : FloodCostPolicy {
+  static const bool RECORDS_DIRECTION = true;
+  uint16_t stepCost(const FloodInfo &from, uint8_t exitWall, FloodInfo &to) const {
+    to.entryDir = exitWall;
+    if (from.entryDir == exitWall) {
+      return 0;
+    }
+    return 1;
+  }
+};
+
+TEST_F(TEST_29_FloodEngine, 00_TurnPenaltyIsPer45Degrees) {
+  const uint16_t penalty = RunLengthCost::TURN_PENALTY;
+  EXPECT_EQ(22, penalty);
+  Maze maze(16);
+  const RunLengthCost policy = maze.runLengthCost();
+  // heading north and leaving through the east wall is a 45 degree turn onto the diagonal after a run of 3
+  FloodInfo from(0, 0, 3, DIR_N, SOUTH);
+  FloodInfo to;
+  uint16_t cost = policy.stepCost(from, EAST, to);
+  EXPECT_EQ(1, to.runLength);
+  EXPECT_EQ(DIR_NE, to.entryDir);
+  EXPECT_EQ(WEST, to.entryWall);
+  FloodInfo ahead;
+  FloodInfo straightFrom(0, 0, 0, DIR_NE, WEST);
+  EXPECT_EQ(cost, policy.stepCost(straightFrom, NORTH, ahead) + penalty);
+  EXPECT_EQ(1, ahead.runLength);
+}
+
+TEST_F(TEST_29_FloodEngine, 01_PolicyMatchesRunLengthStepCost) {
+  Maze maze(16);
+  const RunLengthCost policy = maze.runLengthCost();
+  for (uint8_t entryWall = NORTH; entryWall <= WEST; entryWall++) {
+    for (uint8_t entryDir = 0; entryDir < 8; entryDir++) {
+      for (uint8_t runLength = 1; runLength < 20; runLength++) {
+        for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+          if (exitWall == entryWall) {
+            continue;
+          }
+          FloodInfo from(0, 0, runLength, entryDir, entryWall);
+          FloodInfo to;
+          uint8_t newRunLength;
+          uint8_t exitDir;
+          uint16_t cost = maze.runLengthStepCost(from, exitWall, newRunLength, exitDir);
+          ASSERT_EQ(cost, policy.stepCost(from, exitWall, to));
+          ASSERT_EQ(newRunLength, to.runLength);
+          ASSERT_EQ(exitDir, to.entryDir);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_29_FloodEngine, 10_BuiltInPoliciesMatchTheFloodTypes) {
+  Maze maze(16);
+  maze.setBitParallelFlood(false);
+  FloodResult result;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      maze.floodWith(ManhattanCost(), maze.goal(), mask, result);
+      expectSameAsFloodType(maze, Maze::MANHATTAN_FLOOD, result, true, mazeList[i].title);
+      maze.floodWith(WeightedCost(maze.getCornerWeight()), maze.goal(), mask, result);
+      expectSameAsFloodType(maze, Maze::WEIGHTED_FLOOD, result, true, mazeList[i].title);
+      maze.floodWith(maze.runLengthCost(), maze.goal(), mask, result);
+      expectSameAsFloodType(maze, Maze::RUNLENGTH_FLOOD, result, true, mazeList[i].title);
+      // the heap may settle cells of equal cost in another order so the recorded directions can differ
+      maze.floodWith(DirectionCost(), maze.goal(), mask, result);
+      expectSameAsFloodType(maze, Maze::DIRECTION_FLOOD, result, false, mazeList[i].title);
+    }
+  }
+}
+
+TEST_F(TEST_29_FloodEngine, 11_WorkspaceGivesTheSameResult) {
+  FloodWorkspace workspace;
+  Maze maze(16);
+  FloodResult local;
+  FloodResult shared;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t cost = maze.floodWith(maze.runLengthCost(), maze.goal(), OPEN_MASK, local);
+    ASSERT_EQ(cost, maze.floodWith(maze.runLengthCost(), maze.goal(), OPEN_MASK, shared, &workspace));
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(local.cost(cell), shared.cost(cell)) << mazeList[i].title;
+      ASSERT_EQ(local.direction(cell), shared.direction(cell)) << mazeList[i].title;
+    }
+  }
+}
+
+TEST_F(TEST_29_FloodEngine, 20_UserPolicyScalesTheManhattanFlood) {
+  Maze maze(16);
+  FloodResult uniform;
+  FloodResult manhattan;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t cost = maze.floodWith(UniformCost(), maze.goal(), OPEN_MASK, uniform);
+    maze.floodWith(ManhattanCost(), maze.goal(), OPEN_MASK, manhattan);
+    EXPECT_EQ(cost, uniform.pathCost());
+    EXPECT_EQ(maze.goal(), uniform.target());
+    EXPECT_EQ(maze.width(), uniform.width());
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      uint16_t expected = manhattan.cost(cell) == MAX_COST ? MAX_COST : 3 * manhattan.cost(cell);
+      ASSERT_EQ(expected, uniform.cost(cell)) << mazeList[i].title;
+      // the default direction rule leads to a cheaper neighbour from every reachable cell
+      if (cell != maze.goal() && uniform.cost(cell) != MAX_COST) {
+        uint8_t direction = uniform.direction(cell);
+        ASSERT_NE(INVALID_DIRECTION, direction);
+        ASSERT_LT(uniform.cost(maze.neighbour(cell, direction)), uniform.cost(cell));
+      }
+    }
+  }
+}
+
+TEST_F(TEST_29_FloodEngine, 21_UserPolicyCountsTurns) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  // a corridor up column 0 and along row 15 to the target in the top right corner
+  for (uint16_t row = 0; row < 15; row++) {
+    maze.setWall(row, EAST);
+  }
+  for (uint16_t col = 1; col < 16; col++) {
+    maze.setWall((uint16_t)(col * 16 + 15), SOUTH);
+  }
+  FloodResult result;
+  uint16_t target = 0xFF;
+  maze.floodWith(TurnCountCost(), target, OPEN_MASK, result);
+  // the flood starts out heading north so the first step west is a turn
+  EXPECT_EQ(1, result.cost(0xEF));
+  EXPECT_EQ(1, result.cost(0x1F));
+  EXPECT_EQ(1, result.cost(0x0F));
+  EXPECT_EQ(2, result.cost(0x0E));
+  EXPECT_EQ(2, result.pathCost());
+  EXPECT_EQ(NORTH, result.direction(0));
+  EXPECT_EQ(EAST, result.direction(0x0F));
+}
+
+TEST_F(TEST_29_FloodEngine, 22_FloodWithLeavesTheMazeAlone) {
+  Maze maze(16);
+  loadCorpusMaze(maze, 0);
+  maze.flood(maze.goal(), OPEN_MASK);
+  std::vector<uint16_t> cost(maze.numCells());
+  std::vector<uint8_t> direction(maze.numCells());
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    cost[cell] = maze.cost(cell);
+    direction[cell] = maze.direction(cell);
+  }
+  FloodResult result;
+  maze.floodWith(UniformCost(), 0, CLOSED_MASK, result);
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    ASSERT_EQ(cost[cell], maze.cost(cell));
+    ASSERT_EQ(direction[cell], maze.direction(cell));
+  }
+}
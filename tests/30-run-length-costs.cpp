@@ -0,0 +1,118 @@
+// Tests for the run length cost tables generated from a motion profile.
+//
+// The low speed profile must give exactly the tables that used to be pasted
+// into maze.cpp, and switching the profile of a maze must change what its
+// runlength floods see without touching any other maze.
+
+#include <vector>
+
+#include "largemaze.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "runlengthcosts.h"
+
+#include "gtest/gtest.h"
+
+class TEST_30_RunLengthCosts : public ::testing::Test {};
+
+TEST_F(TEST_30_RunLengthCosts, 00_SqrtIsExactEnough) {
+  EXPECT_DOUBLE_EQ(0.0, constexprSqrt(0));
+  EXPECT_DOUBLE_EQ(1.5, constexprSqrt(2.25));
+  EXPECT_DOUBLE_EQ(1.4142135623730951, constexprSqrt(2));
+  EXPECT_DOUBLE_EQ(2145.6, constexprSqrt(2145.6 * 2145.6));
+}
+
+TEST_F(TEST_30_RunLengthCosts, 01_LowSpeedMatchesTheOriginalTables) {
+  const uint16_t ortho[] = {
+      0,  98, 75, 63, 55, 50, 46, 43, 40, 38, 36, 36, 36, 36, 36, 36,
+      36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36, 36,
+  };
+  const uint16_t diag[] = {
+      0,  73, 58, 50, 44, 40, 37, 35, 33, 31, 31, 31, 31, 31, 31, 31,
+      31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31,
+  };
+  constexpr RunLengthCostTables tables = makeRunLengthCosts(LOW_SPEED_MOTION);
+  for (int i = 0; i < RunLengthCostTables::LENGTHS; i++) {
+    EXPECT_EQ(ortho[i], tables.ortho[i]) << "run length " << i;
+    EXPECT_EQ(diag[i], tables.diag[i]) << "run length " << i;
+  }
+}
+
+TEST_F(TEST_30_RunLengthCosts, 02_FasterMiceHaveCheaperCosts) {
+  constexpr RunLengthCostTables slow = makeRunLengthCosts(LOW_SPEED_MOTION);
+  constexpr RunLengthCostTables fast = makeRunLengthCosts(HIGH_SPEED_MOTION);
+  for (int i = 1; i < RunLengthCostTables::LENGTHS; i++) {
+    EXPECT_LE(fast.ortho[i], slow.ortho[i]);
+    EXPECT_LE(fast.diag[i], slow.diag[i]);
+    // each extra cell of a straight never costs more than the one before
+    if (i > 1) {
+      EXPECT_LE(fast.ortho[i], fast.ortho[i - 1]);
+      EXPECT_LE(fast.diag[i], fast.diag[i - 1]);
+    }
+  }
+  // 180 mm at 5000 mm/s
+  EXPECT_EQ(36, fast.ortho[RunLengthCostTables::LENGTHS - 1]);
+}
+
+TEST_F(TEST_30_RunLengthCosts, 10_ProfileSwitchesAtRunTime) {
+  const RunLengthCostTables fast = makeRunLengthCosts(HIGH_SPEED_MOTION);
+  Maze maze(16);
+  EXPECT_EQ(98, maze.runLengthStartCost());
+  maze.setRunLengthProfile(Maze::HIGH_SPEED_PROFILE);
+  EXPECT_EQ(fast.ortho[1], maze.runLengthStartCost());
+  EXPECT_EQ(fast.ortho[1], maze.runLengthCosts().ortho[1]);
+  maze.setRunLengthProfile(Maze::LOW_SPEED_PROFILE);
+  EXPECT_EQ(98, maze.runLengthStartCost());
+}
+
+TEST_F(TEST_30_RunLengthCosts, 11_FloodUsesTheSelectedProfile) {
+  static constexpr RunLengthCostTables slower = makeRunLengthCosts({360, 750, 6500, 2500, 2000});
+  Maze maze(16);
+  maze.copyMazeFromFileData(mazeList[0].data, mazeList[0].size);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  uint16_t slowCost = maze.flood(maze.goal(), OPEN_MASK);
+  maze.setRunLengthCosts(slower);
+  EXPECT_EQ(&slower, &maze.runLengthCosts());
+  EXPECT_GT(maze.flood(maze.goal(), OPEN_MASK), slowCost);
+  maze.setRunLengthProfile(Maze::LOW_SPEED_PROFILE);
+  EXPECT_EQ(slowCost, maze.flood(maze.goal(), OPEN_MASK));
+}
+
+TEST_F(TEST_30_RunLengthCosts, 12_EachMazeKeepsItsOwnProfile) {
+  Maze slow(16);
+  slow.copyMazeFromFileData(mazeList[0].data, mazeList[0].size);
+  slow.setFloodType(Maze::RUNLENGTH_FLOOD);
+  Maze fast(16);
+  fast.copyMazeFromFileData(mazeList[0].data, mazeList[0].size);
+  fast.setFloodType(Maze::RUNLENGTH_FLOOD);
+  uint16_t slowCost = slow.flood(slow.goal(), OPEN_MASK);
+  fast.setRunLengthProfile(Maze::HIGH_SPEED_PROFILE);
+  uint16_t fastCost = fast.flood(fast.goal(), OPEN_MASK);
+  EXPECT_LT(fastCost, slowCost);
+  // setting the profile of one maze leaves every other maze alone
+  EXPECT_EQ(98, slow.runLengthStartCost());
+  EXPECT_EQ(slowCost, slow.flood(slow.goal(), OPEN_MASK));
+  EXPECT_EQ(98, Maze(16).runLengthStartCost());
+  EXPECT_EQ(98, LargeMaze<>(16).runLengthCosts().ortho[1]);
+}
+
+TEST_F(TEST_30_RunLengthCosts, 13_LargeMazeUsesItsOwnProfile) {
+  Maze maze(16);
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  maze.copyMazeFromFileData(mazeList[0].data, mazeList[0].size);
+  maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+  std::vector<uint8_t> data(maze.numCells());
+  maze.save(data.data());
+  LargeMaze<> large(16);
+  large.load(data.data());
+  large.setFloodType(Maze::RUNLENGTH_FLOOD);
+  uint16_t slowCost = maze.flood(maze.goal(), OPEN_MASK);
+  ASSERT_EQ(slowCost, large.flood(maze.goal(), OPEN_MASK));
+  large.setRunLengthProfile(Maze::HIGH_SPEED_PROFILE);
+  uint32_t fastCost = large.flood(maze.goal(), OPEN_MASK);
+  EXPECT_LT(fastCost, slowCost);
+  EXPECT_EQ(slowCost, maze.flood(maze.goal(), OPEN_MASK));
+  maze.setRunLengthProfile(Maze::HIGH_SPEED_PROFILE);
+  EXPECT_EQ(fastCost, maze.flood(maze.goal(), OPEN_MASK));
+}
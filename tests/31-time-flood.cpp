@@ -0,0 +1,184 @@
+// Tests for the time flood.
+//
+// The speed levels and step times must follow the motion profile, the
+// directions must lead to the target from every cell that can reach it and
+// the route from cell 0 must be the quickest one, not the shortest.
+
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "timeflood.h"
+
+#include "gtest/gtest.h"
+
+class TEST_31_TimeFlood : public ::testing::Test {
+ protected:
+  /// the number of steps taken following the directions from the cell to a cell of cost zero, or -1
+  static int stepsToTarget(const Maze &maze, uint16_t cell) {
+    for (int steps = 0; steps <= maze.numCells(); steps++) {
+      if (maze.cost(cell) == 0) {
+        return steps;
+      }
+      if (maze.direction(cell) == INVALID_DIRECTION) {
+        return -1;
+      }
+      cell = maze.neighbour(cell, maze.direction(cell));
+    }
+    return -1;
+  }
+};
+
+TEST_F(TEST_31_TimeFlood, 00_SpeedLevelsAreOneCellOfAccelerationApart) {
+  TimeFlood flood(LOW_SPEED_MOTION);
+  ASSERT_EQ(6, flood.speedCount());
+  EXPECT_DOUBLE_EQ(1500, flood.speed(0));
+  EXPECT_DOUBLE_EQ(5000, flood.speed(flood.speedCount() - 1));
+  for (int level = 1; level < flood.speedCount() - 1; level++) {
+    double gain = flood.speed(level) * flood.speed(level) - flood.speed(level - 1) * flood.speed(level - 1);
+    EXPECT_NEAR(2 * 13000 * 180, gain, 1e-3);
+  }
+}
+
+TEST_F(TEST_31_TimeFlood, 01_StepTimes) {
+  TimeFlood flood(LOW_SPEED_MOTION);
+  // cruising
+  EXPECT_EQ(120000u, flood.stepTime(0, 0));
+  EXPECT_EQ(36000u, flood.stepTime(5, 5));
+  // speeding up takes as long as slowing down
+  for (int level = 0; level + 1 < flood.speedCount(); level++) {
+    EXPECT_EQ(flood.stepTime(level, level + 1), flood.stepTime(level + 1, level));
+    EXPECT_LT(flood.stepTime(level, level + 1), flood.stepTime(level, level));
+  }
+  // a quarter circle of radius 90 mm at 1500 mm/s
+  EXPECT_EQ(94248u, flood.turnTime());
+}
+
+TEST_F(TEST_31_TimeFlood, 02_SlowProfileHasOneLevel) {
+  TimeFlood flood({180, 1000, 5000, 800, 800});
+  EXPECT_EQ(1, flood.speedCount());
+  EXPECT_EQ(180000u, flood.stepTime(0, 0));
+}
+
+TEST_F(TEST_31_TimeFlood, 10_StraightRunAcceleratesAndArrivesFast) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::TIME_FLOOD);
+  uint16_t cost = maze.flood(0x0F, OPEN_MASK);
+  for (uint16_t cell = 0; cell < 0x0F; cell++) {
+    EXPECT_EQ(NORTH, maze.direction(cell)) << cell;
+  }
+  // 15 cells, faster than at the turn speed throughout and slower than at top speed
+  EXPECT_LT(cost, 15 * 120);
+  EXPECT_GT(cost, 15 * 36);
+  TimeFlood flood(LOW_SPEED_MOTION);
+  uint16_t sources[] = {0x0F};
+  std::vector<uint16_t> costs(maze.numCells());
+  std::vector<uint8_t> directions(maze.numCells());
+  flood.flood(maze, sources, 1, OPEN_MASK, costs.data(), directions.data());
+  EXPECT_EQ(cost, (flood.runTime() + 500) / 1000);
+}
+
+TEST_F(TEST_31_TimeFlood, 11_DirectionsReachTheTargetFromEveryCell) {
+  Maze maze(16);
+  maze.setFloodType(Maze::TIME_FLOOD);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      maze.flood(maze.goal(), mask);
+      EXPECT_EQ(0, maze.cost(maze.goal()));
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        if (maze.cost(cell) == MAX_COST) {
+          ASSERT_EQ(INVALID_DIRECTION, maze.direction(cell));
+          continue;
+        }
+        ASSERT_GE(stepsToTarget(maze, cell), 0) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+}
+
+TEST_F(TEST_31_TimeFlood, 12_QuickestRouteIsNotTheShortest) {
+  // two ways from cell 0 to column 8, row 8: a staircase of 16 turns, or 30 cells round
+  // the edge of the maze with only two turns
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      maze.setWall(cell, dir);
+    }
+  }
+  auto openRoute = [&](uint16_t cell, const std::vector<uint8_t> &moves) {
+    for (uint8_t dir : moves) {
+      maze.clearWall(cell, dir);
+      cell = maze.neighbour(cell, dir);
+    }
+  };
+  std::vector<uint8_t> staircase;
+  for (int i = 0; i < 8; i++) {
+    staircase.push_back(EAST);
+    staircase.push_back(NORTH);
+  }
+  std::vector<uint8_t> edge(15, NORTH);
+  edge.insert(edge.end(), 8, EAST);
+  edge.insert(edge.end(), 7, SOUTH);
+  openRoute(0, staircase);
+  openRoute(0, edge);
+  const uint16_t target = 0x88;
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  EXPECT_EQ(16, maze.flood(target, CLOSED_MASK));
+  EXPECT_EQ(EAST, maze.direction(0));
+  // turns at 500 mm/s take 283 ms a cell, so the long way round is quicker
+  maze.setMotionProfile({180, 500, 20000, 5000, 4000});
+  maze.setFloodType(Maze::TIME_FLOOD);
+  maze.flood(target, CLOSED_MASK);
+  EXPECT_EQ(NORTH, maze.direction(0));
+  EXPECT_EQ(30, stepsToTarget(maze, 0));
+}
+
+TEST_F(TEST_31_TimeFlood, 13_FasterProfileIsQuicker) {
+  Maze maze(16);
+  loadCorpusMaze(maze, 0);
+  maze.setFloodType(Maze::TIME_FLOOD);
+  uint16_t slow = maze.flood(maze.goal(), OPEN_MASK);
+  maze.setMotionProfile(HIGH_SPEED_MOTION);
+  EXPECT_DOUBLE_EQ(2000, maze.getMotionProfile().turnSpeed);
+  EXPECT_LT(maze.flood(maze.goal(), OPEN_MASK), slow);
+}
+
+TEST_F(TEST_31_TimeFlood, 14_WorkspaceAndResultMatchTheMaze) {
+  FloodWorkspace workspace;
+  FloodResult result;
+  Maze maze(16);
+  maze.setFloodType(Maze::TIME_FLOOD);
+  for (int i = 0; i < mazeCount; i += 5) {
+    loadCorpusMaze(maze, i);
+    uint16_t cost = maze.flood(maze.goal(), OPEN_MASK);
+    ASSERT_EQ(cost, maze.flood(maze.goal(), OPEN_MASK, result, &workspace));
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(maze.cost(cell), result.cost(cell)) << mazeList[i].title;
+      ASSERT_EQ(maze.direction(cell), result.direction(cell)) << mazeList[i].title;
+    }
+  }
+}
+
+TEST_F(TEST_31_TimeFlood, 15_GoalAreaFloodEndsInTheGoal) {
+  Maze maze(16);
+  maze.setFloodType(Maze::TIME_FLOOD);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.clearGoalArea();
+  for (int cell : {0x77, 0x78, 0x87, 0x88}) {
+    maze.addToGoalArea(cell);
+  }
+  maze.floodGoalArea(OPEN_MASK);
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    if (maze.goalContains(cell)) {
+      ASSERT_EQ(0, maze.cost(cell));
+    } else if (maze.cost(cell) != MAX_COST) {
+      ASSERT_TRUE(maze.goalContains(maze.goalCellFor(cell))) << cell;
+    }
+  }
+}
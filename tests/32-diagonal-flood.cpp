@@ -0,0 +1,259 @@
+// Tests for the diagonal flood and the commands made from its routes.
+//
+// The costs must be exact runlength costs, so never more than the
+// runlength flood gives, and the commands made straight from a route must
+// be the ones the diagonal compiler makes from the path string of the same
+// route.
+
+#include <string>
+#include <vector>
+
+#include "commandnames.h"
+#include "compiler.h"
+#include "corpus-mazes.h"
+#include "diagonalflood.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+using MazeLib::Direction;
+
+class TEST_32_DiagonalFlood : public ::testing::Test {
+ protected:
+  static const int BUF = 256;
+
+  /// the route headings for a path string that starts heading north
+  static MazeLib::Directions headingsFor(const std::string &path) {
+    MazeLib::Directions headings;
+    int moving = MazeLib::North;
+    for (char c : path.substr(1)) {
+      if (c == 'R') {
+        headings.push_back(Direction(moving + 1));
+        moving += 2;
+      } else if (c == 'L') {
+        headings.push_back(Direction(moving - 1));
+        moving -= 2;
+      } else {
+        headings.push_back(Direction(moving));
+      }
+    }
+    return headings;
+  }
+
+  /// the path string for a route, with a letter for each cell as the path finder would write it
+  static std::string pathFor(const MazeLib::Directions &route) {
+    std::string path = "B";
+    int moving = route.front();
+    for (size_t i = 0; i < route.size(); i++) {
+      if (i + 1 == route.size()) {
+        path += 'S';
+      } else if (route[i].isOrthogonal()) {
+        path += 'F';
+      } else {
+        path += route[i] - Direction(moving) == 1 ? 'R' : 'L';
+        moving = route[i] - Direction(moving) == 1 ? moving + 2 : moving - 2;
+      }
+    }
+    return path;
+  }
+
+  static bool hasError(const uint8_t *commands) {
+    for (int i = 0; i < BUF && commands[i] != CMD_STOP; i++) {
+      if (isErr(commands[i])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void expectSameCommands(const uint8_t *expected, const uint8_t *actual, const std::string &path) {
+    for (int i = 0; i < BUF; i++) {
+      ASSERT_EQ(expected[i], actual[i]) << path << " command " << i;
+      if (expected[i] == CMD_STOP) {
+        break;
+      }
+    }
+  }
+
+  /// the number of steps taken following the directions from the cell to a cell of cost zero, or -1
+  static int stepsToTarget(const Maze &maze, uint16_t cell) {
+    for (int steps = 0; steps <= maze.numCells(); steps++) {
+      if (maze.cost(cell) == 0) {
+        return steps;
+      }
+      if (maze.direction(cell) == INVALID_DIRECTION) {
+        return -1;
+      }
+      cell = maze.neighbour(cell, maze.direction(cell));
+    }
+    return -1;
+  }
+};
+
+TEST_F(TEST_32_DiagonalFlood, 00_RouteCommandsForSimplePaths) {
+  uint8_t commands[BUF] = {};
+  makeRouteCommands(headingsFor("BS"), BUF, commands);
+  EXPECT_EQ(CMD_STOP, commands[0]);
+  makeRouteCommands(headingsFor("BFFS"), BUF, commands);
+  EXPECT_EQ(FWD2, commands[0]);
+  EXPECT_EQ(CMD_STOP, commands[1]);
+  const uint8_t diagonal[] = {FWD2, SD45R, DIA4, DD90L, DIA2, DS45R, FWD3, CMD_STOP};
+  makeRouteCommands(headingsFor("BFFRLRLLRFFS"), BUF, commands);
+  expectSameCommands(diagonal, commands, "BFFRLRLLRFFS");
+}
+
+TEST_F(TEST_32_DiagonalFlood, 01_RouteCommandsMatchTheDiagonalCompiler) {
+  const char *paths[] = {
+      "BFRS", "BFLS", "BFRFS", "BFFRLS", "BFFRLFS", "BFFFFRRFFFS", "BFFFFLLS", "BFRRLFS", "BFFRRLLFFS",
+      "BFFRLRLRLRFS", "BFLRLRRLRLFFS", "BFFRLLRRLFFS", "BFRLRLRLLFFFRS", "BFLLRFRRFFS", "BFRLLRRLS",
+      "BFFLRRLS", "BFRRFLLS", "BFLRRLLRS", "BFFRLRRFFFFLRLS",
+  };
+  for (const char *path : paths) {
+    uint8_t expected[BUF] = {};
+    uint8_t actual[BUF] = {};
+    makeDiagonalCommands(path, BUF, expected);
+    ASSERT_FALSE(hasError(expected)) << path;
+    makeRouteCommands(headingsFor(path), BUF, actual);
+    expectSameCommands(expected, actual, path);
+    EXPECT_EQ(path, pathFor(headingsFor(path)));
+  }
+}
+
+TEST_F(TEST_32_DiagonalFlood, 02_LongRunsAreAnError) {
+  uint8_t commands[BUF] = {};
+  makeRouteCommands(headingsFor("B" + std::string(33, 'F') + "S"), BUF, commands);
+  EXPECT_EQ(CMD_ERROR, commands[0]);
+  EXPECT_EQ(CMD_STOP, commands[1]);
+}
+
+TEST_F(TEST_32_DiagonalFlood, 03_RoutesThatEndInATurnAreAnError) {
+  const Direction north(MazeLib::North);
+  const Direction northEast(MazeLib::NorthEast);
+  const Direction east(MazeLib::East);
+  const Direction south(MazeLib::South);
+  const MazeLib::Directions routes[] = {
+      {north, east},
+      {north, north, east, east},
+      {north, northEast, east, south},
+  };
+  for (const MazeLib::Directions &route : routes) {
+    uint8_t commands[BUF] = {};
+    makeRouteCommands(route, BUF, commands);
+    EXPECT_EQ(CMD_ERROR, commands[0]);
+    EXPECT_EQ(CMD_STOP, commands[1]);
+  }
+}
+
+TEST_F(TEST_32_DiagonalFlood, 10_CostsAreNeverMoreThanTheRunLengthFlood) {
+  Maze maze(16);
+  Maze runLength(16);
+  int cheaper = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    loadCorpusMaze(runLength, i);
+    runLength.setFloodType(Maze::RUNLENGTH_FLOOD);
+    maze.setFloodType(Maze::DIAGONAL_FLOOD);
+    for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+      uint16_t goal = maze.goal();
+      uint16_t cost = maze.flood(goal, mask);
+      uint16_t runLengthCost = runLength.flood(goal, mask);
+      ASSERT_LE(cost, runLengthCost) << mazeList[i].title;
+      cheaper += cost < runLengthCost;
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        ASSERT_EQ(maze.cost(cell) == MAX_COST, runLength.cost(cell) == MAX_COST) << mazeList[i].title;
+        if (maze.cost(cell) == MAX_COST) {
+          ASSERT_EQ(INVALID_DIRECTION, maze.direction(cell));
+          continue;
+        }
+        ASSERT_GE(stepsToTarget(maze, cell), 0) << mazeList[i].title << " cell " << cell;
+      }
+    }
+  }
+  // the runlength flood keeps one run for each cell and misses some cheaper routes
+  EXPECT_GT(cheaper, 0);
+}
+
+TEST_F(TEST_32_DiagonalFlood, 11_RoutesMatchTheDirectionsAndTheCompiler) {
+  Maze maze(16);
+  FloodWorkspace workspace;
+  maze.setFloodWorkspace(&workspace);
+  maze.setFloodType(Maze::DIAGONAL_FLOOD);
+  int compared = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t cost = maze.flood(maze.goal(), OPEN_MASK);
+    const DiagonalFlood &flood = workspace.diagonalFlood();
+    EXPECT_EQ(cost, flood.routeCost(0)) << mazeList[i].title;
+    MazeLib::Directions route = flood.route(0);
+    ASSERT_GE(route.size(), 2u) << mazeList[i].title;
+    // the first heading leaves cell 0 the way the directions go
+    EXPECT_EQ(2 * maze.direction(0), (int)route.front()) << mazeList[i].title;
+    std::string path = pathFor(route);
+    uint8_t expected[BUF] = {};
+    uint8_t actual[BUF] = {};
+    makeDiagonalCommands(path.c_str(), BUF, expected);
+    if (hasError(expected)) {
+      continue;
+    }
+    makeRouteCommands(route, BUF, actual);
+    expectSameCommands(expected, actual, mazeList[i].title);
+    compared++;
+  }
+  EXPECT_GT(compared, mazeCount / 2);
+}
+
+TEST_F(TEST_32_DiagonalFlood, 12_StaircaseIsOneDiagonal) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      maze.setWall(cell, dir);
+    }
+  }
+  uint16_t cell = 0;
+  for (int i = 0; i < 8; i++) {
+    maze.clearWall(cell, EAST);
+    cell = maze.neighbour(cell, EAST);
+    maze.clearWall(cell, NORTH);
+    cell = maze.neighbour(cell, NORTH);
+  }
+  DiagonalFlood flood;
+  std::vector<uint16_t> cost(maze.numCells());
+  std::vector<uint8_t> direction(maze.numCells());
+  const uint16_t target = 0x88;
+  flood.flood(maze, &target, 1, CLOSED_MASK, cost.data(), direction.data());
+  MazeLib::Directions route = flood.route(0);
+  ASSERT_EQ(17u, route.size());
+  uint8_t commands[BUF] = {};
+  makeRouteCommands(route, BUF, commands);
+  const uint8_t expected[] = {FWD1, SD45L, DIA15, DS45L, FWD1, CMD_STOP};
+  expectSameCommands(expected, commands, "staircase");
+  // the half cell into the target, one run of 15 diagonals and the turn between them. The half cell out of
+  // the start and its turn are not counted.
+  const RunLengthCostTables &tables = maze.runLengthCosts();
+  uint32_t expectedCost = tables.ortho[1] + RunLengthCost::TURN_PENALTY;
+  for (int i = 1; i <= 15; i++) {
+    expectedCost += tables.diag[i];
+  }
+  EXPECT_EQ(expectedCost, flood.routeCost(0));
+  EXPECT_EQ(expectedCost, cost[0]);
+}
+
+TEST_F(TEST_32_DiagonalFlood, 13_WorkspaceAndResultMatchTheMaze) {
+  FloodWorkspace workspace;
+  FloodResult result;
+  Maze maze(16);
+  maze.setFloodType(Maze::DIAGONAL_FLOOD);
+  for (int i = 0; i < mazeCount; i += 5) {
+    loadCorpusMaze(maze, i);
+    uint16_t cost = maze.flood(maze.goal(), OPEN_MASK);
+    ASSERT_EQ(cost, maze.flood(maze.goal(), OPEN_MASK, result, &workspace));
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      ASSERT_EQ(maze.cost(cell), result.cost(cell)) << mazeList[i].title;
+      ASSERT_EQ(maze.direction(cell), result.direction(cell)) << mazeList[i].title;
+    }
+  }
+}
@@ -0,0 +1,286 @@
+// Tests for the corridor graph.
+//
+// Manhattan floods on the graph must leave exactly the costs and directions
+// of a full flood, routes must cost the same as a search over every cell
+// and heading, and the graph must only be rebuilt when the exits change.
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "corridorgraph.h"
+#include "floodengine.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_33_CorridorGraph : public ::testing::Test {
+ protected:
+  CorridorGraph graph;
+
+  /// a 16x16 maze with every wall present except along the given moves from the cell
+  static void openRoute(Maze &maze, uint16_t cell, const std::vector<uint8_t> &moves) {
+    for (uint8_t dir : moves) {
+      maze.clearWall(cell, dir);
+      cell = maze.neighbour(cell, dir);
+    }
+  }
+
+  static void closeEverything(Maze &maze) {
+    maze.resetToEmptyMaze();
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+        maze.setWall(cell, dir);
+      }
+    }
+  }
+
+  /// the weighted route cost found by Dijkstra over every cell and the heading it was entered with
+  static uint32_t stateSearchCost(const Maze &maze, uint16_t start, uint16_t target, uint8_t mask,
+                                  uint16_t cornerWeight) {
+    const int headings = 5;
+    std::vector<uint32_t> cost(maze.numCells() * headings, UINT32_MAX);
+    using Entry = std::pair<uint32_t, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    cost[start * headings + 4] = 0;
+    queue.push({0, start * headings + 4});
+    while (!queue.empty()) {
+      Entry entry = queue.top();
+      queue.pop();
+      if (entry.first != cost[entry.second]) {
+        continue;
+      }
+      auto cell = (uint16_t)(entry.second / headings);
+      int heading = entry.second % headings;
+      if (cell == target) {
+        return entry.first;
+      }
+      for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+        if (!maze.hasExit(cell, dir, mask)) {
+          continue;
+        }
+        uint32_t step = (heading == 4 || heading == dir) ? WeightedCost::AHEAD_COST : cornerWeight;
+        int next = maze.neighbour(cell, dir) * headings + dir;
+        if (entry.first + step < cost[next]) {
+          cost[next] = entry.first + step;
+          queue.push({cost[next], next});
+        }
+      }
+    }
+    return MAX_COST;
+  }
+
+  /// the weighted cost of following the route from the start, or MAX_COST if it goes through a wall
+  static uint32_t routeCost(const Maze &maze, uint16_t start, uint16_t target, uint8_t mask, uint16_t cornerWeight,
+                            const std::vector<uint8_t> &route) {
+    uint32_t cost = 0;
+    int heading = 4;
+    uint16_t cell = start;
+    for (uint8_t dir : route) {
+      if (!maze.hasExit(cell, dir, mask)) {
+        return MAX_COST;
+      }
+      cost += (heading == 4 || heading == dir) ? WeightedCost::AHEAD_COST : cornerWeight;
+      heading = dir;
+      cell = maze.neighbour(cell, dir);
+    }
+    return cell == target ? cost : MAX_COST;
+  }
+};
+
+TEST_F(TEST_33_CorridorGraph, 00_CorridorIsOneEdge) {
+  Maze maze(16);
+  closeEverything(maze);
+  openRoute(maze, 0, {NORTH, NORTH, NORTH, EAST, EAST});
+  graph.update(maze, CLOSED_MASK);
+  EXPECT_EQ(256, graph.cellCount());
+  // every closed cell is a node, as are both ends of the corridor
+  EXPECT_EQ(256 - 4, graph.nodeCount());
+  EXPECT_EQ(1, graph.edgeCount());
+  EXPECT_NE((uint16_t)CorridorGraph::NO_NODE, graph.node(0));
+  EXPECT_EQ((uint16_t)CorridorGraph::NO_NODE, graph.node(0x03));
+  EXPECT_EQ((uint16_t)CorridorGraph::NO_NODE, graph.node(0x13));
+  EXPECT_NE((uint16_t)CorridorGraph::NO_NODE, graph.node(0x23));
+  std::vector<uint8_t> route;
+  EXPECT_EQ(2u * 4 + 10u, graph.route(maze, 0, 0x23, CLOSED_MASK, 10, route));
+  EXPECT_EQ(std::vector<uint8_t>({NORTH, NORTH, NORTH, EAST, EAST}), route);
+  EXPECT_EQ(2u + 10u, graph.route(maze, 0x13, 0x02, CLOSED_MASK, 10, route));
+  EXPECT_EQ(std::vector<uint8_t>({WEST, SOUTH}), route);
+}
+
+TEST_F(TEST_33_CorridorGraph, 01_RingWithoutJunctionGetsANode) {
+  Maze maze(16);
+  closeEverything(maze);
+  openRoute(maze, 0, {NORTH, EAST, SOUTH, WEST});
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setCorridorGraph(&graph);
+  EXPECT_EQ(2, maze.flood(0x11, CLOSED_MASK));
+  EXPECT_EQ(1, graph.edgeCount());
+  EXPECT_EQ(256 - 3, graph.nodeCount());
+  EXPECT_EQ(1, maze.cost(0x01));
+  EXPECT_EQ(1, maze.cost(0x10));
+  EXPECT_EQ(MAX_COST, maze.cost(0x02));
+  std::vector<uint8_t> route;
+  EXPECT_EQ(2u + 5u, graph.route(maze, 0x01, 0x10, CLOSED_MASK, 5, route));
+  EXPECT_EQ(2u, route.size());
+}
+
+TEST_F(TEST_33_CorridorGraph, 02_CorpusShrinks) {
+  long cells = 0;
+  long nodes = 0;
+  Maze maze(16);
+  maze.setCorridorGraph(&graph);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    graph.update(maze, CLOSED_MASK);
+    ASSERT_LT(graph.nodeCount(), graph.cellCount()) << mazeList[i].title;
+    cells += graph.cellCount();
+    nodes += graph.nodeCount();
+  }
+  // only about 60% of the corpus cells have two exits so there are about 2.5 cells to each node
+  EXPECT_GT(cells * 10, nodes * 25);
+}
+
+TEST_F(TEST_33_CorridorGraph, 10_ManhattanFloodMatchesAFullFlood) {
+  Maze maze(16);
+  Maze reference(16);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  reference.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setCorridorGraph(&graph);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    loadCorpusMaze(reference, i);
+    // the goal, then a cell inside a corridor
+    std::vector<uint16_t> targets = {maze.goal()};
+    graph.update(maze, OPEN_MASK);
+    for (uint16_t cell = 1; cell < maze.numCells(); cell++) {
+      if (graph.node(cell) == CorridorGraph::NO_NODE) {
+        targets.push_back(cell);
+        break;
+      }
+    }
+    for (uint16_t target : targets) {
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        ASSERT_EQ(reference.flood(target, mask), maze.flood(target, mask)) << mazeList[i].title;
+        for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+          ASSERT_EQ(reference.cost(cell), maze.cost(cell)) << mazeList[i].title << " cell " << cell;
+          ASSERT_EQ(reference.direction(cell), maze.direction(cell)) << mazeList[i].title;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_33_CorridorGraph, 11_RoutesMatchAStateSearch) {
+  Maze maze(16);
+  maze.setCorridorGraph(&graph);
+  std::vector<uint8_t> route;
+  for (int i = 0; i < mazeCount; i += 3) {
+    loadCorpusMaze(maze, i);
+    const uint16_t last = (uint16_t)(maze.numCells() - 1);
+    const uint16_t pairs[][2] = {
+        {0, maze.goal()}, {maze.goal(), 0}, {37, last}, {last, 100}, {5, 6}, {18, 19}, {60, 90},
+    };
+    for (auto &pair : pairs) {
+      for (uint16_t cornerWeight : {2, 3, 10}) {
+        uint32_t expected = stateSearchCost(maze, pair[0], pair[1], CLOSED_MASK, cornerWeight);
+        uint32_t cost = graph.route(maze, pair[0], pair[1], CLOSED_MASK, cornerWeight, route);
+        ASSERT_EQ(expected, cost) << mazeList[i].title << " from " << pair[0] << " to " << pair[1];
+        if (cost != MAX_COST) {
+          uint32_t followed = routeCost(maze, pair[0], pair[1], CLOSED_MASK, cornerWeight, route);
+          ASSERT_EQ(cost, followed) << mazeList[i].title;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TEST_33_CorridorGraph, 20_OnlyChangedExitsRebuild) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setCorridorGraph(&graph);
+  maze.flood(0x77, OPEN_MASK);
+  maze.flood(0x77, OPEN_MASK);
+  EXPECT_EQ(1u, graph.counters().builds);
+  EXPECT_EQ(1u, graph.counters().reuses);
+  // seeing that there are no walls changes nothing when unseen walls are open
+  maze.updateMap(0x22, 0x00);
+  EXPECT_FALSE(graph.isValid());
+  maze.flood(0x77, OPEN_MASK);
+  EXPECT_EQ(1u, graph.counters().builds);
+  EXPECT_TRUE(graph.isValid());
+  // a wall that is seen is a real change
+  maze.updateMap(0x23, 0x01);
+  maze.flood(0x77, OPEN_MASK);
+  EXPECT_EQ(2u, graph.counters().builds);
+  // so is another mask
+  maze.flood(0x77, CLOSED_MASK);
+  EXPECT_EQ(3u, graph.counters().builds);
+  // and starting again
+  maze.resetToEmptyMaze();
+  EXPECT_FALSE(graph.isValid());
+  maze.flood(0x77, CLOSED_MASK);
+  EXPECT_EQ(4u, graph.counters().builds);
+}
+
+TEST_F(TEST_33_CorridorGraph, 21_FloodsStayExactWhileExploring) {
+  Maze realMaze(16);
+  realMaze.copyMazeFromFileData(japan2007ef, 256);
+  Maze map(16);
+  map.resetToEmptyMaze();
+  map.setFloodType(Maze::MANHATTAN_FLOOD);
+  map.setCorridorGraph(&graph);
+  Maze reference(16);
+  reference.setFloodType(Maze::MANHATTAN_FLOOD);
+  uint8_t walls[256];
+  for (uint16_t cell = 0; cell < map.numCells(); cell += 7) {
+    map.updateMap(cell, realMaze.walls(cell));
+    uint16_t cost = map.flood(0x77, CLOSED_MASK);
+    map.save(walls);
+    reference.load(walls);
+    ASSERT_EQ(reference.flood(0x77, CLOSED_MASK), cost) << "cell " << cell;
+    for (uint16_t i = 0; i < map.numCells(); i++) {
+      ASSERT_EQ(reference.cost(i), map.cost(i)) << "after cell " << cell;
+      ASSERT_EQ(reference.direction(i), map.direction(i)) << "after cell " << cell;
+    }
+  }
+}
+
+TEST_F(TEST_33_CorridorGraph, 22_TestForSolutionKeepsTheOpenMask) {
+  Maze realMaze(16);
+  realMaze.copyMazeFromFileData(japan2007ef, 256);
+  Maze map(16);
+  map.resetToEmptyMaze();
+  map.setFloodType(Maze::MANHATTAN_FLOOD);
+  map.setCorridorGraph(&graph);
+  // otherwise both mazes are flooded in one pass of BitFlood and the graph is not used at all
+  map.setBitParallelFlood(false);
+  // the same walls flooded with the open mask alone
+  CorridorGraph openGraph;
+  Maze openMap(16);
+  openMap.resetToEmptyMaze();
+  openMap.setFloodType(Maze::MANHATTAN_FLOOD);
+  openMap.setCorridorGraph(&openGraph);
+  Maze reference(16);
+  reference.resetToEmptyMaze();
+  reference.setFloodType(Maze::MANHATTAN_FLOOD);
+  uint32_t tests = 0;
+  for (uint16_t cell = 0; cell < map.numCells(); cell += 5) {
+    map.updateMap(cell, realMaze.walls(cell));
+    openMap.updateMap(cell, realMaze.walls(cell));
+    reference.updateMap(cell, realMaze.walls(cell));
+    ASSERT_EQ(reference.testForSolution(), map.testForSolution()) << "cell " << cell;
+    ASSERT_EQ(reference.closedMazeCost(), map.closedMazeCost()) << "cell " << cell;
+    ASSERT_EQ(reference.openMazeCost(), map.openMazeCost()) << "cell " << cell;
+    openMap.flood(map.goal(), OPEN_MASK);
+    tests++;
+  }
+  // the closed flood of each test goes round the graph, which is only rebuilt when the open exits change
+  EXPECT_EQ(openGraph.counters().builds, graph.counters().builds);
+  EXPECT_EQ(openGraph.counters().reuses, graph.counters().reuses);
+  EXPECT_EQ(tests, graph.counters().builds + graph.counters().reuses);
+}
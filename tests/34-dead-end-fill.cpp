@@ -0,0 +1,282 @@
+// Tests for the dead-end fill.
+//
+// Filling must take out every dead end and pocket but nothing that can be
+// on a route, the floods must give the other cells the same costs as
+// before, and a search must keep the fill up to date without starting it
+// again from scratch. Floods into a FloodResult must never change the fill.
+
+#include <thread>
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "deadendfill.h"
+#include "floodresult.h"
+#include "floodworkspace.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+#include "mazesearcher.h"
+
+#include "gtest/gtest.h"
+
+class TEST_34_DeadEndFill : public ::testing::Test {
+ protected:
+  DeadEndFill fill;
+
+  static void closeEverything(Maze &maze) {
+    maze.resetToEmptyMaze();
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+        maze.setWall(cell, dir);
+      }
+    }
+  }
+
+  static void openRoute(Maze &maze, uint16_t cell, const std::vector<uint8_t> &moves) {
+    for (uint8_t dir : moves) {
+      maze.clearWall(cell, dir);
+      cell = maze.neighbour(cell, dir);
+    }
+  }
+
+  static int reachedCells(const Maze &maze) {
+    int reached = 0;
+    for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+      reached += maze.cost(cell) != MAX_COST;
+    }
+    return reached;
+  }
+};
+
+TEST_F(TEST_34_DeadEndFill, 00_PocketsAreFilledUpToTheGoal) {
+  Maze maze(16);
+  closeEverything(maze);
+  // from the start up two cells and east to the goal, with a branch two cells long east from cell 0x01
+  openRoute(maze, 0, {NORTH, NORTH, EAST, EAST});
+  openRoute(maze, 0x01, {EAST, EAST});
+  maze.setGoal(0x22);
+  maze.setDeadEndFill(&fill);
+  fill.update(maze, CLOSED_MASK);
+  EXPECT_TRUE(fill.isValid());
+  for (uint16_t cell : {0x00, 0x01, 0x02, 0x12, 0x22}) {
+    EXPECT_FALSE(fill.isFilled(cell)) << cell;
+  }
+  // the whole branch is filled, as is every closed cell
+  EXPECT_TRUE(fill.isFilled(0x11));
+  EXPECT_TRUE(fill.isFilled(0x21));
+  EXPECT_EQ(256 - 5, fill.filledCount());
+  EXPECT_EQ(WALL_NORTH | WALL_EAST | WALL_SOUTH | WALL_WEST, fill.walls()[0x11] & 0x0F);
+  // and the route is walled off from it
+  EXPECT_EQ(WALL_EAST, fill.walls()[0x01] & WALL_EAST);
+  EXPECT_EQ(0, maze.getXWalls(0x01) & WALL_EAST);
+}
+
+TEST_F(TEST_34_DeadEndFill, 01_LoopsAreNeverFilled) {
+  Maze maze(16);
+  closeEverything(maze);
+  openRoute(maze, 0x44, {NORTH, EAST, SOUTH, WEST});
+  openRoute(maze, 0x54, {EAST, EAST});
+  maze.setDeadEndFill(&fill);
+  fill.update(maze, CLOSED_MASK);
+  for (uint16_t cell : {0x44, 0x45, 0x54, 0x55}) {
+    EXPECT_FALSE(fill.isFilled(cell)) << cell;
+  }
+  EXPECT_TRUE(fill.isFilled(0x64));
+  EXPECT_TRUE(fill.isFilled(0x74));
+  // the start cell is always kept even when it is walled in
+  EXPECT_FALSE(fill.isFilled(0));
+  fill.keep(0x74);
+  EXPECT_FALSE(fill.isValid());
+  fill.update(maze, CLOSED_MASK);
+  EXPECT_FALSE(fill.isFilled(0x64));
+  EXPECT_EQ(2u, fill.counters().fills);
+}
+
+TEST_F(TEST_34_DeadEndFill, 10_FloodsSkipFilledCells) {
+  Maze maze(16);
+  Maze reference(16);
+  maze.setDeadEndFill(&fill);
+  int skipped = 0;
+  const Maze::FloodType types[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                   Maze::DIRECTION_FLOOD};
+  // the runlength flood with the linear queue settles a cell when it is first reached, and which
+  // of two equal costs gets there first depends on where the filled cells sat in the queue
+  maze.setQueueType(Maze::HEAP_QUEUE);
+  reference.setQueueType(Maze::HEAP_QUEUE);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    loadCorpusMaze(reference, i);
+    for (Maze::FloodType type : types) {
+      maze.setFloodType(type);
+      reference.setFloodType(type);
+      ASSERT_EQ(reference.flood(maze.goal(), OPEN_MASK), maze.flood(maze.goal(), OPEN_MASK)) << mazeList[i].title;
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        if (fill.isFilled(cell)) {
+          ASSERT_EQ(MAX_COST, maze.cost(cell));
+          ASSERT_EQ(INVALID_DIRECTION, maze.direction(cell)) << mazeList[i].title << " flood " << type;
+          continue;
+        }
+        ASSERT_EQ(reference.cost(cell), maze.cost(cell)) << mazeList[i].title << " flood " << type << " cell " << cell;
+        // a route found by the direction flood may run through another cell of the same cost
+        if (cell != maze.goal() && type != Maze::DIRECTION_FLOOD) {
+          ASSERT_EQ(reference.direction(cell), maze.direction(cell)) << mazeList[i].title << " flood " << type;
+        }
+      }
+      ASSERT_LE(reachedCells(maze), reachedCells(reference)) << mazeList[i].title;
+      skipped += reachedCells(reference) - reachedCells(maze);
+    }
+  }
+  EXPECT_GT(skipped, 0);
+}
+
+TEST_F(TEST_34_DeadEndFill, 11_FilledTargetFloodsEveryCell) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setDeadEndFill(&fill);
+  maze.setFloodType(Maze::WEIGHTED_FLOOD);
+  fill.update(maze, OPEN_MASK);
+  uint16_t target = 0;
+  while (!fill.isFilled(target)) {
+    target++;
+  }
+  Maze reference(16);
+  reference.copyMazeFromFileData(japan2007ef, 256);
+  reference.setFloodType(Maze::WEIGHTED_FLOOD);
+  FloodResult result;
+  ASSERT_EQ(reference.flood(target, OPEN_MASK), maze.flood(target, OPEN_MASK, result, nullptr));
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    ASSERT_EQ(reference.cost(cell), result.cost(cell));
+  }
+}
+
+TEST_F(TEST_34_DeadEndFill, 12_ResultFloodsLeaveTheFillAlone) {
+  const int threadCount = 4;
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  maze.setDeadEndFill(&fill);
+  const Maze &reader = maze;
+  Maze reference(16);
+  reference.copyMazeFromFileData(japan2007ef, 256);
+  FloodResult unfilled[2];
+  reference.flood(0x77, OPEN_MASK, unfilled[0]);
+  reference.flood(0x77, CLOSED_MASK, unfilled[1]);
+  std::vector<FloodResult> results(threadCount);
+  std::vector<FloodWorkspace> workspaces(threadCount);
+  auto floodOnThreads = [&]() {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+      threads.emplace_back([&, t]() {
+        for (int repeat = 0; repeat < 20; repeat++) {
+          reader.flood(0x77, t % 2 ? CLOSED_MASK : OPEN_MASK, results[t], &workspaces[t]);
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  };
+  // a fill that has not been made is not made by these floods, and they reach every cell
+  floodOnThreads();
+  EXPECT_FALSE(fill.isValid());
+  EXPECT_EQ(0u, fill.counters().fills);
+  for (int t = 0; t < threadCount; t++) {
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      ASSERT_EQ(unfilled[t % 2].cost(cell), results[t].cost(cell)) << "thread " << t;
+    }
+  }
+  // once a flood into the maze has made the fill, floods with its mask skip the filled cells and the rest
+  // flood every cell without making it again
+  maze.flood(0x77, OPEN_MASK);
+  ASSERT_TRUE(fill.isValid());
+  ASSERT_GT(fill.filledCount(), 0);
+  floodOnThreads();
+  EXPECT_TRUE(fill.isValid());
+  EXPECT_EQ(OPEN_MASK, fill.mask());
+  EXPECT_EQ(1u, fill.counters().fills);
+  EXPECT_EQ(0u, fill.counters().incrementalUpdates);
+  for (int t = 0; t < threadCount; t++) {
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      const uint16_t expected = t % 2 ? unfilled[1].cost(cell) : maze.cost(cell);
+      ASSERT_EQ(expected, results[t].cost(cell)) << "thread " << t << " cell " << cell;
+    }
+  }
+}
+
+TEST_F(TEST_34_DeadEndFill, 20_ClosingWallsUpdatesInPlace) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setDeadEndFill(&fill);
+  fill.update(maze, OPEN_MASK);
+  EXPECT_EQ(0, fill.filledCount());
+  // the north west corner cell has walls to the north and west already
+  maze.updateMap(0x0F, WALL_EAST);
+  fill.update(maze, OPEN_MASK);
+  EXPECT_EQ(1u, fill.counters().fills);
+  EXPECT_EQ(1u, fill.counters().incrementalUpdates);
+  EXPECT_TRUE(fill.isFilled(0x0F));
+  EXPECT_EQ(1, fill.filledCount());
+  // the other mask starts again, and there the unseen walls make a dead end of every cell
+  // but the start and the four goal cells
+  fill.update(maze, CLOSED_MASK);
+  EXPECT_EQ(2u, fill.counters().fills);
+  EXPECT_EQ(256 - 5, fill.filledCount());
+  // seeing that a wall is absent under the closed mask can empty filled cells
+  maze.updateMap(0x01, 0x00);
+  fill.update(maze, CLOSED_MASK);
+  EXPECT_EQ(3u, fill.counters().fills);
+}
+
+TEST_F(TEST_34_DeadEndFill, 21_SearchKeepsTheFillUpToDate) {
+  const uint16_t goal = 0x77;
+  for (const uint8_t *mazeData : {japan2007ef, uk2010f}) {
+    Maze realMaze(16);
+    realMaze.copyMazeFromFileData(mazeData, 256);
+    MazeSearcher plain;
+    plain.setRealMaze(&realMaze);
+    MazeSearcher filled;
+    filled.setRealMaze(&realMaze);
+    filled.setDeadEndFill(true);
+    int plainSteps = plain.searchTo(goal);
+    int steps = filled.searchTo(goal);
+    ASSERT_GT(steps, 0);
+    // the floods give the mouse the same directions so it takes the same route
+    EXPECT_EQ(plainSteps, steps);
+    EXPECT_EQ(plain.searchTo(0), filled.searchTo(0));
+    const DeadEndFill *fill = filled.deadEndFill();
+    EXPECT_EQ(1u, fill->counters().fills);
+    EXPECT_GT(fill->counters().incrementalUpdates, 0u);
+    EXPECT_GT(fill->filledCount(), 0);
+    // the goal was released when the mouse left it so a fresh fill of the map fills the same cells
+    DeadEndFill fresh;
+    fresh.update(*filled.map(), OPEN_MASK);
+    for (uint16_t cell = 0; cell < 256; cell++) {
+      ASSERT_EQ(fresh.isFilled(cell), fill->isFilled(cell)) << cell;
+    }
+  }
+}
+
+TEST_F(TEST_34_DeadEndFill, 22_TestForSolutionUpdatesInPlace) {
+  Maze realMaze(16);
+  realMaze.copyMazeFromFileData(japan2007ef, 256);
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  maze.setDeadEndFill(&fill);
+  Maze reference(16);
+  reference.resetToEmptyMaze();
+  FloodResult closed;
+  int calls = 0;
+  // reveal the cells one at a time as a search would, testing for a solution after each
+  for (uint16_t cell = 0; cell < 256; cell += 5) {
+    maze.updateMap(cell, realMaze.walls(cell));
+    reference.updateMap(cell, realMaze.walls(cell));
+    const bool solved = calls % 2 ? maze.testForSolution(closed) : maze.testForSolution();
+    ASSERT_EQ(reference.testForSolution(), solved) << cell;
+    ASSERT_EQ(reference.closedMazeCost(), maze.closedMazeCost()) << cell;
+    ASSERT_EQ(reference.openMazeCost(), maze.openMazeCost()) << cell;
+    calls++;
+  }
+  // the fill stays with the open mask, so only the first test had to make it from scratch
+  EXPECT_EQ(OPEN_MASK, fill.mask());
+  EXPECT_EQ(1u, fill.counters().fills);
+  EXPECT_EQ((uint32_t)calls - 1, fill.counters().incrementalUpdates);
+}
@@ -0,0 +1,265 @@
+// Tests for the hierarchical planner.
+//
+// Routes must follow open exits to the target, be found whenever the target
+// can be reached, and be no shorter than the manhattan flood says they can
+// be. In a perfect maze there is only one route so they must match exactly.
+// A wall change must rebuild only the clusters it touches.
+
+#include <random>
+#include <vector>
+
+#include "corpus-mazes.h"
+#include "hierarchicalplanner.h"
+#include "largemaze.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_35_HierarchicalPlanner : public ::testing::Test {
+ protected:
+  HierarchicalPlanner<> planner{8};
+
+  /// carve a perfect maze with a seeded depth-first walk into a maze with every wall present
+  static void makePerfectMaze(LargeMaze<> &maze, uint32_t seed) {
+    const uint32_t width = maze.width();
+    for (uint32_t cell = 0; cell < maze.numCells(); cell++) {
+      for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+        maze.setWall(cell, direction);
+      }
+    }
+    std::mt19937 random(seed);
+    std::vector<bool> carved(maze.numCells(), false);
+    std::vector<uint32_t> stack = {0};
+    carved[0] = true;
+    while (!stack.empty()) {
+      uint32_t cell = stack.back();
+      uint8_t choices[4];
+      int count = 0;
+      if (maze.row(cell) + 1 < width && !carved[cell + 1]) {
+        choices[count++] = NORTH;
+      }
+      if (maze.col(cell) + 1 < width && !carved[cell + width]) {
+        choices[count++] = EAST;
+      }
+      if (maze.row(cell) > 0 && !carved[cell - 1]) {
+        choices[count++] = SOUTH;
+      }
+      if (maze.col(cell) > 0 && !carved[cell - width]) {
+        choices[count++] = WEST;
+      }
+      if (count == 0) {
+        stack.pop_back();
+        continue;
+      }
+      uint8_t direction = choices[random() % count];
+      maze.clearWall(cell, direction);
+      carved[maze.neighbour(cell, direction)] = true;
+      stack.push_back(maze.neighbour(cell, direction));
+    }
+  }
+
+  /// the number of steps taken following the route from the start, or maxCost() if it goes through a wall
+  static uint32_t followRoute(const LargeMaze<> &maze, uint32_t start, uint32_t target, uint8_t mask,
+                              const std::vector<uint8_t> &route) {
+    uint32_t cell = start;
+    for (uint8_t direction : route) {
+      if (maze.getXWalls(cell) & (mask << direction)) {
+        return LargeMaze<>::maxCost();
+      }
+      cell = maze.neighbour(cell, direction);
+    }
+    return cell == target ? (uint32_t)route.size() : LargeMaze<>::maxCost();
+  }
+};
+
+TEST_F(TEST_35_HierarchicalPlanner, 00_EmptyMazeRoutesAreShortest) {
+  LargeMaze<> maze(32);
+  maze.resetToEmptyMaze();
+  std::vector<uint8_t> route;
+  EXPECT_EQ(62u, planner.route(maze, 0, maze.numCells() - 1, OPEN_MASK, route));
+  EXPECT_EQ(16u, planner.clusterCount());
+  EXPECT_GT(planner.nodeCount(), 0u);
+  EXPECT_EQ(62u, followRoute(maze, 0, maze.numCells() - 1, OPEN_MASK, route));
+  // inside one cluster
+  EXPECT_EQ(3u, planner.route(maze, maze.cellAt(1, 1), maze.cellAt(2, 3), OPEN_MASK, route));
+  EXPECT_EQ(0u, planner.route(maze, 5, 5, OPEN_MASK, route));
+  EXPECT_TRUE(route.empty());
+  EXPECT_EQ(16u, planner.counters().clusterBuilds);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 01_WalledOffTargetHasNoRoute) {
+  LargeMaze<> maze(32);
+  maze.resetToEmptyMaze();
+  const uint32_t target = maze.cellAt(20, 20);
+  for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+    maze.setWall(target, direction);
+  }
+  std::vector<uint8_t> route;
+  EXPECT_EQ(LargeMaze<>::maxCost(), planner.route(maze, 0, target, OPEN_MASK, route));
+  EXPECT_TRUE(route.empty());
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 10_CorpusRoutesAreValidAndNearlyShortest) {
+  LargeMaze<> maze(16);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  std::vector<uint8_t> route;
+  uint64_t shortest = 0;
+  uint64_t planned = 0;
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    const uint32_t last = (uint32_t)maze.numCells() - 1;
+    const uint32_t targets[] = {maze.cellAt(maze.width() / 2, maze.width() / 2), last, 37};
+    for (uint32_t target : targets) {
+      for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+        maze.flood(target, mask);
+        for (uint32_t start : {0u, last / 3, last / 2 + 5}) {
+          uint32_t cost = planner.route(maze, start, target, mask, route);
+          if (maze.cost(start) == maze.maxCost()) {
+            ASSERT_EQ(maze.maxCost(), cost) << mazeList[i].title;
+            continue;
+          }
+          ASSERT_NE(maze.maxCost(), cost) << mazeList[i].title << " from " << start << " to " << target;
+          ASSERT_GE(cost, maze.cost(start)) << mazeList[i].title;
+          ASSERT_EQ(cost, followRoute(maze, start, target, mask, route)) << mazeList[i].title;
+          shortest += maze.cost(start);
+          planned += cost;
+        }
+      }
+    }
+  }
+  // contest mazes have few long open runs, so going through the entrances costs very little
+  EXPECT_LT(planned * 1000, shortest * 1005);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 11_PerfectMazeRoutesMatchTheFlood) {
+  LargeMaze<> maze(128);
+  makePerfectMaze(maze, 35);
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  HierarchicalPlanner<> large(16);
+  std::vector<uint8_t> route;
+  const uint32_t target = maze.cellAt(63, 63);
+  maze.flood(target, OPEN_MASK);
+  for (uint32_t start = 0; start < maze.numCells(); start += 997) {
+    ASSERT_EQ(maze.cost(start), large.route(maze, start, target, OPEN_MASK, route)) << start;
+    ASSERT_EQ(maze.cost(start), followRoute(maze, start, target, OPEN_MASK, route)) << start;
+  }
+  EXPECT_EQ(64u, large.counters().clusterBuilds);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 20_OnlyTouchedClustersRebuild) {
+  LargeMaze<> maze(32);
+  maze.resetToEmptyMaze();
+  std::vector<uint8_t> route;
+  planner.route(maze, 0, 0x3FF, OPEN_MASK, route);
+  EXPECT_EQ(16u, planner.counters().clusterBuilds);
+  planner.route(maze, 0, 0x3FF, OPEN_MASK, route);
+  EXPECT_EQ(16u, planner.counters().clusterBuilds);
+  // a wall inside the first cluster
+  planner.updateMap(maze, maze.cellAt(2, 2), WALL_NORTH);
+  EXPECT_FALSE(planner.isValid());
+  planner.route(maze, 0, 0x3FF, OPEN_MASK, route);
+  EXPECT_TRUE(planner.isValid());
+  EXPECT_EQ(17u, planner.counters().clusterBuilds);
+  // seeing that a wall is absent where it was taken to be absent is still a change to the map
+  const uint32_t borders = planner.counters().borderBuilds;
+  planner.updateMap(maze, maze.cellAt(7, 3), 0);
+  planner.route(maze, 0, 0x3FF, OPEN_MASK, route);
+  EXPECT_EQ(19u, planner.counters().clusterBuilds);
+  EXPECT_EQ(borders + 1, planner.counters().borderBuilds);
+  // nothing new to see
+  planner.updateMap(maze, maze.cellAt(7, 3), 0);
+  EXPECT_TRUE(planner.isValid());
+  // another mask starts again
+  planner.route(maze, 0, 0x3FF, CLOSED_MASK, route);
+  EXPECT_EQ(19u + 16u, planner.counters().clusterBuilds);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 21_RoutesStayRightWhileExploring) {
+  LargeMaze<> realMaze(64);
+  makePerfectMaze(realMaze, 21);
+  LargeMaze<> map(64);
+  map.resetToEmptyMaze();
+  HierarchicalPlanner<> fresh(8);
+  std::vector<uint8_t> route;
+  std::vector<uint8_t> freshRoute;
+  const uint32_t target = map.cellAt(31, 31);
+  for (uint32_t cell = 0; cell < map.numCells(); cell += 41) {
+    planner.updateMap(map, cell, realMaze.walls(cell));
+    uint32_t cost = planner.route(map, 0, target, OPEN_MASK, route);
+    fresh.invalidate();
+    ASSERT_EQ(fresh.route(map, 0, target, OPEN_MASK, freshRoute), cost) << "after cell " << cell;
+    ASSERT_EQ(freshRoute, route) << "after cell " << cell;
+  }
+  // each update rebuilt a few clusters rather than the whole maze
+  EXPECT_LT(planner.counters().clusterBuilds * 10, fresh.counters().clusterBuilds);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 22_WallsAlongABorderRegroupItsCrossings) {
+  LargeMaze<> maze(4);
+  maze.resetToEmptyMaze();
+  maze.setWall(1, SOUTH);
+  maze.setWall(2, NORTH);
+  maze.clearWall(1, NORTH);
+  maze.clearWall(5, NORTH);
+  maze.clearWall(2, EAST);
+  HierarchicalPlanner<> small(2);
+  std::vector<uint8_t> route;
+  small.route(maze, 1, 2, OPEN_MASK, route);
+  // the west wall of cell 5 splits the run of crossings between its cluster and the one above
+  small.updateMap(maze, 5, WALL_WEST);
+  HierarchicalPlanner<> fresh(2);
+  std::vector<uint8_t> freshRoute;
+  ASSERT_EQ(1u, fresh.route(maze, 1, 2, OPEN_MASK, freshRoute));
+  EXPECT_EQ(1u, small.route(maze, 1, 2, OPEN_MASK, route));
+  EXPECT_EQ(freshRoute, route);
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 23_RandomUpdatesMatchAFreshBuild) {
+  std::mt19937 random(23);
+  for (int trial = 0; trial < 20; trial++) {
+    LargeMaze<> maze(12);
+    maze.resetToEmptyMaze();
+    HierarchicalPlanner<> small(3);
+    HierarchicalPlanner<> fresh(3);
+    std::vector<uint8_t> route;
+    std::vector<uint8_t> freshRoute;
+    for (int step = 0; step < 60; step++) {
+      small.updateMap(maze, random() % maze.numCells(), (uint8_t)(random() & 0x0F));
+      const uint32_t start = random() % maze.numCells();
+      const uint32_t target = random() % maze.numCells();
+      uint32_t cost = small.route(maze, start, target, OPEN_MASK, route);
+      fresh.invalidate();
+      ASSERT_EQ(fresh.route(maze, start, target, OPEN_MASK, freshRoute), cost) << "trial " << trial;
+      ASSERT_EQ(freshRoute, route) << "trial " << trial;
+    }
+  }
+}
+
+TEST_F(TEST_35_HierarchicalPlanner, 24_WallsThePlannerWasNotToldAboutFailTheQuery) {
+  std::mt19937 random(24);
+  LargeMaze<> maze(16);
+  maze.resetToEmptyMaze();
+  HierarchicalPlanner<> stale(4);
+  std::vector<uint8_t> route;
+  stale.route(maze, 0, maze.numCells() - 1, OPEN_MASK, route);
+  for (int i = 0; i < 120; i++) {
+    maze.updateMap(random() % maze.numCells(), (uint8_t)(random() & 0x0F));
+  }
+  HierarchicalPlanner<> fresh(4);
+  int failed = 0;
+  for (int i = 0; i < 200; i++) {
+    const uint32_t start = random() % maze.numCells();
+    const uint32_t target = random() % maze.numCells();
+    uint32_t cost = stale.route(maze, start, target, OPEN_MASK, route);
+    if (cost == stale.maxCost()) {
+      EXPECT_TRUE(route.empty());
+      failed += fresh.route(maze, start, target, OPEN_MASK, route) != fresh.maxCost();
+      continue;
+    }
+    // a route that is given still has to fit the maze
+    ASSERT_EQ(cost, followRoute(maze, start, target, OPEN_MASK, route));
+  }
+  EXPECT_GT(failed, 0);
+}
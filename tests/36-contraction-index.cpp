@@ -0,0 +1,185 @@
+// Tests for the contraction index.
+//
+// Every query must give exactly the cost a diagonal flood from the target
+// gives the start, and an index that has been saved and loaded again must
+// give the same answers. Damaged data must be refused and a stored index
+// must know when it no longer fits the maze.
+
+#include <cstdio>
+#include <vector>
+
+#include "contractionindex.h"
+#include "corpus-mazes.h"
+#include "diagonalflood.h"
+#include "maze.h"
+#include "mazeconstants.h"
+#include "mazedata.h"
+
+#include "gtest/gtest.h"
+
+class TEST_36_ContractionIndex : public ::testing::Test {
+ protected:
+  ContractionIndex index;
+
+  /// compare the index with a diagonal flood from each target for every step'th start cell
+  void expectFloodCosts(const Maze &maze, const std::vector<uint16_t> &targets, uint8_t mask, const char *title,
+                        int step = 1) {
+    DiagonalFlood flood;
+    std::vector<uint16_t> costs(maze.numCells());
+    std::vector<uint8_t> directions(maze.numCells());
+    for (uint16_t target : targets) {
+      flood.flood(maze, &target, 1, mask, costs.data(), directions.data());
+      for (uint16_t start = 0; start < maze.numCells(); start += step) {
+        ASSERT_EQ(flood.routeCost(start), index.query(start, target))
+            << title << " from " << start << " to " << target;
+      }
+    }
+  }
+};
+
+TEST_F(TEST_36_ContractionIndex, 00_QueriesMatchTheDiagonalFlood) {
+  Maze maze(16);
+  // the empty and the open half size mazes are mostly core and slow to check in a debug build. Test 01 is open.
+  for (int i = 2; i < mazeCount; i += 12) {
+    loadCorpusMaze(maze, i);
+    index.build(maze);
+    ASSERT_TRUE(index.isBuilt());
+    EXPECT_EQ(maze.width(), index.width());
+    EXPECT_GT(index.nodeCount(), 2 * maze.numCells());
+    const uint16_t last = (uint16_t)(maze.numCells() - 1);
+    expectFloodCosts(maze, {maze.goal(), 0, last, 37}, CLOSED_MASK, mazeList[i].title, 3);
+  }
+}
+
+TEST_F(TEST_36_ContractionIndex, 01_PartlySeenMazeUnderEitherMask) {
+  Maze maze(16);
+  maze.resetToEmptyMaze();
+  for (uint16_t cell = 0; cell < maze.numCells(); cell += 3) {
+    Maze real(16);
+    real.copyMazeFromFileData(japan2007ef, 256);
+    maze.updateMap(cell, real.walls(cell));
+  }
+  for (uint8_t mask : {OPEN_MASK, CLOSED_MASK}) {
+    index.build(maze, mask);
+    EXPECT_TRUE(index.matches(maze, mask));
+    expectFloodCosts(maze, {0x77, 0x0F, 0xF0}, mask, "partly seen");
+  }
+}
+
+TEST_F(TEST_36_ContractionIndex, 02_EdgeCases) {
+  Maze maze(16);
+  maze.copyMazeFromFileData(japan2007ef, 256);
+  EXPECT_EQ(MAX_COST, index.query(0, 1));
+  index.build(maze);
+  EXPECT_EQ(0u, index.query(0x77, 0x77));
+  // wall one cell in completely
+  maze.setWall(0x44, NORTH);
+  maze.setWall(0x44, EAST);
+  maze.setWall(0x44, SOUTH);
+  maze.setWall(0x44, WEST);
+  index.build(maze);
+  EXPECT_EQ(MAX_COST, index.query(0, 0x44));
+  EXPECT_EQ(MAX_COST, index.query(0x44, 0));
+  EXPECT_EQ(MAX_COST, index.query(0, 0x100));
+  EXPECT_GT(index.shortcutCount(), 0);
+  EXPECT_GT(index.edgeCount(), index.shortcutCount());
+}
+
+TEST_F(TEST_36_ContractionIndex, 03_QueriesSearchFewNodes) {
+  Maze maze(32);
+  loadCorpusMaze(maze, 3);
+  index.build(maze);
+  long settled = 0;
+  int queries = 0;
+  for (uint16_t start = 0; start < maze.numCells(); start += 17) {
+    index.query(start, maze.goal());
+    settled += index.searchSpace();
+    queries++;
+  }
+  // a flood would settle a state for nearly every one of the walls of the maze
+  EXPECT_LT(settled / queries, maze.numCells() / 2);
+}
+
+TEST_F(TEST_36_ContractionIndex, 10_SavedIndexGivesTheSameCosts) {
+  Maze maze(16);
+  loadCorpusMaze(maze, 3);
+  index.build(maze);
+  std::vector<uint8_t> data;
+  index.save(data);
+  ASSERT_GT(data.size(), 20u);
+  EXPECT_EQ('L', data[0]);
+  ContractionIndex loaded;
+  ASSERT_TRUE(loaded.load(data.data(), data.size()));
+  EXPECT_TRUE(loaded.matches(maze));
+  EXPECT_EQ(index.edgeCount(), loaded.edgeCount());
+  EXPECT_EQ(index.shortcutCount(), loaded.shortcutCount());
+  for (uint16_t target : {maze.goal(), (uint16_t)0, (uint16_t)200}) {
+    for (uint16_t start = 0; start < maze.numCells(); start++) {
+      ASSERT_EQ(index.query(start, target), loaded.query(start, target));
+    }
+  }
+  std::vector<uint8_t> again;
+  loaded.save(again);
+  EXPECT_EQ(data, again);
+}
+
+TEST_F(TEST_36_ContractionIndex, 11_DamagedDataIsRefused) {
+  Maze maze(16);
+  loadCorpusMaze(maze, 3);
+  index.build(maze);
+  std::vector<uint8_t> data;
+  index.save(data);
+  ContractionIndex loaded;
+  EXPECT_FALSE(loaded.load(data.data(), data.size() - 1));
+  EXPECT_FALSE(loaded.isBuilt());
+  EXPECT_FALSE(loaded.load(data.data(), 10));
+  std::vector<uint8_t> longer(data);
+  longer.push_back(0);
+  EXPECT_FALSE(loaded.load(longer.data(), longer.size()));
+  std::vector<uint8_t> wrongVersion(data);
+  wrongVersion[4] = 99;
+  EXPECT_FALSE(loaded.load(wrongVersion.data(), wrongVersion.size()));
+  std::vector<uint8_t> wrongMagic(data);
+  wrongMagic[0] = 'X';
+  EXPECT_FALSE(loaded.load(wrongMagic.data(), wrongMagic.size()));
+  EXPECT_EQ(MAX_COST, loaded.query(0, 1));
+}
+
+TEST_F(TEST_36_ContractionIndex, 12_FileRoundTrip) {
+  const char *path = "/tmp/maze_test_36.mch";
+  Maze maze(32);
+  loadCorpusMaze(maze, 3);
+  index.build(maze);
+  ASSERT_EQ(ContractionIndex::INDEX_SUCCESS, index.writeFile(path));
+  ContractionIndex loaded;
+  ASSERT_EQ(ContractionIndex::INDEX_SUCCESS, loaded.readFile(path));
+  EXPECT_TRUE(loaded.matches(maze));
+  for (uint16_t start = 0; start < maze.numCells(); start += 7) {
+    ASSERT_EQ(index.query(start, maze.goal()), loaded.query(start, maze.goal()));
+  }
+  std::remove(path);
+  EXPECT_EQ(ContractionIndex::INDEX_READ_ERROR, loaded.readFile("/tmp/no_such_index_36.mch"));
+  EXPECT_EQ(ContractionIndex::INDEX_WRITE_ERROR, index.writeFile("/no_such_directory_36/index.mch"));
+}
+
+TEST_F(TEST_36_ContractionIndex, 20_StaleIndexDoesNotMatch) {
+  Maze maze(16);
+  loadCorpusMaze(maze, 3);
+  index.build(maze);
+  EXPECT_TRUE(index.matches(maze));
+  EXPECT_FALSE(index.matches(maze, OPEN_MASK));
+  // a different profile gives different costs
+  maze.setRunLengthProfile(Maze::HIGH_SPEED_PROFILE);
+  EXPECT_FALSE(index.matches(maze));
+  maze.setRunLengthProfile(Maze::LOW_SPEED_PROFILE);
+  EXPECT_TRUE(index.matches(maze));
+  Maze other(16);
+  loadCorpusMaze(other, 4);
+  EXPECT_FALSE(index.matches(other));
+  if (maze.hasExit(0x55, NORTH)) {
+    maze.setWall(0x55, NORTH);
+  } else {
+    maze.clearWall(0x55, NORTH);
+  }
+  EXPECT_FALSE(index.matches(maze));
+}
@@ -0,0 +1,43 @@
+// Replacements for the global operator new and delete that count allocations.
+// See allocation-counter.h
+
+#include "allocation-counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> count(0);
+
+long allocationCount() {
+  return count.load();
+}
+
+void *operator new(std::size_t size) {
+  count++;
+  void *p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  ::operator delete(p);
+}
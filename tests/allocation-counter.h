@@ -0,0 +1,14 @@
+// Count the heap allocations made by a test program.
+//
+// allocation-counter.cpp replaces the global operator new and delete, so it
+// must only be linked into a program whose tests all expect that. It is a
+// translation unit of its own so that the compiler cannot inline the
+// replacements into the code that calls them.
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+/// the number of calls to operator new so far, from any thread
+long allocationCount();
+
+#endif  // ALLOCATION_COUNTER_H
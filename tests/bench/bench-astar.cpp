@@ -0,0 +1,52 @@
+// Compare a full flood with an AStar route query, for unit and runlength
+// costs. Routes are timed from cells at increasing distances from the goal
+// to show that the query time follows the route length while the flood
+// time follows the maze size.
+
+#include <cstdio>
+#include <string>
+
+#include "astar.h"
+#include "bench.h"
+
+void benchAStar() {
+  const int repeats = 200;
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::RUNLENGTH_FLOOD};
+  const AStar::CostModel costModels[] = {AStar::UNIT_COST, AStar::RUNLENGTH_COST};
+  const char *names[] = {"unit", "runlength"};
+  const int distances[] = {4, 16, 64, 1000};
+  Maze maze(16);
+  AStar astar;
+  printf("%-10s %8s %10s %10s %10s %8s\n", "costs", "cells", "flood", "astar", "expanded", "speedup");
+  for (int m = 0; m < 2; m++) {
+    maze.setFloodType(floodTypes[m]);
+    astar.setCostModel(costModels[m]);
+    for (int distance : distances) {
+      double floodTotal = 0;
+      double astarTotal = 0;
+      long expanded = 0;
+      int queries = 0;
+      for (int i = 0; i < mazeCount; i++) {
+        loadCorpusMaze(maze, i);
+        uint16_t goal = corpusGoal(maze);
+        maze.setFloodType(Maze::MANHATTAN_FLOOD);
+        maze.flood(goal, CLOSED_MASK);
+        // the cell on the route from home that is the given number of cells from the goal
+        uint16_t start = 0;
+        while (maze.cost(start) > distance && maze.cost(start) != MAX_COST) {
+          start = maze.neighbour(start, maze.direction(start));
+        }
+        if (maze.cost(start) == MAX_COST) {
+          continue;
+        }
+        maze.setFloodType(floodTypes[m]);
+        floodTotal += benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+        astarTotal += benchMeanMicroseconds(repeats, [&]() { astar.findRoute(maze, start, goal, CLOSED_MASK); });
+        expanded += astar.expandedCount();
+        queries++;
+      }
+      printf("%-10s %8s %8.2fus %8.2fus %10.0f %8.2f\n", names[m], distance < 1000 ? std::to_string(distance).c_str() : "home",
+             floodTotal / queries, astarTotal / queries, double(expanded) / queries, floodTotal / astarTotal);
+    }
+  }
+}
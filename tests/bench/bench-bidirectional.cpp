@@ -0,0 +1,52 @@
+// Compare a flood from the start cell with one-sided and bidirectional route
+// searches for the run back to the start of each 32x32 maze in the corpus.
+// The expansions are states taken from the queues, or cells for the flood.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "bidirectionalsearch.h"
+
+void benchBidirectional() {
+  const int repeats = 200;
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD};
+  const BidirectionalSearch::CostModel costModels[] = {
+      BidirectionalSearch::UNIT_COST, BidirectionalSearch::WEIGHTED_COST, BidirectionalSearch::RUNLENGTH_COST};
+  const char *names[] = {"unit", "weighted", "runlength"};
+  Maze maze(32);
+  BidirectionalSearch one;
+  BidirectionalSearch both;
+  one.setBidirectional(false);
+  printf("%-10s %10s %10s %10s %10s %10s %10s\n", "costs", "flood", "one-sided", "both", "cells", "one-sided", "both");
+  for (int m = 0; m < 3; m++) {
+    one.setCostModel(costModels[m]);
+    both.setCostModel(costModels[m]);
+    double floodTotal = 0;
+    double oneTotal = 0;
+    double bothTotal = 0;
+    long cells = 0;
+    long oneExpanded = 0;
+    long bothExpanded = 0;
+    for (int i = 0; i < mazeCount; i++) {
+      if (corpusWidth(i) != 32) {
+        continue;
+      }
+      loadCorpusMaze(maze, i);
+      uint16_t goal = corpusGoal(maze);
+      maze.setFloodType(floodTypes[m]);
+      if (maze.flood(0, CLOSED_MASK) == MAX_COST || maze.cost(goal) == MAX_COST) {
+        continue;
+      }
+      for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+        cells += maze.cost(cell) != MAX_COST;
+      }
+      floodTotal += benchMeanMicroseconds(repeats, [&]() { maze.flood(0, CLOSED_MASK); });
+      oneTotal += benchMeanMicroseconds(repeats, [&]() { one.findRoute(maze, goal, SOUTH, 0, CLOSED_MASK); });
+      bothTotal += benchMeanMicroseconds(repeats, [&]() { both.findRoute(maze, goal, SOUTH, 0, CLOSED_MASK); });
+      oneExpanded += one.expandedCount();
+      bothExpanded += both.expandedCount();
+    }
+    printf("%-10s %8.1fus %8.1fus %8.1fus %10ld %10ld %10ld\n", names[m], floodTotal, oneTotal, bothTotal, cells,
+           oneExpanded, bothExpanded);
+  }
+}
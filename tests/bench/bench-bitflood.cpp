@@ -0,0 +1,46 @@
+// Compare the queue based manhattan flood with the BitFlood kernels across
+// the whole maze corpus. The kernel columns time the costs alone. The last
+// column is a complete Maze::manhattanFlood(), including the directions.
+
+#include <cstdio>
+
+#include "bench.h"
+
+void benchBitFlood() {
+  const int repeats = 2000;
+  const BitFlood::Kernel kernels[] = {BitFlood::PORTABLE_KERNEL, BitFlood::SSE2_KERNEL, BitFlood::AVX2_KERNEL};
+  Maze maze(16);
+  uint16_t costs[1024];
+  double totals[5] = {0, 0, 0, 0, 0};
+  printf("best kernel: %s\n", BitFlood::kernelName(BitFlood::bestKernel()));
+  printf("%-20s %5s %12s %12s %12s %12s %12s\n", "maze", "width", "queue", "portable", "sse2", "avx2", "bit+dirs");
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    double times[5];
+    maze.setBitParallelFlood(false);
+    times[0] = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    for (int k = 0; k < 3; k++) {
+      if (!BitFlood::isSupported(kernels[k])) {
+        times[k + 1] = 0;
+        continue;
+      }
+      times[k + 1] = benchMeanMicroseconds(
+          repeats, [&]() { BitFlood::flood(maze.wallPlanes(), goal, OPEN_MASK, costs, kernels[k]); });
+    }
+    maze.setBitParallelFlood(true);
+    times[4] = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    printf("%-20s %5d", mazeList[i].title, maze.width());
+    for (int t = 0; t < 5; t++) {
+      printf(" %10.2fus", times[t]);
+      totals[t] += times[t];
+    }
+    printf("\n");
+  }
+  printf("%-20s %5s", "TOTAL", "");
+  for (double total : totals) {
+    printf(" %10.2fus", total);
+  }
+  printf("\n");
+}
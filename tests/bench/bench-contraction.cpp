@@ -0,0 +1,62 @@
+// Build the contraction index for each maze in the corpus and compare the
+// time of a query on it with the diagonal flood that gives the same cost.
+//
+// The queries go between pseudo-random pairs of cells, so a flood would
+// have to be run again for almost every one of them.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "contractionindex.h"
+#include "diagonalflood.h"
+
+void benchContraction() {
+  const int queries = 200;
+  Maze maze(16);
+  ContractionIndex index;
+  DiagonalFlood flood;
+  std::vector<uint16_t> costs;
+  std::vector<uint8_t> directions;
+  std::vector<uint8_t> data;
+  double totals[3] = {0, 0, 0};
+  int wrong = 0;
+  printf("%-20s %5s %10s %8s %10s %8s %10s %10s %8s\n", "maze", "width", "build", "edges", "shortcuts", "bytes",
+         "query", "flood", "settled");
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    costs.resize(maze.numCells());
+    directions.resize(maze.numCells());
+    double build = benchMeanMicroseconds(1, [&]() { index.build(maze, OPEN_MASK); });
+    index.save(data);
+
+    std::mt19937 random(i);
+    std::vector<uint16_t> cells(2 * queries);
+    for (uint16_t &cell : cells) {
+      cell = (uint16_t)(random() % maze.numCells());
+    }
+    long settled = 0;
+    BenchTimer timer;
+    for (int q = 0; q < queries; q++) {
+      index.query(cells[2 * q], cells[2 * q + 1]);
+      settled += index.searchSpace();
+    }
+    double query = timer.elapsedMicroseconds() / queries;
+
+    timer.restart();
+    for (int q = 0; q < queries; q++) {
+      flood.flood(maze, &cells[2 * q + 1], 1, OPEN_MASK, costs.data(), directions.data());
+      wrong += flood.routeCost(cells[2 * q]) != index.query(cells[2 * q], cells[2 * q + 1]);
+    }
+    double floods = timer.elapsedMicroseconds() / queries;
+
+    printf("%-20s %5d %8.0fus %8d %10d %8zu %8.2fus %8.2fus %8ld\n", mazeList[i].title, maze.width(), build,
+           index.edgeCount(), index.shortcutCount(), data.size(), query, floods, settled / queries);
+    totals[0] += build;
+    totals[1] += query;
+    totals[2] += floods;
+  }
+  printf("total: build %.0fus  mean query %.2fus  mean flood %.2fus  wrong costs %d\n", totals[0],
+         totals[1] / mazeCount, totals[2] / mazeCount, wrong);
+}
@@ -0,0 +1,46 @@
+// Time manhattan floods on the corridor graph across the maze corpus and
+// compare them with the heap flood and BitFlood on the same walls. The
+// graph is built once per maze; the build time is shown separately.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "corridorgraph.h"
+
+void benchCorridors() {
+  const int repeats = 50;
+  Maze maze(16);
+  CorridorGraph graph;
+  long cells = 0;
+  long nodes = 0;
+  double totals[4] = {0, 0, 0, 0};
+  printf("%-20s %5s %6s %6s %10s %12s %12s %12s\n", "maze", "width", "nodes", "edges", "build", "heap", "bitflood",
+         "graph");
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    double build = benchMeanMicroseconds(repeats, [&]() {
+      graph.invalidate();
+      graph.update(maze, CLOSED_MASK);
+    });
+    maze.setBitParallelFlood(false);
+    double heap = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+    maze.setBitParallelFlood(true);
+    double bits = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+    maze.setCorridorGraph(&graph);
+    maze.flood(goal, CLOSED_MASK);
+    double corridors = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+    maze.setCorridorGraph(nullptr);
+    printf("%-20s %5d %6d %6d %8.2fus %10.2fus %10.2fus %10.2fus\n", mazeList[i].title, maze.width(),
+           graph.nodeCount(), graph.edgeCount(), build, heap, bits, corridors);
+    cells += graph.cellCount();
+    nodes += graph.nodeCount();
+    totals[0] += build;
+    totals[1] += heap;
+    totals[2] += bits;
+    totals[3] += corridors;
+  }
+  printf("total: build %.0fus  heap %.0fus  bitflood %.0fus  graph %.0fus  cells per node %.2f\n", totals[0],
+         totals[1], totals[2], totals[3], (double)cells / nodes);
+}
@@ -0,0 +1,81 @@
+// Count the cells reached by each flood with and without a dead-end fill on
+// the Japanese and UK contest mazes, and time the floods and a search to the
+// goal and back. The manhattan flood uses the queue flood in both cases
+// because BitFlood cannot see the fill.
+
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+#include "deadendfill.h"
+#include "mazesearcher.h"
+
+static int reachedCells(const Maze &maze) {
+  int reached = 0;
+  for (uint16_t cell = 0; cell < maze.numCells(); cell++) {
+    reached += maze.cost(cell) != MAX_COST;
+  }
+  return reached;
+}
+
+void benchDeadEnds() {
+  const int repeats = 20;
+  const Maze::FloodType types[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                   Maze::DIRECTION_FLOOD};
+  const char *names[] = {"manhattan", "weighted", "runlength", "direction"};
+  Maze maze(16);
+  maze.setBitParallelFlood(false);
+  DeadEndFill fill;
+  long reached[2] = {0, 0};
+  double floodTotals[4][2] = {};
+  double searchTotals[2] = {0, 0};
+  int mazes = 0;
+  printf("%-20s %6s %8s %8s %12s %12s %12s %12s\n", "maze", "filled", "reached", "skipped", "plain", "filled",
+         "search", "filled");
+  for (int i = 0; i < mazeCount; i++) {
+    const char *title = mazeList[i].title;
+    if (strncmp(title, "japan", 5) != 0 && strncmp(title, "uk", 2) != 0) {
+      continue;
+    }
+    mazes++;
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    double times[4][2];
+    int reachedPlain = 0;
+    int reachedFilled = 0;
+    for (int useFill = 0; useFill < 2; useFill++) {
+      maze.setDeadEndFill(useFill ? &fill : nullptr);
+      for (int type = 0; type < 4; type++) {
+        maze.setFloodType(types[type]);
+        maze.flood(goal, OPEN_MASK);
+        (useFill ? reachedFilled : reachedPlain) += reachedCells(maze);
+        times[type][useFill] = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+        floodTotals[type][useFill] += times[type][useFill];
+      }
+    }
+    double search[2];
+    for (int useFill = 0; useFill < 2; useFill++) {
+      MazeSearcher searcher;
+      searcher.setRealMaze(&maze);
+      searcher.setDeadEndFill(useFill != 0);
+      BenchTimer timer;
+      searcher.searchTo(goal);
+      searcher.searchTo(0);
+      search[useFill] = timer.elapsedMicroseconds();
+      searchTotals[useFill] += search[useFill];
+    }
+    double plain = times[0][0] + times[1][0] + times[2][0] + times[3][0];
+    double filled = times[0][1] + times[1][1] + times[2][1] + times[3][1];
+    printf("%-20s %6d %8d %8d %10.2fus %10.2fus %10.0fus %10.0fus\n", title, fill.filledCount(), reachedPlain,
+           reachedPlain - reachedFilled, plain, filled, search[0], search[1]);
+    reached[0] += reachedPlain;
+    reached[1] += reachedFilled;
+  }
+  maze.setDeadEndFill(nullptr);
+  printf("%d mazes, cells reached by the four floods %ld plain, %ld filled (%.1f%% fewer)\n", mazes, reached[0],
+         reached[1], 100.0 * (reached[0] - reached[1]) / reached[0]);
+  for (int type = 0; type < 4; type++) {
+    printf("  %-10s plain %8.0fus  filled %8.0fus\n", names[type], floodTotals[type][0], floodTotals[type][1]);
+  }
+  printf("  search to the goal and back: plain %.0fus  filled %.0fus\n", searchTotals[0], searchTotals[1]);
+}
@@ -0,0 +1,36 @@
+// Time the diagonal flood across the maze corpus and compare its cost from
+// the start with the runlength flood, which only estimates the same costs.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "floodworkspace.h"
+
+void benchDiagonal() {
+  const int repeats = 20;
+  Maze maze(16);
+  FloodWorkspace workspace;
+  int cheaper = 0;
+  double totals[2] = {0, 0};
+  printf("%-20s %5s %12s %12s %8s %8s %10s\n", "maze", "width", "rl heap", "diagonal", "rl cost", "cost", "states");
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+    maze.setQueueType(Maze::HEAP_QUEUE);
+    uint16_t runLengthCost = maze.flood(goal, OPEN_MASK);
+    double runLength = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    maze.setFloodType(Maze::DIAGONAL_FLOOD);
+    maze.setFloodWorkspace(&workspace);
+    uint16_t cost = maze.flood(goal, OPEN_MASK);
+    double diagonal = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    maze.setFloodWorkspace(nullptr);
+    printf("%-20s %5d %10.2fus %10.2fus %8u %8u %10u\n", mazeList[i].title, maze.width(), runLength, diagonal,
+           runLengthCost, cost, workspace.diagonalFlood().expansions());
+    cheaper += cost < runLengthCost;
+    totals[0] += runLength;
+    totals[1] += diagonal;
+  }
+  printf("total: runlength %.0fus  diagonal %.0fus  cheaper routes from the start in %d of %d mazes\n", totals[0],
+         totals[1], cheaper, mazeCount);
+}
@@ -0,0 +1,77 @@
+// Route queries on the hierarchical planner against a full flood, for
+// LargeMaze from 64x64 up to 1024x1024 cells.
+//
+// The mazes are the seeded perfect mazes of the scaling benchmark with one
+// interior wall in ten removed again so that there are loops to choose
+// between. Each width reports the time to flood the maze, to build the
+// planner from scratch, to answer a query from cell 0 to the centre and
+// between random cells, and to add one wall and plan again.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "hierarchicalplanner.h"
+#include "largemaze.h"
+
+/// remove about one interior wall in ten
+static void addLoops(LargeMaze<> &maze, uint32_t seed) {
+  std::mt19937 random(seed);
+  const uint32_t width = maze.width();
+  for (uint32_t cell = 0; cell < maze.numCells(); cell++) {
+    if (maze.row(cell) + 1 < width && random() % 10 == 0) {
+      maze.clearWall(cell, NORTH);
+    }
+    if (maze.col(cell) + 1 < width && random() % 10 == 0) {
+      maze.clearWall(cell, EAST);
+    }
+  }
+}
+
+void benchHierarchy() {
+  printf("%6s %10s %8s %10s %10s %12s %12s %12s %10s %10s\n", "width", "cells", "nodes", "flood", "build",
+         "to centre", "random", "replan", "steps", "shortest");
+  for (uint32_t width = 64; width <= 1024; width *= 2) {
+    LargeMaze<> maze(width);
+    makePerfectMaze(maze, width);
+    addLoops(maze, width);
+    maze.setFloodType(Maze::MANHATTAN_FLOOD);
+    const uint32_t centre = maze.cellAt(width / 2 - 1, width / 2 - 1);
+    const int repeats = width <= 256 ? 10 : 2;
+    double flood = benchMeanMicroseconds(repeats, [&]() { maze.flood(centre, OPEN_MASK); });
+    uint32_t shortest = maze.cost(0);
+
+    HierarchicalPlanner<> planner(16);
+    std::vector<uint8_t> route;
+    double build = benchMeanMicroseconds(repeats, [&]() {
+      planner.invalidate();
+      planner.update(maze, OPEN_MASK);
+    });
+    uint32_t steps = planner.route(maze, 0, centre, OPEN_MASK, route);
+    double toCentre = benchMeanMicroseconds(100, [&]() { planner.route(maze, 0, centre, OPEN_MASK, route); });
+
+    std::mt19937 random(width);
+    std::vector<uint32_t> cells(200);
+    for (uint32_t &cell : cells) {
+      cell = random() % maze.numCells();
+    }
+    BenchTimer timer;
+    for (size_t i = 0; i + 1 < cells.size(); i += 2) {
+      planner.route(maze, cells[i], cells[i + 1], OPEN_MASK, route);
+    }
+    double randomQuery = timer.elapsedMicroseconds() / (cells.size() / 2);
+
+    // put a wall across a column one cell at a time, planning again after each
+    uint32_t row = 0;
+    double replan = benchMeanMicroseconds((int)width - 1, [&]() {
+      uint32_t cell = maze.cellAt(width / 3, row++);
+      maze.setWall(cell, NORTH);
+      planner.wallChanged(cell, NORTH);
+      planner.route(maze, 0, centre, OPEN_MASK, route);
+    });
+
+    printf("%6u %10zu %8zu %8.0fus %8.0fus %10.1fus %10.1fus %10.1fus %10u %10u\n", width, maze.numCells(),
+           planner.nodeCount(), flood, build, toCentre, randomQuery, replan, steps, shortest);
+  }
+}
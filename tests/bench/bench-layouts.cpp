@@ -0,0 +1,141 @@
+// Compare the split, packed and padded cell layouts for the queue based floods on the
+// 16x16 and 32x32 mazes of the corpus. Besides the time, the L1 data cache
+// read misses and last level cache misses are counted with the Linux perf
+// counters. Where the counters cannot be opened, say in a container without
+// permission, only the times are shown.
+
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+#include "floodworkspace.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// A hardware counter for this process in user space. reading() is -1 when it could not be opened.
+class CacheCounter {
+ public:
+  CacheCounter(uint32_t type, uint64_t config) {
+#if defined(__linux__)
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    mFd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+    (void)type;
+    (void)config;
+#endif
+  }
+  ~CacheCounter() {
+#if defined(__linux__)
+    if (mFd >= 0) {
+      close(mFd);
+    }
+#endif
+  }
+  bool isOpen() const { return mFd >= 0; }
+  void start() {
+#if defined(__linux__)
+    if (mFd >= 0) {
+      ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  long long stop() {
+    long long count = -1;
+#if defined(__linux__)
+    if (mFd >= 0) {
+      ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(mFd, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int mFd = -1;
+};
+
+void benchLayouts() {
+  const int repeats = 200;
+  struct Setting {
+    const char *name;
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+  };
+  const Setting settings[] = {
+      {"manhattan", Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE},
+      {"weighted", Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE},
+      {"runlength", Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE},
+      {"runlength bucket", Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE},
+      {"runlength heap", Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE},
+  };
+  const Maze::CellLayout layouts[] = {Maze::SPLIT_CELLS, Maze::PACKED_CELLS, Maze::PADDED_CELLS};
+  const char *layoutNames[] = {"split", "packed", "padded"};
+#if defined(__linux__)
+  CacheCounter l1Misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  CacheCounter llcMisses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#else
+  CacheCounter l1Misses(0, 0);
+  CacheCounter llcMisses(0, 0);
+#endif
+  if (!l1Misses.isOpen() || !llcMisses.isOpen()) {
+    printf("perf counters are not available here; showing times only\n");
+  }
+  FloodWorkspace workspace;
+  Maze maze(16);
+  maze.setBitParallelFlood(false);
+  maze.setFloodWorkspace(&workspace);
+  printf("%-18s %5s %-7s %10s %12s %12s\n", "flood", "width", "layout", "time", "L1D misses", "LLC misses");
+  for (const Setting &setting : settings) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    for (uint16_t width : {16, 32}) {
+      for (int l = 0; l < 3; l++) {
+        maze.setCellLayout(layouts[l]);
+        double total = 0;
+        long long l1Total = 0;
+        long long llcTotal = 0;
+        int count = 0;
+        for (int i = 0; i < mazeCount; i++) {
+          if (corpusWidth(i) != width) {
+            continue;
+          }
+          loadCorpusMaze(maze, i);
+          uint16_t goal = corpusGoal(maze);
+          l1Misses.start();
+          llcMisses.start();
+          total += benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+          l1Total += l1Misses.stop();
+          llcTotal += llcMisses.stop();
+          count++;
+        }
+        if (count == 0) {
+          continue;
+        }
+        double floods = double(count) * repeats;
+        if (l1Misses.isOpen() && llcMisses.isOpen()) {
+          printf("%-18s %5d %-7s %8.2fus %12.1f %12.2f\n", setting.name, width, layoutNames[l], total / count,
+                 l1Total / floods, llcTotal / floods);
+        } else {
+          printf("%-18s %5d %-7s %8.2fus %12s %12s\n", setting.name, width, layoutNames[l], total / count, "-", "-");
+        }
+      }
+    }
+  }
+  maze.setFloodWorkspace(nullptr);
+}
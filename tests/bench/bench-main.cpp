@@ -0,0 +1,73 @@
+// Entry point for the libMaze benchmarks.
+//
+// Usage: maze_bench [name ...]
+// With no arguments every benchmark is run.
+
+#include <cstdio>
+#include <cstring>
+
+void benchQueues();
+void benchBitFlood();
+void benchWidths();
+void benchScaling();
+void benchSolution();
+void benchAStar();
+void benchBidirectional();
+void benchWorkspace();
+void benchLayouts();
+void benchTime();
+void benchDiagonal();
+void benchCorridors();
+void benchDeadEnds();
+void benchHierarchy();
+void benchContraction();
+
+struct Benchmark {
+  const char *name;
+  void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    {"queues", benchQueues},
+    {"bitflood", benchBitFlood},
+    {"widths", benchWidths},
+    {"scaling", benchScaling},
+    {"solution", benchSolution},
+    {"astar", benchAStar},
+    {"bidirectional", benchBidirectional},
+    {"workspace", benchWorkspace},
+    {"layouts", benchLayouts},
+    {"time", benchTime},
+    {"diagonal", benchDiagonal},
+    {"corridors", benchCorridors},
+    {"deadends", benchDeadEnds},
+    {"hierarchy", benchHierarchy},
+    {"contraction", benchContraction},
+};
+
+int main(int argc, char **argv) {
+  int ran = 0;
+  for (const Benchmark &benchmark : benchmarks) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) {
+      if (strcmp(argv[i], benchmark.name) == 0) {
+        selected = true;
+      }
+    }
+    if (selected) {
+      printf("=== %s ===\n", benchmark.name);
+      benchmark.run();
+      printf("\n");
+      ran++;
+    }
+  }
+  if (ran == 0) {
+    printf("no benchmark matched. Available:");
+    for (const Benchmark &benchmark : benchmarks) {
+      printf(" %s", benchmark.name);
+    }
+    printf("\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+// Compare the linear PriorityQueue with the IndexedHeap in the weighted and
+// runlength floods, and with the BucketQueue in the runlength flood, across
+// the whole maze corpus.
+
+#include <cstdio>
+
+#include "bench.h"
+
+static double timeFlood(Maze &maze, Maze::FloodType floodType, Maze::QueueType queueType, uint16_t goal) {
+  const int repeats = 200;
+  maze.setFloodType(floodType);
+  maze.setQueueType(queueType);
+  return benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+}
+
+void benchQueues() {
+  Maze maze(16);
+  double totals[5] = {0, 0, 0, 0, 0};
+  printf("%-20s %5s %12s %12s %12s %12s %12s\n", "maze", "width", "rl linear", "rl heap", "rl bucket", "wt linear", "wt heap");
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    double times[5];
+    times[0] = timeFlood(maze, Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE, goal);
+    times[1] = timeFlood(maze, Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE, goal);
+    times[2] = timeFlood(maze, Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE, goal);
+    times[3] = timeFlood(maze, Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE, goal);
+    times[4] = timeFlood(maze, Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE, goal);
+    printf("%-20s %5d", mazeList[i].title, maze.width());
+    for (int t = 0; t < 5; t++) {
+      printf(" %10.2fus", times[t]);
+      totals[t] += times[t];
+    }
+    printf("\n");
+  }
+  printf("%-20s %5s", "TOTAL", "");
+  for (double total : totals) {
+    printf(" %10.2fus", total);
+  }
+  printf("\n");
+  printf("runlength linear/heap %.2f  linear/bucket %.2f  weighted linear/heap %.2f\n", totals[0] / totals[1],
+         totals[0] / totals[2], totals[3] / totals[4]);
+}
@@ -0,0 +1,33 @@
+// Flood times and memory for LargeMaze from 64x64 up to 1024x1024 cells.
+//
+// The mazes are random perfect mazes (exactly one route between any two
+// cells) made with a seeded depth-first walk, so every run uses the same
+// mazes. A perfect maze is close to the worst case for the floods since
+// the routes are long and every cell is reached.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "largemaze.h"
+
+void benchScaling() {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  printf("%6s %10s %10s %12s %12s %12s %12s %12s\n", "width", "cells", "memory", "manhattan", "weighted",
+         "runlength", "direction", "runlen cost");
+  for (uint32_t width = 64; width <= 1024; width *= 2) {
+    LargeMaze<> maze(width);
+    makePerfectMaze(maze, width);
+    const uint32_t goal = maze.cellAt(width / 2 - 1, width / 2 - 1);
+    const int repeats = width <= 256 ? 10 : 2;
+    double times[4];
+    for (int f = 0; f < 4; f++) {
+      maze.setFloodType(floodTypes[f]);
+      times[f] = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    }
+    maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+    uint32_t cost = maze.flood(goal, OPEN_MASK);
+    printf("%6u %10zu %8zukB %10.0fus %10.0fus %10.0fus %10.0fus %12u\n", width, maze.numCells(),
+           maze.memoryUsed() / 1024, times[0], times[1], times[2], times[3], cost);
+  }
+}
@@ -0,0 +1,43 @@
+// Time testForSolution() with the manhattan flood, which floods the closed
+// and open mazes together, against the two separate floods it used to run.
+// Each corpus maze is loaded with only every third cell seen so that the
+// two floods differ, as they do part way through a search. The paired flood
+// keeps its closed costs in the workspace.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "floodworkspace.h"
+
+void benchSolution() {
+  const int repeats = 2000;
+  Maze real(16);
+  Maze maze(16);
+  FloodWorkspace workspace;
+  maze.setFloodType(Maze::MANHATTAN_FLOOD);
+  maze.setFloodWorkspace(&workspace);
+  double separateTotal[2] = {0, 0};
+  double pairedTotal[2] = {0, 0};
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(real, i);
+    maze.setWidth(real.width());
+    maze.resetToEmptyMaze();
+    for (uint16_t cell = 0; cell < maze.numCells(); cell += 3) {
+      maze.updateMap(cell, real.walls(cell));
+    }
+    uint16_t goal = corpusGoal(real);
+    maze.setGoal(goal);
+    int size = maze.width() == 16 ? 0 : 1;
+    separateTotal[size] += benchMeanMicroseconds(repeats, [&]() {
+      maze.flood(goal, CLOSED_MASK);
+      maze.flood(goal, OPEN_MASK);
+    });
+    pairedTotal[size] += benchMeanMicroseconds(repeats, [&]() { maze.testForSolution(); });
+  }
+  printf("%-8s %14s %14s %8s\n", "width", "two floods", "paired", "speedup");
+  const char *names[] = {"16x16", "32x32"};
+  for (int size = 0; size < 2; size++) {
+    printf("%-8s %12.2fus %12.2fus %8.2f\n", names[size], separateTotal[size], pairedTotal[size],
+           separateTotal[size] / pairedTotal[size]);
+  }
+}
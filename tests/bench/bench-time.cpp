@@ -0,0 +1,39 @@
+// Time the time flood across the maze corpus and compare it with the
+// runlength flood on the heap. The target for a 32x32 maze is under 10ms.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "bench.h"
+#include "floodworkspace.h"
+#include "timeflood.h"
+
+void benchTime() {
+  const int repeats = 20;
+  Maze maze(16);
+  FloodWorkspace workspace;
+  double worst[2] = {0, 0};
+  printf("%-20s %5s %12s %12s %12s %10s %10s\n", "maze", "width", "rl heap", "time", "time ws", "states", "estimate");
+  for (int i = 0; i < mazeCount; i++) {
+    loadCorpusMaze(maze, i);
+    uint16_t goal = corpusGoal(maze);
+    maze.setFloodType(Maze::RUNLENGTH_FLOOD);
+    maze.setQueueType(Maze::HEAP_QUEUE);
+    double runLength = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    maze.setFloodType(Maze::TIME_FLOOD);
+    double time = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    maze.setFloodWorkspace(&workspace);
+    double timeWorkspace = benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+    maze.setFloodWorkspace(nullptr);
+    TimeFlood flood(maze.getMotionProfile());
+    std::vector<uint16_t> cost(maze.numCells());
+    std::vector<uint8_t> direction(maze.numCells());
+    flood.flood(maze, &goal, 1, OPEN_MASK, cost.data(), direction.data());
+    printf("%-20s %5d %10.2fus %10.2fus %10.2fus %10u %8.3fs\n", mazeList[i].title, maze.width(), runLength, time,
+           timeWorkspace, flood.expansions(), flood.runTime() / 1e6);
+    double &slowest = worst[maze.width() == 32 ? 1 : 0];
+    slowest = std::max(slowest, std::max(time, timeWorkspace));
+  }
+  printf("slowest time flood: 16x16 %.2fus  32x32 %.2fus\n", worst[0], worst[1]);
+}
@@ -0,0 +1,34 @@
+// Compare each flood compiled for a fixed width of 16 or 32 with the same
+// flood using the runtime width, across the whole maze corpus. The manhattan
+// flood is timed with the queue so that both columns run the same code.
+
+#include <cstdio>
+
+#include "bench.h"
+
+static double timeFlood(Maze &maze, Maze::FloodType floodType, bool fixedWidth, uint16_t goal) {
+  const int repeats = 200;
+  maze.setFloodType(floodType);
+  maze.setFixedWidthFloods(fixedWidth);
+  return benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, OPEN_MASK); });
+}
+
+void benchWidths() {
+  const Maze::FloodType floodTypes[] = {Maze::MANHATTAN_FLOOD, Maze::WEIGHTED_FLOOD, Maze::RUNLENGTH_FLOOD,
+                                        Maze::DIRECTION_FLOOD};
+  const char *names[] = {"manhattan", "weighted", "runlength", "direction"};
+  Maze maze(16);
+  maze.setBitParallelFlood(false);
+  printf("%-12s %14s %14s %8s\n", "flood", "runtime width", "fixed width", "speedup");
+  for (int f = 0; f < 4; f++) {
+    double runtimeTotal = 0;
+    double fixedTotal = 0;
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      uint16_t goal = corpusGoal(maze);
+      runtimeTotal += timeFlood(maze, floodTypes[f], false, goal);
+      fixedTotal += timeFlood(maze, floodTypes[f], true, goal);
+    }
+    printf("%-12s %12.2fus %12.2fus %8.2f\n", names[f], runtimeTotal, fixedTotal, runtimeTotal / fixedTotal);
+  }
+}
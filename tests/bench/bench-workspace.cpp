@@ -0,0 +1,47 @@
+// Time floods across the corpus with and without a FloodWorkspace, as a
+// batch run would use them. The difference is the cost of building and
+// freeing the queues for every flood.
+
+#include <cstdio>
+
+#include "bench.h"
+#include "floodworkspace.h"
+
+void benchWorkspace() {
+  const int repeats = 200;
+  struct Setting {
+    const char *name;
+    Maze::FloodType floodType;
+    Maze::QueueType queueType;
+  };
+  const Setting settings[] = {
+      {"manhattan", Maze::MANHATTAN_FLOOD, Maze::LINEAR_QUEUE},
+      {"weighted", Maze::WEIGHTED_FLOOD, Maze::LINEAR_QUEUE},
+      {"weighted heap", Maze::WEIGHTED_FLOOD, Maze::HEAP_QUEUE},
+      {"runlength", Maze::RUNLENGTH_FLOOD, Maze::LINEAR_QUEUE},
+      {"runlength bucket", Maze::RUNLENGTH_FLOOD, Maze::BUCKET_QUEUE},
+      {"runlength heap", Maze::RUNLENGTH_FLOOD, Maze::HEAP_QUEUE},
+  };
+  FloodWorkspace workspace;
+  Maze maze(16);
+  // the bit-parallel manhattan flood has no queue so time the queue flood instead
+  maze.setBitParallelFlood(false);
+  printf("%-18s %12s %12s %8s\n", "flood", "own queue", "workspace", "speedup");
+  for (const Setting &setting : settings) {
+    maze.setFloodType(setting.floodType);
+    maze.setQueueType(setting.queueType);
+    double plainTotal = 0;
+    double workspaceTotal = 0;
+    for (int i = 0; i < mazeCount; i++) {
+      loadCorpusMaze(maze, i);
+      uint16_t goal = corpusGoal(maze);
+      maze.setFloodWorkspace(nullptr);
+      plainTotal += benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+      maze.setFloodWorkspace(&workspace);
+      workspaceTotal += benchMeanMicroseconds(repeats, [&]() { maze.flood(goal, CLOSED_MASK); });
+    }
+    maze.setFloodWorkspace(nullptr);
+    printf("%-18s %10.2fus %10.2fus %8.2f\n", setting.name, plainTotal / mazeCount, workspaceTotal / mazeCount,
+           plainTotal / workspaceTotal);
+  }
+}
@@ -0,0 +1,95 @@
+// Helpers shared by the libMaze benchmarks.
+//
+// The benchmarks are not part of the test suite. Build the maze_bench target
+// in a Release configuration and run it with the names of the benchmarks
+// to run, or with no arguments to run them all.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../corpus-mazes.h"
+#include "largemaze.h"
+#include "maze.h"
+#include "mazedata.h"
+
+/// Wall clock time for a block of code, in microseconds
+class BenchTimer {
+ public:
+  BenchTimer() : mStart(std::chrono::steady_clock::now()) {}
+
+  void restart() { mStart = std::chrono::steady_clock::now(); }
+
+  double elapsedMicroseconds() const {
+    auto elapsed = std::chrono::steady_clock::now() - mStart;
+    return std::chrono::duration<double, std::micro>(elapsed).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/// Run a function repeatedly and return the mean time per call in microseconds
+template <class function_t>
+double benchMeanMicroseconds(int repeats, function_t function) {
+  BenchTimer timer;
+  for (int i = 0; i < repeats; i++) {
+    function();
+  }
+  return timer.elapsedMicroseconds() / repeats;
+}
+
+/// The goal marked in the maze file or, failing that, the cell just south west of the centre
+inline uint16_t corpusGoal(Maze &maze) {
+  if (maze.goalAreaSize() > 0) {
+    return maze.goal();
+  }
+  uint16_t half = maze.width() / 2 - 1;
+  return static_cast<uint16_t>(half * maze.width() + half);
+}
+
+/// carve a perfect maze into a maze that starts with every wall present
+inline void makePerfectMaze(LargeMaze<> &maze, uint32_t seed) {
+  const uint32_t width = maze.width();
+  for (uint32_t cell = 0; cell < maze.numCells(); cell++) {
+    for (uint8_t direction = NORTH; direction <= WEST; direction++) {
+      maze.setWall(cell, direction);
+    }
+  }
+  std::mt19937 random(seed);
+  std::vector<bool> carved(maze.numCells(), false);
+  std::vector<uint32_t> stack;
+  stack.push_back(0);
+  carved[0] = true;
+  while (!stack.empty()) {
+    uint32_t cell = stack.back();
+    uint32_t col = maze.col(cell);
+    uint32_t row = maze.row(cell);
+    uint8_t choices[4];
+    int count = 0;
+    if (row + 1 < width && !carved[cell + 1]) {
+      choices[count++] = NORTH;
+    }
+    if (col + 1 < width && !carved[cell + width]) {
+      choices[count++] = EAST;
+    }
+    if (row > 0 && !carved[cell - 1]) {
+      choices[count++] = SOUTH;
+    }
+    if (col > 0 && !carved[cell - width]) {
+      choices[count++] = WEST;
+    }
+    if (count == 0) {
+      stack.pop_back();
+      continue;
+    }
+    uint8_t direction = choices[random() % count];
+    uint32_t next = maze.neighbour(cell, direction);
+    maze.clearWall(cell, direction);
+    carved[next] = true;
+    stack.push_back(next);
+  }
+}
@@ -0,0 +1,42 @@
+// Loading the mazes of the corpus in mazedata.h, shared by the tests and the benchmarks.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "largemaze.h"
+#include "maze.h"
+#include "mazedata.h"
+
+/// The corpus holds 16x16 (256 byte) and 32x32 (1024 byte) mazes
+inline uint16_t corpusWidth(int index) {
+  return mazeList[index].size == 256 ? 16 : 32;
+}
+
+/// Load a maze from the corpus, resizing the maze first.
+inline void loadCorpusMaze(Maze &maze, int index) {
+  maze.setWidth(corpusWidth(index));
+  maze.copyMazeFromFileData(mazeList[index].data, mazeList[index].size);
+}
+
+/// A copy of a corpus maze with only every so many cells seen, so the open and closed floods differ
+inline void loadPartlySeenCorpusMaze(Maze &maze, int index, int every) {
+  Maze real(corpusWidth(index));
+  loadCorpusMaze(real, index);
+  maze.setWidth(real.width());
+  maze.resetToEmptyMaze();
+  for (uint16_t cell = 0; cell < maze.numCells(); cell += every) {
+    maze.updateMap(cell, real.walls(cell));
+  }
+}
+
+/// Load a maze from the corpus into a LargeMaze, which takes its walls as saved by a Maze.
+inline void loadCorpusMaze(LargeMaze<> &maze, int index) {
+  Maze source(corpusWidth(index));
+  loadCorpusMaze(source, index);
+  std::vector<uint8_t> walls(source.numCells());
+  source.save(walls.data());
+  maze.setWidth(corpusWidth(index));
+  maze.load(walls.data());
+}
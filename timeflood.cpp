@@ -0,0 +1,254 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "timeflood.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "maze.h"
+#include "mazegeometry.h"
+
+static const double PI = 3.14159265358979;
+
+/// seconds to whole microseconds
+static uint32_t micros(double seconds) {
+  return (uint32_t)(seconds * 1e6 + 0.5);
+}
+
+/// microseconds to the ms costs of the maze, which never reach MAX_COST
+static uint16_t millis(uint32_t time) {
+  return (uint16_t)std::min<uint32_t>((time + 500) / 1000, MAX_COST - 1);
+}
+
+/*
+ * The time to cross the distance while the speed changes from one value
+ * to the other, holding the faster of the two for the rest of the way.
+ * Running it backwards takes the same time.
+ */
+static double crossingTime(double from, double to, double distance, double acceleration) {
+  double fast = std::max(from, to);
+  double slow = std::min(from, to);
+  double rampDistance = (fast * fast - slow * slow) / (2 * acceleration);
+  return (fast - slow) / acceleration + (distance - rampDistance) / fast;
+}
+
+TimeFlood::TimeFlood(const MotionProfile &profile) {
+  setProfile(profile);
+}
+
+void TimeFlood::setProfile(const MotionProfile &profile) {
+  mProfile = profile;
+  const double cellSize = profile.cellSize;
+  const double turnSpeed = profile.turnSpeed;
+  mSpeed[0] = turnSpeed;
+  mSpeedCount = 1;
+  while (mSpeedCount < MAX_SPEEDS && mSpeed[mSpeedCount - 1] < profile.maxSpeed) {
+    double speed = std::sqrt(turnSpeed * turnSpeed + 2 * profile.acceleration * mSpeedCount * cellSize);
+    mSpeed[mSpeedCount++] = std::min(speed, profile.maxSpeed);
+  }
+  for (int level = 0; level < mSpeedCount; level++) {
+    for (int change = -1; change <= 1; change++) {
+      int next = level + change;
+      bool valid = next >= 0 && next < mSpeedCount;
+      mStepTime[level][change + 1] =
+          valid ? micros(crossingTime(mSpeed[level], mSpeed[next], cellSize, profile.acceleration)) : UINT32_MAX;
+    }
+    mArrivalTime[level] = micros(cellSize / 2 / mSpeed[level]);
+  }
+  mTurnTime = micros(PI * cellSize / 4 / turnSpeed);
+}
+
+const MotionProfile &TimeFlood::profile() const {
+  return mProfile;
+}
+
+int TimeFlood::speedCount() const {
+  return mSpeedCount;
+}
+
+double TimeFlood::speed(int level) const {
+  return mSpeed[level];
+}
+
+uint32_t TimeFlood::stepTime(int fromLevel, int toLevel) const {
+  return mStepTime[fromLevel][toLevel - fromLevel + 1];
+}
+
+uint32_t TimeFlood::turnTime() const {
+  return mTurnTime;
+}
+
+uint32_t TimeFlood::runTime() const {
+  return mRunTime;
+}
+
+uint32_t TimeFlood::expansions() const {
+  return mExpansions;
+}
+
+void TimeFlood::relax(int next, uint32_t time) {
+  if (time >= mTime[next]) {
+    return;
+  }
+  mTime[next] = time;
+  mQueue.push_back((uint64_t)time << 32 | (uint32_t)next);
+  std::push_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+}
+
+uint32_t TimeFlood::flood(const Maze &maze, const uint16_t *sources, int sourceCount, uint8_t mask, uint16_t *cost,
+                          uint8_t *direction) {
+  const RuntimeWidth geometry(maze.width());
+  const uint16_t numCells = geometry.numCells();
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    uint8_t walls = maze.getXWalls(cell);
+    mExits[cell] = 0;
+    for (uint8_t dir = NORTH; dir <= WEST; dir++) {
+      if (!(walls & (mask << dir))) {
+        mExits[cell] |= (uint8_t)(1 << dir);
+      }
+    }
+  }
+  mTime.assign((size_t)numCells * HEADINGS * mSpeedCount, UINT32_MAX);
+  mQueue.clear();
+  mExpansions = 0;
+  for (int i = 0; i < sourceCount; i++) {
+    for (uint8_t exitWall = NORTH; exitWall <= WEST; exitWall++) {
+      if (!(mExits[sources[i]] & (1 << exitWall))) {
+        continue;
+      }
+      int first = state(geometry.neighbour(sources[i], exitWall), exitWall, 0);
+      for (int level = 0; level < mSpeedCount; level++) {
+        relax(first + level, mArrivalTime[level]);
+      }
+    }
+  }
+  while (!mQueue.empty()) {
+    std::pop_heap(mQueue.begin(), mQueue.end(), std::greater<uint64_t>());
+    uint64_t entry = mQueue.back();
+    mQueue.pop_back();
+    int here = (int)(entry & 0xFFFFFFFF);
+    uint32_t time = (uint32_t)(entry >> 32);
+    if (time != mTime[here]) {
+      continue;  // a quicker way to this state was found after this entry was queued
+    }
+    mExpansions++;
+    const int level = here % mSpeedCount;
+    const uint8_t heading = (uint8_t)((here / mSpeedCount) % HEADINGS);
+    const uint16_t cell = (uint16_t)(here / mSpeedCount / HEADINGS);
+    if (mExits[cell] & (1 << heading)) {
+      int next = state(geometry.neighbour(cell, heading), heading, level);
+      if (level > 0) {
+        relax(next - 1, time + mStepTime[level][0]);
+      }
+      relax(next, time + mStepTime[level][1]);
+      if (level + 1 < mSpeedCount) {
+        relax(next + 1, time + mStepTime[level][2]);
+      }
+    }
+    if (level == 0) {
+      for (uint8_t turn = 1; turn < 4; turn += 2) {
+        uint8_t exitWall = (uint8_t)((heading + turn) % HEADINGS);
+        if (mExits[cell] & (1 << exitWall)) {
+          relax(state(geometry.neighbour(cell, exitWall), exitWall, 0), time + mTurnTime);
+        }
+      }
+    }
+  }
+  for (uint16_t cell = 0; cell < numCells; cell++) {
+    uint32_t best = UINT32_MAX;
+    uint8_t bestHeading = INVALID_DIRECTION;
+    for (uint8_t heading = 0; heading < HEADINGS; heading++) {
+      for (int level = 0; level < mSpeedCount; level++) {
+        uint32_t time = mTime[state(cell, heading, level)];
+        if (time < best) {
+          best = time;
+          bestHeading = heading;
+        }
+      }
+    }
+    cost[cell] = best == UINT32_MAX ? MAX_COST : millis(best);
+    direction[cell] = best == UINT32_MAX ? INVALID_DIRECTION : (uint8_t)((bestHeading + 2) % HEADINGS);
+  }
+  for (int i = 0; i < sourceCount; i++) {
+    cost[sources[i]] = 0;
+    direction[sources[i]] = NORTH;
+  }
+  traceRoute(maze.width(), cost, direction);
+  return mRunTime;
+}
+
+/*
+ * The route starts at the turn speed in whichever heading is quickest.
+ * Each state is reached from one in the cell behind it whose time plus the
+ * step between them is exactly its own. A route that comes back to a cell
+ * leaves the direction from the later visit, so the directions never loop.
+ */
+void TimeFlood::traceRoute(uint16_t width, uint16_t *cost, uint8_t *direction) {
+  const RuntimeWidth geometry(width);
+  mRunTime = UINT32_MAX;
+  if (cost[0] == 0) {
+    mRunTime = 0;
+    return;
+  }
+  int here = -1;
+  for (uint8_t heading = 0; heading < HEADINGS; heading++) {
+    int start = state(0, heading, 0);
+    if (mTime[start] < mRunTime) {
+      mRunTime = mTime[start];
+      here = start;
+    }
+  }
+  for (size_t steps = 0; here >= 0 && steps < mTime.size(); steps++) {
+    const uint32_t time = mTime[here];
+    const int level = here % mSpeedCount;
+    const uint8_t heading = (uint8_t)((here / mSpeedCount) % HEADINGS);
+    const uint16_t cell = (uint16_t)(here / mSpeedCount / HEADINGS);
+    const uint8_t back = (uint8_t)((heading + 2) % HEADINGS);
+    cost[cell] = millis(time);
+    direction[cell] = back;
+    uint16_t previous = geometry.neighbour(cell, back);
+    if (cost[previous] == 0) {
+      break;  // a source
+    }
+    here = -1;
+    if (mExits[previous] & (1 << heading)) {
+      for (int from = std::max(level - 1, 0); from <= std::min(level + 1, mSpeedCount - 1); from++) {
+        int candidate = state(previous, heading, from);
+        if (mTime[candidate] != UINT32_MAX && mTime[candidate] + stepTime(from, level) == time) {
+          here = candidate;
+          break;
+        }
+      }
+    }
+    for (uint8_t turn = 1; turn < 4 && here < 0 && level == 0; turn += 2) {
+      uint8_t entryHeading = (uint8_t)((heading + turn) % HEADINGS);
+      int candidate = state(previous, entryHeading, 0);
+      if ((mExits[previous] & (1 << heading)) && mTime[candidate] != UINT32_MAX &&
+          mTime[candidate] + mTurnTime == time) {
+        here = candidate;
+      }
+    }
+  }
+}
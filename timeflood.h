@@ -0,0 +1,120 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef TIMEFLOOD_H
+#define TIMEFLOOD_H
+
+#include <cstdint>
+#include <vector>
+#include "runlengthcosts.h"
+
+class Maze;
+
+/*
+ * A flood that finds the quickest route rather than the shortest.
+ *
+ * The runlength flood guesses at the effect of acceleration from the
+ * length of each straight and adds a fixed cost for each turn. This flood
+ * runs Dijkstra over the states a mouse can be in as it crosses from one
+ * cell to the next: the cell it enters, its heading and its speed. The
+ * costs are times from a trapezoidal motion profile.
+ *
+ * The speeds are discretised so that one cell of full acceleration takes
+ * the mouse from one speed level to the next. Level 0 is the turn speed and
+ * the last level is the top speed. Along a straight each cell can then
+ * accelerate, cruise or brake by one level and its time is exact. Turns
+ * are smooth quarter circles taken at the turn speed. Diagonals are not
+ * modelled.
+ *
+ * The flood runs outward from the target. Since the same route run
+ * backwards takes the same time, a state that enters a cell heading away
+ * from the target gives the time for a mouse leaving that cell the other
+ * way. The clock stops at the centre of the target, at whatever speed the
+ * mouse arrives.
+ *
+ * Each cell gets the time from its best state and the direction that
+ * state leaves in, so the directions always lead to the target. The route
+ * from cell 0 is then traced through the states, starting at the turn
+ * speed, and its cells are given the times and directions of that route.
+ * Costs are in ms. The time of the route from cell 0 is the estimated run
+ * time, which runTime() gives in microseconds.
+ *
+ * About 100k bytes of state are held for a 32x32 maze. They are allocated
+ * by the first flood and reused after that.
+ */
+class TimeFlood {
+ public:
+  static const int MAX_CELLS = 1024;
+  static const int HEADINGS = 4;
+  /// profiles that need more levels than this never get above the last one
+  static const int MAX_SPEEDS = 16;
+
+  explicit TimeFlood(const MotionProfile &profile = LOW_SPEED_MOTION);
+
+  void setProfile(const MotionProfile &profile);
+  const MotionProfile &profile() const;
+  /// the number of speed levels for the profile
+  int speedCount() const;
+  /// the speed of a level in mm/s
+  double speed(int level) const;
+  /// the time in us to cross a cell from one speed level to the next. The levels can differ by at most one.
+  uint32_t stepTime(int fromLevel, int toLevel) const;
+  /// the time in us of a turn through one cell at the turn speed
+  uint32_t turnTime() const;
+
+  /// Flood the maze from the sources with the given mask into cost and direction. Returns runTime().
+  uint32_t flood(const Maze &maze, const uint16_t *sources, int sourceCount, uint8_t mask, uint16_t *cost,
+                 uint8_t *direction);
+  /// the time in us of the route from cell 0 found by the last flood. UINT32_MAX if there is none.
+  uint32_t runTime() const;
+  /// the states taken from the queue by the last flood
+  uint32_t expansions() const;
+
+ private:
+  MotionProfile mProfile;
+  int mSpeedCount = 0;
+  double mSpeed[MAX_SPEEDS];
+  /// mStepTime[level][change + 1] for a change of -1, 0 or +1 levels
+  uint32_t mStepTime[MAX_SPEEDS][3];
+  /// the time from entering the target to its centre at each speed
+  uint32_t mArrivalTime[MAX_SPEEDS];
+  uint32_t mTurnTime = 0;
+  uint32_t mRunTime = UINT32_MAX;
+  uint32_t mExpansions = 0;
+  /// the best time for every state, indexed by state()
+  std::vector<uint32_t> mTime;
+  /// a binary heap of (time << 32 | state). Stale entries are skipped when they come out.
+  std::vector<uint64_t> mQueue;
+  uint8_t mExits[MAX_CELLS];
+
+  int state(uint16_t cell, uint8_t heading, int level) const {
+    return (cell * HEADINGS + heading) * mSpeedCount + level;
+  }
+  void relax(int next, uint32_t time);
+  /// follow the route from cell 0 back through the states, writing its times and directions
+  void traceRoute(uint16_t width, uint16_t *cost, uint8_t *direction);
+};
+
+#endif  // TIMEFLOOD_H
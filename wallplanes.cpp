@@ -0,0 +1,112 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#include "wallplanes.h"
+
+WallPlanes::WallPlanes(uint16_t width) {
+  setWidth(width);
+}
+
+void WallPlanes::setWidth(uint16_t width) {
+  mWidth = width;
+  mRowMask = (width >= 32) ? 0xFFFFFFFFu : ((column_t(1) << width) - 1);
+  clear();
+}
+
+void WallPlanes::clear() {
+  for (int direction = 0; direction < 4; direction++) {
+    for (int col = 0; col < MAX_WIDTH; col++) {
+      mWall[direction][col] = 0;
+      mUnseen[direction][col] = 0;
+    }
+  }
+}
+
+void WallPlanes::setCellWalls(uint16_t cell, uint8_t walls) {
+  uint16_t col = cell / mWidth;
+  column_t bit = column_t(1) << (cell % mWidth);
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    if (walls & (WALL_PRESENT << direction)) {
+      mWall[direction][col] |= bit;
+    } else {
+      mWall[direction][col] &= ~bit;
+    }
+    if (walls & (WALL_UNSEEN << direction)) {
+      mUnseen[direction][col] |= bit;
+    } else {
+      mUnseen[direction][col] &= ~bit;
+    }
+  }
+}
+
+uint8_t WallPlanes::cellWalls(uint16_t cell) const {
+  uint16_t col = cell / mWidth;
+  uint16_t row = cell % mWidth;
+  uint8_t walls = 0;
+  for (uint8_t direction = 0; direction < 4; direction++) {
+    walls |= ((mWall[direction][col] >> row) & 1) << direction;
+    walls |= ((mUnseen[direction][col] >> row) & 1) << (direction + 4);
+  }
+  return walls;
+}
+
+/*
+ * Cell numbers run up each column so moving north or south is a shift
+ * within the column word and moving east or west is a move to the next
+ * word. The wrap matches Maze::neighbour(), which works modulo the number
+ * of cells: north from the top row goes to row 0 of the next column and
+ * east from the last column goes back to column 0.
+ */
+void WallPlanes::expand(const column_t *frontier, column_t *reached, uint8_t open_close_mask) const {
+  const uint16_t top = mWidth - 1;
+  for (uint16_t col = 0; col < mWidth; col++) {
+    const uint16_t colEast = (col == top) ? 0 : col + 1;
+    const uint16_t colWest = (col == 0) ? top : col - 1;
+    const column_t cells = frontier[col];
+    if (cells == 0) {
+      continue;
+    }
+    column_t north = cells & exits(col, NORTH, open_close_mask);
+    reached[col] |= (north << 1) & mRowMask;
+    reached[colEast] |= (north >> top) & 1;
+    column_t south = cells & exits(col, SOUTH, open_close_mask);
+    reached[col] |= south >> 1;
+    reached[colWest] |= (south & 1) << top;
+    reached[colEast] |= cells & exits(col, EAST, open_close_mask);
+    reached[colWest] |= cells & exits(col, WEST, open_close_mask);
+  }
+}
+
+uint16_t WallPlanes::count(const column_t *cells) const {
+  uint16_t total = 0;
+  for (uint16_t col = 0; col < mWidth; col++) {
+    column_t bits = cells[col];
+    while (bits) {
+      bits &= bits - 1;
+      total++;
+    }
+  }
+  return total;
+}
@@ -0,0 +1,107 @@
+/************************************************************************
+ *
+ * Copyright (C) 2017 by Peter Harrison. www.micromouseonline.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without l> imitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ************************************************************************/
+
+#ifndef WALLPLANES_H
+#define WALLPLANES_H
+
+#include <cstdint>
+#include "mazeconstants.h"
+
+/*
+ * Wall storage as bitplanes.
+ *
+ * The maze keeps one byte per cell with four wall bits and four unseen bits.
+ * That is the natural form for questions about a single cell but it means
+ * that any question about the whole maze needs a loop over every cell.
+ *
+ * WallPlanes holds the same information as eight planes, one for the wall
+ * bits and one for the unseen bits in each direction. Each plane is an
+ * array of one 32 bit word per column with bit n of the word for row n.
+ * A question like "which cells in this column have an exit to the north"
+ * is then a single word operation and a whole 16x16 maze can be scanned
+ * in 16 of them.
+ *
+ * The planes mirror the wall byte exactly, including the case where the
+ * two sides of a wall disagree, so that setCellWalls() followed by
+ * cellWalls() always gives back the same byte.
+ *
+ * Maze keeps an instance up to date as the walls change. It is available
+ * through Maze::wallPlanes() for flood kernels and other bulk queries.
+ */
+class WallPlanes {
+ public:
+  typedef uint32_t column_t;
+  static const int MAX_WIDTH = 32;
+
+  explicit WallPlanes(uint16_t width = 16);
+
+  /// change the width and clear all the planes
+  void setWidth(uint16_t width);
+  uint16_t width() const { return mWidth; }
+  /// the bits in a column word that belong to cells in the maze
+  column_t rowMask() const { return mRowMask; }
+
+  /// set every wall absent and seen
+  void clear();
+  /// store the wall byte for a cell, in the same format as Maze::getXWalls()
+  void setCellWalls(uint16_t cell, uint8_t walls);
+  /// rebuild the wall byte for a cell from the planes
+  uint8_t cellWalls(uint16_t cell) const;
+
+  /// rows in the column with a wall in the given direction. Seen or not.
+  column_t walls(uint16_t col, uint8_t direction) const { return mWall[direction][col]; }
+  /// rows in the column where the wall in the given direction is not seen
+  column_t unseen(uint16_t col, uint8_t direction) const { return mUnseen[direction][col]; }
+  /// rows in the column with all four walls seen
+  column_t visited(uint16_t col) const {
+    return ~(mUnseen[NORTH][col] | mUnseen[EAST][col] | mUnseen[SOUTH][col] | mUnseen[WEST][col]) & mRowMask;
+  }
+  /// rows in the column with an exit in the given direction. Same rules as Maze::hasExit()
+  /// so with OPEN_MASK unseen walls are exits and with CLOSED_MASK they are not.
+  column_t exits(uint16_t col, uint8_t direction, uint8_t open_close_mask) const {
+    column_t blocked = 0;
+    if (open_close_mask & WALL_PRESENT) {
+      blocked |= mWall[direction][col];
+    }
+    if (open_close_mask & WALL_UNSEEN) {
+      blocked |= mUnseen[direction][col];
+    }
+    return ~blocked & mRowMask;
+  }
+
+  /// OR into reached every cell that is one step from a cell in frontier through an exit.
+  /// Both arrays have one word per column. Neighbours wrap exactly as in Maze::neighbour().
+  void expand(const column_t *frontier, column_t *reached, uint8_t open_close_mask) const;
+  /// the number of set bits in an array of one word per column
+  uint16_t count(const column_t *cells) const;
+
+ private:
+  uint16_t mWidth = 16;
+  column_t mRowMask = 0xFFFF;
+  column_t mWall[4][MAX_WIDTH] = {};
+  column_t mUnseen[4][MAX_WIDTH] = {};
+};
+
+#endif  // WALLPLANES_H